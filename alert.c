@@ -0,0 +1,294 @@
+#include "alert.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+int initAlertMonitor(AlertMonitor* alertMonitor)
+{
+	if (alertMonitor == NULL)
+		return -1;
+
+	alertMonitor->size = 0;
+	alertMonitor->ring.head = 0;
+	alertMonitor->ring.size = 0;
+	alertMonitor->ring.dropped = 0;
+	alertMonitor->nameRules = createHashMap(8, &destroyDynamicArray);
+	alertMonitor->supplierRules = createHashMap(8, &destroyDynamicArray);
+	alertMonitor->anyRules = createDynamicArray(2, NULL);
+
+	if (alertMonitor->nameRules == NULL || alertMonitor->supplierRules == NULL || alertMonitor->anyRules == NULL)
+	{
+		freeAlertMonitor(alertMonitor);
+		return -1;
+	}
+
+	return 1;
+}
+
+void freeAlertMonitor(AlertMonitor* alertMonitor)
+{
+	if (alertMonitor == NULL)
+		return;
+
+	destroyHashMap(alertMonitor->nameRules);
+	destroyHashMap(alertMonitor->supplierRules);
+	destroyDynamicArray(alertMonitor->anyRules);
+	alertMonitor->nameRules = NULL;
+	alertMonitor->supplierRules = NULL;
+	alertMonitor->anyRules = NULL;
+}
+
+void pushAlert(AlertRing* alertRing, const Alert* alert)
+{
+	if (alertRing == NULL || alert == NULL)
+		return;
+
+	if (alertRing->size == ALERT_RING_SIZE)
+	{
+		alertRing->head = (alertRing->head + 1) % ALERT_RING_SIZE;
+		alertRing->size--;
+		alertRing->dropped++;
+	}
+
+	alertRing->alerts[(alertRing->head + alertRing->size) % ALERT_RING_SIZE] = *alert;
+	alertRing->size++;
+}
+
+int popAlert(AlertRing* alertRing, Alert* alert)
+{
+	if (alertRing == NULL || alertRing->size == 0)
+		return 0;
+
+	if (alert != NULL)
+		*alert = alertRing->alerts[alertRing->head];
+
+	alertRing->head = (alertRing->head + 1) % ALERT_RING_SIZE;
+	alertRing->size--;
+
+	return 1;
+}
+
+/*
+	Gets the total quantity of the key of a low stock rule, or the number of its lots expiring in the window of an expiring rule.
+*/
+double getRuleValue(const AlertRule* rule, MaterialRepo* materialRepo, int today)
+{
+	if (rule->type == ALERT_EXPIRING && rule->key[0] == 0)
+		return countCalendarRange(&materialRepo->calendar, today, today + rule->days);
+
+	MaterialGroup* group = rule->bySupplier ? getSupplierGroup(materialRepo, rule->key) : getNameGroup(materialRepo, rule->key);
+
+	if (group == NULL)
+		return 0;
+
+	if (rule->type == ALERT_LOW_STOCK)
+		return group->total;
+
+	int count = 0;
+	for (int i = 0; i < len(group->lots); i++)
+	{
+		int days = dayNumber(getDate(getElement(group->lots, i))) - today;
+		if (days >= 0 && days < rule->days)
+			count++;
+	}
+
+	return count;
+}
+
+void checkRule(AlertMonitor* alertMonitor, AlertRule* rule, MaterialRepo* materialRepo, int today, long long version)
+{
+	double value = getRuleValue(rule, materialRepo, today);
+	int active = rule->type == ALERT_LOW_STOCK ? value < rule->threshold : value > 0;
+
+	if (active == rule->active)
+		return;
+
+	rule->active = active;
+
+	Alert alert;
+	alert.type = rule->type;
+	alert.bySupplier = rule->bySupplier;
+	strcpy(alert.key, rule->key);
+	alert.raised = active;
+	alert.value = value;
+	alert.version = version;
+
+	pushAlert(&alertMonitor->ring, &alert);
+}
+
+void checkRules(AlertMonitor* alertMonitor, DynamicArray* rules, MaterialRepo* materialRepo, int today, long long version)
+{
+	if (rules == NULL)
+		return;
+
+	for (int i = 0; i < len(rules); i++)
+		checkRule(alertMonitor, getElement(rules, i), materialRepo, today, version);
+}
+
+int addAlertRule(AlertMonitor* alertMonitor, MaterialRepo* materialRepo, const AlertRule* rule, int today, long long version)
+{
+	if (alertMonitor == NULL || materialRepo == NULL || rule == NULL || alertMonitor->size == MAX_ALERT_RULES)
+		return -1;
+
+	if (memchr(rule->key, 0, MAX_ALERT_KEY_SIZE) == NULL)
+		return -1;
+	if (rule->type == ALERT_LOW_STOCK && (rule->key[0] == 0 || rule->threshold <= 0))
+		return -1;
+	if (rule->type == ALERT_EXPIRING && rule->days < 1)
+		return -1;
+
+	AlertRule* newRule = &alertMonitor->rules[alertMonitor->size];
+	*newRule = *rule;
+	newRule->active = 0;
+
+	DynamicArray* rules = alertMonitor->anyRules;
+
+	if (newRule->key[0] != 0)
+	{
+		HashMap* keyRules = newRule->bySupplier ? alertMonitor->supplierRules : alertMonitor->nameRules;
+		rules = getValue(keyRules, newRule->key);
+
+		if (rules == NULL)
+		{
+			rules = createDynamicArray(2, NULL);
+			if (rules == NULL || putValue(keyRules, newRule->key, rules) == -1)
+			{
+				destroyDynamicArray(rules);
+				return -1;
+			}
+		}
+	}
+
+	if (apd(rules, newRule) == -1)
+		return -1;
+
+	alertMonitor->size++;
+	checkRule(alertMonitor, newRule, materialRepo, today, version);
+
+	return 1;
+}
+
+void checkChangedKeys(AlertMonitor* alertMonitor, HashMap* keyRules, HashMap* changedKeys, MaterialRepo* materialRepo, int today, long long version)
+{
+	// the rules are usually fewer than the changed keys, so a key is only looked up when some rule could match it
+	if (mapSize(keyRules) == 0)
+		return;
+
+	for (int slot = 0; slot < changedKeys->capacity; slot++)
+	{
+		HashEntry* entry = getEntryAt(changedKeys, slot);
+		if (entry != NULL)
+			checkRules(alertMonitor, getValue(keyRules, entry->key), materialRepo, today, version);
+	}
+}
+
+void checkChangedAlerts(AlertMonitor* alertMonitor, MaterialRepo* materialRepo, int today, long long version)
+{
+	if (alertMonitor == NULL || materialRepo == NULL)
+		return;
+
+	checkChangedKeys(alertMonitor, alertMonitor->nameRules, materialRepo->changedNames, materialRepo, today, version);
+	checkChangedKeys(alertMonitor, alertMonitor->supplierRules, materialRepo->changedSuppliers, materialRepo, today, version);
+	checkRules(alertMonitor, alertMonitor->anyRules, materialRepo, today, version);
+
+	clearChanges(materialRepo);
+}
+
+void checkAllAlerts(AlertMonitor* alertMonitor, MaterialRepo* materialRepo, int today, long long version)
+{
+	if (alertMonitor == NULL || materialRepo == NULL)
+		return;
+
+	for (int i = 0; i < alertMonitor->size; i++)
+		checkRule(alertMonitor, &alertMonitor->rules[i], materialRepo, today, version);
+
+	clearChanges(materialRepo);
+}
+
+
+//Tests
+
+
+void testAlertRing()
+{
+	AlertRing ring = { 0 };
+	Alert alert = { ALERT_LOW_STOCK, 0, "a", 1, 0, 0 };
+
+	assert(popAlert(&ring, &alert) == 0);
+
+	for (int i = 0; i < ALERT_RING_SIZE + 3; i++)
+	{
+		alert.version = i;
+		pushAlert(&ring, &alert);
+	}
+
+	assert(ring.size == ALERT_RING_SIZE && ring.dropped == 3);
+	assert(popAlert(&ring, &alert) == 1 && alert.version == 3);
+
+	int count = 1;
+	while (popAlert(&ring, &alert) == 1)
+		count++;
+	assert(count == ALERT_RING_SIZE && alert.version == ALERT_RING_SIZE + 2);
+}
+
+void testAlertMonitor()
+{
+	AlertMonitor monitor;
+	MaterialRepo* materialRepo = createMaterialRepo(4);
+	Date date = { 1, 1, 2030 };
+	int today = dayNumber(&date);
+	Alert alert;
+
+	addMaterial(materialRepo, createMaterial("flour", "x", 10, createDate(1, 1, 2031)));
+	addMaterial(materialRepo, createMaterial("eggs", "y", 5, createDate(3, 1, 2030)));
+	clearChanges(materialRepo);
+
+	assert(initAlertMonitor(&monitor) == 1);
+
+	AlertRule rule = { ALERT_LOW_STOCK, 0, "flour", 8, 0, 0 };
+	assert(addAlertRule(&monitor, materialRepo, &rule, today, 1) == 1);
+	assert(popAlert(&monitor.ring, &alert) == 0);
+
+	// the eggs already expire in the window, so the rule is raised when it is added
+	AlertRule expiring = { ALERT_EXPIRING, 0, "", 0, 7, 0 };
+	assert(addAlertRule(&monitor, materialRepo, &expiring, today, 1) == 1);
+	assert(popAlert(&monitor.ring, &alert) == 1 && alert.type == ALERT_EXPIRING && alert.raised == 1 && alert.value == 1);
+
+	AlertRule supplier = { ALERT_LOW_STOCK, 1, "y", 1, 0, 0 };
+	assert(addAlertRule(&monitor, materialRepo, &supplier, today, 1) == 1);
+
+	AlertRule invalid = { ALERT_LOW_STOCK, 0, "", 1, 0, 0 };
+	assert(addAlertRule(&monitor, materialRepo, &invalid, today, 1) == -1);
+
+	// the flour drops below its threshold, the eggs are used up
+	consumeMaterial(materialRepo, "flour", 3);
+	consumeMaterial(materialRepo, "eggs", 5);
+	checkChangedAlerts(&monitor, materialRepo, today, 2);
+
+	assert(popAlert(&monitor.ring, &alert) == 1 && strcmp(alert.key, "flour") == 0 && alert.raised == 1 && alert.value == 7);
+	assert(popAlert(&monitor.ring, &alert) == 1 && strcmp(alert.key, "y") == 0 && alert.bySupplier == 1 && alert.value == 0);
+	assert(popAlert(&monitor.ring, &alert) == 1 && alert.type == ALERT_EXPIRING && alert.raised == 0);
+	assert(popAlert(&monitor.ring, &alert) == 0);
+	assert(mapSize(materialRepo->changedNames) == 0);
+
+	// a state that does not change raises nothing
+	consumeMaterial(materialRepo, "flour", 1);
+	checkChangedAlerts(&monitor, materialRepo, today, 3);
+	assert(popAlert(&monitor.ring, &alert) == 0);
+
+	addMaterial(materialRepo, createMaterial("flour", "x", 5, createDate(1, 1, 2031)));
+	checkAllAlerts(&monitor, materialRepo, today, 4);
+	assert(popAlert(&monitor.ring, &alert) == 1 && strcmp(alert.key, "flour") == 0 && alert.raised == 0 && alert.value == 11);
+	assert(popAlert(&monitor.ring, &alert) == 0);
+
+	freeAlertMonitor(&monitor);
+	destroyMaterialRepo(materialRepo);
+}
+
+void testAlert()
+{
+	testAlertRing();
+	testAlertMonitor();
+}
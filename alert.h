@@ -0,0 +1,111 @@
+#pragma once
+
+#include "repository.h"
+
+#define MAX_ALERT_RULES 32
+#define ALERT_RING_SIZE 64
+#define MAX_ALERT_KEY_SIZE 64
+
+typedef enum AlertType
+{
+	ALERT_LOW_STOCK,
+	ALERT_EXPIRING
+} AlertType;
+
+/*
+	A standing condition on the materials of a name or a supplier.
+	type - ALERT_LOW_STOCK holds while the total quantity of the key is below threshold (a key without materials
+		has a total of 0), ALERT_EXPIRING while some lot of the key expires in the next days, today being the first
+	key - the name (bySupplier 0) or the supplier (bySupplier 1); an expiring rule with an empty key watches every lot
+	active - 1 while the condition holds
+*/
+typedef struct AlertRule
+{
+	AlertType type;
+	int bySupplier;
+	char key[MAX_ALERT_KEY_SIZE];
+	double threshold;
+	int days;
+	int active;
+} AlertRule;
+
+/*
+	A change of the state of a rule.
+	raised - 1 if the condition started holding, 0 if it stopped
+	value - the total quantity of a low stock rule, or the number of expiring lots of an expiring rule
+	version - the version of the repository the rule was checked on
+*/
+typedef struct Alert
+{
+	AlertType type;
+	int bySupplier;
+	char key[MAX_ALERT_KEY_SIZE];
+	int raised;
+	double value;
+	long long version;
+} Alert;
+
+/*
+	A bounded queue of alerts. When it is full, a new alert replaces the oldest one, which is counted as dropped.
+*/
+typedef struct AlertRing
+{
+	int head, size;
+	long long dropped;
+	Alert alerts[ALERT_RING_SIZE];
+} AlertRing;
+
+/*
+	Evaluates standing rules incrementally: an alert is only produced when the state of a rule changes (edge triggered),
+	and after a modification only the rules of the changed names and suppliers are checked again.
+	nameRules, supplierRules - map a key to a dynamic array of pointers to its rules
+	anyRules - the expiring rules without a key, checked after every modification with a calendar count
+*/
+typedef struct AlertMonitor
+{
+	int size;
+	AlertRule rules[MAX_ALERT_RULES];
+	HashMap* nameRules;
+	HashMap* supplierRules;
+	DynamicArray* anyRules;
+	AlertRing ring;
+} AlertMonitor;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initAlertMonitor(AlertMonitor* alertMonitor);
+void freeAlertMonitor(AlertMonitor* alertMonitor);
+
+/*
+	Adds an alert to the ring, dropping the oldest one if the ring is full.
+*/
+void pushAlert(AlertRing* alertRing, const Alert* alert);
+
+/*
+	Takes the oldest alert out of the ring.
+	Returns 1 on success, or 0 if the ring is empty.
+*/
+int popAlert(AlertRing* alertRing, Alert* alert);
+
+/*
+	Registers a rule and checks it right away, so a condition that already holds raises an alert.
+	today - the day number of the current date, see dayNumber
+	Returns 1 on success, or -1 if the rule is not valid, there are already MAX_ALERT_RULES rules,
+	or the memory could not be allocated.
+*/
+int addAlertRule(AlertMonitor* alertMonitor, MaterialRepo* materialRepo, const AlertRule* rule, int today, long long version);
+
+/*
+	Checks the rules of the names and suppliers changed in the repository, and the rules without a key,
+	then clears the changes of the repository.
+*/
+void checkChangedAlerts(AlertMonitor* alertMonitor, MaterialRepo* materialRepo, int today, long long version);
+
+/*
+	Checks every rule, e.g. after the repository was replaced by undo or redo, then clears the changes of the repository.
+*/
+void checkAllAlerts(AlertMonitor* alertMonitor, MaterialRepo* materialRepo, int today, long long version);
+
+//Tests
+void testAlert();
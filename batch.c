@@ -0,0 +1,253 @@
+#include "batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+
+
+int initLineReader(LineReader* lineReader, FILE* file)
+{
+	if (lineReader == NULL || file == NULL)
+		return -1;
+
+	lineReader->buffer = (char*)malloc(BATCH_BUFFER_SIZE + 1);
+
+	if (lineReader->buffer == NULL)
+		return -1;
+
+	lineReader->file = file;
+	lineReader->capacity = BATCH_BUFFER_SIZE;
+	lineReader->start = 0;
+	lineReader->end = 0;
+	lineReader->eof = 0;
+
+	return 1;
+}
+
+void freeLineReader(LineReader* lineReader)
+{
+	if (lineReader == NULL)
+		return;
+
+	free(lineReader->buffer);
+	lineReader->buffer = NULL;
+}
+
+/*
+	Reads the next block of the file after the bytes that were not returned yet, which are moved to the start of the buffer.
+	Returns the number of bytes read, or -1 if the memory could not be allocated.
+*/
+int fillLineReader(LineReader* lineReader)
+{
+	int pending = lineReader->end - lineReader->start;
+
+	if (lineReader->start > 0)
+	{
+		memmove(lineReader->buffer, lineReader->buffer + lineReader->start, pending);
+		lineReader->start = 0;
+		lineReader->end = pending;
+	}
+
+	// a line longer than the buffer doubles it
+	if (pending == lineReader->capacity)
+	{
+		char* buffer = (char*)realloc(lineReader->buffer, (size_t)lineReader->capacity * 2 + 1);
+
+		if (buffer == NULL)
+			return -1;
+
+		lineReader->buffer = buffer;
+		lineReader->capacity *= 2;
+	}
+
+	int count = (int)fread(lineReader->buffer + lineReader->end, 1, lineReader->capacity - lineReader->end, lineReader->file);
+
+	if (count == 0)
+		lineReader->eof = 1;
+
+	lineReader->end += count;
+	return count;
+}
+
+char* readLine(LineReader* lineReader)
+{
+	if (lineReader == NULL || lineReader->buffer == NULL)
+		return NULL;
+
+	int scanned = 0;
+
+	while (1)
+	{
+		char* line = lineReader->buffer + lineReader->start;
+		char* newline = memchr(line + scanned, '\n', lineReader->end - lineReader->start - scanned);
+
+		if (newline != NULL || (lineReader->eof && lineReader->end > lineReader->start))
+		{
+			int length;
+			if (newline != NULL)
+			{
+				length = (int)(newline - line);
+				lineReader->start += length + 1;
+			}
+			else
+			{
+				// the last line of the file has no line ending
+				length = lineReader->end - lineReader->start;
+				lineReader->start = lineReader->end;
+			}
+
+			if (length > 0 && line[length - 1] == '\r')
+				length--;
+			line[length] = 0;
+
+			return line;
+		}
+
+		if (lineReader->eof)
+			return NULL;
+
+		scanned = lineReader->end - lineReader->start;
+		if (fillLineReader(lineReader) == -1)
+			return NULL;
+	}
+}
+
+int tokenizeLine(char* line, char** tokens, int maxTokens)
+{
+	if (line == NULL || tokens == NULL)
+		return -1;
+
+	int count = 0;
+	char* c = line;
+
+	while (1)
+	{
+		while (*c == ' ' || *c == '\t')
+			c++;
+
+		if (*c == 0)
+			return count;
+
+		if (count == maxTokens)
+			return -1;
+
+		if (*c == '"')
+		{
+			tokens[count++] = ++c;
+			c = strchr(c, '"');
+			if (c == NULL)
+				return -1;
+		}
+		else
+		{
+			tokens[count++] = c;
+			while (*c != ' ' && *c != '\t' && *c != 0)
+				c++;
+			if (*c == 0)
+				return count;
+		}
+
+		*c++ = 0;
+	}
+}
+
+int parseInteger(const char* token, int* value)
+{
+	if (token == NULL || value == NULL)
+		return -1;
+
+	char* end;
+	long number = strtol(token, &end, 10);
+
+	if (end == token || *end != 0 || number < INT_MIN || number > INT_MAX)
+		return -1;
+
+	*value = (int)number;
+	return 1;
+}
+
+int parseDouble(const char* token, double* value)
+{
+	if (token == NULL || value == NULL)
+		return -1;
+
+	char* end;
+	double number = strtod(token, &end);
+
+	if (end == token || *end != 0 || !isfinite(number))
+		return -1;
+
+	*value = number;
+	return 1;
+}
+
+
+//Tests
+
+
+void testTokenizeLine()
+{
+	char line[] = "  add \"Wheat flour\" WindMill\t10.5 \"\" 2025 ";
+	char* tokens[MAX_BATCH_TOKENS];
+
+	assert(tokenizeLine(line, tokens, MAX_BATCH_TOKENS) == 6);
+	assert(strcmp(tokens[0], "add") == 0);
+	assert(strcmp(tokens[1], "Wheat flour") == 0);
+	assert(strcmp(tokens[2], "WindMill") == 0);
+	assert(strcmp(tokens[3], "10.5") == 0);
+	assert(strcmp(tokens[4], "") == 0);
+	assert(strcmp(tokens[5], "2025") == 0);
+
+	char empty[] = " \t";
+	assert(tokenizeLine(empty, tokens, MAX_BATCH_TOKENS) == 0);
+
+	char open[] = "add \"Wheat flour";
+	assert(tokenizeLine(open, tokens, MAX_BATCH_TOKENS) == -1);
+
+	char many[] = "a b c";
+	assert(tokenizeLine(many, tokens, 2) == -1);
+
+	int integer;
+	double number;
+	assert(parseInteger("42", &integer) == 1 && integer == 42);
+	assert(parseInteger("4x", &integer) == -1);
+	assert(parseDouble("2.5", &number) == 1 && number == 2.5);
+	assert(parseDouble("", &number) == -1);
+	assert(parseInteger("4294967297", &integer) == -1 && parseInteger("-2147483648", &integer) == 1);
+	assert(parseDouble("nan", &number) == -1 && parseDouble("-inf", &number) == -1 && parseDouble("1e999", &number) == -1);
+}
+
+void testReadLine()
+{
+	FILE* file = tmpfile();
+	LineReader lineReader;
+
+	if (file == NULL)
+		return;
+
+	// a line longer than the buffer makes it grow
+	fputs("first\r\n\nsecond line\n", file);
+	for (int i = 0; i < BATCH_BUFFER_SIZE + 10; i++)
+		fputc('x', file);
+	fputs("\nlast", file);
+	rewind(file);
+
+	assert(initLineReader(&lineReader, file) == 1);
+	assert(strcmp(readLine(&lineReader), "first") == 0);
+	assert(strcmp(readLine(&lineReader), "") == 0);
+	assert(strcmp(readLine(&lineReader), "second line") == 0);
+	assert((int)strlen(readLine(&lineReader)) == BATCH_BUFFER_SIZE + 10);
+	assert(strcmp(readLine(&lineReader), "last") == 0);
+	assert(readLine(&lineReader) == NULL);
+
+	freeLineReader(&lineReader);
+	fclose(file);
+}
+
+void testBatch()
+{
+	testTokenizeLine();
+	testReadLine();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdio.h>
+
+#define BATCH_BUFFER_SIZE (1 << 16)
+#define MAX_BATCH_TOKENS 16
+
+/*
+	Reads a file line by line through a large buffer: the file is read in blocks of BATCH_BUFFER_SIZE bytes
+	and the lines are found with memchr, so no character is read on its own.
+	buffer - holds the bytes [start, end) that were read but not returned yet; it grows for the lines that do not fit
+*/
+typedef struct LineReader
+{
+	FILE* file;
+	char* buffer;
+	int capacity, start, end;
+	int eof;
+} LineReader;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initLineReader(LineReader* lineReader, FILE* file);
+void freeLineReader(LineReader* lineReader);
+
+/*
+	Gets the next line, without its line ending ("\n" or "\r\n"), as a string in the buffer of the reader.
+	The line can be modified, and is valid until the next call.
+	Returns the line, or NULL at the end of the file or if the memory could not be allocated.
+*/
+char* readLine(LineReader* lineReader);
+
+/*
+	Splits a line into tokens in place: tokens are separated by spaces or tabs, and a token written between double
+	quotes may contain them, e.g. add "Wheat flour" WindMill 10.5 24 5 2025 has 7 tokens.
+	tokens - receives pointers into the line, at most maxTokens of them
+	Returns the number of tokens, or -1 if a quote is not closed or the line has more than maxTokens tokens.
+*/
+int tokenizeLine(char* line, char** tokens, int maxTokens);
+
+/*
+	Convert a whole token to a number.
+	Return 1 on success, or -1 if the token is not a number, is out of the range of an int for parseInteger, or is
+	not finite for parseDouble.
+*/
+int parseInteger(const char* token, int* value);
+int parseDouble(const char* token, double* value);
+
+//Tests
+void testBatch();
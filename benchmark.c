@@ -0,0 +1,415 @@
+#include "benchmark.h"
+#include "dynamicArray.h"
+#include "typedVector.h"
+#include "repository.h"
+#include "query.h"
+#include "fuzzy.h"
+#include "services.h"
+#include "changeFeed.h"
+#include "rowWriter.h"
+#include "journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <threads.h>
+#include <stdatomic.h>
+#endif
+
+
+double elapsedMs(clock_t start)
+{
+	return (double)(clock() - start) * 1000 / CLOCKS_PER_SEC;
+}
+
+DynamicArray* createBenchMaterials(int count)
+{
+	DynamicArray* materials = createDynamicArray(count, &destroyMaterial);
+
+	srand(42);
+	for (int i = 0; i < count; i++)
+	{
+		double quantity = (double)(rand() % 100000) / 100;
+		apd(materials, createMaterial("benchName", "benchSupplier", quantity, createDate(1, 1, 2022)));
+	}
+
+	return materials;
+}
+
+void benchTypedVector(int count)
+{
+	DynamicArray* materials = createBenchMaterials(count);
+	DynamicArray* view = createDynamicArray(count, NULL);
+	MaterialVector vector;
+	MaterialVectorInit(&vector, count);
+
+	printf("Sorting %d materials:\n", count);
+	printf("%-30s %12s %12s\n", "", "less (ms)", "greater (ms)");
+
+	double generic[2], typed[2];
+	int (*compareFunctions[2])(Material*, Material*) = { &less, &greater };
+
+	for (int c = 0; c < 2; c++)
+	{
+		view->size = 0;
+		apdMany(view, materials->data, count);
+
+		clock_t start = clock();
+		sort(view, compareFunctions[c]);
+		generic[c] = elapsedMs(start);
+	}
+
+	for (int c = 0; c < 2; c++)
+	{
+		MaterialVectorClear(&vector);
+		for (int i = 0; i < count; i++)
+			MaterialVectorPush(&vector, *(Material*)getElement(materials, i));
+
+		clock_t start = clock();
+		if (c == 0)
+			MaterialLessSort(vector.data, vector.size);
+		else
+			MaterialGreaterSort(vector.data, vector.size);
+		typed[c] = elapsedMs(start);
+	}
+
+	printf("%-30s %12.3lf %12.3lf\n", "DynamicArray sort", generic[0], generic[1]);
+	printf("%-30s %12.3lf %12.3lf\n", "MaterialVector typed sort", typed[0], typed[1]);
+
+	MaterialVectorFree(&vector);
+	destroyDynamicArray(view);
+	destroyDynamicArray(materials);
+}
+
+void benchNameIndex(int count, int repeats)
+{
+	MaterialRepo* materialRepo = createMaterialRepo(count);
+	char name[32];
+
+	srand(42);
+	for (int i = 0; i < count; i++)
+	{
+		snprintf(name, sizeof(name), "material %d", i / 4);
+		addMaterial(materialRepo, createMaterial(name, "benchSupplier", 1, createDate(1, 1, 2000 + i % 4)));
+	}
+
+	Query query;
+	parseQuery(&query, "name~\"ial 12\"");
+
+	int scanned = 0, indexed = 0;
+
+	clock_t start = clock();
+	for (int r = 0; r < repeats; r++)
+		for (int i = 0; i < getSize(materialRepo); i++)
+			scanned += strstr(getName(getMaterialAtPos(materialRepo, i)), query.filters[0].text) != NULL;
+	double scan = elapsedMs(start);
+
+	start = clock();
+	for (int r = 0; r < repeats; r++)
+	{
+		DynamicArray* rows = collectQueryView(materialRepo, &query);
+		indexed += len(rows);
+		destroyDynamicArray(rows);
+	}
+	double index = elapsedMs(start);
+
+	printf("Substring search over %d materials, %d times (%d rows each):\n", count, repeats, indexed / repeats);
+	printf("%-30s %12.3lf ms\n", "strstr on every material", scan);
+	printf("%-30s %12.3lf ms\n", "trigram index", index);
+
+	if (scanned != indexed)
+		printf("The results differ!\n");
+
+	destroyMaterialRepo(materialRepo);
+}
+
+void benchEditDistance(int count)
+{
+	const char* words[] = { "wheat", "cake", "pastry", "sprouted", "rye", "flour", "sugar", "brown", "salt", "seeds", "mix", "butter" };
+	char* names = (char*)malloc((size_t)count * 32);
+
+	if (names == NULL)
+		return;
+
+	srand(42);
+	for (int i = 0; i < count; i++)
+		snprintf(names + (size_t)i * 32, 32, "%s %s %d", words[rand() % 12], words[rand() % 12], rand() % 1000);
+
+	int matches = 0;
+	clock_t start = clock();
+	for (int i = 0; i < count; i++)
+		matches += editDistance("Wheat Flour 42", names + (size_t)i * 32, 3) <= 3;
+	double elapsed = elapsedMs(start);
+
+	printf("Fuzzy lookup over %d names (%d within 3 edits):\n", count, matches);
+	printf("%-30s %12.3lf ms\n", "bit-parallel edit distance", elapsed);
+
+	free(names);
+}
+
+double wallMs()
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+
+	return (double)now.tv_sec * 1000 + (double)now.tv_nsec / 1000000;
+}
+
+#ifdef __linux__
+
+typedef struct FeedReader
+{
+	ChangeFeed* changeFeed;
+	int consumer;
+	atomic_int* stop;
+	long long read, lost;
+} FeedReader;
+
+int runFeedReader(void* argument)
+{
+	FeedReader* reader = argument;
+	ChangeRecord record;
+	uint64_t lost;
+
+	while (1)
+	{
+		int status = readChange(reader->changeFeed, reader->consumer, &record, &lost);
+		reader->lost += (long long)lost;
+
+		if (status == 1)
+			reader->read++;
+		else if (atomic_load(reader->stop))
+			break;
+		else
+			thrd_yield();
+	}
+
+	return 0;
+}
+
+#endif
+
+/*
+	Runs count mutations of one kind with the given number of readers attached to the feed.
+	Returns the elapsed wall clock time in milliseconds. The readers run on threads of their own, so without them
+	(outside Linux) only the mutations without readers are measured.
+*/
+double runFeedMutations(MaterialServices* materialServices, int services, int count, int consumers, long long* read, long long* lost)
+{
+	ChangeRecord record = { 0, 0, CHANGE_UPDATE, 0, 1, 0, 0 };
+
+#ifdef __linux__
+	FeedReader readers[4];
+	thrd_t threads[4];
+	atomic_int stop;
+	int started = 0;
+
+	// the readers that could not subscribe or start are left out, only the started ones are joined
+	atomic_init(&stop, 0);
+	while (started < consumers && started < 4)
+	{
+		FeedReader* reader = &readers[started];
+
+		reader->changeFeed = &materialServices->changes;
+		reader->consumer = subscribe(materialServices);
+		reader->stop = &stop;
+		reader->read = 0;
+		reader->lost = 0;
+
+		if (reader->consumer == -1)
+			break;
+		if (thrd_create(&threads[started], &runFeedReader, reader) != thrd_success)
+		{
+			detachConsumer(&materialServices->changes, reader->consumer);
+			break;
+		}
+		started++;
+	}
+#else
+	(void)consumers;
+#endif
+
+	double start = wallMs();
+	for (int i = 0; i < count; i++)
+	{
+		if (services)
+			update(materialServices, "benchName", "benchSupplier", 1, 1, 2030, "benchName", "benchSupplier", 1 + i % 2, 1, 1, 2030);
+		else
+		{
+			record.version = i;
+			publishChange(&materialServices->changes, &record);
+		}
+	}
+	double elapsed = wallMs() - start;
+
+	*read = 0;
+	*lost = 0;
+#ifdef __linux__
+	atomic_store(&stop, 1);
+	for (int c = 0; c < started; c++)
+	{
+		thrd_join(threads[c], NULL);
+		detachConsumer(&materialServices->changes, readers[c].consumer);
+		*read += readers[c].read;
+		*lost += readers[c].lost;
+	}
+#endif
+
+	return elapsed;
+}
+
+void benchChangeFeed(int count)
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+#ifdef __linux__
+	int consumers[] = { 0, 1, 4 }, runs = 3;
+#else
+	int consumers[] = { 0 }, runs = 1;
+#endif
+
+	// the updates are measured without the undo snapshot each of them would otherwise keep
+	setHistoryLimit(materialServices, 0);
+	addMaterial(materialRepo, createMaterial("benchName", "benchSupplier", 1, createDate(1, 1, 2030)));
+
+	printf("Change feed, %d published changes and %d updates (wall clock):\n", count, count / 10);
+	printf("%-30s %12s %12s %14s %12s\n", "", "consumers", "time (ms)", "mutations/s", "lost");
+
+	for (int services = 0; services < 2; services++)
+		for (int c = 0; c < runs; c++)
+		{
+			long long read, lost;
+			int mutations = services ? count / 10 : count;
+			double elapsed = runFeedMutations(materialServices, services, mutations, consumers[c], &read, &lost);
+
+			printf("%-30s %12d %12.3lf %14.0lf %12lld\n", services ? "MaterialServices update" : "publishChange",
+				consumers[c], elapsed, elapsed > 0 ? mutations * 1000 / elapsed : 0, lost);
+		}
+
+	destroyMaterialServices(materialServices);
+}
+
+void benchRowWriter(int count, int repeats)
+{
+	DynamicArray* materials = createBenchMaterials(count);
+	FILE* file = tmpfile();
+	RowWriter rowWriter;
+
+	if (file == NULL || initRowWriter(&rowWriter, file, ROW_WRITER_SIZE) == -1)
+	{
+		if (file != NULL)
+			fclose(file);
+		destroyDynamicArray(materials);
+		return;
+	}
+
+	clock_t start = clock();
+	for (int r = 0; r < repeats; r++)
+	{
+		rewind(file);
+		fprintf(file, "%-3s %20s %20s %20s %30s\n", "NR", "NAME", "SUPPLIER", "QUANTITY", "EXPIRATION_DATE");
+		for (int i = 0; i < count; i++)
+		{
+			Material* m = getElement(materials, i);
+			fprintf(file, "%-3d %20s %20s %*.4lf %20d/%d/%d\n", i + 1, m->name, m->supplier, 20, m->quantity,
+				m->date->day, m->date->month, m->date->year);
+		}
+		fflush(file);
+	}
+	double printed = elapsedMs(start);
+
+	printf("Writing the table of %d materials %d times:\n", count, repeats);
+	printf("%-30s %12s %12s\n", "", "time (ms)", "rows/s");
+	printf("%-30s %12.3lf %12.0lf\n", "fprintf", printed, printed > 0 ? (double)count * repeats * 1000 / printed : 0);
+
+	const char* names[] = { "RowWriter table", "RowWriter tsv", "RowWriter csv", "RowWriter jsonl" };
+	RowLayout layouts[] = { LAYOUT_TABLE, LAYOUT_TSV, LAYOUT_CSV, LAYOUT_JSONL };
+
+	for (int l = 0; l < 4; l++)
+	{
+		start = clock();
+		for (int r = 0; r < repeats; r++)
+		{
+			rewind(file);
+			writeMaterials(&rowWriter, materials, COLUMNS_ALL, layouts[l]);
+			flushRowWriter(&rowWriter);
+			fflush(file);
+		}
+		double written = elapsedMs(start);
+
+		printf("%-30s %12.3lf %12.0lf\n", names[l], written, written > 0 ? (double)count * repeats * 1000 / written : 0);
+	}
+
+	freeRowWriter(&rowWriter);
+	fclose(file);
+	destroyDynamicArray(materials);
+}
+
+void benchMerkleDiff(int count, int changes)
+{
+	MaterialRepo* materialRepo = createMaterialRepo(count);
+	char name[MAX_STRING_SIZE];
+	int buckets[MERKLE_LEAVES];
+	ByteBuffer diff, snapshot;
+
+	for (int i = 0; i < count; i++)
+	{
+		snprintf(name, sizeof(name), "benchName%d", i);
+		addMaterial(materialRepo, createMaterial(name, "benchSupplier", i % 100 + 1, createDate(1 + i % 28, 1, 2030)));
+	}
+
+	MaterialServices* source = createMaterialServices(materialRepo);
+	MaterialServices* target = createMaterialServices(copyMaterialRepo(materialRepo));
+
+	clock_t start = clock();
+	getMerkleTree(source->materialRepo);
+	getMerkleTree(target->materialRepo);
+	double built = elapsedMs(start) / 2;
+
+	for (int i = 0; i < changes; i++)
+	{
+		snprintf(name, sizeof(name), "benchName%d", i * (count / changes));
+		consume(source, name, 0.5);
+	}
+
+	int repeats = 1000, found = 0;
+	start = clock();
+	for (int r = 0; r < repeats; r++)
+		found = diffInventories(source, target, buckets);
+	double compared = elapsedMs(start) / repeats;
+
+	initByteBuffer(&diff);
+	initByteBuffer(&snapshot);
+	start = clock();
+	exportDiff(&diff, source->materialRepo, buckets, found);
+	int applied = applyDiff(target, diff.data, diff.size);
+	double synced = elapsedMs(start);
+	writeSnapshot(&snapshot, source->materialRepo, 0);
+
+	printf("Diff of two repositories of %d lots, %d of them changed:\n", count, changes);
+	printf("%-30s %12s %12s\n", "", "time (ms)", "bytes");
+	printf("%-30s %12.3lf %12s\n", "Merkle tree build", built, "");
+	printf("%-30s %12.4lf %12d\n", "Merkle diff", compared, found);
+	printf("%-30s %12.3lf %12d\n", applied == 1 ? "Export and apply diff" : "Export and apply diff FAILED", synced, diff.size);
+	printf("%-30s %12s %12d\n", "Whole repository snapshot", "", snapshot.size);
+	printf("%-30s %12s %12d\n", "Buckets left after the apply", "", diffInventories(source, target, buckets));
+
+	freeByteBuffer(&diff);
+	freeByteBuffer(&snapshot);
+	destroyMaterialServices(source);
+	destroyMaterialServices(target);
+}
+
+void runBenchmarks()
+{
+	benchTypedVector(1000);
+	benchTypedVector(10000);
+	benchNameIndex(10000, 100);
+	benchEditDistance(100000);
+	benchChangeFeed(200000);
+	benchRowWriter(100000, 10);
+	benchMerkleDiff(20000, 10);
+}
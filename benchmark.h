@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+	Compares the generic sort of DynamicArray with the generated typed sorts, using the less and greater comparators.
+	count - the number of materials to be sorted
+*/
+void benchTypedVector(int count);
+
+/*
+	Compares a substring search done with strstr on every material to the same search done through the name trigram index.
+	count - the number of materials, with 4 lots per name
+	repeats - the number of times the search is run
+*/
+void benchNameIndex(int count, int repeats);
+
+/*
+	Times the fuzzy lookup of a misspelled name among count generated names.
+*/
+void benchEditDistance(int count);
+
+/*
+	Times mutations with 0, 1 and 4 consumer threads reading the change feed, in wall clock time: count changes
+	published to the feed alone, then count / 10 updates through MaterialServices, which also take an undo snapshot.
+*/
+void benchChangeFeed(int count);
+
+/*
+	Compares writing the table of count materials with fprintf to writing it through a RowWriter, into a temporary file,
+	then times the other layouts of the RowWriter.
+	repeats - the number of times the table is written
+*/
+void benchRowWriter(int count, int repeats);
+
+/*
+	Times the Merkle diff of two repositories of count lots in which changes lots differ, and the export and apply of
+	the buckets found, compared to the size of a snapshot of the whole repository.
+*/
+void benchMerkleDiff(int count, int changes);
+
+/*
+	Runs every benchmark and prints the timings.
+*/
+void runBenchmarks();
@@ -0,0 +1,289 @@
+#include "calendar.h"
+#include "statistics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+int initCalendar(Calendar* calendar)
+{
+	if (calendar == NULL)
+		return -1;
+
+	calendar->size = 0;
+	calendar->capacity = 16;
+	calendar->buckets = (DayBucket*)malloc(sizeof(DayBucket) * calendar->capacity);
+
+	if (calendar->buckets == NULL)
+		return -1;
+
+	return 1;
+}
+
+void freeCalendar(Calendar* calendar)
+{
+	if (calendar == NULL || calendar->buckets == NULL)
+		return;
+
+	for (int i = 0; i < calendar->size; i++)
+		destroyDynamicArray(calendar->buckets[i].lots);
+
+	free(calendar->buckets);
+	calendar->buckets = NULL;
+	calendar->size = 0;
+}
+
+int findDayBucket(const Calendar* calendar, int day)
+{
+	int low = 0, high = calendar->size;
+
+	while (low < high)
+	{
+		int middle = low + (high - low) / 2;
+		if (calendar->buckets[middle].day < day)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+int addToCalendar(Calendar* calendar, Material* material)
+{
+	if (calendar == NULL || material == NULL)
+		return -1;
+
+	int day = dayNumber(getDate(material));
+	int position = findDayBucket(calendar, day);
+
+	if (position == calendar->size || calendar->buckets[position].day != day)
+	{
+		if (calendar->size == calendar->capacity)
+		{
+			DayBucket* buckets = (DayBucket*)realloc(calendar->buckets, sizeof(DayBucket) * calendar->capacity * 2);
+			if (buckets == NULL)
+				return -1;
+			calendar->buckets = buckets;
+			calendar->capacity *= 2;
+		}
+
+		DynamicArray* lots = createDynamicArray(2, NULL);
+		if (lots == NULL)
+			return -1;
+
+		memmove(calendar->buckets + position + 1, calendar->buckets + position, sizeof(DayBucket) * (calendar->size - position));
+		calendar->buckets[position].day = day;
+		calendar->buckets[position].lots = lots;
+		calendar->size++;
+	}
+
+	return apd(calendar->buckets[position].lots, material);
+}
+
+/*
+	Gets the position of the material in the lots of its bucket.
+	Returns the position, or -1 if the material is not in the calendar.
+*/
+int findInBucket(const Calendar* calendar, int bucket, Material* material)
+{
+	if (bucket == calendar->size || calendar->buckets[bucket].day != dayNumber(getDate(material)))
+		return -1;
+
+	DynamicArray* lots = calendar->buckets[bucket].lots;
+
+	for (int i = len(lots) - 1; i >= 0; i--)
+		if (getElement(lots, i) == material)
+			return i;
+
+	return -1;
+}
+
+int removeFromCalendar(Calendar* calendar, Material* material)
+{
+	if (calendar == NULL || material == NULL)
+		return -1;
+
+	int bucket = findDayBucket(calendar, dayNumber(getDate(material)));
+	int position = findInBucket(calendar, bucket, material);
+
+	if (position == -1)
+		return -1;
+
+	DynamicArray* lots = calendar->buckets[bucket].lots;
+	del(lots, position);
+
+	if (len(lots) == 0)
+	{
+		destroyDynamicArray(lots);
+		memmove(calendar->buckets + bucket, calendar->buckets + bucket + 1, sizeof(DayBucket) * (calendar->size - bucket - 1));
+		calendar->size--;
+	}
+
+	return 1;
+}
+
+int replaceInCalendar(Calendar* calendar, Material* material, Material* newMaterial)
+{
+	if (calendar == NULL || material == NULL || newMaterial == NULL)
+		return -1;
+
+	int bucket = findDayBucket(calendar, dayNumber(getDate(material)));
+	int position = findInBucket(calendar, bucket, material);
+
+	if (position == -1)
+		return -1;
+
+	calendar->buckets[bucket].lots->data[position] = newMaterial;
+	return 1;
+}
+
+int getCalendarRange(const Calendar* calendar, int from, int to, DynamicArray* sources)
+{
+	if (calendar == NULL || sources == NULL)
+		return -1;
+
+	int count = 0;
+
+	for (int i = findDayBucket(calendar, from); i < calendar->size && calendar->buckets[i].day < to; i++)
+	{
+		if (apd(sources, calendar->buckets[i].lots) == -1)
+			return -1;
+		count += len(calendar->buckets[i].lots);
+	}
+
+	return count;
+}
+
+int countCalendarRange(const Calendar* calendar, int from, int to)
+{
+	if (calendar == NULL)
+		return 0;
+
+	int count = 0;
+
+	for (int i = findDayBucket(calendar, from); i < calendar->size && calendar->buckets[i].day < to; i++)
+		count += len(calendar->buckets[i].lots);
+
+	return count;
+}
+
+int getCalendarHistogram(const Calendar* calendar, int from, int firstMonth, int count, CalendarBin* bins)
+{
+	if (calendar == NULL || bins == NULL || count < 1)
+		return -1;
+
+	memset(bins, 0, sizeof(CalendarBin) * count);
+
+	for (int i = findDayBucket(calendar, from); i < calendar->size; i++)
+	{
+		const DayBucket* bucket = &calendar->buckets[i];
+		int bin;
+
+		// the lots of a bucket share their date, so the first one gives the month of all of them
+		if (firstMonth != -1)
+			bin = expiryBucket(getDate(getElement(bucket->lots, 0))) - firstMonth;
+		else
+			bin = (bucket->day - from) / 7;
+
+		if (bin >= count)
+			break;
+
+		for (int j = 0; j < len(bucket->lots); j++)
+		{
+			bins[bin].lots++;
+			bins[bin].quantity += getQuantity(getElement(bucket->lots, j));
+		}
+	}
+
+	return 1;
+}
+
+
+//Tests
+
+
+void testCalendarBuckets()
+{
+	Calendar calendar;
+	DynamicArray* materials = createDynamicArray(2, &destroyMaterial);
+
+	assert(initCalendar(&calendar) == 1);
+
+	for (int i = 0; i < 40; i++)
+	{
+		Material* material = createMaterial("name", "supplier", i, createDate(1 + i % 20, 1, 2024));
+		apd(materials, material);
+		assert(addToCalendar(&calendar, material) == 1);
+	}
+
+	assert(calendar.size == 20);
+	for (int i = 1; i < calendar.size; i++)
+		assert(calendar.buckets[i - 1].day + 1 == calendar.buckets[i].day);
+
+	Date first = { 1, 1, 2024 };
+	int day = dayNumber(&first);
+
+	DynamicArray* sources = createDynamicArray(2, NULL);
+	assert(getCalendarRange(&calendar, day + 5, day + 8, sources) == 6);
+	assert(len(sources) == 3);
+	assert(countCalendarRange(&calendar, day - 100, day + 1) == 2);
+	assert(countCalendarRange(&calendar, day + 20, day + 100) == 0);
+	destroyDynamicArray(sources);
+
+	Material* material = getElement(materials, 3);
+	Material* other = createMaterial("other", "supplier", 1, createDate(4, 1, 2024));
+	assert(replaceInCalendar(&calendar, material, other) == 1);
+	assert(removeFromCalendar(&calendar, material) == -1);
+	assert(removeFromCalendar(&calendar, other) == 1);
+	assert(removeFromCalendar(&calendar, getElement(materials, 23)) == 1);
+	assert(calendar.size == 19);
+	assert(findDayBucket(&calendar, day + 3) == 3 && calendar.buckets[3].day == day + 4);
+
+	destroyMaterial(other);
+	freeCalendar(&calendar);
+	destroyDynamicArray(materials);
+}
+
+void testCalendarHistogram()
+{
+	Calendar calendar;
+	DynamicArray* materials = createDynamicArray(2, &destroyMaterial);
+	CalendarBin bins[3];
+
+	initCalendar(&calendar);
+
+	int days[] = { 30, 31, 1, 7, 8, 28, 1 };
+	int months[] = { 1, 1, 2, 2, 2, 2, 4 };
+	for (int i = 0; i < 7; i++)
+	{
+		Material* material = createMaterial("name", "supplier", i + 1, createDate(days[i], months[i], 2024));
+		apd(materials, material);
+		addToCalendar(&calendar, material);
+	}
+
+	Date first = { 31, 1, 2024 };
+	int day = dayNumber(&first);
+
+	assert(getCalendarHistogram(&calendar, day, -1, 3, bins) == 1);
+	assert(bins[0].lots == 2 && bins[0].quantity == 2 + 3);
+	assert(bins[1].lots == 2 && bins[1].quantity == 4 + 5);
+	assert(bins[2].lots == 0);
+
+	assert(getCalendarHistogram(&calendar, day, expiryBucket(&first), 3, bins) == 1);
+	assert(bins[0].lots == 1);
+	assert(bins[1].lots == 4 && bins[1].quantity == 3 + 4 + 5 + 6);
+	assert(bins[2].lots == 0);
+
+	assert(getCalendarHistogram(&calendar, day, -1, 0, bins) == -1);
+
+	freeCalendar(&calendar);
+	destroyDynamicArray(materials);
+}
+
+void testCalendar()
+{
+	testCalendarBuckets();
+	testCalendarHistogram();
+}
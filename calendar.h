@@ -0,0 +1,80 @@
+#pragma once
+
+#include "material.h"
+#include "dynamicArray.h"
+
+/*
+	The materials expiring on the same day.
+	day - the day number of the expiration date, see dayNumber
+	lots - the materials, in the order they were added; the calendar does not own them
+*/
+typedef struct DayBucket
+{
+	int day;
+	DynamicArray* lots;
+} DayBucket;
+
+/*
+	An index of materials by expiration day: one bucket per day that has materials, sorted by day,
+	so the materials expiring in a range of days are found with a binary search, without looking at the others.
+*/
+typedef struct Calendar
+{
+	int size, capacity;
+	DayBucket* buckets;
+} Calendar;
+
+/*
+	The materials of a period of a calendar histogram.
+*/
+typedef struct CalendarBin
+{
+	int lots;
+	double quantity;
+} CalendarBin;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initCalendar(Calendar* calendar);
+void freeCalendar(Calendar* calendar);
+
+/*
+	Add or remove a material in the bucket of its expiration day.
+	Return 1 on success, or -1 if the memory could not be allocated or the material is not in the calendar.
+*/
+int addToCalendar(Calendar* calendar, Material* material);
+int removeFromCalendar(Calendar* calendar, Material* material);
+
+/*
+	Replaces a material with another one that expires on the same day.
+	Returns 1 on success, or -1 if the material is not in the calendar.
+*/
+int replaceInCalendar(Calendar* calendar, Material* material, Material* newMaterial);
+
+/*
+	Gets the position of the first bucket of a day that is not before the given one, or size if there is none.
+*/
+int findDayBucket(const Calendar* calendar, int day);
+
+/*
+	Appends to sources the arrays of materials expiring in the days [from, to).
+	Returns the number of materials, or -1 if the memory could not be allocated.
+*/
+int getCalendarRange(const Calendar* calendar, int from, int to, DynamicArray* sources);
+
+/*
+	Counts the materials expiring in the days [from, to), visiting only the buckets of those days.
+*/
+int countCalendarRange(const Calendar* calendar, int from, int to);
+
+/*
+	Builds a histogram of the materials expiring from the day from on, in count periods: weeks of 7 days starting
+	with the day from, or, if firstMonth is not -1, calendar months starting with firstMonth, the month of the day from
+	(see expiryBucket). Only the buckets of the periods are visited.
+	Returns 1 on success, or -1 if the arguments are not valid.
+*/
+int getCalendarHistogram(const Calendar* calendar, int from, int firstMonth, int count, CalendarBin* bins);
+
+//Tests
+void testCalendar();
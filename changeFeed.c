@@ -0,0 +1,271 @@
+#include "changeFeed.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+#define CHANGE_FEED_MASK (CHANGE_FEED_SIZE - 1)
+
+int initChangeFeed(ChangeFeed* changeFeed)
+{
+	if (changeFeed == NULL)
+		return -1;
+
+	changeFeed->slots = (ChangeSlot*)malloc(sizeof(ChangeSlot) * CHANGE_FEED_SIZE);
+
+	if (changeFeed->slots == NULL)
+		return -1;
+
+	for (int i = 0; i < CHANGE_FEED_SIZE; i++)
+	{
+		atomic_init(&changeFeed->slots[i].seq, 0);
+		for (int w = 0; w < 4; w++)
+			atomic_init(&changeFeed->slots[i].words[w], 0);
+	}
+
+	atomic_init(&changeFeed->head, 1);
+	for (int c = 0; c < MAX_FEED_CONSUMERS; c++)
+		atomic_init(&changeFeed->cursors[c], 0);
+
+	return 1;
+}
+
+void freeChangeFeed(ChangeFeed* changeFeed)
+{
+	if (changeFeed == NULL)
+		return;
+
+	free(changeFeed->slots);
+	changeFeed->slots = NULL;
+}
+
+uint64_t publishChange(ChangeFeed* changeFeed, const ChangeRecord* record)
+{
+	uint64_t seq = atomic_load_explicit(&changeFeed->head, memory_order_relaxed);
+	ChangeSlot* slot = &changeFeed->slots[seq & CHANGE_FEED_MASK];
+
+	uint64_t quantity;
+	memcpy(&quantity, &record->quantity, sizeof(quantity));
+
+	// the slot is marked as being written before its words change, so a reader of the previous record notices
+	atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	atomic_store_explicit(&slot->words[0], (uint64_t)record->version, memory_order_relaxed);
+	atomic_store_explicit(&slot->words[1], (uint64_t)record->type | ((uint64_t)(uint32_t)record->dateKey << 32), memory_order_relaxed);
+	atomic_store_explicit(&slot->words[2], quantity, memory_order_relaxed);
+	atomic_store_explicit(&slot->words[3], (uint64_t)record->nameHash | ((uint64_t)record->supplierHash << 32), memory_order_relaxed);
+
+	atomic_store_explicit(&slot->seq, seq, memory_order_release);
+	atomic_store_explicit(&changeFeed->head, seq + 1, memory_order_release);
+
+	return seq;
+}
+
+int attachConsumer(ChangeFeed* changeFeed)
+{
+	if (changeFeed == NULL)
+		return -1;
+
+	for (int c = 0; c < MAX_FEED_CONSUMERS; c++)
+	{
+		uint64_t expected = 0;
+		uint64_t head = atomic_load_explicit(&changeFeed->head, memory_order_acquire);
+
+		if (atomic_compare_exchange_strong(&changeFeed->cursors[c], &expected, head))
+			return c;
+	}
+
+	return -1;
+}
+
+void detachConsumer(ChangeFeed* changeFeed, int consumer)
+{
+	if (changeFeed == NULL || consumer < 0 || consumer >= MAX_FEED_CONSUMERS)
+		return;
+
+	atomic_store_explicit(&changeFeed->cursors[consumer], 0, memory_order_release);
+}
+
+/*
+	Copies the record of the given sequence out of its slot.
+	Returns 1 on success, or 0 if the slot was overwritten by a newer record before or while it was copied.
+*/
+int copyChange(ChangeSlot* slot, uint64_t seq, ChangeRecord* record)
+{
+	if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq)
+		return 0;
+
+	uint64_t words[4];
+	for (int w = 0; w < 4; w++)
+		words[w] = atomic_load_explicit(&slot->words[w], memory_order_relaxed);
+
+	atomic_thread_fence(memory_order_acquire);
+	if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq)
+		return 0;
+
+	if (record != NULL)
+	{
+		record->seq = seq;
+		record->version = (int64_t)words[0];
+		record->type = (ChangeType)(uint32_t)words[1];
+		record->dateKey = (int32_t)(uint32_t)(words[1] >> 32);
+		memcpy(&record->quantity, &words[2], sizeof(record->quantity));
+		record->nameHash = (uint32_t)words[3];
+		record->supplierHash = (uint32_t)(words[3] >> 32);
+	}
+
+	return 1;
+}
+
+int readChange(ChangeFeed* changeFeed, int consumer, ChangeRecord* record, uint64_t* lost)
+{
+	if (changeFeed == NULL || consumer < 0 || consumer >= MAX_FEED_CONSUMERS)
+		return -1;
+
+	uint64_t cursor = atomic_load_explicit(&changeFeed->cursors[consumer], memory_order_relaxed);
+	uint64_t missed = 0;
+
+	if (cursor == 0)
+		return -1;
+
+	while (1)
+	{
+		uint64_t head = atomic_load_explicit(&changeFeed->head, memory_order_acquire);
+
+		if (cursor >= head)
+		{
+			atomic_store_explicit(&changeFeed->cursors[consumer], cursor, memory_order_release);
+			if (lost != NULL)
+				*lost = missed;
+			return 0;
+		}
+
+		// the records older than the last CHANGE_FEED_SIZE ones were already overwritten
+		if (head - cursor > CHANGE_FEED_SIZE)
+		{
+			missed += head - CHANGE_FEED_SIZE - cursor;
+			cursor = head - CHANGE_FEED_SIZE;
+		}
+
+		if (copyChange(&changeFeed->slots[cursor & CHANGE_FEED_MASK], cursor, record) == 1)
+			break;
+
+		// the producer lapped the consumer while it was reading
+		missed++;
+		cursor++;
+	}
+
+	atomic_store_explicit(&changeFeed->cursors[consumer], cursor + 1, memory_order_release);
+	if (lost != NULL)
+		*lost = missed;
+
+	return 1;
+}
+
+uint64_t getConsumerLag(ChangeFeed* changeFeed, int consumer)
+{
+	if (changeFeed == NULL || consumer < 0 || consumer >= MAX_FEED_CONSUMERS)
+		return 0;
+
+	uint64_t cursor = atomic_load_explicit(&changeFeed->cursors[consumer], memory_order_acquire);
+
+	if (cursor == 0)
+		return 0;
+
+	return atomic_load_explicit(&changeFeed->head, memory_order_acquire) - cursor;
+}
+
+
+//Tests
+
+
+void testChangeFeedOrder()
+{
+	ChangeFeed changeFeed;
+	ChangeRecord record = { 0, 7, CHANGE_UPDATE, 20300101, 2.5, 11, 22 };
+	ChangeRecord read;
+	uint64_t lost;
+
+	assert(initChangeFeed(&changeFeed) == 1);
+	assert(readChange(&changeFeed, 0, &read, &lost) == -1);
+
+	publishChange(&changeFeed, &record);
+
+	// a consumer only sees the changes published after it was attached
+	int consumer = attachConsumer(&changeFeed);
+	assert(consumer == 0);
+	assert(readChange(&changeFeed, consumer, &read, &lost) == 0 && lost == 0);
+
+	for (int i = 0; i < 3; i++)
+	{
+		record.version = i;
+		assert(publishChange(&changeFeed, &record) == (uint64_t)i + 2);
+	}
+	assert(getConsumerLag(&changeFeed, consumer) == 3);
+
+	for (int i = 0; i < 3; i++)
+	{
+		assert(readChange(&changeFeed, consumer, &read, &lost) == 1 && lost == 0);
+		assert(read.seq == (uint64_t)i + 2 && read.version == i);
+		assert(read.type == CHANGE_UPDATE && read.dateKey == 20300101 && read.quantity == 2.5);
+		assert(read.nameHash == 11 && read.supplierHash == 22);
+	}
+	assert(readChange(&changeFeed, consumer, &read, &lost) == 0);
+	assert(getConsumerLag(&changeFeed, consumer) == 0);
+
+	detachConsumer(&changeFeed, consumer);
+	assert(readChange(&changeFeed, consumer, &read, &lost) == -1);
+
+	freeChangeFeed(&changeFeed);
+}
+
+void testChangeFeedOverflow()
+{
+	ChangeFeed changeFeed;
+	ChangeRecord record = { 0, 0, CHANGE_ADD, 0, 1, 0, 0 };
+	ChangeRecord read;
+	uint64_t lost;
+
+	initChangeFeed(&changeFeed);
+
+	int slow = attachConsumer(&changeFeed);
+	int fast = attachConsumer(&changeFeed);
+	assert(slow == 0 && fast == 1);
+
+	for (int i = 0; i < CHANGE_FEED_SIZE + 10; i++)
+	{
+		record.version = i;
+		publishChange(&changeFeed, &record);
+		if (i < 5)
+			assert(readChange(&changeFeed, fast, &read, &lost) == 1 && read.version == i);
+	}
+
+	// the slow consumer lost the first 10 changes, the fast one the 5 after those it read
+	assert(getConsumerLag(&changeFeed, slow) == CHANGE_FEED_SIZE + 10);
+	assert(readChange(&changeFeed, slow, &read, &lost) == 1);
+	assert(lost == 10 && read.version == 10);
+	assert(readChange(&changeFeed, fast, &read, &lost) == 1);
+	assert(lost == 5 && read.version == 10);
+
+	int count = 1;
+	while (readChange(&changeFeed, slow, &read, &lost) == 1)
+	{
+		assert(lost == 0);
+		count++;
+	}
+	assert(count == CHANGE_FEED_SIZE);
+
+	for (int c = 2; c < MAX_FEED_CONSUMERS; c++)
+		assert(attachConsumer(&changeFeed) == c);
+	assert(attachConsumer(&changeFeed) == -1);
+
+	freeChangeFeed(&changeFeed);
+}
+
+void testChangeFeed()
+{
+	testChangeFeedOrder();
+	testChangeFeedOverflow();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __linux__
+#include <stdatomic.h>
+#else
+/*
+	The threads are only started on Linux, elsewhere the feed has a single thread, so its atomic operations are plain
+	accesses and the console build does not need the C11 atomics of the compiler.
+*/
+#define _Atomic volatile
+typedef volatile int atomic_int;
+
+#define memory_order_relaxed 0
+#define memory_order_acquire 0
+#define memory_order_release 0
+
+#define atomic_init(object, value) (*(object) = (value))
+#define atomic_load(object) (*(object))
+#define atomic_store(object, value) (*(object) = (value))
+#define atomic_load_explicit(object, order) (*(object))
+#define atomic_store_explicit(object, value, order) (*(object) = (value))
+#define atomic_thread_fence(order) ((void)0)
+#define atomic_compare_exchange_strong(object, expected, desired) \
+	(*(object) == *(expected) ? (*(object) = (desired), 1) : (*(expected) = *(object), 0))
+#endif
+
+#define MAX_FEED_CONSUMERS 8
+#define CHANGE_FEED_SIZE 4096
+
+typedef enum ChangeType
+{
+	CHANGE_ADD,
+	CHANGE_UPDATE,
+	CHANGE_REMOVE,
+	CHANGE_CONSUME,
+	CHANGE_PRODUCE,
+	CHANGE_UNDO,
+	CHANGE_REDO,
+	CHANGE_BEGIN,
+	CHANGE_COMMIT,
+	CHANGE_ROLLBACK,
+	CHANGE_DIFF
+} ChangeType;
+
+/*
+	A modification of the repository, without its strings: the name and the supplier are given by their hashes
+	(see hashString), which is enough to tell which keys changed; the details can be read from the repository.
+	seq - the position of the change in the feed, starting with 1
+	version - the version of the repository after the change
+	dateKey - the expiration date of the material (see dateKey), or 0 if the change has none
+	quantity - the quantity of the material, of the consumption, the number of units produced, or the number of
+		buckets replaced by a diff
+*/
+typedef struct ChangeRecord
+{
+	uint64_t seq;
+	int64_t version;
+	ChangeType type;
+	int32_t dateKey;
+	double quantity;
+	uint32_t nameHash, supplierHash;
+} ChangeRecord;
+
+/*
+	A record stored in a slot of the ring, as words that are read and written atomically.
+	seq - the sequence of the record the words belong to, 0 while the slot is empty or being written
+*/
+typedef struct ChangeSlot
+{
+	_Atomic uint64_t seq;
+	_Atomic uint64_t words[4];
+} ChangeSlot;
+
+/*
+	A lock-free ring buffer of changes with a single producer and up to MAX_FEED_CONSUMERS consumers, each with its
+	own cursor. The producer never waits for the consumers: a consumer that falls more than CHANGE_FEED_SIZE changes
+	behind loses the oldest ones, and is told how many it lost when it reads again.
+	A reader validates every record against the sequence of its slot before and after copying it,
+	so a record overwritten while it was being read is detected and counted as lost.
+	head - the sequence of the next change to be published
+	cursors - the sequence of the next change every consumer reads, or 0 if the consumer is not attached
+*/
+typedef struct ChangeFeed
+{
+	_Atomic uint64_t head;
+	_Atomic uint64_t cursors[MAX_FEED_CONSUMERS];
+	ChangeSlot* slots;
+} ChangeFeed;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initChangeFeed(ChangeFeed* changeFeed);
+void freeChangeFeed(ChangeFeed* changeFeed);
+
+/*
+	Publishes a change. Must only be called by the producer.
+	record - the change; its seq is ignored
+	Returns the sequence given to the change.
+*/
+uint64_t publishChange(ChangeFeed* changeFeed, const ChangeRecord* record);
+
+/*
+	Attaches a consumer that reads the changes published from now on.
+	Returns the id of the consumer, or -1 if MAX_FEED_CONSUMERS consumers are already attached.
+*/
+int attachConsumer(ChangeFeed* changeFeed);
+void detachConsumer(ChangeFeed* changeFeed, int consumer);
+
+/*
+	Reads the next change for a consumer. Each consumer must be read by a single thread.
+	lost - receives the number of changes the consumer missed because it fell behind, 0 if it missed none
+	Returns 1 if a change was read, 0 if there is no new change, or -1 if the consumer is not attached.
+*/
+int readChange(ChangeFeed* changeFeed, int consumer, ChangeRecord* record, uint64_t* lost);
+
+/*
+	Gets the number of published changes the consumer has not read yet, which may exceed CHANGE_FEED_SIZE
+	if the consumer fell behind, or 0 if it is not attached.
+*/
+uint64_t getConsumerLag(ChangeFeed* changeFeed, int consumer);
+
+//Tests
+void testChangeFeed();
@@ -97,6 +97,54 @@ Date* copyDate(Date* date)
 	return dateCopy;
 }
 
+int dateKey(const Date* date)
+{
+	if (date == NULL)
+		return -1;
+
+	return (date->year << 9) | (date->month << 5) | date->day;
+}
+
+int todayKey()
+{
+	// localtime may read the time zone settings on every call, so the key is only recomputed when the second changes
+	static time_t cachedTime = -1;
+	static int cachedKey;
+
+	time_t t = time(NULL);
+	if (t == cachedTime)
+		return cachedKey;
+
+	struct tm time = *localtime(&t);
+	Date today = { time.tm_mday, time.tm_mon + 1, time.tm_year + 1900 };
+
+	cachedTime = t;
+	cachedKey = dateKey(&today);
+	return cachedKey;
+}
+
+int dayNumber(const Date* date)
+{
+	if (date == NULL)
+		return -1;
+
+	// the years start in March, so the leap day is the last day of a year
+	int year = date->month <= 2 ? date->year - 1 : date->year;
+	int era = (year >= 0 ? year : year - 399) / 400;
+	int yearOfEra = year - era * 400;
+	int dayOfYear = (153 * (date->month + (date->month > 2 ? -3 : 9)) + 2) / 5 + date->day - 1;
+	int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+	return era * 146097 + dayOfEra;
+}
+
+int keyDayNumber(int key)
+{
+	Date date = { key & 0x1F, (key >> 5) & 0xF, key >> 9 };
+
+	return dayNumber(&date);
+}
+
 
 //Tests
 
@@ -176,6 +224,30 @@ void testCopyDate()
 	destroyDate(copyOfDate);
 }
 
+void testDateKey()
+{
+	Date* testDate1 = createDate(31, 1, 2022);
+	Date* testDate2 = createDate(1, 2, 2022);
+	Date* testDate3 = createDate(1, 1, 2023);
+
+	assert(dateKey(NULL) == -1);
+	assert(dateKey(testDate1) < dateKey(testDate2));
+	assert(dateKey(testDate2) < dateKey(testDate3));
+	assert(isExpired(testDate1) == (dateKey(testDate1) < todayKey()));
+
+	Date day1 = { 28, 2, 2024 }, day2 = { 1, 3, 2024 }, day3 = { 1, 3, 2023 }, day4 = { 1, 1, 1970 }, day5 = { 31, 12, 1969 };
+	assert(dayNumber(NULL) == -1);
+	assert(dayNumber(&day2) - dayNumber(&day1) == 2);
+	assert(dayNumber(&day2) - dayNumber(&day3) == 366);
+	assert(dayNumber(&day4) - dayNumber(&day5) == 1);
+	assert(dayNumber(&day4) == 719468);
+	assert(keyDayNumber(dateKey(&day1)) == dayNumber(&day1));
+
+	destroyDate(testDate1);
+	destroyDate(testDate2);
+	destroyDate(testDate3);
+}
+
 void testDate()
 {
 	testCreateDate();
@@ -183,4 +255,5 @@ void testDate()
 	testEqualDates();
 	testIsExpired();
 	testCopyDate();
+	testDateKey();
 }
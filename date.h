@@ -20,5 +20,28 @@ int equalDates(const Date* x, const Date* y);
 int isExpired(const Date* date);
 Date* copyDate(Date* date);
 
+/*
+	Packs the date into an integer that has the same order as the dates.
+	Returns the key, or -1 if the pointer is NULL.
+*/
+int dateKey(const Date* date);
+
+/*
+	Returns the key of the current local date, see dateKey.
+*/
+int todayKey();
+
+/*
+	Counts the days from 1 March of the year 0 to the date, in the proleptic Gregorian calendar,
+	so consecutive dates have consecutive numbers.
+	Returns the day number, or -1 if the pointer is NULL.
+*/
+int dayNumber(const Date* date);
+
+/*
+	Returns the day number of the date packed in a key, see dateKey.
+*/
+int keyDayNumber(int key);
+
 //Tests
 void testDate();
@@ -51,17 +51,50 @@ void* getElement(DynamicArray* dArray, int position)
 	return dArray->data[position];
 }
 
+int reserve(DynamicArray* dArray, int capacity)
+{
+	if (dArray == NULL)
+		return -1;
+
+	if (capacity <= dArray->capacity)
+		return 1;
+
+	void** data = (void**)realloc(dArray->data, sizeof(void*) * capacity);
+
+	if (data == NULL)
+		return -1;
+
+	dArray->data = data;
+	dArray->capacity = capacity;
+
+	return 1;
+}
+
 int resize(DynamicArray* dArray)
 {
-	dArray->capacity *= 2;
-	void** data = (void**)malloc(sizeof(void*) * dArray->capacity);
+	int capacity = dArray->capacity * 2;
+	if (capacity < 2)
+		capacity = 2;
+
+	return reserve(dArray, capacity);
+}
+
+int shrinkToFit(DynamicArray* dArray)
+{
+	if (dArray == NULL)
+		return -1;
+
+	int capacity = dArray->size;
+	if (capacity < 1)
+		capacity = 1;
+
+	void** data = (void**)realloc(dArray->data, sizeof(void*) * capacity);
 
 	if (data == NULL)
 		return -1;
 
-	memcpy(data, dArray->data, sizeof(void*) * dArray->size);
-	free(dArray->data);
 	dArray->data = data;
+	dArray->capacity = capacity;
 
 	return 1;
 }
@@ -83,6 +116,32 @@ int apd(DynamicArray* dArray, void* element)
 	return 1;
 }
 
+int apdMany(DynamicArray* dArray, void** elements, int count)
+{
+	if (dArray == NULL || elements == NULL || count < 0)
+		return -1;
+
+	for (int i = 0; i < count; i++)
+		if (elements[i] == NULL)
+			return -1;
+
+	if (dArray->size + count > dArray->capacity)
+	{
+		int capacity = dArray->capacity * 2;
+		if (capacity < dArray->size + count)
+			capacity = dArray->size + count;
+
+		int status = reserve(dArray, capacity);
+		if (status == -1)
+			return -1;
+	}
+
+	memcpy(dArray->data + dArray->size, elements, sizeof(void*) * count);
+	dArray->size += count;
+
+	return 1;
+}
+
 int del(DynamicArray* dArray, int position)
 {
 	if (dArray == NULL)
@@ -92,15 +151,58 @@ int del(DynamicArray* dArray, int position)
 		return -1;
 
 	void* aux = dArray->data[position];
-	for (int i = position; i < dArray->size - 1; i++)
-		dArray->data[i] = dArray->data[i + 1];
+	memmove(dArray->data + position, dArray->data + position + 1, sizeof(void*) * (dArray->size - position - 1));
 
 	dArray->size--;
-	dArray->destroyFunction(aux);
+	if (dArray->destroyFunction != NULL)
+		dArray->destroyFunction(aux);
 
 	return 1;
 }
 
+int delRange(DynamicArray* dArray, int start, int end)
+{
+	if (dArray == NULL)
+		return -1;
+
+	if (start < 0 || end > dArray->size || start > end)
+		return -1;
+
+	if (dArray->destroyFunction != NULL)
+		for (int i = start; i < end; i++)
+			dArray->destroyFunction(dArray->data[i]);
+
+	memmove(dArray->data + start, dArray->data + end, sizeof(void*) * (dArray->size - end));
+	dArray->size -= end - start;
+
+	return 1;
+}
+
+int removeIf(DynamicArray* dArray, int (*predicate)(void*, void*), void* context)
+{
+	if (dArray == NULL || predicate == NULL)
+		return -1;
+
+	int kept = 0;
+	for (int i = 0; i < dArray->size; i++)
+	{
+		void* element = dArray->data[i];
+
+		if (predicate(element, context) == 1)
+		{
+			if (dArray->destroyFunction != NULL)
+				dArray->destroyFunction(element);
+		}
+		else
+			dArray->data[kept++] = element;
+	}
+
+	int removed = dArray->size - kept;
+	dArray->size = kept;
+
+	return removed;
+}
+
 int upd(DynamicArray* dArray, int position, void* newValues)
 {
 	if (dArray == NULL || newValues == NULL)
@@ -111,7 +213,8 @@ int upd(DynamicArray* dArray, int position, void* newValues)
 
 	void* aux = dArray->data[position];
 	dArray->data[position] = newValues;
-	dArray->destroyFunction(aux);
+	if (dArray->destroyFunction != NULL)
+		dArray->destroyFunction(aux);
 
 	return 1;
 }
@@ -263,6 +366,100 @@ void testSwap()
 	destroyDynamicArray(testArray);
 }
 
+void testReserveShrink()
+{
+	DynamicArray* testArray = createDynamicArray(1, &free);
+
+	assert(reserve(NULL, 10) == -1);
+	assert(reserve(testArray, 10) == 1);
+	assert(testArray->capacity == 10);
+	assert(reserve(testArray, 5) == 1);
+	assert(testArray->capacity == 10);
+
+	int* element = (int*)malloc(sizeof(int));
+	apd(testArray, element);
+
+	assert(shrinkToFit(testArray) == 1);
+	assert(testArray->capacity == 1);
+	assert(getElement(testArray, 0) == element);
+
+	destroyDynamicArray(testArray);
+}
+
+void testApdMany()
+{
+	DynamicArray* testArray = createDynamicArray(1, &free);
+	void* elements[5];
+
+	for (int i = 0; i < 5; i++)
+	{
+		elements[i] = malloc(sizeof(int));
+		*(int*)elements[i] = i;
+	}
+
+	assert(apdMany(NULL, elements, 5) == -1);
+	assert(apdMany(testArray, elements, 5) == 1);
+	assert(len(testArray) == 5);
+	assert(testArray->capacity == 5);
+
+	for (int i = 0; i < 5; i++)
+		assert(getElement(testArray, i) == elements[i]);
+
+	destroyDynamicArray(testArray);
+}
+
+void testDelRange()
+{
+	DynamicArray* testArray = createDynamicArray(2, &free);
+
+	for (int i = 0; i < 6; i++)
+	{
+		int* element = (int*)malloc(sizeof(int));
+		*element = i;
+		apd(testArray, element);
+	}
+
+	assert(delRange(testArray, 4, 7) == -1);
+	assert(delRange(testArray, 3, 2) == -1);
+	assert(delRange(testArray, 1, 4) == 1);
+	assert(len(testArray) == 3);
+	assert(*(int*)getElement(testArray, 0) == 0);
+	assert(*(int*)getElement(testArray, 1) == 4);
+	assert(*(int*)getElement(testArray, 2) == 5);
+
+	assert(delRange(testArray, 0, len(testArray)) == 1);
+	assert(len(testArray) == 0);
+
+	destroyDynamicArray(testArray);
+}
+
+int isEven(int* x, void* context)
+{
+	(void)context;
+	return *x % 2 == 0;
+}
+
+void testRemoveIf()
+{
+	DynamicArray* testArray = createDynamicArray(2, &free);
+
+	for (int i = 0; i < 7; i++)
+	{
+		int* element = (int*)malloc(sizeof(int));
+		*element = i;
+		apd(testArray, element);
+	}
+
+	assert(removeIf(testArray, NULL, NULL) == -1);
+	assert(removeIf(testArray, &isEven, NULL) == 4);
+	assert(len(testArray) == 3);
+	assert(*(int*)getElement(testArray, 0) == 1);
+	assert(*(int*)getElement(testArray, 1) == 3);
+	assert(*(int*)getElement(testArray, 2) == 5);
+
+	destroyDynamicArray(testArray);
+}
+
 int compareInts(int* x, int* y)
 {
 	if (x == NULL || y == NULL)
@@ -305,6 +502,10 @@ void testDynamicArray()
 	testDynamicArrayApd();
 	testDynamicArrayUpd();
 	testDynamicArrayDel();
+	testReserveShrink();
+	testApdMany();
+	testDelRange();
+	testRemoveIf();
 	testSwap();
 	testSort();
 }
@@ -45,6 +45,44 @@ int apd(DynamicArray* dArray, void* element);
 int upd(DynamicArray* dArray, int position, void* newValues);
 int del(DynamicArray* dArray, int position);
 
+/*
+	Makes sure the dynamic array can hold at least the given number of elements without reallocating.
+	dArray - pointer to the dynamic array
+	capacity - the minimum capacity
+	Returns 1 on success, or -1 if the pointer is NULL or the memory could not be allocated.
+*/
+int reserve(DynamicArray* dArray, int capacity);
+
+/*
+	Releases the unused capacity of the dynamic array.
+	dArray - pointer to the dynamic array
+	Returns 1 on success, or -1 if the pointer is NULL or the memory could not be reallocated.
+*/
+int shrinkToFit(DynamicArray* dArray);
+
+/*
+	Appends count elements at the end of the dynamic array, reallocating at most once.
+	dArray - pointer to the dynamic array
+	elements - the pointers to be appended, none of them can be NULL
+	Returns 1 on success, or -1 if the arguments are not valid or the memory could not be allocated.
+*/
+int apdMany(DynamicArray* dArray, void** elements, int count);
+
+/*
+	Deletes the elements from the positions [start, end) and shifts the tail only once.
+	dArray - pointer to the dynamic array
+	Returns 1 on success, or -1 if the range is not valid.
+*/
+int delRange(DynamicArray* dArray, int start, int end);
+
+/*
+	Deletes every element for which the predicate returns 1, compacting the dynamic array in a single pass.
+	dArray - pointer to the dynamic array
+	predicate - called with each element and the given context
+	Returns the number of deleted elements, or -1 if the arguments are not valid.
+*/
+int removeIf(DynamicArray* dArray, int (*predicate)(void*, void*), void* context);
+
 int swap(DynamicArray* dArray, int x, int y);
 int sort(DynamicArray* dArray, int(compareFunction(void*, void*)));
 
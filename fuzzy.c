@@ -0,0 +1,155 @@
+#include "fuzzy.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+
+static inline unsigned char foldCase(char character)
+{
+	return (unsigned char)tolower((unsigned char)character);
+}
+
+int dynamicEditDistance(const char* pattern, int m, const char* text, int n, int maxDistance)
+{
+	int* row = (int*)malloc(sizeof(int) * (m + 1));
+
+	if (row == NULL)
+		return maxDistance + 1;
+
+	for (int i = 0; i <= m; i++)
+		row[i] = i;
+
+	for (int j = 1; j <= n; j++)
+	{
+		int diagonal = row[0];
+		int best = row[0] = j;
+
+		for (int i = 1; i <= m; i++)
+		{
+			int value = diagonal + (foldCase(pattern[i - 1]) != foldCase(text[j - 1]));
+			if (row[i] + 1 < value)
+				value = row[i] + 1;
+			if (row[i - 1] + 1 < value)
+				value = row[i - 1] + 1;
+
+			diagonal = row[i];
+			row[i] = value;
+			if (value < best)
+				best = value;
+		}
+
+		// every cell of the row is above the bound, so the distance is too
+		if (best > maxDistance)
+		{
+			free(row);
+			return maxDistance + 1;
+		}
+	}
+
+	int distance = row[m];
+	free(row);
+	return distance > maxDistance ? maxDistance + 1 : distance;
+}
+
+int editDistance(const char* pattern, const char* text, int maxDistance)
+{
+	int m = (int)strlen(pattern);
+	int n = (int)strlen(text);
+
+	if (abs(m - n) > maxDistance)
+		return maxDistance + 1;
+	if (m == 0)
+		return n;
+	if (m > 64)
+		return dynamicEditDistance(pattern, m, text, n, maxDistance);
+
+	// peq[c] has the bit i set if the character i of the pattern is c
+	uint64_t peq[256] = { 0 };
+	for (int i = 0; i < m; i++)
+		peq[foldCase(pattern[i])] |= (uint64_t)1 << i;
+
+	uint64_t last = (uint64_t)1 << (m - 1);
+	uint64_t pv = m == 64 ? ~(uint64_t)0 : (((uint64_t)1 << m) - 1);
+	uint64_t mv = 0;
+	int score = m;
+
+	for (int j = 0; j < n; j++)
+	{
+		uint64_t eq = peq[foldCase(text[j])];
+		uint64_t xv = eq | mv;
+		uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+		uint64_t ph = mv | ~(xh | pv);
+		uint64_t mh = pv & xh;
+
+		if (ph & last)
+			score++;
+		else if (mh & last)
+			score--;
+
+		// the first row of the matrix grows by one at every column
+		ph = (ph << 1) | 1;
+		mh <<= 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+
+		// the score drops by at most one per remaining column
+		if (score - (n - j - 1) > maxDistance)
+			return maxDistance + 1;
+	}
+
+	return score > maxDistance ? maxDistance + 1 : score;
+}
+
+
+//Tests
+
+
+void testEditDistance()
+{
+	assert(editDistance("Wheat flour", "Wheat Flour", 2) == 0);
+	assert(editDistance("Wheat flour", "Wheat flours", 2) == 1);
+	assert(editDistance("Wheat flour", "Whaet flour", 2) == 2);
+	assert(editDistance("kitten", "sitting", 5) == 3);
+	assert(editDistance("kitten", "sitting", 2) == 3);
+	assert(editDistance("sugar", "Salt", 10) == 4);
+	assert(editDistance("", "abc", 5) == 3);
+	assert(editDistance("abc", "", 5) == 3);
+	assert(editDistance("abc", "abcdefgh", 2) == 3);
+}
+
+void testEditDistanceLong()
+{
+	char pattern[101], text[101];
+
+	for (int i = 0; i < 100; i++)
+		pattern[i] = text[i] = (char)('a' + i % 26);
+	pattern[100] = text[100] = 0;
+
+	text[10] = 'X';
+	text[90] = 'Y';
+	assert(editDistance(pattern, text, 5) == 2);
+	assert(editDistance(pattern, text, 1) == 2);
+
+	// the word-sized pattern agrees with the dynamic programming on random strings
+	srand(11);
+	for (int t = 0; t < 200; t++)
+	{
+		int m = 1 + rand() % 64, n = rand() % 70;
+		for (int i = 0; i < m; i++)
+			pattern[i] = (char)('a' + rand() % 3);
+		for (int i = 0; i < n; i++)
+			text[i] = (char)('a' + rand() % 3);
+		pattern[m] = text[n] = 0;
+
+		assert(editDistance(pattern, text, 100) == dynamicEditDistance(pattern, m, text, n, 100));
+	}
+}
+
+void testFuzzy()
+{
+	testEditDistance();
+	testEditDistanceLong();
+}
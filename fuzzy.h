@@ -0,0 +1,13 @@
+#pragma once
+
+/*
+	Computes the Levenshtein distance between two strings, ignoring the case of the letters.
+	Patterns of at most 64 characters use the bit-parallel algorithm of Myers, one machine word per text character;
+	longer patterns fall back to the dynamic programming algorithm.
+	maxDistance - the computation stops as soon as the distance is known to exceed it
+	Returns the distance, or maxDistance + 1 if it is larger than maxDistance.
+*/
+int editDistance(const char* pattern, const char* text, int maxDistance);
+
+//Tests
+void testFuzzy();
@@ -0,0 +1,321 @@
+#include "hashMap.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+
+
+uint32_t hashString(const char* key)
+{
+	uint32_t hash = 2166136261u;
+
+	for (const unsigned char* c = (const unsigned char*)key; *c != 0; c++)
+	{
+		hash ^= *c;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+HashMap* createHashMap(int capacity, void (*destroyFunction)(void*))
+{
+	HashMap* hashMap = (HashMap*)malloc(sizeof(HashMap));
+
+	if (hashMap == NULL)
+		return NULL;
+
+	// the capacity is kept a power of two, at most half full
+	int slots = 8;
+	while (slots < 2 * capacity)
+		slots *= 2;
+
+	hashMap->entries = (HashEntry*)calloc(slots, sizeof(HashEntry));
+
+	if (hashMap->entries == NULL)
+	{
+		free(hashMap);
+		return NULL;
+	}
+
+	hashMap->size = 0;
+	hashMap->capacity = slots;
+	hashMap->destroyFunction = destroyFunction;
+
+	return hashMap;
+}
+
+void destroyHashMap(HashMap* hashMap)
+{
+	if (hashMap == NULL)
+		return;
+
+	for (int i = 0; i < hashMap->capacity; i++)
+	{
+		HashEntry* entry = &hashMap->entries[i];
+		if (entry->key == NULL)
+			continue;
+
+		free(entry->key);
+		if (hashMap->destroyFunction != NULL)
+			hashMap->destroyFunction(entry->value);
+	}
+
+	free(hashMap->entries);
+	free(hashMap);
+}
+
+int mapSize(HashMap* hashMap)
+{
+	if (hashMap == NULL)
+		return -1;
+
+	return hashMap->size;
+}
+
+int findSlot(HashMap* hashMap, const char* key, uint32_t hash)
+{
+	int mask = hashMap->capacity - 1;
+	int slot = (int)(hash & mask);
+
+	while (hashMap->entries[slot].key != NULL)
+	{
+		HashEntry* entry = &hashMap->entries[slot];
+		if (entry->hash == hash && strcmp(entry->key, key) == 0)
+			return slot;
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+int growHashMap(HashMap* hashMap)
+{
+	int capacity = hashMap->capacity * 2;
+	HashEntry* entries = (HashEntry*)calloc(capacity, sizeof(HashEntry));
+
+	if (entries == NULL)
+		return -1;
+
+	for (int i = 0; i < hashMap->capacity; i++)
+	{
+		HashEntry* entry = &hashMap->entries[i];
+		if (entry->key == NULL)
+			continue;
+
+		int slot = (int)(entry->hash & (capacity - 1));
+		while (entries[slot].key != NULL)
+			slot = (slot + 1) & (capacity - 1);
+		entries[slot] = *entry;
+	}
+
+	free(hashMap->entries);
+	hashMap->entries = entries;
+	hashMap->capacity = capacity;
+
+	return 1;
+}
+
+void* getValue(HashMap* hashMap, const char* key)
+{
+	if (hashMap == NULL || key == NULL)
+		return NULL;
+
+	int slot = findSlot(hashMap, key, hashString(key));
+
+	return hashMap->entries[slot].value;
+}
+
+int putValue(HashMap* hashMap, const char* key, void* value)
+{
+	if (hashMap == NULL || key == NULL)
+		return -1;
+
+	uint32_t hash = hashString(key);
+	int slot = findSlot(hashMap, key, hash);
+	HashEntry* entry = &hashMap->entries[slot];
+
+	if (entry->key != NULL)
+	{
+		if (hashMap->destroyFunction != NULL && entry->value != value)
+			hashMap->destroyFunction(entry->value);
+		entry->value = value;
+		return 1;
+	}
+
+	if (2 * (hashMap->size + 1) > hashMap->capacity)
+	{
+		if (growHashMap(hashMap) == -1)
+			return -1;
+		slot = findSlot(hashMap, key, hash);
+		entry = &hashMap->entries[slot];
+	}
+
+	entry->key = (char*)malloc(sizeof(char) * (strlen(key) + 1));
+
+	if (entry->key == NULL)
+		return -1;
+
+	strcpy(entry->key, key);
+	entry->hash = hash;
+	entry->value = value;
+	hashMap->size++;
+
+	return 1;
+}
+
+int removeValue(HashMap* hashMap, const char* key)
+{
+	if (hashMap == NULL || key == NULL)
+		return -1;
+
+	int mask = hashMap->capacity - 1;
+	int slot = findSlot(hashMap, key, hashString(key));
+	HashEntry* entry = &hashMap->entries[slot];
+
+	if (entry->key == NULL)
+		return -1;
+
+	free(entry->key);
+	if (hashMap->destroyFunction != NULL)
+		hashMap->destroyFunction(entry->value);
+	entry->key = NULL;
+	entry->value = NULL;
+	hashMap->size--;
+
+	// the entries following the removed one are shifted back, so no lookup chain is broken
+	int hole = slot;
+	int next = (slot + 1) & mask;
+	while (hashMap->entries[next].key != NULL)
+	{
+		int home = (int)(hashMap->entries[next].hash & mask);
+		if (((next - home) & mask) >= ((next - hole) & mask))
+		{
+			hashMap->entries[hole] = hashMap->entries[next];
+			hashMap->entries[next].key = NULL;
+			hashMap->entries[next].value = NULL;
+			hole = next;
+		}
+		next = (next + 1) & mask;
+	}
+
+	return 1;
+}
+
+void clearHashMap(HashMap* hashMap)
+{
+	if (hashMap == NULL || hashMap->size == 0)
+		return;
+
+	for (int i = 0; i < hashMap->capacity; i++)
+	{
+		HashEntry* entry = &hashMap->entries[i];
+		if (entry->key == NULL)
+			continue;
+
+		free(entry->key);
+		if (hashMap->destroyFunction != NULL)
+			hashMap->destroyFunction(entry->value);
+		entry->key = NULL;
+		entry->value = NULL;
+	}
+
+	hashMap->size = 0;
+}
+
+HashEntry* getEntryAt(HashMap* hashMap, int slot)
+{
+	if (hashMap == NULL || slot < 0 || slot >= hashMap->capacity)
+		return NULL;
+
+	if (hashMap->entries[slot].key == NULL)
+		return NULL;
+
+	return &hashMap->entries[slot];
+}
+
+
+//Tests
+
+
+void testHashMapPutGet()
+{
+	HashMap* hashMap = createHashMap(1, &free);
+
+	assert(mapSize(NULL) == -1);
+	assert(getValue(hashMap, "missing") == NULL);
+
+	for (int i = 0; i < 100; i++)
+	{
+		char key[16];
+		snprintf(key, sizeof(key), "key%d", i);
+		int* value = (int*)malloc(sizeof(int));
+		*value = i;
+		assert(putValue(hashMap, key, value) == 1);
+	}
+
+	assert(mapSize(hashMap) == 100);
+	assert(*(int*)getValue(hashMap, "key42") == 42);
+
+	int* value = (int*)malloc(sizeof(int));
+	*value = -1;
+	assert(putValue(hashMap, "key42", value) == 1);
+	assert(mapSize(hashMap) == 100);
+	assert(*(int*)getValue(hashMap, "key42") == -1);
+
+	destroyHashMap(hashMap);
+}
+
+void testHashMapRemove()
+{
+	HashMap* hashMap = createHashMap(4, NULL);
+	int values[200];
+
+	for (int i = 0; i < 200; i++)
+	{
+		char key[16];
+		snprintf(key, sizeof(key), "%d", i);
+		values[i] = i;
+		putValue(hashMap, key, &values[i]);
+	}
+
+	for (int i = 0; i < 200; i += 2)
+	{
+		char key[16];
+		snprintf(key, sizeof(key), "%d", i);
+		assert(removeValue(hashMap, key) == 1);
+		assert(removeValue(hashMap, key) == -1);
+	}
+
+	assert(mapSize(hashMap) == 100);
+	for (int i = 0; i < 200; i++)
+	{
+		char key[16];
+		snprintf(key, sizeof(key), "%d", i);
+		if (i % 2 == 0)
+			assert(getValue(hashMap, key) == NULL);
+		else
+			assert(getValue(hashMap, key) == &values[i]);
+	}
+
+	int count = 0;
+	for (int i = 0; i < hashMap->capacity; i++)
+		if (getEntryAt(hashMap, i) != NULL)
+			count++;
+	assert(count == 100);
+
+	int capacity = hashMap->capacity;
+	clearHashMap(hashMap);
+	assert(mapSize(hashMap) == 0 && hashMap->capacity == capacity);
+	assert(getValue(hashMap, "1") == NULL);
+	assert(putValue(hashMap, "1", &values[1]) == 1 && getValue(hashMap, "1") == &values[1]);
+
+	destroyHashMap(hashMap);
+}
+
+void testHashMap()
+{
+	testHashMapPutGet();
+	testHashMapRemove();
+}
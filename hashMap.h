@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef struct HashEntry
+{
+	char* key;
+	uint32_t hash;
+	void* value;
+} HashEntry;
+
+/*
+	A hash map from strings to pointers, using open addressing with linear probing.
+	The keys are copied, the values are owned by the map if a destroy function is given.
+*/
+typedef struct HashMap
+{
+	int size, capacity;
+	HashEntry* entries;
+	void (*destroyFunction)(void*);
+} HashMap;
+
+/*
+	Computes the FNV-1a hash of a string.
+*/
+uint32_t hashString(const char* key);
+
+/*
+	Creates a hash map.
+	capacity - the number of entries the map can hold before growing
+	destroyFunction - a pointer to the destroy function of the values, or NULL if the map does not own them
+	Returns a pointer to the new hash map, or NULL if the memory could not be allocated.
+*/
+HashMap* createHashMap(int capacity, void (*destroyFunction)(void*));
+
+/*
+	Deallocates the memory ocuppied by the hash map, its keys and its values.
+*/
+void destroyHashMap(HashMap* hashMap);
+
+/*
+	Gets the number of keys stored in the hash map, or -1 if the pointer is NULL.
+*/
+int mapSize(HashMap* hashMap);
+
+/*
+	Gets the value stored for the key, or NULL if the key is not in the hash map.
+*/
+void* getValue(HashMap* hashMap, const char* key);
+
+/*
+	Stores the value for the key, destroying the previous value of the key if there is one.
+	Returns 1 on success, or -1 if the arguments are not valid or the memory could not be allocated.
+*/
+int putValue(HashMap* hashMap, const char* key, void* value);
+
+/*
+	Removes the key and destroys its value.
+	Returns 1 on success, or -1 if the key is not in the hash map.
+*/
+int removeValue(HashMap* hashMap, const char* key);
+
+/*
+	Removes every key and destroys the values, keeping the capacity of the hash map.
+*/
+void clearHashMap(HashMap* hashMap);
+
+/*
+	Gets the entry from the given slot, used to iterate over the hash map with slots from 0 to capacity - 1.
+	Returns a pointer to the entry, or NULL if the slot is empty or not valid.
+*/
+HashEntry* getEntryAt(HashMap* hashMap, int slot);
+
+//Tests
+void testHashMap();
@@ -0,0 +1,626 @@
+#include "journal.h"
+#include "validation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+
+void initJournal(Journal* journal, uint32_t id)
+{
+	if (journal == NULL)
+		return;
+
+	initByteBuffer(&journal->records);
+	journal->id = id;
+	journal->base = 0;
+	journal->open = -1;
+	journal->seq = 0;
+	journal->dropped = 0;
+}
+
+void freeJournal(Journal* journal)
+{
+	if (journal == NULL)
+		return;
+
+	freeByteBuffer(&journal->records);
+	journal->open = -1;
+}
+
+double journalTime()
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+void putLotRecord(ByteBuffer* buffer, uint32_t seq, Material* material)
+{
+	int frame = beginFrame(buffer, seq, JOURNAL_PUT);
+	putMaterial(buffer, material);
+	endFrame(buffer, frame);
+}
+
+void putMarkRecord(ByteBuffer* buffer, uint32_t seq, uint8_t type)
+{
+	int frame = beginFrame(buffer, seq, type);
+	if (type == JOURNAL_COMMIT)
+		putDouble(buffer, journalTime());
+	endFrame(buffer, frame);
+}
+
+/*
+	Opens a group if none is open, and returns the sequence it will be committed with.
+*/
+uint32_t openGroup(Journal* journal)
+{
+	if (journal->open == -1)
+		journal->open = journal->records.size;
+
+	return journal->seq + 1;
+}
+
+void journalPut(Journal* journal, Material* material)
+{
+	if (journal == NULL)
+		return;
+
+	putLotRecord(&journal->records, openGroup(journal), material);
+}
+
+void journalDelete(Journal* journal, const char* name, const char* supplier, int day, int month, int year)
+{
+	if (journal == NULL)
+		return;
+
+	int frame = beginFrame(&journal->records, openGroup(journal), JOURNAL_DELETE);
+	putStringField(&journal->records, name);
+	putStringField(&journal->records, supplier);
+	putDateField(&journal->records, day, month, year);
+	endFrame(&journal->records, frame);
+}
+
+void journalUpdate(Journal* journal, const char* name, const char* supplier, int day, int month, int year, Material* material)
+{
+	if (journal == NULL)
+		return;
+
+	int frame = beginFrame(&journal->records, openGroup(journal), JOURNAL_UPDATE);
+	putStringField(&journal->records, name);
+	putStringField(&journal->records, supplier);
+	putDateField(&journal->records, day, month, year);
+	putMaterial(&journal->records, material);
+	endFrame(&journal->records, frame);
+}
+
+DynamicArray* copyNameLots(Journal* journal, MaterialRepo* materialRepo, const char* name)
+{
+	if (journal == NULL)
+		return NULL;
+
+	MaterialGroup* group = getNameGroup(materialRepo, name);
+	DynamicArray* lots = createDynamicArray(group == NULL ? 1 : len(group->lots), &destroyMaterial);
+
+	for (int i = 0; lots != NULL && group != NULL && i < len(group->lots); i++)
+	{
+		Material* lot = copyMaterial(getElement(group->lots, i));
+
+		if (lot == NULL || apd(lots, lot) == -1)
+		{
+			destroyMaterial(lot);
+			destroyDynamicArray(lots);
+			lots = NULL;
+		}
+	}
+
+	if (lots == NULL)
+		journal->records.failed = 1;
+	return lots;
+}
+
+void journalConsumed(Journal* journal, MaterialServices* materialServices, DynamicArray* lots)
+{
+	if (journal == NULL || lots == NULL)
+		return;
+
+	for (int i = 0; i < len(lots); i++)
+	{
+		Material* material = getElement(lots, i);
+		const Date* date = getDate(material);
+		Material* lot = findLot(materialServices, getName(material), getSupplier(material), getDay(date), getMonth(date), getYear(date));
+
+		if (lot == NULL)
+			journalDelete(journal, getName(material), getSupplier(material), getDay(date), getMonth(date), getYear(date));
+		else if (getQuantity(lot) != getQuantity(material))
+			journalPut(journal, lot);
+	}
+
+	destroyDynamicArray(lots);
+}
+
+void journalRecord(Journal* journal, const unsigned char* frame, int length)
+{
+	if (journal == NULL || length < 5)
+		return;
+
+	int start = beginFrame(&journal->records, openGroup(journal), frame[4]);
+	putBytes(&journal->records, frame + 5, length - 5);
+	endFrame(&journal->records, start);
+}
+
+void journalReset(Journal* journal, MaterialRepo* materialRepo)
+{
+	if (journal == NULL)
+		return;
+
+	putMarkRecord(&journal->records, openGroup(journal), JOURNAL_RESET);
+	for (int i = 0; i < getSize(materialRepo); i++)
+		journalPut(journal, getMaterialAtPos(materialRepo, i));
+}
+
+/*
+	Drops the oldest groups, until at least the given number of bytes is dropped.
+*/
+void dropGroups(Journal* journal, int minimum)
+{
+	int position = 0, cut = 0, size;
+	int end = committedSize(journal);
+	ByteReader reader;
+
+	while (cut < minimum && (size = frameSize(journal->records.data + position, end - position)) > 0)
+	{
+		initByteReader(&reader, journal->records.data + position + 4, size - 4);
+		uint32_t seq = getU32(&reader);
+
+		position += size;
+		if (getU8(&reader) == JOURNAL_COMMIT)
+		{
+			cut = position;
+			journal->dropped = seq;
+		}
+	}
+
+	memmove(journal->records.data, journal->records.data + cut, journal->records.size - cut);
+	journal->records.size -= cut;
+	journal->base += cut;
+	if (journal->open != -1)
+		journal->open -= cut;
+}
+
+void commitJournal(Journal* journal)
+{
+	if (journal == NULL || journal->open == -1)
+		return;
+
+	putMarkRecord(&journal->records, openGroup(journal), JOURNAL_COMMIT);
+	journal->seq++;
+	journal->open = -1;
+
+	// a group that lost a record cannot be sent, so every group is dropped and the followers get a snapshot
+	if (journal->records.failed)
+	{
+		journal->base += journal->records.size;
+		journal->records.size = 0;
+		journal->records.failed = 0;
+		journal->dropped = journal->seq;
+	}
+	else if (journal->records.size > JOURNAL_MAX_SIZE)
+		dropGroups(journal, journal->records.size / 2);
+}
+
+void rollbackJournal(Journal* journal)
+{
+	if (journal == NULL || journal->open == -1)
+		return;
+
+	journal->records.size = journal->open;
+	journal->records.failed = 0;
+	journal->open = -1;
+}
+
+int committedSize(Journal* journal)
+{
+	return journal->open == -1 ? journal->records.size : journal->open;
+}
+
+int findJournalGroup(Journal* journal, uint32_t seq)
+{
+	if (seq < journal->dropped || seq > journal->seq)
+		return -1;
+	if (seq == journal->dropped)
+		return 0;
+
+	int position = 0, size;
+	int end = committedSize(journal);
+	ByteReader reader;
+
+	while ((size = frameSize(journal->records.data + position, end - position)) > 0)
+	{
+		initByteReader(&reader, journal->records.data + position + 4, size - 4);
+		uint32_t id = getU32(&reader);
+
+		position += size;
+		if (getU8(&reader) == JOURNAL_COMMIT && id == seq)
+			return position;
+	}
+
+	return -1;
+}
+
+void writeSnapshot(ByteBuffer* buffer, MaterialRepo* materialRepo, uint32_t seq)
+{
+	putMarkRecord(buffer, seq, JOURNAL_SNAPSHOT);
+	for (int i = 0; i < getSize(materialRepo); i++)
+		putLotRecord(buffer, seq, getMaterialAtPos(materialRepo, i));
+	putMarkRecord(buffer, seq, JOURNAL_COMMIT);
+}
+
+/*
+	Replaces the repository of the services with an empty one.
+*/
+int resetRepo(MaterialServices* materialServices)
+{
+	MaterialRepo* materialRepo = createMaterialRepo(2);
+
+	if (materialRepo == NULL || upd(materialServices->repoStack, materialServices->index, materialRepo) == -1)
+	{
+		destroyMaterialRepo(materialRepo);
+		return -1;
+	}
+
+	materialServices->materialRepo = materialRepo;
+	return 1;
+}
+
+/*
+	Reads the name, supplier, quantity and date of a lot, as putMaterial writes them; a NULL quantity is not read.
+*/
+void getLotFields(ByteReader* reader, char* name, char* supplier, double* quantity, int* day, int* month, int* year)
+{
+	getStringField(reader, name, MAX_STRING_SIZE);
+	getStringField(reader, supplier, MAX_STRING_SIZE);
+	if (quantity != NULL)
+		*quantity = getDouble(reader);
+	getDateField(reader, day, month, year);
+}
+
+int applyJournalRecord(MaterialServices* materialServices, const unsigned char* frame, int length)
+{
+	ByteReader reader;
+	char name[MAX_STRING_SIZE], supplier[MAX_STRING_SIZE];
+	char newName[MAX_STRING_SIZE], newSupplier[MAX_STRING_SIZE];
+	int day = 1, month = 1, year = 2000, newDay = 1, newMonth = 1, newYear = 2000;
+	double quantity = 0;
+	int bucket = 0;
+
+	if (materialServices == NULL || frame == NULL)
+		return -1;
+
+	initByteReader(&reader, frame, length);
+	getU32(&reader);
+	uint8_t type = getU8(&reader);
+
+	switch (type)
+	{
+	case JOURNAL_PUT:
+		getLotFields(&reader, name, supplier, &quantity, &day, &month, &year);
+		break;
+	case JOURNAL_DELETE:
+		getLotFields(&reader, name, supplier, NULL, &day, &month, &year);
+		break;
+	case JOURNAL_UPDATE:
+		getLotFields(&reader, name, supplier, NULL, &day, &month, &year);
+		getLotFields(&reader, newName, newSupplier, &quantity, &newDay, &newMonth, &newYear);
+		break;
+	case JOURNAL_BUCKET:
+		bucket = getU16(&reader);
+		break;
+	case JOURNAL_RESET:
+	case JOURNAL_SNAPSHOT:
+		break;
+	default:
+		return -1;
+	}
+
+	if (reader.failed || reader.position != reader.size || !validateDate(day, month, year) || !validateDate(newDay, newMonth, newYear))
+		return -1;
+
+	MaterialRepo* materialRepo = materialServices->materialRepo;
+
+	if (type == JOURNAL_RESET || type == JOURNAL_SNAPSHOT)
+		return resetRepo(materialServices);
+
+	if (type == JOURNAL_BUCKET)
+		return removeBucket(materialRepo, bucket) == -1 ? -1 : 1;
+
+	Material* material = createMaterial(name, supplier, type == JOURNAL_UPDATE ? 0 : quantity, createDate(day, month, year));
+	int status = -1;
+
+	if (material == NULL)
+		return -1;
+
+	if (type == JOURNAL_DELETE)
+	{
+		status = removeMaterial(materialRepo, material);
+		destroyMaterial(material);
+		return status;
+	}
+
+	if (type == JOURNAL_UPDATE)
+	{
+		Material* newMaterial = createMaterial(newName, newSupplier, quantity, createDate(newDay, newMonth, newYear));
+
+		if (newMaterial != NULL)
+			status = updateMaterial(materialRepo, material, newMaterial);
+		if (status == -1)
+			destroyMaterial(newMaterial);
+		destroyMaterial(material);
+		return status;
+	}
+
+	// the lot is found once, then replaced at its position or appended, as a snapshot adds every lot
+	Material* lot = findLot(materialServices, name, supplier, day, month, year);
+	status = lot != NULL ? updateMaterial(materialRepo, lot, material) : appendMaterial(materialRepo, material);
+
+	if (status == -1)
+		destroyMaterial(material);
+	return status;
+}
+
+int exportDiff(ByteBuffer* diff, MaterialRepo* materialRepo, const int* buckets, int count)
+{
+	MerkleTree* tree = getMerkleTree(materialRepo);
+
+	if (diff == NULL || tree == NULL || buckets == NULL)
+		return -1;
+
+	for (int i = 0; i < count; i++)
+	{
+		DynamicArray* lots = tree->buckets[buckets[i]];
+		int frame = beginFrame(diff, 0, JOURNAL_BUCKET);
+
+		putU16(diff, (uint16_t)buckets[i]);
+		endFrame(diff, frame);
+		for (int j = 0; lots != NULL && j < len(lots); j++)
+			putLotRecord(diff, 0, getElement(lots, j));
+	}
+
+	return diff->failed ? -1 : 1;
+}
+
+int checkDiff(const unsigned char* diff, int size)
+{
+	ByteReader reader;
+	char name[MAX_STRING_SIZE], supplier[MAX_STRING_SIZE];
+	int day = 1, month = 1, year = 2000, length, bucket = -1;
+	double quantity;
+
+	if (diff == NULL)
+		return -1;
+
+	for (int position = 0; position < size; position += length)
+	{
+		length = frameSize(diff + position, size - position);
+		if (length <= 0)
+			return -1;
+
+		initByteReader(&reader, diff + position + 4, length - 4);
+		getU32(&reader);
+		uint8_t type = getU8(&reader);
+
+		if (type == JOURNAL_BUCKET)
+			bucket = getU16(&reader);
+		else if (type == JOURNAL_PUT && bucket != -1)
+		{
+			getLotFields(&reader, name, supplier, &quantity, &day, &month, &year);
+			if (!reader.failed && validateDate(day, month, year))
+			{
+				Date date = { day, month, year };
+
+				// a lot put in another bucket would be left there by the next diff of its own bucket
+				if (keyBucket(name, supplier, &date) != bucket)
+					return -1;
+			}
+		}
+		else
+			return -1;
+
+		if (reader.failed || reader.position != reader.size || bucket >= MERKLE_LEAVES || !validateDate(day, month, year))
+			return -1;
+	}
+
+	return 1;
+}
+
+//Tests
+
+
+/*
+	Applies the committed groups of the journal from the given position on, and returns the number of groups.
+*/
+int applyTestGroups(MaterialServices* materialServices, const unsigned char* data, int size)
+{
+	int position = 0, length, groups = 0;
+
+	while ((length = frameSize(data + position, size - position)) > 0)
+	{
+		if (data[position + 8] == JOURNAL_COMMIT)
+			groups++;
+		else
+			assert(applyJournalRecord(materialServices, data + position + 4, length - 4) == 1);
+		position += length;
+	}
+	assert(position == size);
+
+	return groups;
+}
+
+/*
+	Checks that the follower has the lots of the leader, in the same order.
+*/
+void checkSameLots(MaterialServices* leader, MaterialServices* follower)
+{
+	assert(getSize(leader->materialRepo) == getSize(follower->materialRepo));
+
+	for (int i = 0; i < getSize(leader->materialRepo); i++)
+	{
+		Material* material = getMaterial(leader, i);
+		Material* lot = getMaterial(follower, i);
+
+		assert(equalMaterials(lot, material) == 1 && getQuantity(lot) == getQuantity(material));
+	}
+}
+
+void testJournalGroups()
+{
+	MaterialServices* leader = createMaterialServices(createMaterialRepo(10));
+	MaterialServices* follower = createMaterialServices(createMaterialRepo(10));
+	Journal journal;
+
+	initJournal(&journal, 7);
+	attachJournal(leader, &journal);
+
+	assert(add(leader, "Eggs", "Farm", 3, 1, 1, 2030) == 1);
+	assert(add(leader, "Eggs", "Farm", 2, 1, 1, 2030) == 1);
+	assert(add(leader, "Eggs", "Coop", 4, 1, 2, 2030) == 1);
+	assert(add(leader, "Milk", "Dairy", 1, 1, 1, 2030) == 1);
+	assert(update(leader, "Eggs", "Coop", 1, 2, 2030, "Eggs", "Coop", 2, 1, 2, 2030) == 1);
+	assert(consume(leader, "Eggs", 6) == 1);
+	assert(journal.seq == 6);
+
+	// the failed operations and the rolled back transactions record nothing
+	assert(rem(leader, "Eggs", "Farm", 1, 1, 2030) == -1);
+	assert(beginTransaction(leader) == 1);
+	assert(add(leader, "Salt", "Mine", 1, 1, 1, 2030) == 1);
+	assert(rollbackTransaction(leader) == 1);
+	assert(journal.seq == 6 && journal.open == -1);
+
+	// a transaction is a single group
+	assert(beginTransaction(leader) == 1);
+	assert(add(leader, "Salt", "Mine", 1, 1, 1, 2030) == 1);
+	assert(update(leader, "Milk", "Dairy", 1, 1, 2030, "Cream", "Dairy", 2, 2, 1, 2030) == 1);
+	assert(committedSize(&journal) < journal.records.size);
+	assert(commitTransaction(leader) == 1);
+	assert(undo(leader) == 1 && redo(leader) == 1);
+	assert(journal.seq == 9);
+
+	int middle = findJournalGroup(&journal, 4);
+	assert(findJournalGroup(&journal, 0) == 0 && middle > 0);
+	assert(findJournalGroup(&journal, 9) == committedSize(&journal) && findJournalGroup(&journal, 10) == -1);
+
+	follower->readOnly = 1;
+	assert(add(follower, "Eggs", "Farm", 1, 1, 1, 2030) == -1 && undo(follower) == -1 && beginTransaction(follower) == -1);
+
+	assert(applyTestGroups(follower, journal.records.data, middle) == 4);
+	assert(getSize(follower->materialRepo) == 3);
+	assert(applyTestGroups(follower, journal.records.data + middle, journal.records.size - middle) == 5);
+	checkSameLots(leader, follower);
+
+	// the dropped groups cannot be found anymore, the offsets of the others stay the same
+	long long end = journal.base + committedSize(&journal);
+	dropGroups(&journal, middle);
+	assert(journal.dropped == 4 && journal.base == middle && journal.base + committedSize(&journal) == end);
+	assert(findJournalGroup(&journal, 3) == -1 && findJournalGroup(&journal, 4) == 0);
+
+	// a snapshot replaces whatever the follower had
+	ByteBuffer snapshot;
+	initByteBuffer(&snapshot);
+	assert(applyJournalRecord(follower, (const unsigned char*)"\0\0\0\0\x63", 5) == -1);
+	writeSnapshot(&snapshot, leader->materialRepo, journal.seq);
+	assert(add(leader, "Flour", "Mill", 1, 1, 1, 2030) == 1);
+	assert(applyTestGroups(follower, snapshot.data, snapshot.size) == 1);
+	assert(getSize(follower->materialRepo) == getSize(leader->materialRepo) - 1);
+	assert(applyTestGroups(follower, journal.records.data + findJournalGroup(&journal, 9), committedSize(&journal) - findJournalGroup(&journal, 9)) == 1);
+	checkSameLots(leader, follower);
+
+	freeByteBuffer(&snapshot);
+	attachJournal(leader, NULL);
+	freeJournal(&journal);
+	destroyMaterialServices(leader);
+	destroyMaterialServices(follower);
+}
+
+void testJournalDiff()
+{
+	MaterialServices* source = createMaterialServices(createMaterialRepo(10));
+	MaterialServices* target = createMaterialServices(createMaterialRepo(10));
+	MaterialServices* follower = createMaterialServices(createMaterialRepo(10));
+	Journal journal;
+	ByteBuffer diff, snapshot;
+	int buckets[MERKLE_LEAVES];
+	uint64_t hash, targetHash;
+	int lots, targetLots;
+	char name[MAX_STRING_SIZE];
+
+	initJournal(&journal, 7);
+	attachJournal(target, &journal);
+	initByteBuffer(&diff);
+	initByteBuffer(&snapshot);
+
+	// the same lots added in another order give the same hash
+	for (int i = 0; i < 300; i++)
+	{
+		snprintf(name, sizeof(name), "Lot%d", i);
+		assert(add(source, name, "Farm", i + 1, 1 + i % 28, 1, 2030) == 1);
+		snprintf(name, sizeof(name), "Lot%d", 299 - i);
+		assert(add(target, name, "Farm", 300 - i, 1 + (299 - i) % 28, 1, 2030) == 1);
+	}
+	assert(getInventoryHash(source, &hash, &lots) == 1 && getInventoryHash(target, &targetHash, &targetLots) == 1);
+	assert(hash == targetHash && lots == 300 && targetLots == 300);
+	assert(diffInventories(source, target, buckets) == 0);
+
+	assert(rem(target, "Lot5", "Farm", 6, 1, 2030) == 1);
+	assert(add(source, "Salt", "Mine", 1, 1, 1, 2030) == 1);
+	assert(update(source, "Lot7", "Farm", 8, 1, 2030, "Lot7", "Farm", 1, 8, 1, 2030) == 1);
+	int count = diffInventories(source, target, buckets);
+	assert(count >= 1 && count <= 3);
+
+	// only the lots of the buckets that differ are exchanged
+	assert(exportDiff(&diff, source->materialRepo, buckets, count) == 1 && checkDiff(diff.data, diff.size) == 1);
+	writeSnapshot(&snapshot, source->materialRepo, 0);
+	assert(diff.size * 10 < snapshot.size);
+	assert(getInventoryHash(source, &hash, &lots) == 1 && lots == 301);
+
+	// a diff is checked whole, nothing changes for a truncated one; the one applied is published to the change feed
+	ChangeRecord record;
+	uint64_t lost;
+	int consumer = subscribe(target);
+	assert(applyDiff(target, diff.data, diff.size - 1) == -1);
+	assert(applyDiff(target, diff.data, diff.size) == 1);
+	assert(readChange(&target->changes, consumer, &record, &lost) == 1 && record.type == CHANGE_DIFF && record.quantity == count);
+	assert(getInventoryHash(target, &targetHash, &targetLots) == 1 && targetHash == hash && targetLots == 301);
+	assert(diffInventories(source, target, buckets) == 0);
+
+	// the diff reaches the followers through the journal
+	assert(applyTestGroups(follower, journal.records.data, committedSize(&journal)) == (int)journal.seq);
+	assert(getInventoryHash(follower, &targetHash, &targetLots) == 1 && targetHash == hash);
+
+	assert(undo(target) == 1);
+	assert(getInventoryHash(target, &targetHash, &targetLots) == 1 && targetHash != hash && targetLots == 299);
+
+	// a lot put in a bucket that is not its own is refused
+	Material* salt = findLot(source, "Salt", "Mine", 1, 1, 2030);
+	diff.size = 0;
+	int frame = beginFrame(&diff, 0, JOURNAL_BUCKET);
+	putU16(&diff, (uint16_t)((lotBucket(salt) + 1) % MERKLE_LEAVES));
+	endFrame(&diff, frame);
+	putLotRecord(&diff, 0, salt);
+	assert(checkDiff(diff.data, diff.size) == -1 && applyDiff(target, diff.data, diff.size) == -1);
+
+	freeByteBuffer(&diff);
+	freeByteBuffer(&snapshot);
+	attachJournal(target, NULL);
+	freeJournal(&journal);
+	destroyMaterialServices(source);
+	destroyMaterialServices(target);
+	destroyMaterialServices(follower);
+}
+
+void testJournal()
+{
+	testJournalGroups();
+	testJournalDiff();
+}
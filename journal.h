@@ -0,0 +1,145 @@
+#pragma once
+
+#include "protocol.h"
+
+#define JOURNAL_MAGIC 0xB2
+#define JOURNAL_MAX_SIZE (1 << 23)
+
+/*
+	The records of a journal, as frames of the binary protocol (see RequestType) whose id is the sequence of the group
+	they belong to. The lots are given by their name, supplier and date, as the requests give them.
+	JOURNAL_PUT - name, supplier, quantity, date: the lot now has the quantity, it is added if it is missing
+	JOURNAL_DELETE - name, supplier, date: the lot is removed
+	JOURNAL_UPDATE - name, supplier, date, then the name, supplier, quantity and date of the lot that replaces it
+	JOURNAL_RESET - every lot is removed, the lots of the repository follow as puts
+	JOURNAL_SNAPSHOT - a reset that starts a snapshot, sent to a follower instead of the groups it misses
+	JOURNAL_BUCKET - the u16 number of a bucket of the Merkle tree (see MerkleTree): every lot of the bucket is
+		removed, the lots it gets follow as puts
+	JOURNAL_COMMIT - the time of the commit (see journalTime), as a number: ends a group, which is applied whole
+	A follower starts its connection with the byte JOURNAL_MAGIC, then exchanges these frames with the leader:
+	JOURNAL_HELLO - the u32 id of the journal; sent by the follower with the last group it applied as the sequence,
+		answered by the leader with its last committed group
+	JOURNAL_ACK - sent by the follower once it applied the groups up to the sequence
+*/
+typedef enum JournalRecordType
+{
+	JOURNAL_PUT = 1,
+	JOURNAL_DELETE,
+	JOURNAL_UPDATE,
+	JOURNAL_RESET,
+	JOURNAL_COMMIT,
+	JOURNAL_HELLO,
+	JOURNAL_ACK,
+	JOURNAL_SNAPSHOT,
+	JOURNAL_BUCKET
+} JournalRecordType;
+
+/*
+	The changes made to the lots of a repository, recorded by the services it is attached to (see MaterialServices)
+	in groups, one for every operation or transaction. Only the lots an operation changed are recorded, except for
+	undo and redo, which record the whole repository they go back to. The records keep the order of the materials:
+	a lot changed in place is changed in place by the follower too.
+	records - the groups committed since the dropped ones, followed by the group still open
+	id - tells the journal apart from the journals of other leaders, or of an earlier run of the same one
+	base - the number of bytes dropped from the start of the journal, so an offset in the journal stays valid
+	open - the position of the group still open in records, or -1 if no group is open
+	seq - the sequence of the last committed group, the groups are numbered from 1
+	dropped - the sequence of the last dropped group, the ones after it are still in records
+*/
+typedef struct Journal
+{
+	ByteBuffer records;
+	uint32_t id;
+	long long base;
+	int open;
+	uint32_t seq, dropped;
+} Journal;
+
+void initJournal(Journal* journal, uint32_t id);
+void freeJournal(Journal* journal);
+
+/*
+	Gets the time the commits are stamped with, in microseconds since the epoch, so a follower on the same machine
+	can tell how long ago a group was committed.
+*/
+double journalTime();
+
+/*
+	Record a change in the open group, opening one if needed. A NULL journal records nothing.
+	journalReset records every lot of the repository.
+*/
+void journalPut(Journal* journal, Material* material);
+void journalDelete(Journal* journal, const char* name, const char* supplier, int day, int month, int year);
+void journalUpdate(Journal* journal, const char* name, const char* supplier, int day, int month, int year, Material* material);
+void journalReset(Journal* journal, MaterialRepo* materialRepo);
+
+/*
+	Records a copy of a record, without its length, in the open group.
+*/
+void journalRecord(Journal* journal, const unsigned char* frame, int length);
+
+/*
+	Copies the lots of the name before some of them are consumed, so journalConsumed can tell which ones changed.
+	Returns the copies, or NULL if the journal is NULL or the memory could not be allocated, in which case the
+	group will not be sent to the followers (see commitJournal).
+*/
+DynamicArray* copyNameLots(Journal* journal, MaterialRepo* materialRepo, const char* name);
+
+/*
+	Records the changes of the copied lots: a delete for every lot used up, a put for every lot reduced.
+	The copies are destroyed.
+*/
+void journalConsumed(Journal* journal, MaterialServices* materialServices, DynamicArray* lots);
+
+/*
+	Closes the open group. Once the journal exceeds JOURNAL_MAX_SIZE bytes, its oldest groups are dropped until it
+	is half as large; if the memory for a record could not be allocated, every group is dropped. The followers that
+	need a dropped group are sent a snapshot instead.
+*/
+void commitJournal(Journal* journal);
+
+/*
+	Discards the open group.
+*/
+void rollbackJournal(Journal* journal);
+
+/*
+	Gets the number of bytes of records in committed groups, the ones a follower can be sent.
+*/
+int committedSize(Journal* journal);
+
+/*
+	Finds where the groups after the given one start.
+	Returns the position in records, or -1 if the group was dropped or is not committed yet.
+*/
+int findJournalGroup(Journal* journal, uint32_t seq);
+
+/*
+	Writes the whole repository as a group with the given sequence, for a follower that cannot be sent the groups it
+	needs: a snapshot record followed by a put of every lot.
+*/
+void writeSnapshot(ByteBuffer* buffer, MaterialRepo* materialRepo, uint32_t seq);
+
+/*
+	Writes the lots of the buckets of the Merkle tree of the repository (see diffMerkleTrees), for another repository
+	to take them with applyDiff: a bucket record followed by a put of every lot of the bucket, for every bucket, even
+	the ones that have no lots. The records have the sequence 0.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int exportDiff(ByteBuffer* diff, MaterialRepo* materialRepo, const int* buckets, int count);
+
+/*
+	Checks that a diff is made of whole bucket and put records, every put in the bucket of the record before it.
+	Returns 1 if the diff is valid, or -1 otherwise.
+*/
+int checkDiff(const unsigned char* diff, int size);
+
+/*
+	Applies a put, delete, update, bucket, reset or snapshot record, without its length, to the repository of the services.
+	Returns 1 on success, or -1 if the record is not valid, the lot of a delete is missing, or the memory could not be
+	allocated.
+*/
+int applyJournalRecord(MaterialServices* materialServices, const unsigned char* frame, int length);
+
+//Tests
+void testJournal();
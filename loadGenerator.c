@@ -0,0 +1,309 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "loadGenerator.h"
+#include "protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+
+#include <time.h>
+#include <threads.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+/*
+	A client of the load generator.
+	requests - the requests encoded and not sent yet
+	replies - the bytes received and not parsed yet, from start on
+	sent - the times the requests were sent at, in microseconds, replaced by their latencies once they are answered
+*/
+typedef struct LoadClient
+{
+	const char* path;
+	int index, clients, count, writes, binary, depth;
+	int socket;
+	ByteBuffer requests, replies;
+	int start;
+	double* sent;
+	int failed;
+} LoadClient;
+
+double nowUs()
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+/*
+	Encodes a request in the protocol of the client: the add of its material for the number -1, then updates or lookups
+	of its material, or queries for the material of a random client.
+*/
+void encodeRequest(LoadClient* client, int number, unsigned int random)
+{
+	char name[32], pattern[64];
+	int other = (int)(random >> 8) % client->clients;
+	int type = number == -1 ? REQUEST_ADD : (int)(random >> 16) % 100 < client->writes ? REQUEST_UPDATE :
+		random % 2 ? REQUEST_LOOKUP : REQUEST_QUERY;
+	int quantity = 1 + (number + 2) % 2;
+
+	snprintf(name, sizeof(name), "load%d", client->index);
+	snprintf(pattern, sizeof(pattern), "name~load%d limit=10", other);
+
+	if (!client->binary)
+	{
+		char line[256];
+		int length = 0;
+
+		if (type == REQUEST_ADD)
+			length = snprintf(line, sizeof(line), "add %s loadSupplier 1 1 1 2030\n", name);
+		else if (type == REQUEST_UPDATE)
+			length = snprintf(line, sizeof(line), "update %s loadSupplier 1 1 2030 %s loadSupplier %d 1 1 2030\n", name, name, quantity);
+		else if (type == REQUEST_LOOKUP)
+			length = snprintf(line, sizeof(line), "lookup %s loadSupplier 1 1 2030\n", name);
+		else
+			length = snprintf(line, sizeof(line), "query %s\n", pattern);
+
+		putBytes(&client->requests, line, length);
+		return;
+	}
+
+	int frame = beginFrame(&client->requests, (uint32_t)(number + 1), (uint8_t)type);
+	if (type == REQUEST_QUERY)
+		putStringField(&client->requests, pattern);
+	else
+	{
+		putStringField(&client->requests, name);
+		putStringField(&client->requests, "loadSupplier");
+		if (type == REQUEST_ADD)
+			putDouble(&client->requests, 1);
+		putDateField(&client->requests, 1, 1, 2030);
+	}
+	if (type == REQUEST_UPDATE)
+	{
+		putStringField(&client->requests, name);
+		putStringField(&client->requests, "loadSupplier");
+		putDouble(&client->requests, quantity);
+		putDateField(&client->requests, 1, 1, 2030);
+	}
+	endFrame(&client->requests, frame);
+}
+
+/*
+	Parses the next reply, if it was received whole.
+	Returns 1 if it reports a success, -1 if it reports an error, or 0 if more bytes are needed.
+*/
+int parseReply(LoadClient* client, int number)
+{
+	unsigned char* reply = client->replies.data + client->start;
+	int available = client->replies.size - client->start;
+
+	if (client->binary)
+	{
+		int size = frameSize(reply, available);
+		if (size <= 0)
+			return size;
+
+		// the responses come in the order of the requests, with their ids
+		uint32_t id = (uint32_t)reply[4] | (uint32_t)reply[5] << 8 | (uint32_t)reply[6] << 16 | (uint32_t)reply[7] << 24;
+		client->start += size;
+		if (id != (uint32_t)(number + 1))
+			return -1;
+		return reply[8] == RESPONSE_OK ? 1 : -1;
+	}
+
+	// the header line is followed by the length of the output
+	unsigned char* newline = memchr(reply, '\n', available);
+	if (newline == NULL)
+		return 0;
+
+	unsigned char* space = memchr(reply, ' ', newline - reply);
+	if (space == NULL)
+		return -1;
+
+	long long length = strtoll((char*)space + 1, NULL, 10);
+	if (length > available - (newline + 1 - reply))
+		return 0;
+
+	client->start += (int)(newline + 1 - reply + length);
+	return space - reply == 2 && strncmp((char*)reply, "OK", 2) == 0 ? 1 : -1;
+}
+
+/*
+	Runs count requests, with at most depth of them sent and not answered yet; the request number -1 is the add of
+	the material of the client.
+	Returns 1 on success, or -1 if a request failed or the connection was closed.
+*/
+int runLoadRequests(LoadClient* client, int first, int count, unsigned int* random)
+{
+	int sent = 0, received = 0;
+
+	while (received < count)
+	{
+		client->requests.size = 0;
+		for (; sent < count && sent - received < client->depth; sent++)
+		{
+			*random = *random * 1103515245u + 12345u;
+			encodeRequest(client, first + sent, *random);
+			if (first + sent >= 0)
+				client->sent[first + sent] = nowUs();
+		}
+
+		if (client->requests.failed || send(client->socket, client->requests.data, client->requests.size, MSG_NOSIGNAL) != client->requests.size)
+			return -1;
+
+		int status;
+		while ((status = parseReply(client, first + received)) == 0)
+		{
+			// the parsed replies are dropped before more are read
+			memmove(client->replies.data, client->replies.data + client->start, client->replies.size - client->start);
+			client->replies.size -= client->start;
+			client->start = 0;
+
+			if (reserveBuffer(&client->replies, LOAD_BUFFER_SIZE) == -1)
+				return -1;
+
+			ssize_t length = recv(client->socket, client->replies.data + client->replies.size, LOAD_BUFFER_SIZE, 0);
+			if (length <= 0)
+				return -1;
+			client->replies.size += (int)length;
+		}
+		if (status == -1)
+			return -1;
+
+		// every reply that arrived with it is taken as well
+		do
+		{
+			if (first + received >= 0)
+				client->sent[first + received] = nowUs() - client->sent[first + received];
+			received++;
+		} while (received < sent && (status = parseReply(client, first + received)) == 1);
+
+		if (status == -1)
+			return -1;
+	}
+
+	return 1;
+}
+
+int runLoadClient(void* argument)
+{
+	LoadClient* client = (LoadClient*)argument;
+	struct sockaddr_un address;
+	unsigned int random = 2654435761u * (unsigned int)(client->index + 1);
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	snprintf(address.sun_path, sizeof(address.sun_path), "%s", client->path);
+
+	client->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (client->socket == -1 || connect(client->socket, (struct sockaddr*)&address, sizeof(address)) == -1)
+	{
+		client->failed = 1;
+		return -1;
+	}
+
+	unsigned char magic = PROTOCOL_MAGIC;
+	if (client->binary && send(client->socket, &magic, 1, MSG_NOSIGNAL) != 1)
+		client->failed = 1;
+
+	if (!client->failed && (runLoadRequests(client, -1, 1, &random) == -1 || runLoadRequests(client, 0, client->count, &random) == -1))
+		client->failed = 1;
+
+	close(client->socket);
+	freeByteBuffer(&client->requests);
+	freeByteBuffer(&client->replies);
+
+	return client->failed ? -1 : 1;
+}
+
+int compareLatencies(const void* x, const void* y)
+{
+	double a = *(const double*)x, b = *(const double*)y;
+	return (a > b) - (a < b);
+}
+
+int runLoadGenerator(const char* path, int clients, int requests, int writes, int binary, int depth)
+{
+	if (path == NULL || clients <= 0 || requests <= 0 || writes < 0 || writes > 100 || depth <= 0)
+		return -1;
+
+	LoadClient* loadClients = (LoadClient*)calloc(clients, sizeof(LoadClient));
+	thrd_t* threads = (thrd_t*)malloc(sizeof(thrd_t) * clients);
+	double* latencies = (double*)malloc(sizeof(double) * clients * requests);
+	int failed = 0, started = 0;
+
+	if (loadClients == NULL || threads == NULL || latencies == NULL)
+	{
+		free(loadClients);
+		free(threads);
+		free(latencies);
+		return -1;
+	}
+
+	double start = nowUs();
+	for (int c = 0; c < clients; c++)
+	{
+		loadClients[c].path = path;
+		loadClients[c].index = c;
+		loadClients[c].clients = clients;
+		loadClients[c].count = requests;
+		loadClients[c].writes = writes;
+		loadClients[c].binary = binary;
+		loadClients[c].depth = depth;
+		loadClients[c].sent = latencies + (size_t)c * requests;
+		initByteBuffer(&loadClients[c].requests);
+		initByteBuffer(&loadClients[c].replies);
+
+		if (thrd_create(&threads[c], &runLoadClient, &loadClients[c]) != thrd_success)
+			break;
+		started++;
+	}
+
+	for (int c = 0; c < started; c++)
+	{
+		int result;
+		thrd_join(threads[c], &result);
+		if (result == -1)
+			failed = 1;
+	}
+	double elapsed = nowUs() - start;
+
+	if (!failed && started == clients)
+	{
+		int total = clients * requests;
+		qsort(latencies, total, sizeof(double), &compareLatencies);
+
+		printf("%d clients, %d requests each, %d%% updates, %s protocol, %d in flight:\n", clients, requests, writes,
+			binary ? "binary" : "text", depth);
+		printf("%-20s %12.0lf\n", "requests/s", total * 1e6 / elapsed);
+		printf("%-20s %12.1lf\n", "p50 (us)", latencies[total / 2]);
+		printf("%-20s %12.1lf\n", "p99 (us)", latencies[(int)(total * 0.99)]);
+		printf("%-20s %12.1lf\n", "p99.9 (us)", latencies[(int)(total * 0.999)]);
+		printf("%-20s %12.1lf\n", "max (us)", latencies[total - 1]);
+	}
+	else
+		failed = 1;
+
+	free(loadClients);
+	free(threads);
+	free(latencies);
+
+	return failed ? -1 : 1;
+}
+
+#else
+
+int runLoadGenerator(const char* path, int clients, int requests, int writes, int binary, int depth)
+{
+	return -1;
+}
+
+#endif
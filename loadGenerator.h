@@ -0,0 +1,18 @@
+#pragma once
+
+#define LOAD_BUFFER_SIZE (1 << 16)
+
+/*
+	Measures a running server (see Server): every client connects, adds a material of its own, then sends its requests
+	and records the time from sending each of them to receiving its reply.
+	path - the path of the socket of the server
+	clients - the number of clients, each on its own thread
+	requests - the number of requests of each client
+	writes - the percentage of the requests that update the quantity of the material of the client; the others are
+		split between lookups of that material and queries for the name of the material of a random client
+	binary - 1 to use the binary protocol (see RequestType), 0 for the text commands
+	depth - the number of requests a client sends without waiting for their replies, 1 to wait for each one
+	Prints the requests per second and the latency percentiles.
+	Returns 1 on success, or -1 if a client could not connect or a request failed.
+*/
+int runLoadGenerator(const char* path, int clients, int requests, int writes, int binary, int depth);
@@ -2,25 +2,173 @@
 #include "ui.h"
 #include "validation.h"
 #include "dynamicArray.h"
+#include "typedVector.h"
+#include "radixSort.h"
+#include "orderBy.h"
+#include "query.h"
+#include "hashMap.h"
+#include "statistics.h"
+#include "planner.h"
+#include "topK.h"
+#include "queryCache.h"
+#include "trigramIndex.h"
+#include "trie.h"
+#include "fuzzy.h"
+#include "calendar.h"
+#include "recipe.h"
+#include "alert.h"
+#include "changeFeed.h"
+#include "batch.h"
+#include "rowWriter.h"
+#include "server.h"
+#include "protocol.h"
+#include "journal.h"
+#include "merkle.h"
+#include "replica.h"
+#include "loadGenerator.h"
+#include "benchmark.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <signal.h>
 #include <crtdbg.h>
 
-int main()
+static Server* runningServer = NULL;
+
+void stopOnSignal(int number)
+{
+	(void)number;
+	stopServer(runningServer);
+}
+
+int main(int argc, char** argv)
 {
+	int batch = argc > 1 && strcmp(argv[1], "--batch") == 0;
+
+	// the output of a batch is written in large blocks instead of line by line
+	if (batch)
+		setvbuf(stdout, NULL, _IOFBF, BATCH_BUFFER_SIZE);
+
 	testDate();
+	testHashMap();
+	testStatistics();
 	testMaterial();
 	testMaterialRepo();
 	testMaterialServices();
 	testValidation();
 	testDynamicArray();
+	testTypedVector();
+	testRadixSort();
+	testOrderBy();
+	testTopK();
+	testQuery();
+	testPlanner();
+	testQueryCache();
+	testTrigramIndex();
+	testTrie();
+	testFuzzy();
+	testCalendar();
+	testRecipe();
+	testAlert();
+	testChangeFeed();
+	testBatch();
+	testRowWriter();
+	testProtocol();
+	testMerkle();
+	testJournal();
+	testServer();
+	testReplica();
 	//_CrtDumpMemoryLeaks();
-	printf("Test ran successfully!\n\n");
+	if (!batch)
+		printf("Test ran successfully!\n\n");
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+	{
+		runBenchmarks();
+		return 0;
+	}
+
+	// --loadgen <socket> [clients] [requests per client] [percentage of updates] [text|binary] [requests in flight]
+	if (argc > 2 && strcmp(argv[1], "--loadgen") == 0)
+	{
+		int settings[] = { 4, 10000, 10 };
+		int binary = argc > 6 && strcmp(argv[6], "binary") == 0;
+		int depth = 1;
+
+		for (int i = 3; i < argc && i < 6; i++)
+			if (parseInteger(argv[i], &settings[i - 3]) == -1)
+				return 1;
+		if ((argc > 6 && !binary && strcmp(argv[6], "text") != 0) || (argc > 7 && parseInteger(argv[7], &depth) == -1))
+			return 1;
+
+		return runLoadGenerator(argv[2], settings[0], settings[1], settings[2], binary, depth) == 1 ? 0 : 1;
+	}
 
 	MaterialRepo* materialRepo = createMaterialRepo(10);
 	MaterialServices* materialServices = createMaterialServices(materialRepo);
 	UI* ui = createUI(materialServices);
 
+	if (batch)
+	{
+		// a batch starts from an empty repository without undo history (see the history command) and reads the
+		// standard input if no file (or -) is given
+		setHistoryLimit(materialServices, 0);
+		FILE* input = stdin;
+		if (argc > 2 && strcmp(argv[2], "-") != 0)
+			input = fopen(argv[2], "r");
+
+		int failed = -1;
+		if (input == NULL)
+			fprintf(stderr, "The batch file could not be opened!\n");
+		else
+			failed = runBatch(ui, input);
+
+		if (input != NULL && input != stdin)
+			fclose(input);
+		destroyUI(ui);
+
+		return failed == 0 ? 0 : 1;
+	}
+
+	// --serve <socket> serves the batch commands until the shutdown command, SIGINT or SIGTERM
+	// --follow <leader socket> <socket> serves a read-only replica of the repository of the leader the same way
+	int follow = argc > 3 && strcmp(argv[1], "--follow") == 0;
+	if ((argc > 2 && strcmp(argv[1], "--serve") == 0) || follow)
+	{
+		Server server;
+		Replica replica;
+		const char* path = follow ? argv[3] : argv[2];
+
+		// as in a batch, the writes change the repository in place until a client asks for history, see setHistoryLimit
+		setHistoryLimit(materialServices, 0);
+		int status = initServer(&server, ui, path);
+
+		if (status == 1 && follow && (initReplica(&replica, materialServices, argv[2]) == -1 || followLeader(&server, &replica) == -1))
+		{
+			freeServer(&server);
+			status = -1;
+		}
+
+		if (status == -1)
+			fprintf(stderr, "The server could not be started!\n");
+		else
+		{
+			runningServer = &server;
+			signal(SIGINT, &stopOnSignal);
+			signal(SIGTERM, &stopOnSignal);
+			printf("Serving on %s\n", path);
+			fflush(stdout);
+
+			status = runServer(&server);
+			freeServer(&server);
+			if (follow)
+				freeReplica(&replica);
+		}
+		destroyUI(ui);
+
+		return status == 1 ? 0 : 1;
+	}
+
 	start(ui);
 
 	destroyUI(ui);
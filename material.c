@@ -36,6 +36,9 @@ Material* createMaterial(char* name, char* supplier, double quantity, Date* date
 
 	material->date = date;
 	material->quantity = quantity;
+	material->position = -1;
+	material->nameSlot = -1;
+	material->supplierSlot = -1;
 
 	return material;
 }
@@ -149,6 +152,17 @@ int greater(Material* x, Material* y)
 	return 0;
 }
 
+int earlier(Material* x, Material* y)
+{
+	if (x == NULL || y == NULL)
+		return -1;
+
+	if (dateKey(getDate(x)) < dateKey(getDate(y)))
+		return 1;
+
+	return 0;
+}
+
 Material* copyMaterial(Material* material)
 {
 	if (material == NULL)
@@ -189,6 +203,9 @@ Material* copyMaterial(Material* material)
 	materialCopy->supplier = supplierCopy;
 	materialCopy->quantity = material->quantity;
 	materialCopy->date = dateCopy;
+	materialCopy->position = -1;
+	materialCopy->nameSlot = -1;
+	materialCopy->supplierSlot = -1;
 
 	return materialCopy;
 }
@@ -284,6 +301,20 @@ void testLessGreater()
 	destroyMaterial(testMaterial2);
 }
 
+void testEarlier()
+{
+	Material* testMaterial1 = createMaterial("testName", "testSupplier", 12.34, createDate(1, 2, 3));
+	Material* testMaterial2 = createMaterial("testName", "testSupplier", 12.34, createDate(2, 2, 3));
+
+	assert(earlier(NULL, testMaterial1) == -1);
+	assert(earlier(testMaterial1, testMaterial2) == 1);
+	assert(earlier(testMaterial2, testMaterial1) == 0);
+	assert(earlier(testMaterial1, testMaterial1) == 0);
+
+	destroyMaterial(testMaterial1);
+	destroyMaterial(testMaterial2);
+}
+
 void testCopyMaterial()
 {
 	Date* testDate = createDate(1, 2, 3);
@@ -313,5 +344,6 @@ void testMaterial()
 	testIsLessThan();
 	testNameContains();
 	testLessGreater();
+	testEarlier();
 	testCopyMaterial();
 }
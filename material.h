@@ -2,12 +2,19 @@
 
 #include "date.h"
 
+/*
+	position - the position of the material in the materials of the repository that holds it, or -1 while it is not
+		in a repository
+	nameSlot, supplierSlot - the positions of the material in the lots of its name and supplier groups, kept by the
+		repository that holds it (see MaterialGroup), or -1 while it is not in a repository
+*/
 typedef struct Material
 {
 	char* name;
 	char* supplier;
 	double quantity;
 	Date* date;
+	int position, nameSlot, supplierSlot;
 } Material;
 
 Material* createMaterial(char* name, char* supplier, double quantity, Date* date);
@@ -23,6 +30,7 @@ int isLessThan(Material* material, char* quantity);
 int nameContains(Material* material, char* string);
 int less(Material* x, Material* y);
 int greater(Material* x, Material* y);
+int earlier(Material* x, Material* y);
 
 Material* copyMaterial(Material* material);
 
@@ -1,11 +1,42 @@
 
 #include "repository.h"
+#include "fuzzy.h"
 
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <limits.h>
 
 
+MaterialGroup* createMaterialGroup()
+{
+	MaterialGroup* group = (MaterialGroup*)malloc(sizeof(MaterialGroup));
+
+	if (group == NULL)
+		return NULL;
+
+	group->lots = createDynamicArray(2, NULL);
+	group->total = 0;
+	group->expired = 0;
+
+	if (group->lots == NULL)
+	{
+		free(group);
+		return NULL;
+	}
+
+	return group;
+}
+
+void destroyMaterialGroup(MaterialGroup* group)
+{
+	if (group == NULL)
+		return;
+
+	destroyDynamicArray(group->lots);
+	free(group);
+}
+
 MaterialRepo* createMaterialRepo(int capacity)
 {
 	MaterialRepo* materialRepo = (MaterialRepo*)malloc(sizeof(MaterialRepo));
@@ -14,6 +45,28 @@ MaterialRepo* createMaterialRepo(int capacity)
 		return NULL;
 
 	materialRepo->data = createDynamicArray(capacity, &destroyMaterial);
+	materialRepo->suppliers = createHashMap(8, &destroyMaterialGroup);
+	materialRepo->names = createHashMap(8, &destroyMaterialGroup);
+	materialRepo->expiredBefore = todayKey();
+	int status = initTrigramIndex(&materialRepo->nameTrigrams);
+	if (initTrie(&materialRepo->nameTrie) == -1 || initTrie(&materialRepo->supplierTrie) == -1)
+		status = -1;
+	if (initCalendar(&materialRepo->calendar) == -1)
+		status = -1;
+	initHistogram(&materialRepo->expiryHistogram);
+	initHistogram(&materialRepo->quantityHistogram);
+	materialRepo->changedNames = createHashMap(8, NULL);
+	materialRepo->changedSuppliers = createHashMap(8, NULL);
+	materialRepo->merkle = (MerkleTree){ NULL, NULL, 0 };
+
+	if (materialRepo->changedNames == NULL || materialRepo->changedSuppliers == NULL)
+		status = -1;
+
+	if (materialRepo->data == NULL || materialRepo->suppliers == NULL || materialRepo->names == NULL || status == -1)
+	{
+		destroyMaterialRepo(materialRepo);
+		return NULL;
+	}
 
 	return materialRepo;
 }
@@ -24,9 +77,498 @@ void destroyMaterialRepo(MaterialRepo* materialRepo)
 		return;
 
 	destroyDynamicArray(materialRepo->data);
+	destroyHashMap(materialRepo->suppliers);
+	destroyHashMap(materialRepo->names);
+	freeTrigramIndex(&materialRepo->nameTrigrams);
+	freeTrie(&materialRepo->nameTrie);
+	freeTrie(&materialRepo->supplierTrie);
+	freeCalendar(&materialRepo->calendar);
+	freeHistogram(&materialRepo->expiryHistogram);
+	freeHistogram(&materialRepo->quantityHistogram);
+	destroyHashMap(materialRepo->changedNames);
+	destroyHashMap(materialRepo->changedSuppliers);
+	freeMerkleTree(&materialRepo->merkle);
 	free(materialRepo);
 }
 
+int isExpiredLot(MaterialRepo* materialRepo, Material* material)
+{
+	return dateKey(getDate(material)) < materialRepo->expiredBefore;
+}
+
+void addToTotals(MaterialGroup* group, MaterialRepo* materialRepo, Material* material, int sign)
+{
+	group->total += sign * getQuantity(material);
+	group->expired += sign * isExpiredLot(materialRepo, material);
+}
+
+Trie* getGroupTrie(MaterialRepo* materialRepo, HashMap* groups)
+{
+	return groups == materialRepo->names ? &materialRepo->nameTrie : &materialRepo->supplierTrie;
+}
+
+static inline int expiresBefore(DynamicArray* lots, int x, int y)
+{
+	return dateKey(getDate(lots->data[x])) < dateKey(getDate(lots->data[y]));
+}
+
+/*
+	Stores a lot at a position of the lots of its name (byName 1) or supplier group, and records the position in it.
+*/
+static inline void placeLot(DynamicArray* lots, int i, Material* material, int byName)
+{
+	lots->data[i] = material;
+	if (byName)
+		material->nameSlot = i;
+	else
+		material->supplierSlot = i;
+}
+
+static inline void swapLots(DynamicArray* lots, int x, int y)
+{
+	Material* material = lots->data[x];
+	placeLot(lots, x, lots->data[y], 1);
+	placeLot(lots, y, material, 1);
+}
+
+void siftLotUp(DynamicArray* lots, int i)
+{
+	while (i > 0 && expiresBefore(lots, i, (i - 1) / 2))
+	{
+		swapLots(lots, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+
+void siftLotDown(DynamicArray* lots, int i)
+{
+	while (2 * i + 1 < len(lots))
+	{
+		int child = 2 * i + 1;
+		if (child + 1 < len(lots) && expiresBefore(lots, child + 1, child))
+			child++;
+		if (!expiresBefore(lots, child, i))
+			break;
+		swapLots(lots, i, child);
+		i = child;
+	}
+}
+
+/*
+	Restores the heap order of the lots of a name after the lot at position i changed.
+*/
+void siftLot(DynamicArray* lots, int i)
+{
+	siftLotUp(lots, i);
+	siftLotDown(lots, i);
+}
+
+/*
+	Finds a lot in a group from the position recorded in it, in O(1).
+	Returns the position, or -1 if the lot is not in the group.
+*/
+int findInGroup(MaterialGroup* group, Material* material, int byName)
+{
+	int position = byName ? material->nameSlot : material->supplierSlot;
+
+	if (position < 0 || position >= len(group->lots) || getElement(group->lots, position) != material)
+		return -1;
+
+	return position;
+}
+
+int removeFromGroup(MaterialRepo* materialRepo, HashMap* groups, const char* key, Material* material)
+{
+	MaterialGroup* group = getValue(groups, key);
+	int byName = groups == materialRepo->names;
+
+	if (group == NULL)
+		return -1;
+
+	int position = findInGroup(group, material, byName);
+
+	if (position != -1)
+	{
+		// the last lot fills the hole, and is sifted to its place in the heap of a name
+		int last = len(group->lots) - 1;
+
+		if (position < last)
+			placeLot(group->lots, position, getElement(group->lots, last), byName);
+		group->lots->size--;
+		if (byName && position < last)
+			siftLot(group->lots, position);
+
+		if (byName)
+			material->nameSlot = -1;
+		else
+			material->supplierSlot = -1;
+		addToTotals(group, materialRepo, material, -1);
+	}
+
+	if (len(group->lots) == 0)
+	{
+		setTrieKey(getGroupTrie(materialRepo, groups), key, NULL, 0);
+		removeValue(groups, key);
+	}
+	else
+		setTrieKey(getGroupTrie(materialRepo, groups), key, group, group->total);
+
+	return 1;
+}
+
+int addToGroup(MaterialRepo* materialRepo, HashMap* groups, const char* key, Material* material)
+{
+	MaterialGroup* group = getValue(groups, key);
+
+	if (group == NULL)
+	{
+		group = createMaterialGroup();
+		if (group == NULL || putValue(groups, key, group) == -1)
+		{
+			destroyMaterialGroup(group);
+			return -1;
+		}
+	}
+
+	if (apd(group->lots, material) == -1)
+		return -1;
+
+	placeLot(group->lots, len(group->lots) - 1, material, groups == materialRepo->names);
+	if (groups == materialRepo->names)
+		siftLotUp(group->lots, len(group->lots) - 1);
+
+	addToTotals(group, materialRepo, material, 1);
+
+	if (setTrieKey(getGroupTrie(materialRepo, groups), key, group, group->total) == -1)
+	{
+		removeFromGroup(materialRepo, groups, key, material);
+		return -1;
+	}
+
+	return 1;
+}
+
+int replaceInGroup(MaterialRepo* materialRepo, HashMap* groups, const char* key, Material* material, Material* newMaterial)
+{
+	MaterialGroup* group = getValue(groups, key);
+
+	if (group == NULL)
+		return -1;
+
+	int position = findInGroup(group, material, groups == materialRepo->names);
+
+	if (position == -1)
+		return -1;
+
+	placeLot(group->lots, position, newMaterial, groups == materialRepo->names);
+	if (groups == materialRepo->names)
+		siftLot(group->lots, position);
+
+	addToTotals(group, materialRepo, material, -1);
+	addToTotals(group, materialRepo, newMaterial, 1);
+	return setTrieKey(getGroupTrie(materialRepo, groups), key, group, group->total);
+}
+
+/*
+	Moves a material to the group of its replacement's key, or replaces it in place if the key did not change.
+*/
+int moveInGroups(MaterialRepo* materialRepo, HashMap* groups, const char* key, const char* newKey, Material* material, Material* newMaterial)
+{
+	if (strcmp(key, newKey) == 0)
+		return replaceInGroup(materialRepo, groups, key, material, newMaterial);
+
+	if (addToGroup(materialRepo, groups, newKey, newMaterial) == -1)
+		return -1;
+
+	return removeFromGroup(materialRepo, groups, key, material);
+}
+
+/*
+	Adds a material to its name group. A new name is also added to the trigram index.
+*/
+int addToNames(MaterialRepo* materialRepo, Material* material)
+{
+	if (addToGroup(materialRepo, materialRepo->names, getName(material), material) == -1)
+		return -1;
+
+	MaterialGroup* group = getValue(materialRepo->names, getName(material));
+
+	if (len(group->lots) == 1 && addTrigrams(&materialRepo->nameTrigrams, getName(material), group) == -1)
+	{
+		removeFromGroup(materialRepo, materialRepo->names, getName(material), material);
+		return -1;
+	}
+
+	return 1;
+}
+
+/*
+	Removes a material from its name group. The last material of a name also removes the name from the trigram index.
+*/
+void removeFromNames(MaterialRepo* materialRepo, Material* material)
+{
+	MaterialGroup* group = getValue(materialRepo->names, getName(material));
+
+	if (group != NULL && len(group->lots) == 1 && getElement(group->lots, 0) == material)
+		removeTrigrams(&materialRepo->nameTrigrams, getName(material), group);
+
+	removeFromGroup(materialRepo, materialRepo->names, getName(material), material);
+}
+
+void updateStatistics(MaterialRepo* materialRepo, Material* material, int delta)
+{
+	addToHistogram(&materialRepo->expiryHistogram, expiryBucket(getDate(material)), delta);
+	addToHistogram(&materialRepo->quantityHistogram, quantityBucket(getQuantity(material)), delta);
+}
+
+/*
+	Records the name and the supplier of a material as changed. Only the keys are stored, the material may be
+	destroyed afterwards.
+*/
+void markChanged(MaterialRepo* materialRepo, Material* material)
+{
+	putValue(materialRepo->changedNames, getName(material), NULL);
+	putValue(materialRepo->changedSuppliers, getSupplier(material), NULL);
+}
+
+void clearChanges(MaterialRepo* materialRepo)
+{
+	if (materialRepo == NULL)
+		return;
+
+	clearHashMap(materialRepo->changedNames);
+	clearHashMap(materialRepo->changedSuppliers);
+}
+
+/*
+	Adds a lot to the Merkle tree if it is built. The tree is only a summary of the lots, so one that cannot be kept
+	up to date is dropped, to be built again when it is needed.
+*/
+void addToMerkle(MaterialRepo* materialRepo, Material* material)
+{
+	if (materialRepo->merkle.nodes != NULL && addToMerkleTree(&materialRepo->merkle, material) == -1)
+		dropMerkleTree(materialRepo);
+}
+
+void removeFromMerkle(MaterialRepo* materialRepo, Material* material)
+{
+	if (materialRepo->merkle.nodes != NULL)
+		removeFromMerkleTree(&materialRepo->merkle, material);
+}
+
+/*
+	Adds a material that was just stored in the repository to the indexes, the aggregates and the statistics.
+*/
+int indexMaterial(MaterialRepo* materialRepo, Material* material)
+{
+	if (addToGroup(materialRepo, materialRepo->suppliers, getSupplier(material), material) == -1)
+		return -1;
+
+	if (addToNames(materialRepo, material) == -1)
+	{
+		removeFromGroup(materialRepo, materialRepo->suppliers, getSupplier(material), material);
+		return -1;
+	}
+
+	if (addToCalendar(&materialRepo->calendar, material) == -1)
+	{
+		removeFromGroup(materialRepo, materialRepo->suppliers, getSupplier(material), material);
+		removeFromNames(materialRepo, material);
+		return -1;
+	}
+
+	updateStatistics(materialRepo, material, 1);
+	markChanged(materialRepo, material);
+	addToMerkle(materialRepo, material);
+	return 1;
+}
+
+/*
+	Removes a material that is about to leave the repository from the indexes, the aggregates and the statistics.
+*/
+void unindexMaterial(MaterialRepo* materialRepo, Material* material)
+{
+	removeFromGroup(materialRepo, materialRepo->suppliers, getSupplier(material), material);
+	removeFromNames(materialRepo, material);
+	removeFromCalendar(&materialRepo->calendar, material);
+	updateStatistics(materialRepo, material, -1);
+	markChanged(materialRepo, material);
+	removeFromMerkle(materialRepo, material);
+}
+
+/*
+	Moves the index entries of a material to the material that replaces it at the same position.
+*/
+int reindexMaterial(MaterialRepo* materialRepo, Material* material, Material* newMaterial)
+{
+	if (moveInGroups(materialRepo, materialRepo->suppliers, getSupplier(material), getSupplier(newMaterial), material, newMaterial) == -1)
+		return -1;
+
+	if (strcmp(getName(material), getName(newMaterial)) == 0)
+		replaceInGroup(materialRepo, materialRepo->names, getName(material), material, newMaterial);
+	else if (addToNames(materialRepo, newMaterial) == 1)
+		removeFromNames(materialRepo, material);
+	else
+	{
+		moveInGroups(materialRepo, materialRepo->suppliers, getSupplier(newMaterial), getSupplier(material), newMaterial, material);
+		return -1;
+	}
+
+	if (dayNumber(getDate(material)) == dayNumber(getDate(newMaterial)))
+		replaceInCalendar(&materialRepo->calendar, material, newMaterial);
+	else
+	{
+		addToCalendar(&materialRepo->calendar, newMaterial);
+		removeFromCalendar(&materialRepo->calendar, material);
+	}
+
+	updateStatistics(materialRepo, material, -1);
+	updateStatistics(materialRepo, newMaterial, 1);
+	markChanged(materialRepo, material);
+	markChanged(materialRepo, newMaterial);
+	removeFromMerkle(materialRepo, material);
+	addToMerkle(materialRepo, newMaterial);
+	return 1;
+}
+
+MaterialGroup* getSupplierGroup(MaterialRepo* materialRepo, const char* supplier)
+{
+	if (materialRepo == NULL || supplier == NULL)
+		return NULL;
+
+	return getValue(materialRepo->suppliers, supplier);
+}
+
+MaterialGroup* getNameGroup(MaterialRepo* materialRepo, const char* name)
+{
+	if (materialRepo == NULL || name == NULL)
+		return NULL;
+
+	return getValue(materialRepo->names, name);
+}
+
+int findNameGroups(MaterialRepo* materialRepo, const char* pattern, DynamicArray* groups)
+{
+	if (materialRepo == NULL || pattern == NULL || groups == NULL)
+		return 0;
+
+	DynamicArray* candidates = getTrigramCandidates(&materialRepo->nameTrigrams, pattern);
+
+	if (candidates == NULL)
+		return 0;
+
+	// every candidate is a distinct name, so each name is verified only once, whatever its number of lots
+	for (int i = 0; i < len(candidates); i++)
+	{
+		MaterialGroup* group = getElement(candidates, i);
+
+		if (strstr(getName(getElement(group->lots, 0)), pattern) != NULL)
+			apd(groups, group);
+	}
+
+	return 1;
+}
+
+int completeGroups(MaterialRepo* materialRepo, const char* prefix, int bySupplier, int limit, MaterialGroup** groups)
+{
+	if (materialRepo == NULL || groups == NULL || limit < 0)
+		return -1;
+
+	TrieMatch* matches = (TrieMatch*)malloc(sizeof(TrieMatch) * (limit + 1));
+
+	if (matches == NULL)
+		return -1;
+
+	int count = completeTrie(bySupplier ? &materialRepo->supplierTrie : &materialRepo->nameTrie, prefix, limit, matches);
+
+	for (int i = 0; i < count; i++)
+		groups[i] = matches[i].item;
+
+	free(matches);
+	return count;
+}
+
+int suggestNames(MaterialRepo* materialRepo, const char* pattern, int maxDistance, int limit, MaterialGroup** groups, int* distances)
+{
+	if (materialRepo == NULL || pattern == NULL || groups == NULL || distances == NULL || limit < 0)
+		return -1;
+
+	int count = 0;
+	HashMap* names = materialRepo->names;
+
+	for (int slot = 0; slot < names->capacity && limit > 0; slot++)
+	{
+		HashEntry* entry = getEntryAt(names, slot);
+		if (entry == NULL)
+			continue;
+
+		int distance = editDistance(pattern, entry->key, maxDistance);
+		if (distance > maxDistance)
+			continue;
+
+		MaterialGroup* group = entry->value;
+		int position = count;
+		while (position > 0 && (distances[position - 1] > distance ||
+			(distances[position - 1] == distance && groups[position - 1]->total < group->total)))
+			position--;
+
+		if (position == limit)
+			continue;
+
+		if (count < limit)
+			count++;
+		for (int i = count - 1; i > position; i--)
+		{
+			groups[i] = groups[i - 1];
+			distances[i] = distances[i - 1];
+		}
+		groups[position] = group;
+		distances[position] = distance;
+
+		// once the list is full, only the names closer than its last one can enter it
+		if (count == limit && distances[count - 1] < maxDistance)
+			maxDistance = distances[count - 1];
+	}
+
+	return count;
+}
+
+void resetExpiredCounts(HashMap* groups)
+{
+	for (int slot = 0; slot < groups->capacity; slot++)
+	{
+		HashEntry* entry = getEntryAt(groups, slot);
+		if (entry != NULL)
+			((MaterialGroup*)entry->value)->expired = 0;
+	}
+}
+
+int refreshExpiredCounts(MaterialRepo* materialRepo, int today)
+{
+	if (materialRepo == NULL)
+		return -1;
+
+	if (materialRepo->expiredBefore == today)
+		return 1;
+
+	materialRepo->expiredBefore = today;
+	resetExpiredCounts(materialRepo->suppliers);
+	resetExpiredCounts(materialRepo->names);
+
+	for (int i = 0; i < len(materialRepo->data); i++)
+	{
+		Material* material = getElement(materialRepo->data, i);
+
+		if (isExpiredLot(materialRepo, material))
+		{
+			((MaterialGroup*)getValue(materialRepo->suppliers, getSupplier(material)))->expired++;
+			((MaterialGroup*)getValue(materialRepo->names, getName(material)))->expired++;
+		}
+	}
+
+	return 1;
+}
+
 int getSize(MaterialRepo* materialRepo)
 {
 	if (materialRepo == NULL)
@@ -40,12 +582,15 @@ int getMaterialPos(MaterialRepo* materialRepo, Material* material)
 	if (materialRepo == NULL || material == NULL)
 		return -1;
 
-	for (int i = 0; i < len(materialRepo->data); i++)
+	// an equal material has the same name, so only the lots of the name are compared
+	MaterialGroup* group = getNameGroup(materialRepo, getName(material));
+
+	for (int i = 0; group != NULL && i < len(group->lots); i++)
 	{
-		Material* tmpMaterial = getElement(materialRepo->data, i);
+		Material* lot = getElement(group->lots, i);
 
-		if (equalMaterials(tmpMaterial, material) == 1)
-			return i;
+		if (equalMaterials(lot, material) == 1)
+			return lot->position;
 	}
 	return -1;
 }
@@ -65,13 +610,37 @@ int findMaterial(MaterialRepo* materialRepo, Material* material)
 	if (materialRepo == NULL || material == NULL)
 		return -1;
 
-	for (int i = 0; i < len(materialRepo->data); i++)
+	return getMaterialPos(materialRepo, material) != -1;
+}
+
+/*
+	Removes the material at the given position, which was already unindexed, by moving the last material into its
+	place: no other material moves, so the removal costs O(1) whatever the size of the repository.
+*/
+void takeOutMaterial(MaterialRepo* materialRepo, int position)
+{
+	int lastPosition = len(materialRepo->data) - 1;
+
+	((Material*)getElement(materialRepo->data, lastPosition))->position = position;
+	swap(materialRepo->data, position, lastPosition);
+	del(materialRepo->data, lastPosition);
+}
+
+int appendMaterial(MaterialRepo* materialRepo, Material* material)
+{
+	int status = apd(materialRepo->data, material);
+
+	if (status == -1)
+		return -1;
+
+	if (indexMaterial(materialRepo, material) == -1)
 	{
-		Material* tmpMaterial = getElement(materialRepo->data, i);
-		if (equalMaterials(tmpMaterial, material) == 1)
-			return 1;
+		materialRepo->data->size--;
+		return -1;
 	}
-	return 0;
+
+	material->position = len(materialRepo->data) - 1;
+	return 1;
 }
 
 int addMaterial(MaterialRepo* materialRepo, Material* material)
@@ -84,10 +653,14 @@ int addMaterial(MaterialRepo* materialRepo, Material* material)
 	{
 		Material* tmpMaterial = getElement(materialRepo->data, materialPosition);
 		material->quantity += getQuantity(tmpMaterial);
+
+		if (reindexMaterial(materialRepo, tmpMaterial, material) == -1)
+			return -1;
+		material->position = materialPosition;
 		return upd(materialRepo->data, materialPosition, material);
 	}
 
-	return apd(materialRepo->data, material);
+	return appendMaterial(materialRepo, material);
 }
 
 int updateMaterial(MaterialRepo* materialRepo, Material* material, Material* updatedMaterial)
@@ -95,10 +668,16 @@ int updateMaterial(MaterialRepo* materialRepo, Material* material, Material* upd
 	if (materialRepo == NULL || material == NULL || updatedMaterial == NULL)
 		return -1;
 
-	int materialPosition = getMaterialPos(materialRepo, material);
+	int materialPosition = material->position;
+	if (materialPosition == -1 || getElement(materialRepo->data, materialPosition) != material)
+		materialPosition = getMaterialPos(materialRepo, material);
 	if (materialPosition == -1)
 		return -1;
 
+	if (reindexMaterial(materialRepo, getElement(materialRepo->data, materialPosition), updatedMaterial) == -1)
+		return -1;
+
+	updatedMaterial->position = materialPosition;
 	return upd(materialRepo->data, materialPosition, updatedMaterial);
 }
 
@@ -111,7 +690,105 @@ int removeMaterial(MaterialRepo* materialRepo, Material* material)
 	if (materialPosition == -1)
 		return -1;
 
-	return del(materialRepo->data, materialPosition);
+	unindexMaterial(materialRepo, getElement(materialRepo->data, materialPosition));
+	takeOutMaterial(materialRepo, materialPosition);
+	return 1;
+}
+
+int consumeMaterial(MaterialRepo* materialRepo, const char* name, double quantity)
+{
+	if (materialRepo == NULL || name == NULL || quantity <= 0)
+		return -1;
+
+	MaterialGroup* group = getNameGroup(materialRepo, name);
+
+	// the total is a running sum, so it is compared with a small tolerance
+	if (group == NULL || group->total < quantity - 1e-9)
+		return -1;
+
+	double remaining = quantity;
+
+	while (remaining > 0 && group != NULL)
+	{
+		Material* lot = getElement(group->lots, 0);
+		int last = len(group->lots) == 1;
+
+		unindexMaterial(materialRepo, lot);
+
+		if (getQuantity(lot) <= remaining + 1e-9)
+		{
+			remaining -= getQuantity(lot);
+			takeOutMaterial(materialRepo, lot->position);
+
+			// the group is destroyed with its last lot
+			if (last)
+				group = NULL;
+		}
+		else
+		{
+			// the lot keeps its place in the materials array, only its index entries are refreshed
+			lot->quantity -= remaining;
+			remaining = 0;
+			indexMaterial(materialRepo, lot);
+		}
+	}
+
+	return 1;
+}
+
+MerkleTree* getMerkleTree(MaterialRepo* materialRepo)
+{
+	if (materialRepo == NULL)
+		return NULL;
+
+	if (materialRepo->merkle.nodes != NULL)
+		return &materialRepo->merkle;
+
+	if (initMerkleTree(&materialRepo->merkle) == -1)
+		return NULL;
+
+	for (int i = 0; i < getSize(materialRepo); i++)
+	{
+		if (addToMerkleTree(&materialRepo->merkle, getMaterialAtPos(materialRepo, i)) == -1)
+		{
+			freeMerkleTree(&materialRepo->merkle);
+			return NULL;
+		}
+	}
+
+	return &materialRepo->merkle;
+}
+
+void dropMerkleTree(MaterialRepo* materialRepo)
+{
+	if (materialRepo != NULL)
+		freeMerkleTree(&materialRepo->merkle);
+}
+
+int removeBucket(MaterialRepo* materialRepo, int bucket)
+{
+	MerkleTree* tree = getMerkleTree(materialRepo);
+
+	if (tree == NULL || bucket < 0 || bucket >= MERKLE_LEAVES)
+		return -1;
+
+	if (tree->buckets[bucket] == NULL)
+		return 0;
+
+	// the bucket array shrinks as its lots are unindexed, so they are taken from its end; the last material takes the
+	// place of every removed lot, so removing a bucket costs as much as its lots whatever the size of the repository
+	int count = 0;
+
+	while (tree->buckets[bucket] != NULL)
+	{
+		Material* lot = getElement(tree->buckets[bucket], len(tree->buckets[bucket]) - 1);
+
+		unindexMaterial(materialRepo, lot);
+		takeOutMaterial(materialRepo, lot->position);
+		count++;
+	}
+
+	return count;
 }
 
 MaterialRepo* copyMaterialRepo(MaterialRepo* materialRepo)
@@ -127,13 +804,32 @@ MaterialRepo* copyMaterialRepo(MaterialRepo* materialRepo)
 
 	MaterialRepo* materialRepoCopy = createMaterialRepo(capacity);
 
+	if (materialRepoCopy == NULL)
+		return NULL;
+
+	materialRepoCopy->expiredBefore = materialRepo->expiredBefore;
+
+	if (materialRepo->merkle.nodes != NULL && initMerkleTree(&materialRepoCopy->merkle) == -1)
+	{
+		destroyMaterialRepo(materialRepoCopy);
+		return NULL;
+	}
+
+	// the materials of a repository are already distinct, so the copies are appended without searching for duplicates
 	for (int i = 0; i < getSize(materialRepo); i++)
 	{
 		Material* material = getMaterialAtPos(materialRepo, i);
 		Material* materialCopy = copyMaterial(material);
-		addMaterial(materialRepoCopy, materialCopy);
+
+		if (materialCopy == NULL || appendMaterial(materialRepoCopy, materialCopy) == -1)
+		{
+			destroyMaterial(materialCopy);
+			destroyMaterialRepo(materialRepoCopy);
+			return NULL;
+		}
 	}
 
+	clearChanges(materialRepoCopy);
 	return materialRepoCopy;
 }
 
@@ -271,9 +967,11 @@ void testRemoveMaterial()
 	
 	assert(removeMaterial(testMaterialRepo, NULL) == -1);
 
+	// the last material takes the place of the removed one
 	assert(removeMaterial(testMaterialRepo, testMaterial1) == 1);
 	assert(getSize(testMaterialRepo) == 2);
-
+	assert(getMaterialAtPos(testMaterialRepo, 0) == testMaterial3);
+	assert(getMaterialPos(testMaterialRepo, testMaterial3) == 0);
 
 	assert(removeMaterial(testMaterialRepo, testMaterial2) == 1);
 	assert(getSize(testMaterialRepo) == 1);
@@ -314,6 +1012,228 @@ void testCopyMaterialRepo()
 	assert(equalMaterials(getMaterialAtPos(testMaterialRepo, 1), getMaterialAtPos(materialRepoCopy, 1)) == 1);
 	assert(equalMaterials(getMaterialAtPos(testMaterialRepo, 2), getMaterialAtPos(materialRepoCopy, 2)) == 1);
 
+	assert(mapSize(testMaterialRepo->changedNames) == 3 && mapSize(testMaterialRepo->changedSuppliers) == 3);
+	assert(mapSize(materialRepoCopy->changedNames) == 0 && mapSize(materialRepoCopy->changedSuppliers) == 0);
+
+	clearChanges(testMaterialRepo);
+	removeMaterial(testMaterialRepo, testMaterial2);
+	assert(mapSize(testMaterialRepo->changedNames) == 1 && mapSize(testMaterialRepo->changedSuppliers) == 1);
+	for (int i = 0; i < testMaterialRepo->changedSuppliers->capacity; i++)
+		if (getEntryAt(testMaterialRepo->changedSuppliers, i) != NULL)
+			assert(strcmp(getEntryAt(testMaterialRepo->changedSuppliers, i)->key, "otherSupplier") == 0);
+
+	destroyMaterialRepo(testMaterialRepo);
+	destroyMaterialRepo(materialRepoCopy);
+}
+
+void testMaterialRepoIndexes()
+{
+	MaterialRepo* testMaterialRepo = createMaterialRepo(1);
+
+	Material* testMaterial1 = createMaterial("testName", "testSupplier", 1, createDate(1, 2, 2020));
+	Material* testMaterial2 = createMaterial("otherName", "testSupplier", 2, createDate(3, 2, 2021));
+	Material* testMaterial3 = createMaterial("otherName", "testSupplier", 3, createDate(3, 2, 2021));
+	Material* testMaterial4 = createMaterial("otherName", "otherSupplier", 4, createDate(3, 2, 2021));
+
+	addMaterial(testMaterialRepo, testMaterial1);
+	addMaterial(testMaterialRepo, testMaterial2);
+	assert(getSupplierGroup(testMaterialRepo, "otherSupplier") == NULL);
+	assert(len(getSupplierGroup(testMaterialRepo, "testSupplier")->lots) == 2);
+	assert(testMaterialRepo->quantityHistogram.total == 2);
+
+	addMaterial(testMaterialRepo, testMaterial3);
+	assert(len(getSupplierGroup(testMaterialRepo, "testSupplier")->lots) == 2);
+	assert(getElement(getSupplierGroup(testMaterialRepo, "testSupplier")->lots, 1) == testMaterial3);
+	assert(histogramCount(&testMaterialRepo->quantityHistogram, quantityBucket(5)) == 1);
+
+	updateMaterial(testMaterialRepo, testMaterial3, testMaterial4);
+	assert(len(getSupplierGroup(testMaterialRepo, "testSupplier")->lots) == 1);
+	assert(len(getSupplierGroup(testMaterialRepo, "otherSupplier")->lots) == 1);
+
+	assert(testMaterialRepo->calendar.size == 2);
+
+	MaterialRepo* materialRepoCopy = copyMaterialRepo(testMaterialRepo);
+	assert(len(getSupplierGroup(materialRepoCopy, "otherSupplier")->lots) == 1);
+	assert(materialRepoCopy->calendar.size == 2);
+	assert(materialRepoCopy->expiryHistogram.total == 2);
+
+	removeMaterial(testMaterialRepo, testMaterial4);
+	assert(getSupplierGroup(testMaterialRepo, "otherSupplier") == NULL);
+	assert(testMaterialRepo->expiryHistogram.total == 1);
+	assert(testMaterialRepo->calendar.size == 1);
+
+	// the last lot of a supplier fills the hole of a removed one, and its recorded position follows it
+	addMaterial(testMaterialRepo, createMaterial("a", "testSupplier", 1, createDate(1, 1, 2030)));
+	addMaterial(testMaterialRepo, createMaterial("b", "testSupplier", 1, createDate(1, 1, 2030)));
+	removeMaterial(testMaterialRepo, testMaterial1);
+	MaterialGroup* group = getSupplierGroup(testMaterialRepo, "testSupplier");
+	assert(len(group->lots) == 2);
+	for (int i = 0; i < len(group->lots); i++)
+		assert(((Material*)getElement(group->lots, i))->supplierSlot == i);
+	assert(((Material*)getElement(getNameGroup(testMaterialRepo, "a")->lots, 0))->nameSlot == 0);
+
+	destroyMaterialRepo(testMaterialRepo);
+	destroyMaterialRepo(materialRepoCopy);
+}
+
+void testMaterialRepoAggregates()
+{
+	MaterialRepo* testMaterialRepo = createMaterialRepo(1);
+	Date day1 = { 1, 1, 2021 }, day2 = { 1, 1, 2020 };
+	refreshExpiredCounts(testMaterialRepo, dateKey(&day1));
+
+	Material* testMaterial1 = createMaterial("testName", "testSupplier", 1, createDate(1, 2, 2020));
+	Material* testMaterial2 = createMaterial("otherName", "testSupplier", 2, createDate(3, 2, 2021));
+	Material* testMaterial3 = createMaterial("otherName", "testSupplier", 3, createDate(3, 2, 2021));
+	Material* testMaterial4 = createMaterial("testName", "otherSupplier", 4, createDate(3, 2, 2019));
+
+	addMaterial(testMaterialRepo, testMaterial1);
+	addMaterial(testMaterialRepo, testMaterial2);
+	assert(getSupplierGroup(testMaterialRepo, "testSupplier")->total == 3);
+	assert(getSupplierGroup(testMaterialRepo, "testSupplier")->expired == 1);
+	assert(getNameGroup(testMaterialRepo, "otherName")->total == 2);
+	assert(getNameGroup(testMaterialRepo, "otherName")->expired == 0);
+
+	// the quantity of an existing lot is merged
+	addMaterial(testMaterialRepo, testMaterial3);
+	assert(getNameGroup(testMaterialRepo, "otherName")->total == 5);
+	assert(len(getNameGroup(testMaterialRepo, "otherName")->lots) == 1);
+	assert(getSupplierGroup(testMaterialRepo, "testSupplier")->total == 6);
+
+	updateMaterial(testMaterialRepo, testMaterial3, testMaterial4);
+	assert(getNameGroup(testMaterialRepo, "otherName") == NULL);
+	assert(getNameGroup(testMaterialRepo, "testName")->total == 5);
+	assert(getNameGroup(testMaterialRepo, "testName")->expired == 2);
+	assert(getSupplierGroup(testMaterialRepo, "otherSupplier")->expired == 1);
+
+	MaterialGroup* completions[2];
+	assert(completeGroups(testMaterialRepo, "t", 0, 2, completions) == 1);
+	assert(completions[0] == getNameGroup(testMaterialRepo, "testName"));
+	assert(completeGroups(testMaterialRepo, "", 1, 2, completions) == 2);
+	assert(completions[0] == getSupplierGroup(testMaterialRepo, "otherSupplier"));
+	assert(completeGroups(testMaterialRepo, "o", 0, 2, completions) == 0);
+
+	int distances[2];
+	assert(suggestNames(testMaterialRepo, "TestNane", 2, 2, completions, distances) == 1);
+	assert(completions[0] == getNameGroup(testMaterialRepo, "testName") && distances[0] == 1);
+	assert(suggestNames(testMaterialRepo, "other", 2, 2, completions, distances) == 0);
+
+	DynamicArray* groups = createDynamicArray(2, NULL);
+	assert(findNameGroups(testMaterialRepo, "Name", groups) == 1);
+	assert(len(groups) == 1 && getElement(groups, 0) == getNameGroup(testMaterialRepo, "testName"));
+	assert(findNameGroups(testMaterialRepo, "Na", groups) == 0);
+	destroyDynamicArray(groups);
+
+	MaterialRepo* materialRepoCopy = copyMaterialRepo(testMaterialRepo);
+	assert(getNameGroup(materialRepoCopy, "testName")->total == 5);
+	assert(getNameGroup(materialRepoCopy, "testName")->expired == 2);
+
+	refreshExpiredCounts(testMaterialRepo, dateKey(&day2));
+	assert(getNameGroup(testMaterialRepo, "testName")->expired == 1);
+	assert(getSupplierGroup(testMaterialRepo, "testSupplier")->expired == 0);
+
+	removeMaterial(testMaterialRepo, testMaterial4);
+	assert(getNameGroup(testMaterialRepo, "testName")->total == 1);
+	assert(getNameGroup(testMaterialRepo, "testName")->expired == 0);
+
+	destroyMaterialRepo(testMaterialRepo);
+	destroyMaterialRepo(materialRepoCopy);
+}
+
+void testConsumeMaterial()
+{
+	MaterialRepo* testMaterialRepo = createMaterialRepo(1);
+
+	int days[] = { 5, 1, 4, 2, 3 };
+	for (int i = 0; i < 5; i++)
+		addMaterial(testMaterialRepo, createMaterial("flour", i % 2 ? "x" : "y", 10, createDate(days[i], 1, 2030)));
+	addMaterial(testMaterialRepo, createMaterial("sugar", "x", 1, createDate(1, 1, 2030)));
+
+	MaterialGroup* group = getNameGroup(testMaterialRepo, "flour");
+	assert(getDay(getDate(getElement(group->lots, 0))) == 1);
+
+	assert(consumeMaterial(testMaterialRepo, "flour", 51) == -1);
+	assert(consumeMaterial(testMaterialRepo, "salt", 1) == -1);
+	assert(getSize(testMaterialRepo) == 6 && group->total == 50);
+
+	// the lots of the 1st and 2nd are used up, the one of the 3rd is reduced
+	assert(consumeMaterial(testMaterialRepo, "flour", 25) == 1);
+	assert(getSize(testMaterialRepo) == 4);
+	group = getNameGroup(testMaterialRepo, "flour");
+	assert(group->total == 25 && len(group->lots) == 3);
+	assert(getDay(getDate(getElement(group->lots, 0))) == 3);
+	assert(getQuantity(getElement(group->lots, 0)) == 5);
+	assert(getSupplierGroup(testMaterialRepo, "x")->total == 1);
+	assert(getSupplierGroup(testMaterialRepo, "y")->total == 25);
+	assert(testMaterialRepo->quantityHistogram.total == 4);
+	assert(countCalendarRange(&testMaterialRepo->calendar, 0, INT_MAX) == 4);
+
+	// the lots left record their new positions, so they are still found
+	for (int i = 0; i < getSize(testMaterialRepo); i++)
+		assert(getMaterialPos(testMaterialRepo, getMaterialAtPos(testMaterialRepo, i)) == i);
+
+	assert(consumeMaterial(testMaterialRepo, "flour", 25) == 1);
+	assert(getNameGroup(testMaterialRepo, "flour") == NULL);
+	assert(getSize(testMaterialRepo) == 1);
+	assert(strcmp(getName(getMaterialAtPos(testMaterialRepo, 0)), "sugar") == 0);
+
+	destroyMaterialRepo(testMaterialRepo);
+}
+
+/*
+	Gets the root hash of a tree built from scratch over the lots of the repository.
+*/
+uint64_t rebuiltMerkleRoot(MaterialRepo* materialRepo)
+{
+	MerkleTree tree;
+
+	assert(initMerkleTree(&tree) == 1);
+	for (int i = 0; i < getSize(materialRepo); i++)
+		assert(addToMerkleTree(&tree, getMaterialAtPos(materialRepo, i)) == 1);
+
+	uint64_t root = getMerkleRoot(&tree);
+	freeMerkleTree(&tree);
+	return root;
+}
+
+void testMerkleRepo()
+{
+	MaterialRepo* testMaterialRepo = createMaterialRepo(2);
+
+	addMaterial(testMaterialRepo, createMaterial("Eggs", "Farm", 3, createDate(1, 1, 2030)));
+	addMaterial(testMaterialRepo, createMaterial("Eggs", "Coop", 2, createDate(2, 1, 2030)));
+	assert(testMaterialRepo->merkle.nodes == NULL);
+
+	MerkleTree* tree = getMerkleTree(testMaterialRepo);
+	assert(tree != NULL && tree->lots == 2 && getMerkleRoot(tree) == rebuiltMerkleRoot(testMaterialRepo));
+
+	// every operation keeps the tree up to date, the merged quantities included
+	addMaterial(testMaterialRepo, createMaterial("Eggs", "Farm", 1, createDate(1, 1, 2030)));
+	addMaterial(testMaterialRepo, createMaterial("Milk", "Dairy", 1, createDate(1, 1, 2030)));
+	updateMaterial(testMaterialRepo, getMaterialAtPos(testMaterialRepo, 1), createMaterial("Salt", "Mine", 5, createDate(1, 1, 2031)));
+	assert(consumeMaterial(testMaterialRepo, "Eggs", 1) == 1);
+	assert(tree->lots == 3 && getMerkleRoot(tree) == rebuiltMerkleRoot(testMaterialRepo));
+
+	MaterialRepo* materialRepoCopy = copyMaterialRepo(testMaterialRepo);
+	assert(materialRepoCopy->merkle.nodes != NULL && getMerkleRoot(&materialRepoCopy->merkle) == getMerkleRoot(tree));
+
+	// a bucket is emptied in one pass, leaving the lots of the other buckets
+	Material* milk = getMaterialAtPos(testMaterialRepo, 2);
+	int bucket = lotBucket(milk);
+	int others = 0;
+	for (int i = 0; i < getSize(testMaterialRepo); i++)
+		others += lotBucket(getMaterialAtPos(testMaterialRepo, i)) != bucket;
+
+	assert(removeBucket(testMaterialRepo, bucket) >= 1 && removeBucket(testMaterialRepo, bucket) == 0);
+	assert(removeBucket(testMaterialRepo, MERKLE_LEAVES) == -1);
+	assert(getSize(testMaterialRepo) == others && tree->lots == others && tree->buckets[bucket] == NULL);
+	assert(getMerkleRoot(tree) == rebuiltMerkleRoot(testMaterialRepo));
+
+	// a dropped tree is built again with the same hashes
+	dropMerkleTree(materialRepoCopy);
+	assert(materialRepoCopy->merkle.nodes == NULL);
+	assert(getMerkleRoot(getMerkleTree(materialRepoCopy)) == rebuiltMerkleRoot(materialRepoCopy));
+
 	destroyMaterialRepo(testMaterialRepo);
 	destroyMaterialRepo(materialRepoCopy);
 }
@@ -327,4 +1247,8 @@ void testMaterialRepo()
 	testUpdateMaterial();
 	testRemoveMaterial();
 	testCopyMaterialRepo();
+	testMaterialRepoIndexes();
+	testMaterialRepoAggregates();
+	testConsumeMaterial();
+	testMerkleRepo();
 }
@@ -1,5 +1,8 @@
 
 #include "services.h"
+#include "journal.h"
+#include "radixSort.h"
+#include "typedVector.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -7,6 +10,10 @@
 #include <stdio.h>
 
 
+#define ENTRY_LESS(x, y) (strcmp((*(x))->key, (*(y))->key) < 0)
+
+DEFINE_SORT(Entry, HashEntry*, ENTRY_LESS)
+
 MaterialServices* createMaterialServices(MaterialRepo* materialRepo)
 {
 	MaterialServices* materialServices = (MaterialServices*)malloc(sizeof(MaterialServices));
@@ -16,9 +23,20 @@ MaterialServices* createMaterialServices(MaterialRepo* materialRepo)
 
 	materialServices->materialRepo = materialRepo;
 	materialServices->index = 0;
+	materialServices->transaction = 0;
+	materialServices->transactionStatus = 0;
+	materialServices->version = 0;
+	materialServices->journal = NULL;
+	materialServices->readOnly = 0;
+	materialServices->historyLimit = -1;
+	initQueryCache(&materialServices->queryCache);
+	materialServices->recipes = createHashMap(8, &free);
 	materialServices->repoStack = createDynamicArray(2, &destroyMaterialRepo);
 
-	if (materialServices->repoStack == NULL)
+	if (materialServices->recipes == NULL || materialServices->repoStack == NULL)
+		return NULL;
+
+	if (initAlertMonitor(&materialServices->alerts) == -1 || initChangeFeed(&materialServices->changes) == -1)
 		return NULL;
 
 	int status = apd(materialServices->repoStack, materialServices->materialRepo);
@@ -34,6 +52,10 @@ void destroyMaterialServices(MaterialServices* materialServices)
 	if (materialServices == NULL)
 		return;
 
+	clearQueryCache(&materialServices->queryCache);
+	destroyHashMap(materialServices->recipes);
+	freeAlertMonitor(&materialServices->alerts);
+	freeChangeFeed(&materialServices->changes);
 	destroyDynamicArray(materialServices->repoStack);
 	free(materialServices);
 }
@@ -54,6 +76,8 @@ void initMaterialRepo(MaterialServices* materialServices)
 	addMaterial(materialServices->materialRepo, createMaterial("Sprouted flour", "CakesSupply", 25, createDate(12, 3, 2022)));
 	addMaterial(materialServices->materialRepo, createMaterial("Seeds mix", "HomeGoods", 33, createDate(3, 3, 2022)));
 
+	materialServices->version++;
+	checkAllAlerts(&materialServices->alerts, materialServices->materialRepo, keyDayNumber(todayKey()), materialServices->version);
 }
 
 Material* getMaterial(MaterialServices* materialServices, int position)
@@ -64,33 +88,165 @@ Material* getMaterial(MaterialServices* materialServices, int position)
 	return getMaterialAtPos(materialServices->materialRepo, position);
 }
 
+Material* findLot(MaterialServices* materialServices, const char* name, const char* supplier, int day, int month, int year)
+{
+	if (materialServices == NULL || name == NULL || supplier == NULL)
+		return NULL;
+
+	MaterialGroup* group = getNameGroup(materialServices->materialRepo, name);
+
+	if (group == NULL)
+		return NULL;
+
+	for (int i = 0; i < len(group->lots); i++)
+	{
+		Material* material = getElement(group->lots, i);
+		const Date* date = getDate(material);
+
+		if (getDay(date) == day && getMonth(date) == month && getYear(date) == year && strcmp(getSupplier(material), supplier) == 0)
+			return material;
+	}
+
+	return NULL;
+}
+
+
+int buildExpiredQuery(Query* query, int (*filterFunction)(Material*, char*), char* filter, int limit)
+{
+	if (query == NULL || limit < 0)
+		return -1;
+
+	initQuery(query);
+	addExpiredFilter(query);
+	addCustomFilter(query, filterFunction, filter);
+
+	// a lot is the only one with its name, supplier and date, so the rows come in the same order whichever index
+	// the filters select
+	query->limit = limit;
+	query->orderBy.count = 3;
+	query->orderBy.keys[0].column = COLUMN_DATE;
+	query->orderBy.keys[1].column = COLUMN_NAME;
+	query->orderBy.keys[2].column = COLUMN_SUPPLIER;
+
+	return 1;
+}
+
+DynamicArray* getExpiredTop(MaterialServices* materialServices, int (*filterFunction)(Material*, char*), char* filter, int limit)
+{
+	Query query;
+
+	if (materialServices == NULL || buildExpiredQuery(&query, filterFunction, filter, limit) == -1)
+		return NULL;
+
+	return collectQuery(materialServices->materialRepo, &query);
+}
 
 DynamicArray* getExpired(MaterialServices* materialServices, int (*filterFunction)(Material*, char*), char* filter)
 {
-	DynamicArray* dArray = createDynamicArray(2, &destroyMaterial);
-	
-	for (int i = 0; i < getSize(materialServices->materialRepo); i++)
-	{
-		Material* material = getMaterialAtPos(materialServices->materialRepo, i);
+	return getExpiredTop(materialServices, filterFunction, filter, 0);
+}
+
+DynamicArray* getQueryResult(MaterialServices* materialServices, const Query* query)
+{
+	if (materialServices == NULL || query == NULL)
+		return NULL;
+
+	return collectQuery(materialServices->materialRepo, query);
+}
+
+DynamicArray* getQueryView(MaterialServices* materialServices, const Query* query)
+{
+	if (materialServices == NULL || query == NULL)
+		return NULL;
+
+	QueryCache* queryCache = &materialServices->queryCache;
+	DynamicArray* rows = lookupQueryCache(queryCache, query, materialServices->version);
 
-		int expired = isExpired(getDate(material));
-		int ok = filterFunction(material, filter);
-		if (expired == 1 && ok == 1)
+	if (rows == NULL)
+	{
+		rows = collectQueryView(materialServices->materialRepo, query);
+		if (rows == NULL || storeQueryCache(queryCache, query, materialServices->version, rows) == -1)
 		{
-			Material* materialCopy = copyMaterial(material);
-			apd(dArray, materialCopy);
+			destroyDynamicArray(rows);
+			return NULL;
 		}
 	}
 
-	return dArray;
+	DynamicArray* view = createDynamicArray(len(rows) + 2, NULL);
+
+	if (view == NULL || apdMany(view, rows->data, len(rows)) == -1)
+	{
+		destroyDynamicArray(view);
+		return NULL;
+	}
+
+	return view;
 }
 
-void clearStack(MaterialServices* materialServices)
+DynamicArray* getTotals(MaterialServices* materialServices, int bySupplier)
 {
-	for (int i = materialServices->index + 1; i < len(materialServices->repoStack); i++)
+	if (materialServices == NULL)
+		return NULL;
+
+	MaterialRepo* materialRepo = materialServices->materialRepo;
+	HashMap* groups = bySupplier ? materialRepo->suppliers : materialRepo->names;
+
+	refreshExpiredCounts(materialRepo, todayKey());
+
+	DynamicArray* totals = createDynamicArray(mapSize(groups) + 2, NULL);
+
+	if (totals == NULL)
+		return NULL;
+
+	for (int slot = 0; slot < groups->capacity; slot++)
 	{
-		del(materialServices->repoStack, i);
+		HashEntry* entry = getEntryAt(groups, slot);
+		if (entry != NULL)
+			apd(totals, entry);
 	}
+
+	EntrySort((HashEntry**)totals->data, len(totals));
+	return totals;
+}
+
+int getCompletions(MaterialServices* materialServices, const char* prefix, int bySupplier, int limit, MaterialGroup** groups)
+{
+	if (materialServices == NULL)
+		return -1;
+
+	return completeGroups(materialServices->materialRepo, prefix, bySupplier, limit, groups);
+}
+
+int getSuggestions(MaterialServices* materialServices, const char* name, int limit, MaterialGroup** groups, int* distances)
+{
+	if (materialServices == NULL)
+		return -1;
+
+	return suggestNames(materialServices->materialRepo, name, SUGGEST_DISTANCE, limit, groups, distances);
+}
+
+int getExpiryHistogram(MaterialServices* materialServices, int byMonth, int count, CalendarBin* bins)
+{
+	if (materialServices == NULL)
+		return -1;
+
+	int today = todayKey();
+	Date date = { today & 0x1F, (today >> 5) & 0xF, today >> 9 };
+
+	return getCalendarHistogram(&materialServices->materialRepo->calendar, dayNumber(&date), byMonth ? expiryBucket(&date) : -1, count, bins);
+}
+
+int explain(MaterialServices* materialServices, const Query* query, QueryPlan* plan)
+{
+	if (materialServices == NULL)
+		return -1;
+
+	return explainQuery(materialServices->materialRepo, query, plan);
+}
+
+void clearStack(MaterialServices* materialServices)
+{
+	delRange(materialServices->repoStack, materialServices->index + 1, len(materialServices->repoStack));
 }
 
 int setMaterialRepo(MaterialServices* materialServices)
@@ -110,6 +266,195 @@ int setMaterialRepo(MaterialServices* materialServices)
 	
 	materialServices->materialRepo = materialRepoCopy;
 	materialServices->index++;
+	materialServices->version++;
+
+	// the Merkle tree moved to the copy, the repository left on the undo stack builds it again if it is needed
+	dropMerkleTree(getElement(materialServices->repoStack, materialServices->index - 1));
+
+	return 1;
+}
+
+/*
+	Drops the snapshot on top of the undo stack and goes back to the repository under it.
+*/
+void dropSnapshot(MaterialServices* materialServices)
+{
+	materialServices->index--;
+	materialServices->materialRepo = getElement(materialServices->repoStack, materialServices->index);
+	del(materialServices->repoStack, materialServices->index + 1);
+	materialServices->version++;
+}
+
+/*
+	Publishes a change to the change feed. The strings are only hashed and the date is only packed,
+	so publishing costs about as much as a few stores.
+*/
+void recordChange(MaterialServices* materialServices, ChangeType type, const char* name, const char* supplier, double quantity, int day, int month, int year)
+{
+	Date date = { day, month, year };
+	ChangeRecord record;
+
+	record.version = materialServices->version;
+	record.type = type;
+	record.dateKey = day == 0 ? 0 : dateKey(&date);
+	record.quantity = quantity;
+	record.nameHash = name == NULL ? 0 : hashString(name);
+	record.supplierHash = supplier == NULL ? 0 : hashString(supplier);
+
+	publishChange(&materialServices->changes, &record);
+}
+
+/*
+	Drops the oldest undo steps above the history limit.
+*/
+void trimHistory(MaterialServices* materialServices)
+{
+	if (materialServices->historyLimit == -1)
+		return;
+
+	int excess = materialServices->index - materialServices->historyLimit;
+
+	if (excess > 0)
+	{
+		delRange(materialServices->repoStack, 0, excess);
+		materialServices->index -= excess;
+	}
+}
+
+int setHistoryLimit(MaterialServices* materialServices, int limit)
+{
+	if (materialServices == NULL || limit < -1)
+		return -1;
+
+	materialServices->historyLimit = limit;
+
+	// the snapshot of an active transaction is its rollback base, it is trimmed at the commit
+	if (materialServices->transaction == 0)
+		trimHistory(materialServices);
+
+	return 1;
+}
+
+int prepareMutation(MaterialServices* materialServices)
+{
+	if (materialServices->readOnly)
+		return -1;
+
+	if (materialServices->transaction == 1)
+		return 1;
+
+	// without history the repository is changed in place, the steps that could be redone are dropped all the same
+	if (materialServices->historyLimit == 0)
+	{
+		clearStack(materialServices);
+		return 1;
+	}
+
+	return setMaterialRepo(materialServices);
+}
+
+/*
+	Undoes the partial changes of an operation that failed halfway outside a transaction: its snapshot is dropped, or,
+	for a repository changed in place, the journal records the whole repository again so followers stay in step.
+*/
+void abandonMutation(MaterialServices* materialServices)
+{
+	rollbackJournal(materialServices->journal);
+
+	if (materialServices->historyLimit == 0)
+		journalReset(materialServices->journal, materialServices->materialRepo);
+	else
+		dropSnapshot(materialServices);
+}
+
+int finishMutation(MaterialServices* materialServices, int status)
+{
+	materialServices->version++;
+
+	// the changes of a transaction are checked together at its commit, a rollback leaves the rules as they were
+	if (materialServices->transaction == 0)
+	{
+		checkChangedAlerts(&materialServices->alerts, materialServices->materialRepo, keyDayNumber(todayKey()), materialServices->version);
+		commitJournal(materialServices->journal);
+		trimHistory(materialServices);
+	}
+
+	if (materialServices->transaction == 1)
+	{
+		if (status == -1)
+			materialServices->transactionStatus = -1;
+		else if (materialServices->transactionStatus == 0)
+			materialServices->transactionStatus = 1;
+	}
+
+	return status;
+}
+
+/*
+	Fails an operation that is refused before it changes anything: the repository and its version are left as they
+	are, only an active transaction is marked as failed, unless the services are read-only for the caller.
+*/
+int rejectMutation(MaterialServices* materialServices)
+{
+	if (materialServices->transaction == 1 && !materialServices->readOnly)
+		materialServices->transactionStatus = -1;
+
+	return -1;
+}
+
+int beginTransaction(MaterialServices* materialServices)
+{
+	if (materialServices == NULL || materialServices->transaction == 1 || materialServices->readOnly)
+		return -1;
+
+	int status = setMaterialRepo(materialServices);
+
+	if (status == -1)
+		return -1;
+
+	materialServices->transaction = 1;
+	materialServices->transactionStatus = 0;
+	recordChange(materialServices, CHANGE_BEGIN, NULL, NULL, 0, 0, 0, 0);
+
+	return 1;
+}
+
+int rollbackTransaction(MaterialServices* materialServices)
+{
+	if (materialServices == NULL || materialServices->transaction == 0 || materialServices->readOnly)
+		return -1;
+
+	dropSnapshot(materialServices);
+
+	materialServices->transaction = 0;
+	materialServices->transactionStatus = 0;
+	rollbackJournal(materialServices->journal);
+	recordChange(materialServices, CHANGE_ROLLBACK, NULL, NULL, 0, 0, 0, 0);
+
+	return 1;
+}
+
+int commitTransaction(MaterialServices* materialServices)
+{
+	if (materialServices == NULL || materialServices->transaction == 0 || materialServices->readOnly)
+		return -1;
+
+	int status = materialServices->transactionStatus;
+
+	if (status != 1)
+	{
+		rollbackTransaction(materialServices);
+		if (status == 0)
+			return 1;
+		return -1;
+	}
+
+	materialServices->transaction = 0;
+	materialServices->transactionStatus = 0;
+	checkChangedAlerts(&materialServices->alerts, materialServices->materialRepo, keyDayNumber(todayKey()), materialServices->version);
+	commitJournal(materialServices->journal);
+	trimHistory(materialServices);
+	recordChange(materialServices, CHANGE_COMMIT, NULL, NULL, 0, 0, 0, 0);
 
 	return 1;
 }
@@ -125,7 +470,7 @@ int add(MaterialServices* materialServices, char* name, char* supplier, double q
 	if (material == NULL)
 		return -1;
 
-	int status = setMaterialRepo(materialServices);
+	int status = prepareMutation(materialServices);
 
 	if (status == -1)
 	{
@@ -136,6 +481,12 @@ int add(MaterialServices* materialServices, char* name, char* supplier, double q
 	status = addMaterial(materialServices->materialRepo, material);
 	if (status == -1)
 		destroyMaterial(material);
+	else
+		journalPut(materialServices->journal, material);
+
+	status = finishMutation(materialServices, status);
+	if (status == 1)
+		recordChange(materialServices, CHANGE_ADD, name, supplier, quantity, day, month, year);
 
 	return status;
 }
@@ -154,7 +505,7 @@ int update(MaterialServices* materialServices, char* name, char* supplier, int d
 	if (material == NULL || newMaterial == NULL)
 		return -1;
 
-	int status = setMaterialRepo(materialServices);
+	int status = prepareMutation(materialServices);
 
 	if (status == -1)
 	{
@@ -168,6 +519,12 @@ int update(MaterialServices* materialServices, char* name, char* supplier, int d
 	destroyMaterial(material);
 	if (status == -1) 
 		destroyMaterial(newMaterial);
+	else
+		journalUpdate(materialServices->journal, name, supplier, day, month, year, newMaterial);
+
+	status = finishMutation(materialServices, status);
+	if (status == 1)
+		recordChange(materialServices, CHANGE_UPDATE, newName, newSupplier, newQuantity, newDay, newMonth, newYear);
 
 	return status;
 }
@@ -183,102 +540,379 @@ int rem(MaterialServices* materialServices, char* name, char* supplier, int day,
 	if (material == NULL)
 		return -1;
 
-	int status = setMaterialRepo(materialServices);
+	int status = prepareMutation(materialServices);
+
+	if (status == -1)
+	{
+		destroyMaterial(material);
+		return -1;
+	}
+
+	status = removeMaterial(materialServices->materialRepo, material);
+	destroyMaterial(material);
+	if (status == 1)
+		journalDelete(materialServices->journal, name, supplier, day, month, year);
+
+	status = finishMutation(materialServices, status);
+	if (status == 1)
+		recordChange(materialServices, CHANGE_REMOVE, name, supplier, 0, day, month, year);
+
+	return status;
+}
+
+int consume(MaterialServices* materialServices, char* name, double quantity)
+{
+	if (materialServices == NULL)
+		return -1;
+
+	// the stock is checked first, so a failed consumption does not leave an empty undo step behind
+	MaterialGroup* group = name == NULL ? NULL : getNameGroup(materialServices->materialRepo, name);
+	if (group == NULL || quantity <= 0 || group->total < quantity - 1e-9)
+		return rejectMutation(materialServices);
+
+	int status = prepareMutation(materialServices);
+
+	if (status == -1)
+		return -1;
+
+	DynamicArray* lots = copyNameLots(materialServices->journal, materialServices->materialRepo, name);
+
+	status = consumeMaterial(materialServices->materialRepo, name, quantity);
+	if (status == 1)
+		journalConsumed(materialServices->journal, materialServices, lots);
+	else
+		destroyDynamicArray(lots);
+
+	status = finishMutation(materialServices, status);
+	if (status == 1)
+		recordChange(materialServices, CHANGE_CONSUME, name, NULL, quantity, 0, 0, 0);
+
+	return status;
+}
+
+int defineRecipe(MaterialServices* materialServices, const char* name, const Recipe* recipe)
+{
+	if (materialServices == NULL || name == NULL || name[0] == 0 || recipe == NULL || recipe->size == 0)
+		return -1;
+
+	Recipe* recipeCopy = (Recipe*)malloc(sizeof(Recipe));
+
+	if (recipeCopy == NULL)
+		return -1;
+
+	*recipeCopy = *recipe;
+
+	if (putValue(materialServices->recipes, name, recipeCopy) == -1)
+	{
+		free(recipeCopy);
+		return -1;
+	}
+
+	return 1;
+}
+
+Recipe* getRecipe(MaterialServices* materialServices, const char* name)
+{
+	if (materialServices == NULL || name == NULL)
+		return NULL;
+
+	return getValue(materialServices->recipes, name);
+}
+
+int produce(MaterialServices* materialServices, const char* recipeName, int count, Ingredient* shortfalls, int* shortfallCount)
+{
+	if (materialServices == NULL || shortfalls == NULL || shortfallCount == NULL)
+		return -1;
+
+	*shortfallCount = 0;
+
+	Recipe* recipe = recipeName == NULL ? NULL : getRecipe(materialServices, recipeName);
+	if (recipe == NULL || count < 1)
+		return rejectMutation(materialServices);
+
+	// the ingredients of a recipe are distinct, so each one is checked against the total of its own name group
+	for (int i = 0; i < recipe->size; i++)
+	{
+		double needed = recipe->ingredients[i].quantity * count;
+		MaterialGroup* group = getNameGroup(materialServices->materialRepo, recipe->ingredients[i].name);
+		double available = group == NULL ? 0 : group->total;
+
+		if (available < needed - 1e-9)
+		{
+			shortfalls[*shortfallCount] = recipe->ingredients[i];
+			shortfalls[*shortfallCount].quantity = needed - available;
+			(*shortfallCount)++;
+		}
+	}
+
+	if (*shortfallCount > 0)
+		return rejectMutation(materialServices);
+
+	int status = prepareMutation(materialServices);
+
+	if (status == -1)
+		return -1;
+
+	for (int i = 0; i < recipe->size && status == 1; i++)
+	{
+		const char* name = recipe->ingredients[i].name;
+		DynamicArray* lots = copyNameLots(materialServices->journal, materialServices->materialRepo, name);
+
+		status = consumeMaterial(materialServices->materialRepo, name, recipe->ingredients[i].quantity * count);
+		if (status == 1)
+			journalConsumed(materialServices->journal, materialServices, lots);
+		else
+			destroyDynamicArray(lots);
+	}
+
+	// only an allocation failure gets here; the partial changes of a single operation are abandoned at once,
+	// the ones of a transaction when the failed transaction is committed or rolled back
+	if (status == -1 && materialServices->transaction == 0)
+		abandonMutation(materialServices);
+
+	status = finishMutation(materialServices, status);
+	if (status == 1)
+		recordChange(materialServices, CHANGE_PRODUCE, recipeName, NULL, count, 0, 0, 0);
+
+	return status;
+}
+
+int addAlert(MaterialServices* materialServices, const AlertRule* rule)
+{
+	if (materialServices == NULL)
+		return -1;
+
+	return addAlertRule(&materialServices->alerts, materialServices->materialRepo, rule, keyDayNumber(todayKey()), materialServices->version);
+}
+
+int takeAlert(MaterialServices* materialServices, Alert* alert)
+{
+	if (materialServices == NULL)
+		return 0;
+
+	return popAlert(&materialServices->alerts.ring, alert);
+}
+
+int subscribe(MaterialServices* materialServices)
+{
+	if (materialServices == NULL)
+		return -1;
+
+	return attachConsumer(&materialServices->changes);
+}
+
+void attachJournal(MaterialServices* materialServices, struct Journal* journal)
+{
+	if (materialServices == NULL)
+		return;
+
+	materialServices->journal = journal;
+}
+
+int getInventoryHash(MaterialServices* materialServices, uint64_t* hash, int* lots)
+{
+	MerkleTree* tree = materialServices == NULL ? NULL : getMerkleTree(materialServices->materialRepo);
+
+	if (tree == NULL || hash == NULL || lots == NULL)
+		return -1;
+
+	*hash = getMerkleRoot(tree);
+	*lots = tree->lots;
+	return 1;
+}
+
+int diffInventories(MaterialServices* x, MaterialServices* y, int* buckets)
+{
+	if (x == NULL || y == NULL || buckets == NULL)
+		return -1;
+
+	MerkleTree* xTree = getMerkleTree(x->materialRepo);
+	MerkleTree* yTree = getMerkleTree(y->materialRepo);
+
+	if (xTree == NULL || yTree == NULL)
+		return -1;
+
+	return diffMerkleTrees(xTree, yTree, buckets);
+}
+
+int applyDiff(MaterialServices* materialServices, const unsigned char* diff, int size)
+{
+	if (materialServices == NULL || checkDiff(diff, size) == -1)
+		return -1;
+
+	int status = prepareMutation(materialServices);
+	int buckets = 0;
 
 	if (status == -1)
-	{
-		destroyMaterial(material);
 		return -1;
+
+	for (int position = 0, length; position < size && status == 1; position += length)
+	{
+		length = frameSize(diff + position, size - position);
+		status = applyJournalRecord(materialServices, diff + position + 4, length - 4);
+		if (status == 1)
+			journalRecord(materialServices->journal, diff + position + 4, length - 4);
+		if (diff[position + 8] == JOURNAL_BUCKET)
+			buckets++;
 	}
 
-	status = removeMaterial(materialServices->materialRepo, material);
-	destroyMaterial(material);
+	// as for produce, a failure can only come from an allocation
+	if (status == -1 && materialServices->transaction == 0)
+		abandonMutation(materialServices);
+
+	status = finishMutation(materialServices, status);
+	if (status == 1)
+		recordChange(materialServices, CHANGE_DIFF, NULL, NULL, buckets, 0, 0, 0);
 
 	return status;
 }
 
+/*
+	Records the repository that undo or redo went back to as a group of its own.
+*/
+void journalRepo(MaterialServices* materialServices)
+{
+	journalReset(materialServices->journal, materialServices->materialRepo);
+	commitJournal(materialServices->journal);
+}
+
 int undo(MaterialServices* materialServices)
 {
+	if (materialServices->transaction == 1 || materialServices->readOnly)
+		return -1;
+
 	if (materialServices->index > 0)
 	{ 
 		materialServices->index--;
 		materialServices->materialRepo = getElement(materialServices->repoStack, materialServices->index);
+		materialServices->version++;
+		dropMerkleTree(getElement(materialServices->repoStack, materialServices->index + 1));
 	}
 	else
 		return -1;
-	
+
+	checkAllAlerts(&materialServices->alerts, materialServices->materialRepo, keyDayNumber(todayKey()), materialServices->version);
+	journalRepo(materialServices);
+	recordChange(materialServices, CHANGE_UNDO, NULL, NULL, 0, 0, 0, 0);
 	return 1;
 }
 
 int redo(MaterialServices* materialServices)
 {
+	if (materialServices->transaction == 1 || materialServices->readOnly)
+		return -1;
+
 	if (materialServices->index < len(materialServices->repoStack) - 1)
 	{
 		materialServices->index++;
 		materialServices->materialRepo = getElement(materialServices->repoStack, materialServices->index);
+		materialServices->version++;
+		dropMerkleTree(getElement(materialServices->repoStack, materialServices->index - 1));
 	}
 	else
 		return -1;
 
+	checkAllAlerts(&materialServices->alerts, materialServices->materialRepo, keyDayNumber(todayKey()), materialServices->version);
+	journalRepo(materialServices);
+	recordChange(materialServices, CHANGE_REDO, NULL, NULL, 0, 0, 0, 0);
 	return 1;
 }
 
-DynamicArray* getSortedAscending(MaterialServices* materialServices)
+/*
+	Sorts the materials with the given comparator. For large arrays the known comparators on fixed width keys
+	(less, greater, earlier) are replaced by a radix sort.
+*/
+int sortMaterials(DynamicArray* dArray, int (*compareFunction)(Material*, Material*))
 {
-	if (materialServices == NULL)
-		return NULL;
+	if (len(dArray) >= RADIX_THRESHOLD)
+	{
+		if (compareFunction == &less)
+			return radixSortByQuantity(dArray, 0);
+		if (compareFunction == &greater)
+			return radixSortByQuantity(dArray, 1);
+		if (compareFunction == &earlier)
+			return radixSortByDate(dArray, 0);
+	}
 
-	DynamicArray* dArray = createDynamicArray(10, &destroyMaterial);
+	return sort(dArray, compareFunction);
+}
 
-	if (dArray == NULL)
+DynamicArray* getOrdered(MaterialServices* materialServices, const OrderBy* orderBy)
+{
+	if (materialServices == NULL || orderBy == NULL)
 		return NULL;
 
-	for (int i = 0; i < getSize(materialServices->materialRepo); i++)
-	{
-		Material* material = getMaterialAtPos(materialServices->materialRepo, i);
-		Material* materialCopy = copyMaterial(material);
-		apd(dArray, materialCopy);
-	}
+	Query query;
+	initQuery(&query);
+	query.orderBy = *orderBy;
 
-	for (int i = 0; i < len(dArray) - 1; i++)
-		for (int j = i + 1; j < len(dArray); j++)
-		{
-			Material* x = getElement(dArray, i);
-			Material* y = getElement(dArray, j);
+	return collectQuery(materialServices->materialRepo, &query);
+}
 
-			if (strcmp(getName(x), getName(y)) > 0)
-			{
-				swap(dArray, i, j);
-			}
-		}
-	return dArray;
+DynamicArray* getSortedAscending(MaterialServices* materialServices)
+{
+	OrderBy orderBy = { 1, { { COLUMN_NAME, 0 } } };
+
+	return getOrdered(materialServices, &orderBy);
 }
 
-DynamicArray* getShort(MaterialServices* materialServices, int (*compareFunction)(Material*, Material*), char* filterSupplier, double filterQuantity)
+int buildShortQuery(Query* query, int (*compareFunction)(Material*, Material*), char* filterSupplier, double filterQuantity, int limit)
+{
+	if (query == NULL || limit < 0)
+		return -1;
+
+	initQuery(query);
+	addQuantityFilter(query, filterQuantity);
+	addSupplierFilter(query, filterSupplier);
+	query->limit = limit;
+
+	if (compareFunction != &less && compareFunction != &greater)
+		return -1;
+
+	query->orderBy.count = 1;
+	query->orderBy.keys[0].column = COLUMN_QUANTITY;
+	query->orderBy.keys[0].descending = compareFunction == &greater;
+
+	return 1;
+}
+
+DynamicArray* getShortTop(MaterialServices* materialServices, int (*compareFunction)(Material*, Material*), char* filterSupplier, double filterQuantity, int limit)
 { 
-	if (materialServices == NULL)
+	if (materialServices == NULL || limit < 0)
 		return NULL;
 
-	DynamicArray* dArray = createDynamicArray(2, &destroyMaterial);
+	Query query;
 
-	if (dArray == NULL)
-		return NULL;
+	if (buildShortQuery(&query, compareFunction, filterSupplier, filterQuantity, limit) == 1)
+		return collectQuery(materialServices->materialRepo, &query);
+
+	// an unknown comparator needs every row, so the limit is applied after sorting with it
+	query.limit = 0;
 
-	for (int i = 0; i < getSize(materialServices->materialRepo); i++)
+	DynamicArray* dArray = collectQuery(materialServices->materialRepo, &query);
+
+	if (dArray != NULL)
 	{
-		Material* material = getMaterialAtPos(materialServices->materialRepo, i);
-		if (getQuantity(material) < filterQuantity && strcmp(getSupplier(material), filterSupplier) == 0)
-		{
-			Material* materialCopy = copyMaterial(material);
-			apd(dArray, materialCopy);
-		}
+		sortMaterials(dArray, compareFunction);
+		if (limit > 0 && len(dArray) > limit)
+			delRange(dArray, limit, len(dArray));
 	}
 
-	sort(dArray, compareFunction);
-
 	return dArray;
 }
 
+DynamicArray* getShort(MaterialServices* materialServices, int (*compareFunction)(Material*, Material*), char* filterSupplier, double filterQuantity)
+{
+	return getShortTop(materialServices, compareFunction, filterSupplier, filterQuantity, 0);
+}
+
+DynamicArray* getSortedByDate(MaterialServices* materialServices)
+{
+	OrderBy orderBy = { 1, { { COLUMN_DATE, 0 } } };
+
+	return getOrdered(materialServices, &orderBy);
+}
+
 
 //Tests
 
@@ -303,6 +937,11 @@ void testGetMaterial()
 	assert(getMaterial(materialServices, 1) == NULL);
 	assert(getMaterial(materialServices, 0) != NULL);
 
+	assert(findLot(materialServices, "testName", "testSupplier", 1, 2, 3) == getMaterial(materialServices, 0));
+	assert(findLot(materialServices, "testName", "testSupplier", 2, 2, 3) == NULL);
+	assert(findLot(materialServices, "testName", "other", 1, 2, 3) == NULL);
+	assert(findLot(materialServices, "other", "testSupplier", 1, 2, 3) == NULL);
+
 	destroyMaterialServices(materialServices);
 }
 
@@ -319,11 +958,12 @@ void testGetExpired()
 
 	DynamicArray* dArray1 = getExpired(materialServices, &isLessThan, "3.5234");
 
+	// the lots expire on the same day, so they are ordered by name
 	assert(len(dArray1) == 4);
-	assert(getQuantity(getElement(dArray1, 0)) == 1);
-	assert(getQuantity(getElement(dArray1, 1)) == 2);
-	assert(getQuantity(getElement(dArray1, 2)) == 2);
-	assert(getQuantity(getElement(dArray1, 3)) == 3);
+	assert(strcmp(getName(getElement(dArray1, 0)), "otherName2") == 0);
+	assert(strcmp(getName(getElement(dArray1, 1)), "testName1") == 0);
+	assert(strcmp(getName(getElement(dArray1, 2)), "testName3") == 0);
+	assert(strcmp(getName(getElement(dArray1, 3)), "testName4") == 0);
 
 	DynamicArray* dArray2 = getExpired(materialServices, &nameContains, "test");
 
@@ -334,6 +974,43 @@ void testGetExpired()
 
 	destroyDynamicArray(dArray1);
 	destroyDynamicArray(dArray2);
+
+	// the supplier index and the full scan produce the rows in different orders, the query orders them the same way
+	beginTransaction(materialServices);
+	for (int i = 0; i < 200; i++)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "lot%d", (i * 7) % 20);
+		add(materialServices, name, i % 10 ? "otherSupplier" : "onlySupplier", 1, 1 + i % 3, 1, 2020 + i % 5);
+	}
+	add(materialServices, "lot0", "onlySupplier", 1, 1, 1, 2019);
+	commitTransaction(materialServices);
+
+	// the last lot takes the place of the second one, it is now early in the repository and last in its supplier
+	removeMaterial(materialServices->materialRepo, getMaterialAtPos(materialServices->materialRepo, 1));
+
+	Query bySupplier, byScan;
+	QueryPlan supplierPlan, scanPlan;
+
+	buildExpiredQuery(&bySupplier, &isLessThan, "10", 0);
+	addSupplierFilter(&bySupplier, "onlySupplier");
+	buildExpiredQuery(&byScan, &isLessThan, "10", 0);
+	explain(materialServices, &bySupplier, &supplierPlan);
+	explain(materialServices, &byScan, &scanPlan);
+	assert(supplierPlan.path == PATH_SUPPLIER_INDEX && scanPlan.path != PATH_SUPPLIER_INDEX);
+
+	DynamicArray* dArray3 = getQueryResult(materialServices, &bySupplier);
+	DynamicArray* dArray4 = getQueryResult(materialServices, &byScan);
+	int matched = 0;
+
+	assert(len(dArray3) > 1);
+	for (int i = 0; i < len(dArray4); i++)
+		if (strcmp(getSupplier(getElement(dArray4, i)), "onlySupplier") == 0)
+			assert(equalMaterials(getElement(dArray3, matched++), getElement(dArray4, i)) == 1);
+	assert(matched == len(dArray3));
+
+	destroyDynamicArray(dArray3);
+	destroyDynamicArray(dArray4);
 	destroyMaterialServices(materialServices);
 }
 
@@ -359,6 +1036,116 @@ void testGetShort()
 	destroyMaterialServices(materialServices);
 }
 
+void testGetShortLarge()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	beginTransaction(materialServices);
+	for (int i = 0; i < 2 * RADIX_THRESHOLD; i++)
+		add(materialServices, "testName", "testSupplier", (i * 7) % (2 * RADIX_THRESHOLD), 1, 1, 2000 + i);
+	commitTransaction(materialServices);
+
+	DynamicArray* dArray1 = getShort(materialServices, &less, "testSupplier", RADIX_THRESHOLD);
+	DynamicArray* dArray2 = getShort(materialServices, &greater, "testSupplier", RADIX_THRESHOLD);
+
+	assert(len(dArray1) == RADIX_THRESHOLD);
+	assert(len(dArray2) == RADIX_THRESHOLD);
+	for (int i = 0; i < RADIX_THRESHOLD; i++)
+	{
+		assert(getQuantity(getElement(dArray1, i)) == i);
+		assert(getQuantity(getElement(dArray2, i)) == RADIX_THRESHOLD - 1 - i);
+	}
+
+	destroyDynamicArray(dArray1);
+	destroyDynamicArray(dArray2);
+	destroyMaterialServices(materialServices);
+}
+
+void testGetSortedByDate()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	add(materialServices, "testName1", "testSupplier", 1, 1, 3, 2022);
+	add(materialServices, "testName2", "testSupplier", 2, 2, 1, 2021);
+	add(materialServices, "testName3", "testSupplier", 3, 28, 2, 2022);
+
+	DynamicArray* dArray = getSortedByDate(materialServices);
+
+	assert(len(dArray) == 3);
+	assert(getQuantity(getElement(dArray, 0)) == 2);
+	assert(getQuantity(getElement(dArray, 1)) == 3);
+	assert(getQuantity(getElement(dArray, 2)) == 1);
+
+	destroyDynamicArray(dArray);
+	destroyMaterialServices(materialServices);
+}
+
+void testGetOrdered()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	add(materialServices, "b", "supplierB", 1, 1, 3, 2022);
+	add(materialServices, "c", "supplierA", 2, 2, 1, 2021);
+	add(materialServices, "a", "supplierA", 3, 2, 1, 2021);
+
+	OrderBy orderBy;
+	parseOrderBy(&orderBy, "supplier date -quantity");
+	DynamicArray* dArray1 = getOrdered(materialServices, &orderBy);
+
+	assert(len(dArray1) == 3);
+	assert(getQuantity(getElement(dArray1, 0)) == 3);
+	assert(getQuantity(getElement(dArray1, 1)) == 2);
+	assert(getQuantity(getElement(dArray1, 2)) == 1);
+
+	DynamicArray* dArray2 = getSortedAscending(materialServices);
+
+	assert(strcmp(getName(getElement(dArray2, 0)), "a") == 0);
+	assert(strcmp(getName(getElement(dArray2, 1)), "b") == 0);
+	assert(strcmp(getName(getElement(dArray2, 2)), "c") == 0);
+
+	destroyDynamicArray(dArray1);
+	destroyDynamicArray(dArray2);
+	destroyMaterialServices(materialServices);
+}
+
+void testGetTop()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	beginTransaction(materialServices);
+	for (int i = 0; i < 100; i++)
+		add(materialServices, "testName", i % 2 ? "testSupplier" : "otherSupplier", (i * 37) % 100, 1, 1 + i % 12, 1900 + (i * 13) % 100);
+	commitTransaction(materialServices);
+
+	assert(getExpiredTop(materialServices, &nameContains, "", -1) == NULL);
+
+	DynamicArray* dArray1 = getShortTop(materialServices, &less, "testSupplier", 50, 5);
+	DynamicArray* dArray2 = getShortTop(materialServices, &greater, "testSupplier", 50, 5);
+	DynamicArray* dArray3 = getExpiredTop(materialServices, &nameContains, "", 3);
+
+	assert(len(dArray1) == 5);
+	assert(len(dArray2) == 5);
+	for (int i = 0; i < 5; i++)
+	{
+		assert(getQuantity(getElement(dArray1, i)) == 2 * i + 1);
+		assert(getQuantity(getElement(dArray2, i)) == 49 - 2 * i);
+	}
+
+	assert(len(dArray3) == 3);
+	assert(getYear(getDate(getElement(dArray3, 0))) == 1900);
+	assert(getYear(getDate(getElement(dArray3, 1))) == 1901);
+	assert(getYear(getDate(getElement(dArray3, 2))) == 1902);
+
+	destroyDynamicArray(dArray1);
+	destroyDynamicArray(dArray2);
+	destroyDynamicArray(dArray3);
+	destroyMaterialServices(materialServices);
+}
+
 void testAdd()
 {
 	MaterialRepo* materialRepo = createMaterialRepo(1);
@@ -452,14 +1239,395 @@ void testUndoRedo()
 	destroyMaterialServices(materialServices);
 }
 
+void testClearStack()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(1);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	add(materialServices, "a", "a", 1, 1, 1, 1);
+	add(materialServices, "b", "b", 1, 1, 1, 1);
+	add(materialServices, "c", "c", 1, 1, 1, 1);
+	assert(len(materialServices->repoStack) == 4);
+
+	undo(materialServices);
+	undo(materialServices);
+	undo(materialServices);
+	add(materialServices, "d", "d", 1, 1, 1, 1);
+	assert(materialServices->index == 1);
+	assert(len(materialServices->repoStack) == 2);
+	assert(redo(materialServices) == -1);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testHistoryLimit()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(1);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	assert(setHistoryLimit(materialServices, -2) == -1);
+
+	add(materialServices, "a", "a", 1, 1, 1, 1);
+	add(materialServices, "b", "b", 1, 1, 1, 1);
+	add(materialServices, "c", "c", 1, 1, 1, 1);
+	assert(setHistoryLimit(materialServices, 2) == 1);
+	assert(materialServices->index == 2 && len(materialServices->repoStack) == 3);
+	assert(undo(materialServices) == 1 && undo(materialServices) == 1 && undo(materialServices) == -1);
+	assert(getSize(materialServices->materialRepo) == 1);
+
+	// in place, the steps that could be redone are dropped and the repository is not copied
+	assert(setHistoryLimit(materialServices, 0) == 1);
+	MaterialRepo* current = materialServices->materialRepo;
+	assert(add(materialServices, "d", "d", 1, 1, 1, 1) == 1);
+	assert(materialServices->materialRepo == current && len(materialServices->repoStack) == 1);
+	assert(getSize(current) == 2 && redo(materialServices) == -1 && undo(materialServices) == -1);
+
+	// a transaction can still be rolled back, and leaves no undo step once committed
+	assert(beginTransaction(materialServices) == 1);
+	assert(add(materialServices, "e", "e", 1, 1, 1, 1) == 1);
+	assert(rollbackTransaction(materialServices) == 1);
+	assert(materialServices->materialRepo == current && getSize(current) == 2);
+	assert(beginTransaction(materialServices) == 1);
+	assert(add(materialServices, "e", "e", 1, 1, 1, 1) == 1);
+	assert(commitTransaction(materialServices) == 1);
+	assert(getSize(materialServices->materialRepo) == 3 && len(materialServices->repoStack) == 1);
+	assert(consume(materialServices, "e", 1) == 1 && getSize(materialServices->materialRepo) == 2);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testTransaction()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(1);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	assert(commitTransaction(materialServices) == -1);
+	assert(rollbackTransaction(materialServices) == -1);
+
+	assert(beginTransaction(materialServices) == 1);
+	assert(beginTransaction(materialServices) == -1);
+	assert(add(materialServices, "a", "a", 1, 1, 1, 1) == 1);
+	assert(add(materialServices, "b", "b", 2, 2, 2, 2) == 1);
+	assert(update(materialServices, "a", "a", 1, 1, 1, "c", "c", 3, 3, 3, 3) == 1);
+	assert(undo(materialServices) == -1);
+	assert(commitTransaction(materialServices) == 1);
+	assert(materialServices->index == 1);
+	assert(len(materialServices->repoStack) == 2);
+	assert(getSize(materialServices->materialRepo) == 2);
+
+	assert(undo(materialServices) == 1);
+	assert(getSize(materialServices->materialRepo) == 0);
+	assert(redo(materialServices) == 1);
+	assert(getSize(materialServices->materialRepo) == 2);
+
+	assert(beginTransaction(materialServices) == 1);
+	assert(rem(materialServices, "b", "b", 2, 2, 2) == 1);
+	assert(rem(materialServices, "x", "x", 1, 1, 1) == -1);
+	assert(commitTransaction(materialServices) == -1);
+	assert(materialServices->index == 1);
+	assert(getSize(materialServices->materialRepo) == 2);
+
+	assert(beginTransaction(materialServices) == 1);
+	assert(rem(materialServices, "b", "b", 2, 2, 2) == 1);
+	assert(rollbackTransaction(materialServices) == 1);
+	assert(materialServices->index == 1);
+	assert(len(materialServices->repoStack) == 2);
+	assert(getSize(materialServices->materialRepo) == 2);
+
+	assert(beginTransaction(materialServices) == 1);
+	assert(commitTransaction(materialServices) == 1);
+	assert(materialServices->index == 1);
+	assert(len(materialServices->repoStack) == 2);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testGetQueryView()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+	QueryCache* queryCache = &materialServices->queryCache;
+
+	add(materialServices, "b", "testSupplier", 2, 1, 1, 2000);
+	add(materialServices, "a", "testSupplier", 1, 1, 1, 2001);
+
+	Query query;
+	assert(buildShortQuery(&query, &less, "testSupplier", 10, 0) == 1);
+	assert(buildShortQuery(&query, &earlier, "testSupplier", 10, 0) == -1);
+	assert(buildShortQuery(&query, &greater, "testSupplier", 10, 0) == 1);
+
+	DynamicArray* dArray1 = getQueryView(materialServices, &query);
+	DynamicArray* dArray2 = getQueryView(materialServices, &query);
+	assert(queryCache->misses == 1 && queryCache->hits == 1);
+	assert(len(dArray1) == 2 && len(dArray2) == 2);
+	assert(getElement(dArray1, 0) == getElement(dArray2, 0));
+	assert(getQuantity(getElement(dArray1, 0)) == 2);
+	destroyDynamicArray(dArray1);
+	destroyDynamicArray(dArray2);
+
+	long long version = materialServices->version;
+	add(materialServices, "c", "testSupplier", 3, 1, 1, 2002);
+	assert(materialServices->version > version);
+
+	dArray1 = getQueryView(materialServices, &query);
+	assert(queryCache->misses == 2);
+	assert(len(dArray1) == 3 && getQuantity(getElement(dArray1, 0)) == 3);
+	destroyDynamicArray(dArray1);
+
+	undo(materialServices);
+	dArray1 = getQueryView(materialServices, &query);
+	assert(queryCache->misses == 3);
+	assert(len(dArray1) == 2);
+	destroyDynamicArray(dArray1);
+
+	assert(buildExpiredQuery(&query, &nameContains, "a", 0) == 1);
+	dArray1 = getQueryView(materialServices, &query);
+	assert(len(dArray1) == 1 && strcmp(getName(getElement(dArray1, 0)), "a") == 0);
+	destroyDynamicArray(dArray1);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testGetTotals()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	add(materialServices, "b", "y", 2, 1, 1, 2000);
+	add(materialServices, "a", "y", 1, 1, 1, 3000);
+	add(materialServices, "b", "x", 4, 1, 1, 3000);
+	add(materialServices, "b", "x", 4, 1, 1, 3000);
+
+	DynamicArray* totals = getTotals(materialServices, 0);
+	assert(len(totals) == 2);
+
+	HashEntry* entry = getElement(totals, 1);
+	MaterialGroup* group = entry->value;
+	assert(strcmp(entry->key, "b") == 0);
+	assert(group->total == 10 && group->expired == 1 && len(group->lots) == 2);
+	destroyDynamicArray(totals);
+
+	undo(materialServices);
+	totals = getTotals(materialServices, 1);
+	assert(len(totals) == 2);
+	entry = getElement(totals, 0);
+	assert(strcmp(entry->key, "x") == 0 && ((MaterialGroup*)entry->value)->total == 4);
+	entry = getElement(totals, 1);
+	assert(((MaterialGroup*)entry->value)->total == 3 && ((MaterialGroup*)entry->value)->expired == 1);
+	destroyDynamicArray(totals);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testGetExpiryHistogram()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+	CalendarBin bins[2];
+
+	add(materialServices, "a", "x", 1, 1, 1, 2000);
+	add(materialServices, "b", "x", 2, 1, 1, 3000);
+
+	assert(getExpiryHistogram(materialServices, 0, 2, bins) == 1);
+	assert(bins[0].lots == 0 && bins[1].lots == 0);
+
+	Query query;
+	parseQuery(&query, "within=100000000");
+	DynamicArray* dArray = getQueryView(materialServices, &query);
+	assert(len(dArray) == 1 && getQuantity(getElement(dArray, 0)) == 2);
+	destroyDynamicArray(dArray);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testConsume()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+
+	add(materialServices, "a", "x", 2, 2, 1, 2030);
+	add(materialServices, "a", "x", 3, 1, 1, 2030);
+	add(materialServices, "b", "x", 3, 1, 1, 2030);
+
+	long long version = materialServices->version;
+	assert(consume(materialServices, "a", 10) == -1);
+	assert(materialServices->index == 3 && materialServices->version == version);
+
+	// a refused consumption fails the transaction it belongs to, whatever the reason
+	for (int i = 0; i < 2; i++)
+	{
+		assert(beginTransaction(materialServices) == 1);
+		assert(consume(materialServices, "a", i == 0 ? 0 : 10) == -1);
+		assert(commitTransaction(materialServices) == -1);
+	}
+	assert(materialServices->index == 3);
+
+	assert(consume(materialServices, "a", 4) == 1);
+	assert(materialServices->index == 4);
+	assert(getSize(materialServices->materialRepo) == 2);
+	assert(getQuantity(getMaterial(materialServices, 0)) == 1);
+	assert(getDay(getDate(getMaterial(materialServices, 0))) == 2);
+
+	assert(undo(materialServices) == 1);
+	assert(getSize(materialServices->materialRepo) == 3);
+	assert(getNameGroup(materialServices->materialRepo, "a")->total == 5);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testProduce()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+	Ingredient shortfalls[MAX_INGREDIENTS];
+	int shortfallCount;
+	Recipe recipe;
+
+	add(materialServices, "flour", "x", 2, 2, 1, 2030);
+	add(materialServices, "flour", "y", 3, 1, 1, 2030);
+	add(materialServices, "eggs", "x", 10, 1, 1, 2030);
+
+	parseRecipe(&recipe, "flour=0.5, eggs=2, salt=0.1");
+	assert(defineRecipe(materialServices, "bread", &recipe) == 1);
+	assert(getRecipe(materialServices, "bread")->size == 3);
+	assert(getRecipe(materialServices, "cake") == NULL);
+
+	// the salt is missing and the eggs are short, the flour is enough
+	assert(produce(materialServices, "bread", 6, shortfalls, &shortfallCount) == -1);
+	assert(shortfallCount == 2);
+	assert(strcmp(shortfalls[0].name, "eggs") == 0 && shortfalls[0].quantity == 2);
+	assert(strcmp(shortfalls[1].name, "salt") == 0 && shortfalls[1].quantity > 0.6 - 1e-9 && shortfalls[1].quantity < 0.6 + 1e-9);
+	assert(materialServices->index == 3);
+	assert(getSize(materialServices->materialRepo) == 3);
+
+	assert(produce(materialServices, "cake", 1, shortfalls, &shortfallCount) == -1);
+	assert(produce(materialServices, "bread", 0, shortfalls, &shortfallCount) == -1);
+	assert(beginTransaction(materialServices) == 1);
+	assert(produce(materialServices, "bread", 0, shortfalls, &shortfallCount) == -1);
+	assert(commitTransaction(materialServices) == -1 && materialServices->index == 3);
+
+	parseRecipe(&recipe, "flour=0.5, eggs=2");
+	assert(defineRecipe(materialServices, "bread", &recipe) == 1);
+	assert(produce(materialServices, "bread", 4, shortfalls, &shortfallCount) == 1);
+	assert(shortfallCount == 0);
+	assert(materialServices->index == 4);
+	assert(getNameGroup(materialServices->materialRepo, "flour")->total == 3);
+	assert(getNameGroup(materialServices->materialRepo, "eggs")->total == 2);
+	assert(getSupplierGroup(materialServices->materialRepo, "y")->total == 1);
+
+	// the whole production is one undo step, the recipes are kept
+	assert(undo(materialServices) == 1);
+	assert(getNameGroup(materialServices->materialRepo, "flour")->total == 5);
+	assert(getNameGroup(materialServices->materialRepo, "eggs")->total == 10);
+	assert(getRecipe(materialServices, "bread") != NULL);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testAlerts()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+	Alert alert;
+
+	add(materialServices, "flour", "x", 10, 1, 1, 2100);
+
+	AlertRule rule = { ALERT_LOW_STOCK, 0, "flour", 5, 0, 0 };
+	assert(addAlert(materialServices, &rule) == 1);
+	assert(takeAlert(materialServices, &alert) == 0);
+
+	// the changes of another name do not touch the rule
+	add(materialServices, "salt", "x", 1, 1, 1, 2100);
+	assert(takeAlert(materialServices, &alert) == 0);
+
+	assert(consume(materialServices, "flour", 6) == 1);
+	assert(takeAlert(materialServices, &alert) == 1 && alert.raised == 1 && alert.value == 4);
+	assert(alert.version == materialServices->version);
+
+	// undo restores the stock, redo takes it again
+	assert(undo(materialServices) == 1);
+	assert(takeAlert(materialServices, &alert) == 1 && alert.raised == 0 && alert.value == 10);
+	assert(redo(materialServices) == 1);
+	assert(takeAlert(materialServices, &alert) == 1 && alert.raised == 1);
+
+	// a transaction is checked once, at its commit, and a rollback raises nothing
+	beginTransaction(materialServices);
+	add(materialServices, "flour", "y", 3, 1, 1, 2100);
+	assert(takeAlert(materialServices, &alert) == 0);
+	rollbackTransaction(materialServices);
+	assert(takeAlert(materialServices, &alert) == 0);
+
+	beginTransaction(materialServices);
+	add(materialServices, "flour", "y", 3, 1, 1, 2100);
+	consume(materialServices, "flour", 2);
+	assert(takeAlert(materialServices, &alert) == 0);
+	assert(commitTransaction(materialServices) == 1);
+	assert(takeAlert(materialServices, &alert) == 1 && alert.raised == 0 && alert.value == 5);
+	assert(takeAlert(materialServices, &alert) == 0);
+
+	destroyMaterialServices(materialServices);
+}
+
+void testSubscribe()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	MaterialServices* materialServices = createMaterialServices(materialRepo);
+	ChangeRecord record;
+	Date date = { 3, 4, 2030 };
+	uint64_t lost;
+
+	add(materialServices, "a", "x", 1, 1, 1, 2030);
+
+	int consumer = subscribe(materialServices);
+	assert(consumer == 0);
+
+	add(materialServices, "b", "y", 2, 3, 4, 2030);
+	assert(rem(materialServices, "c", "y", 3, 4, 2030) == -1);
+	consume(materialServices, "b", 1);
+	undo(materialServices);
+	beginTransaction(materialServices);
+	rem(materialServices, "a", "x", 1, 1, 2030);
+	rollbackTransaction(materialServices);
+
+	assert(readChange(&materialServices->changes, consumer, &record, &lost) == 1);
+	assert(record.type == CHANGE_ADD && record.nameHash == hashString("b") && record.supplierHash == hashString("y"));
+	assert(record.quantity == 2 && record.dateKey == dateKey(&date));
+
+	// the failed rem is not published
+	ChangeType types[] = { CHANGE_CONSUME, CHANGE_UNDO, CHANGE_BEGIN, CHANGE_REMOVE, CHANGE_ROLLBACK };
+	for (int i = 0; i < 5; i++)
+	{
+		assert(readChange(&materialServices->changes, consumer, &record, &lost) == 1);
+		assert(record.type == types[i] && lost == 0);
+	}
+	assert(record.version == materialServices->version);
+	assert(readChange(&materialServices->changes, consumer, &record, &lost) == 0);
+
+	destroyMaterialServices(materialServices);
+}
+
 void testMaterialServices()
 {
 	testCreateMaterialServices();
 	testGetMaterial();
 	testGetExpired();
 	testGetShort();
+	testGetShortLarge();
+	testGetSortedByDate();
+	testGetOrdered();
+	testGetTop();
+	testGetQueryView();
+	testGetTotals();
+	testGetExpiryHistogram();
+	testConsume();
+	testProduce();
+	testAlerts();
+	testSubscribe();
 	testAdd();
 	testUpdate();
 	testRem();
 	testUndoRedo();
+	testClearStack();
+	testHistoryLimit();
+	testTransaction();
 }
@@ -0,0 +1,254 @@
+#include "merkle.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+int initMerkleTree(MerkleTree* tree)
+{
+	if (tree == NULL)
+		return -1;
+
+	tree->nodes = (uint64_t*)calloc(2 * MERKLE_LEAVES, sizeof(uint64_t));
+	tree->buckets = (DynamicArray**)calloc(MERKLE_LEAVES, sizeof(DynamicArray*));
+	tree->lots = 0;
+
+	if (tree->nodes == NULL || tree->buckets == NULL)
+	{
+		freeMerkleTree(tree);
+		return -1;
+	}
+
+	return 1;
+}
+
+void freeMerkleTree(MerkleTree* tree)
+{
+	if (tree == NULL)
+		return;
+
+	for (int b = 0; tree->buckets != NULL && b < MERKLE_LEAVES; b++)
+		destroyDynamicArray(tree->buckets[b]);
+
+	free(tree->nodes);
+	free(tree->buckets);
+	tree->nodes = NULL;
+	tree->buckets = NULL;
+	tree->lots = 0;
+}
+
+/*
+	Spreads the bits of a hash, so that close inputs give unrelated hashes (the finalizer of splitmix64).
+*/
+uint64_t mixHash(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
+}
+
+/*
+	Hashes a string and its terminator into the hash, with 64 bit FNV-1a.
+*/
+uint64_t hashText(uint64_t hash, const char* text)
+{
+	const unsigned char* c = (const unsigned char*)text;
+
+	do
+	{
+		hash ^= *c;
+		hash *= 0x100000001B3ull;
+	} while (*c++ != 0);
+
+	return hash;
+}
+
+uint64_t identityHash(const char* name, const char* supplier, const Date* date)
+{
+	uint64_t hash = hashText(0xCBF29CE484222325ull, name);
+	hash = hashText(hash, supplier);
+	hash ^= (uint32_t)dateKey(date);
+
+	return mixHash(hash * 0x100000001B3ull);
+}
+
+int keyBucket(const char* name, const char* supplier, const Date* date)
+{
+	return (int)(identityHash(name, supplier, date) & (MERKLE_LEAVES - 1));
+}
+
+int lotBucket(Material* material)
+{
+	return keyBucket(getName(material), getSupplier(material), getDate(material));
+}
+
+uint64_t lotHash(Material* material)
+{
+	// -0 and 0 are the same quantity, but not the same bits
+	double quantity = getQuantity(material) == 0 ? 0 : getQuantity(material);
+	uint64_t bits;
+
+	memcpy(&bits, &quantity, sizeof(bits));
+	return mixHash(identityHash(getName(material), getSupplier(material), getDate(material)) ^ mixHash(bits + 0x9E3779B97F4A7C15ull));
+}
+
+uint64_t combineHashes(uint64_t left, uint64_t right)
+{
+	if (left == 0 && right == 0)
+		return 0;
+
+	return mixHash(left * 0x9E3779B97F4A7C15ull ^ mixHash(right));
+}
+
+/*
+	Recomputes the hashes of the ancestors of a bucket.
+*/
+void updatePath(MerkleTree* tree, int bucket)
+{
+	for (int node = (MERKLE_LEAVES + bucket) / 2; node >= 1; node /= 2)
+		tree->nodes[node] = combineHashes(tree->nodes[2 * node], tree->nodes[2 * node + 1]);
+}
+
+int addToMerkleTree(MerkleTree* tree, Material* material)
+{
+	if (tree == NULL || tree->nodes == NULL || material == NULL)
+		return -1;
+
+	int bucket = lotBucket(material);
+
+	if (tree->buckets[bucket] == NULL)
+		tree->buckets[bucket] = createDynamicArray(2, NULL);
+	if (tree->buckets[bucket] == NULL || apd(tree->buckets[bucket], material) == -1)
+		return -1;
+
+	tree->nodes[MERKLE_LEAVES + bucket] += lotHash(material);
+	updatePath(tree, bucket);
+	tree->lots++;
+
+	return 1;
+}
+
+int removeFromMerkleTree(MerkleTree* tree, Material* material)
+{
+	if (tree == NULL || tree->nodes == NULL || material == NULL)
+		return -1;
+
+	int bucket = lotBucket(material);
+	DynamicArray* lots = tree->buckets[bucket];
+
+	// the lots are looked for from the last one, which a bucket that is emptied removes first
+	for (int i = lots == NULL ? -1 : len(lots) - 1; i >= 0; i--)
+	{
+		if (getElement(lots, i) != material)
+			continue;
+
+		// the order of the lots of a bucket does not matter, so the last one takes the place of the removed one
+		swap(lots, i, len(lots) - 1);
+		del(lots, len(lots) - 1);
+		if (len(lots) == 0)
+		{
+			destroyDynamicArray(lots);
+			tree->buckets[bucket] = NULL;
+		}
+
+		tree->nodes[MERKLE_LEAVES + bucket] -= lotHash(material);
+		updatePath(tree, bucket);
+		tree->lots--;
+		return 1;
+	}
+
+	return -1;
+}
+
+uint64_t getMerkleRoot(const MerkleTree* tree)
+{
+	return tree->nodes[1];
+}
+
+void collectDifferences(const MerkleTree* x, const MerkleTree* y, int node, int* buckets, int* count)
+{
+	if (x->nodes[node] == y->nodes[node])
+		return;
+
+	if (node >= MERKLE_LEAVES)
+	{
+		buckets[(*count)++] = node - MERKLE_LEAVES;
+		return;
+	}
+
+	collectDifferences(x, y, 2 * node, buckets, count);
+	collectDifferences(x, y, 2 * node + 1, buckets, count);
+}
+
+int diffMerkleTrees(const MerkleTree* x, const MerkleTree* y, int* buckets)
+{
+	int count = 0;
+
+	if (x == NULL || y == NULL || x->nodes == NULL || y->nodes == NULL || buckets == NULL)
+		return 0;
+
+	collectDifferences(x, y, 1, buckets, &count);
+	return count;
+}
+
+//Tests
+
+
+void testMerkleTree()
+{
+	MerkleTree x, y;
+	int buckets[MERKLE_LEAVES];
+	Material* materials[4] = {
+		createMaterial("Eggs", "Farm", 3, createDate(1, 1, 2030)),
+		createMaterial("Eggs", "Farm", 3, createDate(2, 1, 2030)),
+		createMaterial("Eggs", "Coop", 3, createDate(1, 1, 2030)),
+		createMaterial("Milk", "Dairy", 1, createDate(1, 1, 2030))
+	};
+
+	assert(initMerkleTree(&x) == 1 && initMerkleTree(&y) == 1);
+	assert(getMerkleRoot(&x) == 0 && diffMerkleTrees(&x, &y, buckets) == 0);
+
+	// the same lots in another order give the same hashes
+	for (int i = 0; i < 3; i++)
+	{
+		assert(addToMerkleTree(&x, materials[i]) == 1);
+		assert(addToMerkleTree(&y, materials[2 - i]) == 1);
+	}
+	assert(getMerkleRoot(&x) == getMerkleRoot(&y) && getMerkleRoot(&x) != 0 && x.lots == 3);
+
+	assert(addToMerkleTree(&y, materials[3]) == 1);
+	assert(diffMerkleTrees(&x, &y, buckets) == 1 && buckets[0] == lotBucket(materials[3]));
+	assert(removeFromMerkleTree(&x, materials[3]) == -1);
+
+	// a quantity is part of the hash of a lot
+	Material* changed = copyMaterial(materials[0]);
+	changed->quantity = 4;
+	assert(removeFromMerkleTree(&x, materials[0]) == 1 && addToMerkleTree(&x, changed) == 1);
+	int count = diffMerkleTrees(&x, &y, buckets);
+	assert(count >= 1 && count <= 2);
+	for (int i = 1; i < count; i++)
+		assert(buckets[i - 1] < buckets[i]);
+
+	// a tree emptied again has the hashes of a new one
+	assert(removeFromMerkleTree(&x, changed) == 1);
+	for (int i = 1; i < 3; i++)
+		assert(removeFromMerkleTree(&x, materials[i]) == 1);
+	assert(getMerkleRoot(&x) == 0 && x.lots == 0);
+	for (int b = 0; b < MERKLE_LEAVES; b++)
+		assert(x.buckets[b] == NULL);
+
+	destroyMaterial(changed);
+	for (int i = 0; i < 4; i++)
+		destroyMaterial(materials[i]);
+	freeMerkleTree(&x);
+	freeMerkleTree(&y);
+}
+
+void testMerkle()
+{
+	testMerkleTree();
+}
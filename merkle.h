@@ -0,0 +1,62 @@
+#pragma once
+
+#include "material.h"
+#include "dynamicArray.h"
+
+#include <stdint.h>
+
+#define MERKLE_LEAVES (1 << 16)
+
+/*
+	A Merkle tree of hashes over lots. Every lot falls in one of MERKLE_LEAVES buckets by the hash of its name,
+	supplier and expiration date, the same in every repository, so two repositories holding a lot keep it in the same
+	bucket. The hash of a bucket is the sum of the hashes of its lots, quantities included, so a lot is added or
+	removed without looking at the others; the hash of an inner node mixes the hashes of its two children, and is 0
+	if both are. Two trees with equal hashes at a node hold the same lots under it, whatever their order.
+	There are as many buckets as a bucket record of a diff can name (see exportDiff), so for d lots that differ between
+	repositories of n lots, O(d log MERKLE_LEAVES) nodes are compared and O(d (1 + n / MERKLE_LEAVES)) lots are sent:
+	about one per difference up to 65536 lots. A tree takes 1.5 MB, and is only built when a diff or a checksum
+	needs it.
+	nodes - the hashes, as a binary heap: node 1 is the root, the children of node i are 2i and 2i + 1, and the hash
+		of bucket b is node MERKLE_LEAVES + b
+	buckets - the lots of every bucket, or NULL while it has none; the tree does not own them
+	lots - the number of lots in the tree
+*/
+typedef struct MerkleTree
+{
+	uint64_t* nodes;
+	DynamicArray** buckets;
+	int lots;
+} MerkleTree;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initMerkleTree(MerkleTree* tree);
+void freeMerkleTree(MerkleTree* tree);
+
+/*
+	Gets the bucket of a lot, from its name, supplier and expiration date.
+*/
+int keyBucket(const char* name, const char* supplier, const Date* date);
+int lotBucket(Material* material);
+
+/*
+	Add or remove a lot, updating the hashes on the path from its bucket to the root.
+	Return 1 on success, or -1 if the memory could not be allocated or the lot is not in the tree.
+*/
+int addToMerkleTree(MerkleTree* tree, Material* material);
+int removeFromMerkleTree(MerkleTree* tree, Material* material);
+
+uint64_t getMerkleRoot(const MerkleTree* tree);
+
+/*
+	Finds the buckets whose hashes differ between two trees, descending only into the nodes whose hashes differ:
+	for d buckets that differ, O(d log MERKLE_LEAVES) nodes are compared.
+	buckets - receives the buckets in increasing order; it must have room for MERKLE_LEAVES buckets
+	Returns the number of buckets.
+*/
+int diffMerkleTrees(const MerkleTree* x, const MerkleTree* y, int* buckets);
+
+//Tests
+void testMerkle();
@@ -0,0 +1,227 @@
+#include "orderBy.h"
+#include "radixSort.h"
+#include "typedVector.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+#define SORT_KEY_LESS(x, y) (compareSortKeys((x), (y)) < 0)
+
+DEFINE_SORT(SortKey, SortKeyRef, SORT_KEY_LESS)
+
+int parseColumn(const char* token, int length, OrderKey* orderKey)
+{
+	const char* names[] = { "name", "supplier", "quantity", "date" };
+	Column columns[] = { COLUMN_NAME, COLUMN_SUPPLIER, COLUMN_QUANTITY, COLUMN_DATE };
+
+	orderKey->descending = 0;
+	if (token[0] == '-' || token[0] == '+')
+	{
+		orderKey->descending = token[0] == '-';
+		token++;
+		length--;
+	}
+
+	for (int i = 0; i < 4; i++)
+		if ((int)strlen(names[i]) == length && strncmp(token, names[i], length) == 0)
+		{
+			orderKey->column = columns[i];
+			return 1;
+		}
+
+	return -1;
+}
+
+int parseOrderBy(OrderBy* orderBy, const char* text)
+{
+	if (orderBy == NULL || text == NULL)
+		return -1;
+
+	orderBy->count = 0;
+
+	while (*text != 0)
+	{
+		int skip = (int)strspn(text, " ,\t\r\n");
+		text += skip;
+
+		int length = (int)strcspn(text, " ,\t\r\n");
+		if (length == 0)
+			break;
+
+		if (orderBy->count == MAX_ORDER_KEYS)
+			return -1;
+
+		if (parseColumn(text, length, &orderBy->keys[orderBy->count]) == -1)
+			return -1;
+
+		orderBy->count++;
+		text += length;
+	}
+
+	if (orderBy->count == 0)
+		return -1;
+
+	return 1;
+}
+
+void putBigEndian(unsigned char* buffer, uint64_t value, int bytes, int descending)
+{
+	for (int i = bytes - 1; i >= 0; i--)
+	{
+		unsigned char byte = (unsigned char)(value & 0xFF);
+		buffer[i] = descending ? (unsigned char)~byte : byte;
+		value >>= 8;
+	}
+}
+
+int encodeSortKey(const OrderBy* orderBy, Material* material, unsigned char* buffer)
+{
+	if (orderBy == NULL || material == NULL)
+		return -1;
+
+	int length = 0;
+
+	for (int k = 0; k < orderBy->count; k++)
+	{
+		const OrderKey* orderKey = &orderBy->keys[k];
+
+		switch (orderKey->column)
+		{
+		case COLUMN_NAME:
+		case COLUMN_SUPPLIER:
+		{
+			const char* string = orderKey->column == COLUMN_NAME ? getName(material) : getSupplier(material);
+			int size = (int)strlen(string) + 1;
+
+			if (buffer != NULL)
+			{
+				memcpy(buffer + length, string, size);
+				if (orderKey->descending)
+					for (int i = length; i < length + size; i++)
+						buffer[i] = (unsigned char)~buffer[i];
+			}
+			length += size;
+			break;
+		}
+		case COLUMN_QUANTITY:
+			if (buffer != NULL)
+				putBigEndian(buffer + length, quantityKey(getQuantity(material)), 8, orderKey->descending);
+			length += 8;
+			break;
+		case COLUMN_DATE:
+			if (buffer != NULL)
+				putBigEndian(buffer + length, (uint64_t)dateKey(getDate(material)), 4, orderKey->descending);
+			length += 4;
+			break;
+		}
+	}
+
+	return length;
+}
+
+int sortOrderBy(DynamicArray* dArray, const OrderBy* orderBy)
+{
+	if (dArray == NULL || orderBy == NULL)
+		return -1;
+
+	int size = len(dArray);
+	if (size < 2)
+		return 1;
+
+	size_t total = 0;
+	for (int i = 0; i < size; i++)
+		total += encodeSortKey(orderBy, getElement(dArray, i), NULL);
+
+	unsigned char* arena = (unsigned char*)malloc(total);
+	SortKeyRef* refs = (SortKeyRef*)malloc(sizeof(SortKeyRef) * size);
+	void** data = (void**)malloc(sizeof(void*) * size);
+
+	if (arena == NULL || refs == NULL || data == NULL)
+	{
+		free(arena);
+		free(refs);
+		free(data);
+		return -1;
+	}
+
+	unsigned char* key = arena;
+	for (int i = 0; i < size; i++)
+	{
+		int length = encodeSortKey(orderBy, getElement(dArray, i), key);
+
+		refs[i].prefix = getKeyPrefix(key, length);
+		refs[i].key = key;
+		refs[i].length = (uint32_t)length;
+		refs[i].index = (uint32_t)i;
+		key += length;
+	}
+
+	SortKeySort(refs, size);
+
+	for (int i = 0; i < size; i++)
+		data[i] = dArray->data[refs[i].index];
+	memcpy(dArray->data, data, sizeof(void*) * size);
+
+	free(arena);
+	free(refs);
+	free(data);
+	return 1;
+}
+
+
+//Tests
+
+
+void testParseOrderBy()
+{
+	OrderBy orderBy;
+
+	assert(parseOrderBy(&orderBy, "supplier, date -quantity") == 1);
+	assert(orderBy.count == 3);
+	assert(orderBy.keys[0].column == COLUMN_SUPPLIER && orderBy.keys[0].descending == 0);
+	assert(orderBy.keys[1].column == COLUMN_DATE && orderBy.keys[1].descending == 0);
+	assert(orderBy.keys[2].column == COLUMN_QUANTITY && orderBy.keys[2].descending == 1);
+
+	assert(parseOrderBy(&orderBy, "") == -1);
+	assert(parseOrderBy(&orderBy, "colour") == -1);
+	assert(parseOrderBy(&orderBy, "name name name name name") == -1);
+}
+
+void testSortOrderBy()
+{
+	DynamicArray* testArray = createDynamicArray(2, &destroyMaterial);
+
+	apd(testArray, createMaterial("a", "y", 1, createDate(1, 1, 2022)));
+	apd(testArray, createMaterial("b", "x", 2, createDate(1, 1, 2022)));
+	apd(testArray, createMaterial("c", "y", 3, createDate(1, 1, 2021)));
+	apd(testArray, createMaterial("d", "y", 4, createDate(1, 1, 2022)));
+	apd(testArray, createMaterial("ab", "xy", 5, createDate(1, 1, 2022)));
+
+	OrderBy orderBy;
+	parseOrderBy(&orderBy, "supplier date -quantity");
+
+	assert(sortOrderBy(testArray, &orderBy) == 1);
+	assert(getQuantity(getElement(testArray, 0)) == 2);
+	assert(getQuantity(getElement(testArray, 1)) == 5);
+	assert(getQuantity(getElement(testArray, 2)) == 3);
+	assert(getQuantity(getElement(testArray, 3)) == 4);
+	assert(getQuantity(getElement(testArray, 4)) == 1);
+
+	parseOrderBy(&orderBy, "-name");
+	assert(sortOrderBy(testArray, &orderBy) == 1);
+	assert(strcmp(getName(getElement(testArray, 0)), "d") == 0);
+	assert(strcmp(getName(getElement(testArray, 1)), "c") == 0);
+	assert(strcmp(getName(getElement(testArray, 2)), "b") == 0);
+	assert(strcmp(getName(getElement(testArray, 3)), "ab") == 0);
+	assert(strcmp(getName(getElement(testArray, 4)), "a") == 0);
+
+	destroyDynamicArray(testArray);
+}
+
+void testOrderBy()
+{
+	testParseOrderBy();
+	testSortOrderBy();
+}
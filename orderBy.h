@@ -0,0 +1,90 @@
+#pragma once
+
+#include "dynamicArray.h"
+#include "material.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_ORDER_KEYS 4
+
+typedef enum Column
+{
+	COLUMN_NAME,
+	COLUMN_SUPPLIER,
+	COLUMN_QUANTITY,
+	COLUMN_DATE
+} Column;
+
+typedef struct OrderKey
+{
+	Column column;
+	int descending;
+} OrderKey;
+
+typedef struct OrderBy
+{
+	int count;
+	OrderKey keys[MAX_ORDER_KEYS];
+} OrderBy;
+
+/*
+	A reference to an encoded sort key. The first 8 bytes of the key are also kept as a big endian integer,
+	which decides most comparisons without reading the key. The index breaks the ties.
+*/
+typedef struct SortKeyRef
+{
+	uint64_t prefix;
+	const unsigned char* key;
+	uint32_t length, index;
+} SortKeyRef;
+
+static inline uint64_t getKeyPrefix(const unsigned char* key, int length)
+{
+	uint64_t prefix = 0;
+	for (int b = 0; b < 8; b++)
+		prefix = (prefix << 8) | (b < length ? key[b] : 0);
+
+	return prefix;
+}
+
+static inline int compareSortKeys(const SortKeyRef* x, const SortKeyRef* y)
+{
+	if (x->prefix != y->prefix)
+		return x->prefix < y->prefix ? -1 : 1;
+
+	uint32_t length = x->length < y->length ? x->length : y->length;
+	int status = memcmp(x->key, y->key, length);
+	if (status != 0)
+		return status;
+
+	if (x->length != y->length)
+		return x->length < y->length ? -1 : 1;
+
+	return x->index < y->index ? -1 : (x->index > y->index);
+}
+
+/*
+	Parses a list of column names separated by spaces or commas, e.g. "supplier date -quantity".
+	A '-' in front of a column selects descending order.
+	Returns 1 on success, or -1 if a column is unknown or there are too many of them.
+*/
+int parseOrderBy(OrderBy* orderBy, const char* text);
+
+/*
+	Encodes the columns of the material into a byte string that compares with memcmp in the order given by orderBy.
+	Strings are followed by a 0 byte, quantities and dates are stored as big endian order-preserving integers,
+	and the bytes of the descending columns are inverted.
+	Returns the length of the key, or -1 if the arguments are not valid. If the buffer is NULL, only the length is computed.
+*/
+int encodeSortKey(const OrderBy* orderBy, Material* material, unsigned char* buffer);
+
+/*
+	Sorts a dynamic array of materials in the order given by orderBy. The key of every row is encoded once,
+	then the rows are ordered by comparing the keys. Rows with equal keys keep their relative order.
+	Returns 1 on success, or -1 otherwise.
+*/
+int sortOrderBy(DynamicArray* dArray, const OrderBy* orderBy);
+
+//Tests
+void testOrderBy();
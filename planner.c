@@ -0,0 +1,347 @@
+#include "planner.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <assert.h>
+
+// selectivities used for the filters the statistics know nothing about
+#define NAME_SELECTIVITY 0.1
+#define CUSTOM_SELECTIVITY 0.5
+
+
+/*
+	Estimates the rows examined through the trigram index for a name filter: every candidate name with the average
+	number of lots per name. Returns -1 if the pattern is too short for the index.
+*/
+double estimateNameIndexRows(MaterialRepo* materialRepo, const Filter* filter)
+{
+	DynamicArray* candidates = getTrigramCandidates(&materialRepo->nameTrigrams, filter->text);
+	int names = mapSize(materialRepo->names);
+
+	if (candidates == NULL)
+		return -1;
+	if (names == 0)
+		return 0;
+
+	return (double)len(candidates) * getSize(materialRepo) / names;
+}
+
+/*
+	Gets the range of expiration days [from, to) matched by a date filter.
+	Returns 1 if the filter is a date filter, 0 otherwise.
+*/
+int getFilterDays(const Query* query, const Filter* filter, int* from, int* to)
+{
+	int today = keyDayNumber(query->today);
+
+	if (filter->type == FILTER_EXPIRED)
+	{
+		*from = INT_MIN;
+		*to = today;
+		return 1;
+	}
+	if (filter->type == FILTER_EXPIRES_WITHIN)
+	{
+		*from = today;
+		*to = today + (int)filter->number;
+		return 1;
+	}
+
+	return 0;
+}
+
+double estimateFilterRows(MaterialRepo* materialRepo, const Query* query, const Filter* filter)
+{
+	int size = getSize(materialRepo);
+
+	switch (filter->type)
+	{
+	case FILTER_NAME_CONTAINS:
+	{
+		double rows = estimateNameIndexRows(materialRepo, filter);
+		if (rows != -1 && rows < size * NAME_SELECTIVITY)
+			return rows;
+		return filter->text[0] == 0 ? size : size * NAME_SELECTIVITY;
+	}
+	case FILTER_SUPPLIER:
+	{
+		MaterialGroup* group = getSupplierGroup(materialRepo, filter->text);
+		return group == NULL ? 0 : len(group->lots);
+	}
+	case FILTER_LESS_THAN:
+		return estimateLessThan(&materialRepo->quantityHistogram, filter->number);
+	case FILTER_EXPIRED:
+		return estimateExpired(&materialRepo->expiryHistogram, query->today);
+	case FILTER_EXPIRES_WITHIN:
+	{
+		int from = 0, to = 0;
+		getFilterDays(query, filter, &from, &to);
+		return countCalendarRange(&materialRepo->calendar, from, to);
+	}
+	case FILTER_CUSTOM:
+		return size * CUSTOM_SELECTIVITY;
+	}
+
+	return size;
+}
+
+int planQuery(MaterialRepo* materialRepo, const Query* query, QueryPlan* plan)
+{
+	if (materialRepo == NULL || query == NULL || plan == NULL)
+		return -1;
+
+	int size = getSize(materialRepo);
+
+	plan->path = PATH_FULL_SCAN;
+	plan->filter = -1;
+	plan->cost = size;
+	plan->estimatedRows = size;
+	plan->actualRows = -1;
+
+	for (int i = 0; i < query->filterCount; i++)
+	{
+		const Filter* filter = &query->filters[i];
+		double rows = estimateFilterRows(materialRepo, query, filter);
+
+		// the filters are assumed to be independent
+		if (size > 0)
+			plan->estimatedRows *= rows / size;
+
+		if (filter->type == FILTER_SUPPLIER && rows < plan->cost)
+		{
+			plan->path = PATH_SUPPLIER_INDEX;
+			plan->filter = i;
+			plan->cost = rows;
+		}
+
+		int from, to;
+		if (getFilterDays(query, filter, &from, &to))
+		{
+			// the calendar gives the exact number of rows of a date range
+			int calendarRows = countCalendarRange(&materialRepo->calendar, from, to);
+			if (calendarRows < plan->cost)
+			{
+				plan->path = PATH_CALENDAR;
+				plan->filter = i;
+				plan->cost = calendarRows;
+			}
+		}
+
+		if (filter->type == FILTER_NAME_CONTAINS)
+		{
+			double indexRows = estimateNameIndexRows(materialRepo, filter);
+			if (indexRows != -1 && indexRows < plan->cost)
+			{
+				plan->path = PATH_NAME_INDEX;
+				plan->filter = i;
+				plan->cost = indexRows;
+			}
+		}
+	}
+
+	if (query->limit > 0 && plan->estimatedRows > query->limit)
+		plan->estimatedRows = query->limit;
+
+	return 1;
+}
+
+int getPlanSources(MaterialRepo* materialRepo, const Query* query, const QueryPlan* plan, DynamicArray* sources)
+{
+	if (materialRepo == NULL || query == NULL || plan == NULL || sources == NULL)
+		return -1;
+
+	switch (plan->path)
+	{
+	case PATH_FULL_SCAN:
+		return apd(sources, materialRepo->data);
+	case PATH_SUPPLIER_INDEX:
+	{
+		MaterialGroup* group = getSupplierGroup(materialRepo, query->filters[plan->filter].text);
+		if (group == NULL)
+			return 1;
+		return apd(sources, group->lots);
+	}
+	case PATH_NAME_INDEX:
+	{
+		DynamicArray* groups = createDynamicArray(2, NULL);
+		if (groups == NULL)
+			return -1;
+
+		int status = findNameGroups(materialRepo, query->filters[plan->filter].text, groups);
+		for (int i = 0; i < len(groups) && status == 1; i++)
+			status = apd(sources, ((MaterialGroup*)getElement(groups, i))->lots);
+
+		destroyDynamicArray(groups);
+		return status == 1 ? 1 : -1;
+	}
+	case PATH_CALENDAR:
+	{
+		int from, to;
+		if (!getFilterDays(query, &query->filters[plan->filter], &from, &to))
+			return -1;
+		return getCalendarRange(&materialRepo->calendar, from, to, sources) == -1 ? -1 : 1;
+	}
+	}
+
+	return -1;
+}
+
+int countRows(Material* material, int columns, int* count)
+{
+	(void)material;
+	(void)columns;
+	(*count)++;
+	return 1;
+}
+
+int explainQuery(MaterialRepo* materialRepo, const Query* query, QueryPlan* plan)
+{
+	if (planQuery(materialRepo, query, plan) == -1)
+		return -1;
+
+	int count = 0;
+	if (runQuery(materialRepo, query, &countRows, &count) == -1)
+		return -1;
+
+	plan->actualRows = count;
+	return 1;
+}
+
+const char* getAccessPathName(AccessPath path)
+{
+	switch (path)
+	{
+	case PATH_FULL_SCAN:
+		return "full scan";
+	case PATH_SUPPLIER_INDEX:
+		return "supplier index";
+	case PATH_NAME_INDEX:
+		return "name trigram index";
+	case PATH_CALENDAR:
+		return "expiration calendar";
+	}
+
+	return "unknown";
+}
+
+
+//Tests
+
+
+void testPlanQuery()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(2);
+
+	for (int i = 0; i < 20; i++)
+		addMaterial(materialRepo, createMaterial("name", "bigSupplier", i, createDate(1, 1, 2000 + i)));
+	addMaterial(materialRepo, createMaterial("name", "smallSupplier", 1, createDate(1, 1, 2000)));
+
+	Query query;
+	QueryPlan plan;
+
+	initQuery(&query);
+	assert(planQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_FULL_SCAN);
+	assert(plan.cost == 21);
+
+	parseQuery(&query, "quantity<5 supplier=smallSupplier");
+	assert(planQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_SUPPLIER_INDEX);
+	assert(plan.filter == 1);
+	assert(plan.cost == 1);
+
+	parseQuery(&query, "supplier=missingSupplier");
+	assert(planQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_SUPPLIER_INDEX);
+	assert(plan.estimatedRows == 0);
+
+	parseQuery(&query, "supplier=bigSupplier quantity<5");
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_SUPPLIER_INDEX);
+	assert(plan.actualRows == 5);
+	assert(plan.estimatedRows > 0 && plan.estimatedRows < 20);
+
+	destroyMaterialRepo(materialRepo);
+}
+
+void testPlanNameIndex()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(2);
+	char name[16];
+
+	for (int i = 0; i < 200; i++)
+	{
+		snprintf(name, sizeof(name), "name%03d", i);
+		addMaterial(materialRepo, createMaterial(name, "supplier", i, createDate(1, 1, 2000)));
+		addMaterial(materialRepo, createMaterial(name, "supplier", i, createDate(1, 1, 2001)));
+	}
+
+	Query query;
+	QueryPlan plan;
+
+	parseQuery(&query, "name~e15");
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_NAME_INDEX);
+	assert(plan.cost < 40);
+	assert(plan.actualRows == 20);
+
+	parseQuery(&query, "name~xyz");
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_NAME_INDEX);
+	assert(plan.cost == 0 && plan.actualRows == 0);
+
+	parseQuery(&query, "name~e1");
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_FULL_SCAN);
+	assert(plan.actualRows == 200);
+
+	parseQuery(&query, "name~ame");
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_FULL_SCAN);
+	assert(plan.actualRows == 400);
+
+	destroyMaterialRepo(materialRepo);
+}
+
+void testPlanCalendar()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(2);
+	Query query;
+	QueryPlan plan;
+
+	for (int i = 0; i < 50; i++)
+		addMaterial(materialRepo, createMaterial("name", "supplier", i, createDate(1 + i % 28, 1 + i % 12, 2000 + i)));
+
+	parseQuery(&query, "within=7");
+	Date today = { 1, 1, 2030 };
+	query.today = dateKey(&today);
+	addMaterial(materialRepo, createMaterial("soon", "supplier", 1, createDate(1, 1, 2030)));
+	addMaterial(materialRepo, createMaterial("soon", "supplier", 2, createDate(7, 1, 2030)));
+	addMaterial(materialRepo, createMaterial("later", "supplier", 3, createDate(8, 1, 2030)));
+
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_CALENDAR);
+	assert(plan.cost == 2 && plan.actualRows == 2);
+
+	parseQuery(&query, "expired");
+	query.today = dateKey(&today);
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.actualRows == 30);
+
+	Date past = { 1, 1, 2005 };
+	query.today = dateKey(&past);
+	assert(explainQuery(materialRepo, &query, &plan) == 1);
+	assert(plan.path == PATH_CALENDAR);
+	assert(plan.cost == 5 && plan.actualRows == 5);
+
+	destroyMaterialRepo(materialRepo);
+}
+
+void testPlanner()
+{
+	testPlanCalendar();
+	testPlanQuery();
+	testPlanNameIndex();
+}
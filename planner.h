@@ -0,0 +1,51 @@
+#pragma once
+
+#include "query.h"
+
+typedef enum AccessPath
+{
+	PATH_FULL_SCAN,
+	PATH_SUPPLIER_INDEX,
+	PATH_NAME_INDEX,
+	PATH_CALENDAR
+} AccessPath;
+
+/*
+	The way a query is executed.
+	path - the access path producing the candidate rows, in its own order: the repository order for a full scan, no
+		particular order for the supplier and name indexes, and expiration days for the calendar
+	filter - the position of the query filter served by the access path, or -1 for a full scan
+	cost - the estimated number of candidate rows the path examines
+	estimatedRows - the estimated number of rows passing every filter
+	actualRows - the number of rows the query produced, filled in by explainQuery
+*/
+typedef struct QueryPlan
+{
+	AccessPath path;
+	int filter;
+	double cost, estimatedRows;
+	int actualRows;
+} QueryPlan;
+
+/*
+	Chooses the access path with the lowest estimated cost, using the statistics of the repository.
+	Returns 1 on success, or -1 if the arguments are not valid.
+*/
+int planQuery(MaterialRepo* materialRepo, const Query* query, QueryPlan* plan);
+
+/*
+	Appends to sources the arrays of materials that the access path of the plan examines.
+	Returns 1 on success, or -1 otherwise.
+*/
+int getPlanSources(MaterialRepo* materialRepo, const Query* query, const QueryPlan* plan, DynamicArray* sources);
+
+/*
+	Plans and runs the query, filling in the actual number of rows of the plan.
+	Returns 1 on success, or -1 otherwise.
+*/
+int explainQuery(MaterialRepo* materialRepo, const Query* query, QueryPlan* plan);
+
+const char* getAccessPathName(AccessPath path);
+
+//Tests
+void testPlanner();
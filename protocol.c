@@ -0,0 +1,512 @@
+#include "protocol.h"
+#include "validation.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+
+void initByteBuffer(ByteBuffer* buffer)
+{
+	if (buffer == NULL)
+		return;
+
+	buffer->data = NULL;
+	buffer->size = 0;
+	buffer->capacity = 0;
+	buffer->failed = 0;
+}
+
+void freeByteBuffer(ByteBuffer* buffer)
+{
+	if (buffer == NULL)
+		return;
+
+	free(buffer->data);
+	initByteBuffer(buffer);
+}
+
+int reserveBuffer(ByteBuffer* buffer, int length)
+{
+	if (buffer->size + length <= buffer->capacity)
+		return 1;
+
+	int capacity = buffer->capacity == 0 ? 4096 : buffer->capacity;
+	while (capacity < buffer->size + length)
+		capacity *= 2;
+
+	unsigned char* data = (unsigned char*)realloc(buffer->data, capacity);
+	if (data == NULL)
+	{
+		buffer->failed = 1;
+		return -1;
+	}
+
+	buffer->data = data;
+	buffer->capacity = capacity;
+	return 1;
+}
+
+void putBytes(ByteBuffer* buffer, const void* bytes, int length)
+{
+	if (reserveBuffer(buffer, length) == -1)
+		return;
+
+	memcpy(buffer->data + buffer->size, bytes, length);
+	buffer->size += length;
+}
+
+void putU8(ByteBuffer* buffer, uint8_t value)
+{
+	putBytes(buffer, &value, 1);
+}
+
+void putU16(ByteBuffer* buffer, uint16_t value)
+{
+	unsigned char bytes[2] = { (unsigned char)value, (unsigned char)(value >> 8) };
+	putBytes(buffer, bytes, 2);
+}
+
+void putU32(ByteBuffer* buffer, uint32_t value)
+{
+	unsigned char bytes[4];
+	for (int i = 0; i < 4; i++)
+		bytes[i] = (unsigned char)(value >> (8 * i));
+	putBytes(buffer, bytes, 4);
+}
+
+void putDouble(ByteBuffer* buffer, double value)
+{
+	uint64_t bits;
+	unsigned char bytes[8];
+
+	memcpy(&bits, &value, sizeof(bits));
+	for (int i = 0; i < 8; i++)
+		bytes[i] = (unsigned char)(bits >> (8 * i));
+	putBytes(buffer, bytes, 8);
+}
+
+void putStringField(ByteBuffer* buffer, const char* text)
+{
+	size_t length = text == NULL ? 0 : strlen(text);
+	if (length > UINT16_MAX)
+		length = UINT16_MAX;
+
+	putU16(buffer, (uint16_t)length);
+	putBytes(buffer, text, (int)length);
+}
+
+void putDateField(ByteBuffer* buffer, int day, int month, int year)
+{
+	putU8(buffer, (uint8_t)day);
+	putU8(buffer, (uint8_t)month);
+	putU16(buffer, (uint16_t)year);
+}
+
+void initByteReader(ByteReader* reader, const unsigned char* data, int size)
+{
+	reader->data = data;
+	reader->size = size;
+	reader->position = 0;
+	reader->failed = 0;
+}
+
+/*
+	Returns the next length bytes, or NULL if the frame ends before them.
+*/
+const unsigned char* takeBytes(ByteReader* reader, int length)
+{
+	if (reader->failed || reader->size - reader->position < length)
+	{
+		reader->failed = 1;
+		return NULL;
+	}
+
+	const unsigned char* bytes = reader->data + reader->position;
+	reader->position += length;
+	return bytes;
+}
+
+uint8_t getU8(ByteReader* reader)
+{
+	const unsigned char* bytes = takeBytes(reader, 1);
+	return bytes == NULL ? 0 : bytes[0];
+}
+
+uint16_t getU16(ByteReader* reader)
+{
+	const unsigned char* bytes = takeBytes(reader, 2);
+	return bytes == NULL ? 0 : (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+uint32_t getU32(ByteReader* reader)
+{
+	const unsigned char* bytes = takeBytes(reader, 4);
+	return bytes == NULL ? 0 : (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+double getDouble(ByteReader* reader)
+{
+	const unsigned char* bytes = takeBytes(reader, 8);
+	uint64_t bits = 0;
+	double value;
+
+	if (bytes != NULL)
+		for (int i = 0; i < 8; i++)
+			bits |= (uint64_t)bytes[i] << (8 * i);
+
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void getDateField(ByteReader* reader, int* day, int* month, int* year)
+{
+	*day = getU8(reader);
+	*month = getU8(reader);
+	*year = getU16(reader);
+}
+
+int getStringField(ByteReader* reader, char* text, int capacity)
+{
+	int length = getU16(reader);
+	const unsigned char* bytes = takeBytes(reader, length);
+
+	if (bytes == NULL || length > capacity - 1)
+	{
+		reader->failed = 1;
+		text[0] = 0;
+		return -1;
+	}
+
+	memcpy(text, bytes, length);
+	text[length] = 0;
+	return 1;
+}
+
+int beginFrame(ByteBuffer* buffer, uint32_t id, uint8_t code)
+{
+	int frame = buffer->size;
+
+	putU32(buffer, 0);
+	putU32(buffer, id);
+	putU8(buffer, code);
+
+	return frame;
+}
+
+void endFrame(ByteBuffer* buffer, int frame)
+{
+	if (buffer->failed)
+		return;
+
+	uint32_t length = (uint32_t)(buffer->size - frame - 4);
+	for (int i = 0; i < 4; i++)
+		buffer->data[frame + i] = (unsigned char)(length >> (8 * i));
+}
+
+int frameSize(const unsigned char* data, int size)
+{
+	if (size < 4)
+		return 0;
+
+	uint32_t length = (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+
+	if (length > MAX_FRAME_SIZE)
+		return -1;
+	if ((uint32_t)size - 4 < length)
+		return 0;
+
+	return (int)length + 4;
+}
+
+void putMaterial(ByteBuffer* buffer, Material* material)
+{
+	const Date* date = getDate(material);
+
+	putStringField(buffer, getName(material));
+	putStringField(buffer, getSupplier(material));
+	putDouble(buffer, getQuantity(material));
+	putDateField(buffer, getDay(date), getMonth(date), getYear(date));
+}
+
+/*
+	Reads the name, supplier and date of a lot, and checks them as the text commands do.
+	Returns 1 on success, or -1 if they are not valid.
+*/
+int getLot(ByteReader* reader, char* name, char* supplier, int* day, int* month, int* year)
+{
+	getStringField(reader, name, MAX_STRING_SIZE);
+	getStringField(reader, supplier, MAX_STRING_SIZE);
+	getDateField(reader, day, month, year);
+
+	if (reader->failed || !validateDate(*day, *month, *year))
+		return -1;
+
+	return 1;
+}
+
+int serveBinaryRequest(MaterialServices* materialServices, const unsigned char* frame, int length, ByteBuffer* responses)
+{
+	ByteReader reader;
+	char name[MAX_STRING_SIZE], supplier[MAX_STRING_SIZE];
+	char newName[MAX_STRING_SIZE], newSupplier[MAX_STRING_SIZE];
+	char text[MAX_QUERY_SIZE];
+	int day, month, year, newDay = 0, newMonth = 0, newYear = 0;
+	double quantity = 0;
+	Query query;
+
+	initByteReader(&reader, frame, length);
+	uint32_t id = getU32(&reader);
+	uint8_t type = getU8(&reader);
+
+	// every field is read and checked before anything is run
+	int valid = 1;
+	switch (type)
+	{
+	case REQUEST_ADD:
+		getStringField(&reader, name, MAX_STRING_SIZE);
+		getStringField(&reader, supplier, MAX_STRING_SIZE);
+		quantity = getDouble(&reader);
+		getDateField(&reader, &day, &month, &year);
+		valid = isfinite(quantity) && validateDate(day, month, year);
+		break;
+	case REQUEST_UPDATE:
+		valid = getLot(&reader, name, supplier, &day, &month, &year) == 1;
+		getStringField(&reader, newName, MAX_STRING_SIZE);
+		getStringField(&reader, newSupplier, MAX_STRING_SIZE);
+		quantity = getDouble(&reader);
+		getDateField(&reader, &newDay, &newMonth, &newYear);
+		valid = valid && isfinite(quantity) && validateDate(newDay, newMonth, newYear);
+		break;
+	case REQUEST_REMOVE:
+	case REQUEST_LOOKUP:
+		valid = getLot(&reader, name, supplier, &day, &month, &year) == 1;
+		break;
+	case REQUEST_QUERY:
+		valid = getStringField(&reader, text, sizeof(text)) == 1 && parseQuery(&query, text) == 1;
+		break;
+	default:
+		valid = 0;
+		break;
+	}
+
+	// the frame has to hold exactly the fields of its type
+	if (reader.failed || reader.position != reader.size)
+		valid = 0;
+
+	ResponseStatus status = RESPONSE_INVALID;
+	DynamicArray* rows = NULL;
+	Material* lot = NULL;
+	int result = -1;
+
+	if (valid)
+	{
+		switch (type)
+		{
+		case REQUEST_ADD:
+			result = add(materialServices, name, supplier, quantity, day, month, year);
+			break;
+		case REQUEST_UPDATE:
+			result = update(materialServices, name, supplier, day, month, year, newName, newSupplier, quantity, newDay, newMonth, newYear);
+			break;
+		case REQUEST_REMOVE:
+			result = rem(materialServices, name, supplier, day, month, year);
+			break;
+		case REQUEST_LOOKUP:
+			lot = findLot(materialServices, name, supplier, day, month, year);
+			result = lot != NULL ? 1 : -1;
+			break;
+		case REQUEST_QUERY:
+			rows = getQueryView(materialServices, &query);
+			result = rows != NULL ? 1 : -1;
+			break;
+		}
+		status = result == 1 ? RESPONSE_OK : RESPONSE_FAILED;
+	}
+
+	int response = beginFrame(responses, id, (uint8_t)status);
+	if (lot != NULL)
+	{
+		putU32(responses, 1);
+		putMaterial(responses, lot);
+	}
+	if (rows != NULL)
+	{
+		putU32(responses, (uint32_t)len(rows));
+		for (int i = 0; i < len(rows); i++)
+			putMaterial(responses, getElement(rows, i));
+		destroyDynamicArray(rows);
+	}
+	endFrame(responses, response);
+
+	return responses->failed ? -1 : 1;
+}
+
+//Tests
+
+
+void testByteBuffer()
+{
+	ByteBuffer buffer;
+	ByteReader reader;
+	char text[8];
+	int day, month, year;
+
+	initByteBuffer(&buffer);
+
+	int frame = beginFrame(&buffer, 0xA1B2C3D4, 7);
+	putU16(&buffer, 65535);
+	putDouble(&buffer, -2.5);
+	putStringField(&buffer, "Eggs");
+	putStringField(&buffer, "too long");
+	putDateField(&buffer, 31, 12, 2030);
+	endFrame(&buffer, frame);
+
+	assert(frameSize(buffer.data, buffer.size) == buffer.size);
+	assert(frameSize(buffer.data, buffer.size - 1) == 0);
+	assert(frameSize(buffer.data, 3) == 0);
+	assert(buffer.data[0] == buffer.size - 4 && buffer.data[4] == 0xD4);
+
+	initByteReader(&reader, buffer.data + 4, buffer.size - 4);
+	assert(getU32(&reader) == 0xA1B2C3D4 && getU8(&reader) == 7);
+	assert(getU16(&reader) == 65535 && getDouble(&reader) == -2.5);
+	assert(getStringField(&reader, text, sizeof(text)) == 1 && strcmp(text, "Eggs") == 0);
+	assert(getStringField(&reader, text, sizeof(text)) == -1 && reader.failed);
+
+	initByteReader(&reader, buffer.data + buffer.size - 4, 4);
+	getDateField(&reader, &day, &month, &year);
+	assert(day == 31 && month == 12 && year == 2030 && !reader.failed);
+	assert(getU8(&reader) == 0 && reader.failed);
+
+	unsigned char large[4] = { 0, 0, 0x20, 0 };
+	assert(frameSize(large, 4) == -1);
+
+	freeByteBuffer(&buffer);
+}
+
+/*
+	Runs the request frames in the buffer and checks the status of each response.
+*/
+void checkResponses(MaterialServices* materialServices, ByteBuffer* requests, ByteBuffer* responses, const uint8_t* statuses, int count)
+{
+	int size, position = 0;
+
+	responses->size = 0;
+	while ((size = frameSize(requests->data + position, requests->size - position)) > 0)
+	{
+		assert(serveBinaryRequest(materialServices, requests->data + position + 4, size - 4, responses) == 1);
+		position += size;
+	}
+	assert(position == requests->size);
+
+	position = 0;
+	for (int i = 0; i < count; i++)
+	{
+		size = frameSize(responses->data + position, responses->size - position);
+		assert(size > 0);
+		assert(responses->data[position + 4] == i + 1 && responses->data[position + 8] == statuses[i]);
+		position += size;
+	}
+	assert(position == responses->size);
+}
+
+void testServeBinaryRequest()
+{
+	MaterialServices* materialServices = createMaterialServices(createMaterialRepo(10));
+	ByteBuffer requests, responses;
+	ByteReader reader;
+	char text[MAX_STRING_SIZE];
+	int day, month, year;
+
+	initByteBuffer(&requests);
+	initByteBuffer(&responses);
+
+	int frame = beginFrame(&requests, 1, REQUEST_ADD);
+	putStringField(&requests, "Eggs");
+	putStringField(&requests, "Farm");
+	putDouble(&requests, 3);
+	putDateField(&requests, 1, 1, 2030);
+	endFrame(&requests, frame);
+
+	frame = beginFrame(&requests, 2, REQUEST_UPDATE);
+	putStringField(&requests, "Eggs");
+	putStringField(&requests, "Farm");
+	putDateField(&requests, 1, 1, 2030);
+	putStringField(&requests, "Eggs");
+	putStringField(&requests, "Farm");
+	putDouble(&requests, 5);
+	putDateField(&requests, 1, 1, 2030);
+	endFrame(&requests, frame);
+
+	frame = beginFrame(&requests, 3, REQUEST_LOOKUP);
+	putStringField(&requests, "Eggs");
+	putStringField(&requests, "Farm");
+	putDateField(&requests, 1, 1, 2030);
+	endFrame(&requests, frame);
+
+	// an invalid date, a missing lot, a frame with a field too many, an unknown type
+	frame = beginFrame(&requests, 4, REQUEST_REMOVE);
+	putStringField(&requests, "Eggs");
+	putStringField(&requests, "Farm");
+	putDateField(&requests, 31, 2, 2030);
+	endFrame(&requests, frame);
+
+	frame = beginFrame(&requests, 5, REQUEST_REMOVE);
+	putStringField(&requests, "Eggs");
+	putStringField(&requests, "Farm");
+	putDateField(&requests, 2, 1, 2030);
+	endFrame(&requests, frame);
+
+	frame = beginFrame(&requests, 6, REQUEST_QUERY);
+	putStringField(&requests, "name~Egg");
+	putU8(&requests, 0);
+	endFrame(&requests, frame);
+
+	frame = beginFrame(&requests, 7, 99);
+	endFrame(&requests, frame);
+
+	frame = beginFrame(&requests, 8, REQUEST_QUERY);
+	putStringField(&requests, "name~Egg");
+	endFrame(&requests, frame);
+
+	// a quantity that is not finite
+	frame = beginFrame(&requests, 9, REQUEST_ADD);
+	putStringField(&requests, "Eggs");
+	putStringField(&requests, "Farm");
+	putDouble(&requests, NAN);
+	putDateField(&requests, 2, 1, 2030);
+	endFrame(&requests, frame);
+
+	uint8_t statuses[] = { RESPONSE_OK, RESPONSE_OK, RESPONSE_OK, RESPONSE_INVALID, RESPONSE_FAILED, RESPONSE_INVALID, RESPONSE_INVALID, RESPONSE_OK, RESPONSE_INVALID };
+	checkResponses(materialServices, &requests, &responses, statuses, 9);
+
+	// the lookup and the query return the updated lot
+	int position = frameSize(responses.data, responses.size);
+	position += frameSize(responses.data + position, responses.size - position);
+	for (int i = 0; i < 2; i++)
+	{
+		initByteReader(&reader, responses.data + position + 9, frameSize(responses.data + position, responses.size - position) - 9);
+		assert(getU32(&reader) == 1);
+		assert(getStringField(&reader, text, sizeof(text)) == 1 && strcmp(text, "Eggs") == 0);
+		assert(getStringField(&reader, text, sizeof(text)) == 1 && strcmp(text, "Farm") == 0);
+		assert(getDouble(&reader) == 5);
+		getDateField(&reader, &day, &month, &year);
+		assert(day == 1 && month == 1 && year == 2030);
+		assert(reader.position == reader.size && !reader.failed);
+
+		// skip to the response of the second query
+		for (int skip = 0; skip < 5; skip++)
+			position += frameSize(responses.data + position, responses.size - position);
+	}
+
+	freeByteBuffer(&requests);
+	freeByteBuffer(&responses);
+	destroyMaterialServices(materialServices);
+}
+
+void testProtocol()
+{
+	testByteBuffer();
+	testServeBinaryRequest();
+}
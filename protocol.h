@@ -0,0 +1,125 @@
+#pragma once
+
+#include "services.h"
+
+#include <stdint.h>
+
+#define PROTOCOL_MAGIC 0xB1
+#define MAX_FRAME_SIZE (1 << 20)
+#define MAX_QUERY_SIZE 256
+
+/*
+	The binary protocol of the server (see Server). A client starts its connection with the byte PROTOCOL_MAGIC, then
+	sends request frames, without waiting for the responses: each one is answered by a response frame with the same id,
+	in the order the requests were sent, and all the responses to the requests read at once are written at once.
+	Every integer is little endian, a string is its length as a u16 followed by its bytes, a number is the bits of a
+	double as a u64, and a date is the day as a u8, the month as a u8 and the year as a u16.
+	request - u32 length of the rest of the frame, u32 id, u8 type, then the fields of the type:
+		REQUEST_ADD - name, supplier, quantity, date
+		REQUEST_UPDATE - name, supplier, date, new name, new supplier, new quantity, new date
+		REQUEST_REMOVE, REQUEST_LOOKUP - name, supplier, date
+		REQUEST_QUERY - the stages of a query, as a string (see parseQuery)
+	response - u32 length of the rest of the frame, u32 id, u8 status, then for a lookup or a query that succeeded
+		the u32 number of materials and every material as its name, supplier, quantity and date
+*/
+typedef enum RequestType
+{
+	REQUEST_ADD = 1,
+	REQUEST_UPDATE,
+	REQUEST_REMOVE,
+	REQUEST_LOOKUP,
+	REQUEST_QUERY
+} RequestType;
+
+typedef enum ResponseStatus
+{
+	RESPONSE_OK,
+	RESPONSE_INVALID,
+	RESPONSE_FAILED
+} ResponseStatus;
+
+/*
+	A growable buffer of bytes, written at its end.
+	failed - 1 once the memory for a write could not be allocated
+*/
+typedef struct ByteBuffer
+{
+	unsigned char* data;
+	int size, capacity;
+	int failed;
+} ByteBuffer;
+
+/*
+	Reads the fields of a frame; a read past its end sets failed and reads zeros.
+*/
+typedef struct ByteReader
+{
+	const unsigned char* data;
+	int size, position;
+	int failed;
+} ByteReader;
+
+void initByteBuffer(ByteBuffer* buffer);
+void freeByteBuffer(ByteBuffer* buffer);
+
+/*
+	Makes room for length more bytes.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int reserveBuffer(ByteBuffer* buffer, int length);
+
+/*
+	Append bytes or a field. If the memory could not be allocated, nothing is written and the buffer is marked as failed.
+	A string is cut to the first 65535 bytes.
+*/
+void putBytes(ByteBuffer* buffer, const void* bytes, int length);
+void putU8(ByteBuffer* buffer, uint8_t value);
+void putU16(ByteBuffer* buffer, uint16_t value);
+void putU32(ByteBuffer* buffer, uint32_t value);
+void putDouble(ByteBuffer* buffer, double value);
+void putStringField(ByteBuffer* buffer, const char* text);
+void putDateField(ByteBuffer* buffer, int day, int month, int year);
+
+void initByteReader(ByteReader* reader, const unsigned char* data, int size);
+uint8_t getU8(ByteReader* reader);
+uint16_t getU16(ByteReader* reader);
+uint32_t getU32(ByteReader* reader);
+double getDouble(ByteReader* reader);
+void getDateField(ByteReader* reader, int* day, int* month, int* year);
+
+/*
+	Copies a string field into text, as a null terminated string of at most capacity - 1 characters.
+	Returns 1 on success, or -1 if the string is longer or the frame ended.
+*/
+int getStringField(ByteReader* reader, char* text, int capacity);
+
+/*
+	Appends the name, supplier, quantity and date of a material.
+*/
+void putMaterial(ByteBuffer* buffer, Material* material);
+
+/*
+	Starts a frame: its length is written by endFrame, once all of its fields are added.
+	code - the type of a request, or the status of a response
+	Returns the position of the frame in the buffer.
+*/
+int beginFrame(ByteBuffer* buffer, uint32_t id, uint8_t code);
+void endFrame(ByteBuffer* buffer, int frame);
+
+/*
+	Checks whether the bytes start with a whole frame.
+	Returns the size of the frame, including its length, 0 if more bytes are needed, or -1 if the frame is larger
+	than MAX_FRAME_SIZE.
+*/
+int frameSize(const unsigned char* data, int size);
+
+/*
+	Runs a request frame, without its length, against the services and appends the response frame to the responses.
+	A frame with missing or extra fields, an invalid date or a quantity that is not finite is answered with
+	RESPONSE_INVALID.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int serveBinaryRequest(MaterialServices* materialServices, const unsigned char* frame, int length, ByteBuffer* responses);
+
+//Tests
+void testProtocol();
@@ -0,0 +1,577 @@
+#include "query.h"
+#include "planner.h"
+#include "radixSort.h"
+#include "topK.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+
+void initQuery(Query* query)
+{
+	if (query == NULL)
+		return;
+
+	// the whole structure is cleared so that two equal queries are also equal byte by byte
+	memset(query, 0, sizeof(Query));
+	query->columns = COLUMNS_ALL;
+	query->today = todayKey();
+}
+
+Filter* nextFilter(Query* query, FilterType type)
+{
+	if (query == NULL || query->filterCount == MAX_FILTERS)
+		return NULL;
+
+	Filter* filter = &query->filters[query->filterCount++];
+	filter->type = type;
+
+	return filter;
+}
+
+void copyFilterText(Filter* filter, const char* text)
+{
+	if (text == NULL)
+		text = "";
+
+	strncpy(filter->text, text, MAX_FILTER_SIZE - 1);
+}
+
+int addNameFilter(Query* query, const char* text)
+{
+	Filter* filter = nextFilter(query, FILTER_NAME_CONTAINS);
+	if (filter == NULL)
+		return -1;
+
+	copyFilterText(filter, text);
+	return 1;
+}
+
+int addSupplierFilter(Query* query, const char* supplier)
+{
+	Filter* filter = nextFilter(query, FILTER_SUPPLIER);
+	if (filter == NULL)
+		return -1;
+
+	copyFilterText(filter, supplier);
+	return 1;
+}
+
+int addQuantityFilter(Query* query, double quantity)
+{
+	Filter* filter = nextFilter(query, FILTER_LESS_THAN);
+	if (filter == NULL)
+		return -1;
+
+	filter->number = quantity;
+	return 1;
+}
+
+int addExpiredFilter(Query* query)
+{
+	Filter* filter = nextFilter(query, FILTER_EXPIRED);
+	if (filter == NULL)
+		return -1;
+
+	return 1;
+}
+
+/*
+	The materials that are not expired yet but expire in the next days: today is the first of them.
+*/
+int addExpiresWithinFilter(Query* query, int days)
+{
+	if (days < 0 || days > MAX_WITHIN_DAYS)
+		return -1;
+
+	Filter* filter = nextFilter(query, FILTER_EXPIRES_WITHIN);
+
+	if (filter == NULL)
+		return -1;
+
+	filter->number = days;
+	return 1;
+}
+
+int addCustomFilter(Query* query, int (*filterFunction)(Material*, char*), const char* text)
+{
+	if (filterFunction == NULL)
+		return -1;
+
+	// the filters with a known implementation are evaluated inline
+	if (filterFunction == &nameContains)
+		return addNameFilter(query, text);
+	if (filterFunction == &isLessThan)
+		return addQuantityFilter(query, strtod(text, NULL));
+
+	Filter* filter = nextFilter(query, FILTER_CUSTOM);
+	if (filter == NULL)
+		return -1;
+
+	filter->filterFunction = filterFunction;
+	copyFilterText(filter, text);
+	return 1;
+}
+
+int nextToken(const char** text, char* token, int size)
+{
+	const char* s = *text;
+	while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n')
+		s++;
+
+	if (*s == 0)
+		return 0;
+
+	int length = 0, quoted = 0;
+	while (*s != 0 && (quoted || (*s != ' ' && *s != '\t' && *s != '\r' && *s != '\n')))
+	{
+		if (*s == '"')
+			quoted = !quoted;
+		else if (length < size - 1)
+			token[length++] = *s;
+		s++;
+	}
+	token[length] = 0;
+
+	*text = s;
+	return 1;
+}
+
+int parseStage(Query* query, char* token)
+{
+	if (strcmp(token, "expired") == 0)
+		return addExpiredFilter(query);
+	if (strncmp(token, "name~", 5) == 0)
+		return addNameFilter(query, token + 5);
+	if (strncmp(token, "supplier=", 9) == 0)
+		return addSupplierFilter(query, token + 9);
+	if (strncmp(token, "quantity<", 9) == 0)
+	{
+		char* end;
+		double quantity = strtod(token + 9, &end);
+		if (end == token + 9 || *end != 0)
+			return -1;
+		return addQuantityFilter(query, quantity);
+	}
+	if (strncmp(token, "within=", 7) == 0)
+	{
+		char* end;
+		long days = strtol(token + 7, &end, 10);
+		if (end == token + 7 || *end != 0 || days < 0 || days > MAX_WITHIN_DAYS)
+			return -1;
+		return addExpiresWithinFilter(query, (int)days);
+	}
+	if (strncmp(token, "order=", 6) == 0)
+		return parseOrderBy(&query->orderBy, token + 6);
+	if (strncmp(token, "limit=", 6) == 0)
+	{
+		char* end;
+		long limit = strtol(token + 6, &end, 10);
+		if (end == token + 6 || *end != 0 || limit < 0 || limit > INT_MAX)
+			return -1;
+		query->limit = (int)limit;
+		return 1;
+	}
+	if (strncmp(token, "columns=", 8) == 0)
+	{
+		OrderBy columns;
+		if (parseOrderBy(&columns, token + 8) == -1)
+			return -1;
+
+		query->columns = 0;
+		for (int i = 0; i < columns.count; i++)
+			query->columns |= 1 << columns.keys[i].column;
+		return 1;
+	}
+
+	return -1;
+}
+
+int parseQuery(Query* query, const char* text)
+{
+	if (query == NULL || text == NULL)
+		return -1;
+
+	initQuery(query);
+
+	char token[2 * MAX_FILTER_SIZE];
+	while (nextToken(&text, token, sizeof(token)))
+		if (strcmp(token, "none") != 0 && parseStage(query, token) == -1)
+			return -1;
+
+	return 1;
+}
+
+int equalQueries(const Query* x, const Query* y)
+{
+	if (x->filterCount != y->filterCount || x->orderBy.count != y->orderBy.count)
+		return 0;
+
+	if (x->limit != y->limit || x->columns != y->columns || x->today != y->today)
+		return 0;
+
+	for (int i = 0; i < x->filterCount; i++)
+	{
+		const Filter* f = &x->filters[i];
+		const Filter* g = &y->filters[i];
+
+		if (f->type != g->type || f->number != g->number || f->filterFunction != g->filterFunction || strcmp(f->text, g->text) != 0)
+			return 0;
+	}
+
+	for (int i = 0; i < x->orderBy.count; i++)
+		if (x->orderBy.keys[i].column != y->orderBy.keys[i].column || x->orderBy.keys[i].descending != y->orderBy.keys[i].descending)
+			return 0;
+
+	return 1;
+}
+
+static inline int matchesFilter(const Query* query, const Filter* filter, Material* material)
+{
+	switch (filter->type)
+	{
+	case FILTER_NAME_CONTAINS:
+		return strstr(material->name, filter->text) != NULL;
+	case FILTER_SUPPLIER:
+		return strcmp(material->supplier, filter->text) == 0;
+	case FILTER_LESS_THAN:
+		return material->quantity < filter->number;
+	case FILTER_EXPIRED:
+		return dateKey(material->date) < query->today;
+	case FILTER_EXPIRES_WITHIN:
+	{
+		int days = dayNumber(material->date) - keyDayNumber(query->today);
+		return days >= 0 && days < filter->number;
+	}
+	case FILTER_CUSTOM:
+		return filter->filterFunction(material, (char*)filter->text) == 1;
+	}
+
+	return 0;
+}
+
+int matchesQuery(const Query* query, Material* material)
+{
+	for (int i = 0; i < query->filterCount; i++)
+		if (!matchesFilter(query, &query->filters[i], material))
+			return 0;
+
+	return 1;
+}
+
+int sortRows(DynamicArray* rows, const OrderBy* orderBy)
+{
+	// a single fixed width column is sorted with the radix sort, anything else with the composite keys
+	if (orderBy->count == 1 && len(rows) >= RADIX_THRESHOLD)
+	{
+		if (orderBy->keys[0].column == COLUMN_QUANTITY)
+			return radixSortByQuantity(rows, orderBy->keys[0].descending);
+		if (orderBy->keys[0].column == COLUMN_DATE)
+			return radixSortByDate(rows, orderBy->keys[0].descending);
+	}
+
+	return sortOrderBy(rows, orderBy);
+}
+
+int emitRows(DynamicArray* rows, const Query* query, RowSink sink, void* context, int* count, int limit)
+{
+	for (int i = 0; i < len(rows) && *count < limit; i++)
+	{
+		Material* material = getElement(rows, i);
+		if (!matchesQuery(query, material))
+			continue;
+
+		int status = sink(material, query->columns, context);
+		if (status == -1)
+			return -1;
+		(*count)++;
+		if (status == 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+	Collects and sorts every matching row of the sources.
+*/
+DynamicArray* collectRows(DynamicArray* sources, const Query* query)
+{
+	DynamicArray* rows = createDynamicArray(16, NULL);
+
+	for (int i = 0; i < len(sources) && rows != NULL; i++)
+	{
+		DynamicArray* source = getElement(sources, i);
+
+		for (int j = 0; j < len(source); j++)
+		{
+			Material* material = getElement(source, j);
+			if (matchesQuery(query, material) && apd(rows, material) == -1)
+			{
+				destroyDynamicArray(rows);
+				return NULL;
+			}
+		}
+	}
+
+	if (rows != NULL && sortRows(rows, &query->orderBy) == -1)
+	{
+		destroyDynamicArray(rows);
+		return NULL;
+	}
+
+	return rows;
+}
+
+/*
+	Selects the first query->limit matching rows of the sources with a bounded heap, without sorting the others.
+*/
+DynamicArray* selectRows(DynamicArray* sources, const Query* query)
+{
+	TopK topK;
+	int candidates = 0;
+
+	for (int i = 0; i < len(sources); i++)
+		candidates += len((DynamicArray*)getElement(sources, i));
+
+	// the heap never holds more rows than the sources have, whatever the limit
+	int k = query->limit < candidates ? query->limit : candidates;
+
+	if (initTopK(&topK, k > 0 ? k : 1, &query->orderBy) == -1)
+		return NULL;
+
+	for (int i = 0; i < len(sources); i++)
+	{
+		DynamicArray* source = getElement(sources, i);
+
+		for (int j = 0; j < len(source); j++)
+		{
+			Material* material = getElement(source, j);
+			if (matchesQuery(query, material) && offerTopK(&topK, material) == -1)
+			{
+				freeTopK(&topK);
+				return NULL;
+			}
+		}
+	}
+
+	DynamicArray* rows = createDynamicArray(topK.size + 1, NULL);
+
+	if (rows != NULL && drainTopK(&topK, rows) == -1)
+	{
+		destroyDynamicArray(rows);
+		rows = NULL;
+	}
+
+	freeTopK(&topK);
+	return rows;
+}
+
+int runQuery(MaterialRepo* materialRepo, const Query* query, RowSink sink, void* context)
+{
+	if (materialRepo == NULL || query == NULL || sink == NULL)
+		return -1;
+
+	QueryPlan plan;
+	DynamicArray* sources = createDynamicArray(2, NULL);
+
+	if (sources == NULL)
+		return -1;
+
+	if (planQuery(materialRepo, query, &plan) == -1 || getPlanSources(materialRepo, query, &plan, sources) == -1)
+	{
+		destroyDynamicArray(sources);
+		return -1;
+	}
+
+	int limit = query->limit > 0 ? query->limit : getSize(materialRepo);
+	int count = 0, status = 1;
+
+	if (query->orderBy.count == 0)
+	{
+		for (int i = 0; i < len(sources) && status == 1; i++)
+			status = emitRows(getElement(sources, i), query, sink, context, &count, limit);
+
+		destroyDynamicArray(sources);
+		return status == -1 ? -1 : count;
+	}
+
+	DynamicArray* rows = query->limit > 0 ? selectRows(sources, query) : collectRows(sources, query);
+	destroyDynamicArray(sources);
+
+	if (rows == NULL)
+		return -1;
+
+	// the rows were already filtered, so they are emitted without checking the filters again
+	for (int i = 0; i < len(rows) && count < limit && status == 1; i++)
+	{
+		status = sink(getElement(rows, i), query->columns, context);
+		if (status != -1)
+			count++;
+	}
+
+	destroyDynamicArray(rows);
+	return status == -1 ? -1 : count;
+}
+
+int collectSink(Material* material, int columns, DynamicArray* dArray)
+{
+	(void)columns;
+	Material* materialCopy = copyMaterial(material);
+
+	if (materialCopy == NULL || apd(dArray, materialCopy) == -1)
+	{
+		destroyMaterial(materialCopy);
+		return -1;
+	}
+
+	return 1;
+}
+
+DynamicArray* collectQuery(MaterialRepo* materialRepo, const Query* query)
+{
+	DynamicArray* dArray = createDynamicArray(2, &destroyMaterial);
+
+	if (dArray == NULL)
+		return NULL;
+
+	if (runQuery(materialRepo, query, &collectSink, dArray) == -1)
+	{
+		destroyDynamicArray(dArray);
+		return NULL;
+	}
+
+	return dArray;
+}
+
+int viewSink(Material* material, int columns, DynamicArray* dArray)
+{
+	(void)columns;
+	return apd(dArray, material);
+}
+
+DynamicArray* collectQueryView(MaterialRepo* materialRepo, const Query* query)
+{
+	DynamicArray* dArray = createDynamicArray(2, NULL);
+
+	if (dArray == NULL)
+		return NULL;
+
+	if (runQuery(materialRepo, query, &viewSink, dArray) == -1)
+	{
+		destroyDynamicArray(dArray);
+		return NULL;
+	}
+
+	return dArray;
+}
+
+
+//Tests
+
+
+MaterialRepo* createTestQueryRepo()
+{
+	MaterialRepo* materialRepo = createMaterialRepo(2);
+
+	addMaterial(materialRepo, createMaterial("Wheat flour", "WindMill", 10.5, createDate(24, 5, 2000)));
+	addMaterial(materialRepo, createMaterial("Sugar", "HomeGoods", 20, createDate(20, 6, 3000)));
+	addMaterial(materialRepo, createMaterial("Cake flour", "HomeGoods", 15.3, createDate(10, 5, 2001)));
+	addMaterial(materialRepo, createMaterial("Salt", "HomeGoods", 1.5, createDate(30, 10, 2002)));
+	addMaterial(materialRepo, createMaterial("Rye flour", "WindMill", 5, createDate(30, 10, 3000)));
+
+	return materialRepo;
+}
+
+int countSink(Material* material, int columns, int* count)
+{
+	(void)material;
+	(void)columns;
+	(*count)++;
+	return 1;
+}
+
+void testParseQuery()
+{
+	Query query;
+
+	assert(parseQuery(&query, "expired supplier=HomeGoods name~\"Cake flour\" quantity<10 order=-date limit=3 columns=name,date") == 1);
+	assert(query.filterCount == 4);
+	assert(query.filters[0].type == FILTER_EXPIRED);
+	assert(query.filters[1].type == FILTER_SUPPLIER && strcmp(query.filters[1].text, "HomeGoods") == 0);
+	assert(query.filters[2].type == FILTER_NAME_CONTAINS && strcmp(query.filters[2].text, "Cake flour") == 0);
+	assert(query.filters[3].type == FILTER_LESS_THAN && query.filters[3].number == 10);
+	assert(query.orderBy.count == 1 && query.orderBy.keys[0].descending == 1);
+	assert(query.limit == 3);
+	assert(query.columns == ((1 << COLUMN_NAME) | (1 << COLUMN_DATE)));
+
+	assert(parseQuery(&query, "none") == 1);
+	assert(query.filterCount == 0);
+
+	assert(parseQuery(&query, "colour=red") == -1);
+	assert(parseQuery(&query, "quantity<abc") == -1);
+	assert(parseQuery(&query, "limit=-2") == -1);
+	assert(parseQuery(&query, "limit=4294967297") == -1);
+	assert(parseQuery(&query, "within=4294967297") == -1 && addExpiresWithinFilter(&query, MAX_WITHIN_DAYS + 1) == -1);
+}
+
+void testRunQuery()
+{
+	MaterialRepo* materialRepo = createTestQueryRepo();
+	Query query;
+	int count = 0;
+
+	initQuery(&query);
+	assert(runQuery(NULL, &query, &countSink, &count) == -1);
+	assert(runQuery(materialRepo, &query, &countSink, &count) == 5);
+	assert(count == 5);
+
+	addExpiredFilter(&query);
+	addNameFilter(&query, "flour");
+	DynamicArray* dArray1 = collectQuery(materialRepo, &query);
+
+	assert(len(dArray1) == 2);
+	assert(strcmp(getName(getElement(dArray1, 0)), "Wheat flour") == 0);
+	assert(strcmp(getName(getElement(dArray1, 1)), "Cake flour") == 0);
+
+	parseQuery(&query, "supplier=HomeGoods quantity<16 order=quantity");
+	DynamicArray* dArray2 = collectQuery(materialRepo, &query);
+
+	assert(len(dArray2) == 2);
+	assert(getQuantity(getElement(dArray2, 0)) == 1.5);
+	assert(getQuantity(getElement(dArray2, 1)) == 15.3);
+
+	parseQuery(&query, "order=-quantity limit=2");
+	DynamicArray* dArray3 = collectQuery(materialRepo, &query);
+
+	assert(len(dArray3) == 2);
+	assert(getQuantity(getElement(dArray3, 0)) == 20);
+	assert(getQuantity(getElement(dArray3, 1)) == 15.3);
+
+	// a limit far above the number of rows only sizes the heap to the rows
+	parseQuery(&query, "order=-quantity limit=2000000000");
+	DynamicArray* dArray5 = collectQuery(materialRepo, &query);
+	assert(dArray5 != NULL && len(dArray5) == getSize(materialRepo) && getQuantity(getElement(dArray5, 0)) == 20);
+	destroyDynamicArray(dArray5);
+
+	initQuery(&query);
+	addCustomFilter(&query, &isLessThan, "6");
+	assert(query.filters[0].type == FILTER_LESS_THAN);
+	DynamicArray* dArray4 = collectQuery(materialRepo, &query);
+
+	assert(len(dArray4) == 2);
+
+	destroyDynamicArray(dArray1);
+	destroyDynamicArray(dArray2);
+	destroyDynamicArray(dArray3);
+	destroyDynamicArray(dArray4);
+	destroyMaterialRepo(materialRepo);
+}
+
+void testQuery()
+{
+	testParseQuery();
+	testRunQuery();
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "repository.h"
+#include "orderBy.h"
+
+#define MAX_FILTERS 8
+#define MAX_FILTER_SIZE 64
+// the longest window of an expires within filter, so that the day it ends on cannot overflow an int
+#define MAX_WITHIN_DAYS 100000000
+
+#define COLUMNS_ALL ((1 << COLUMN_NAME) | (1 << COLUMN_SUPPLIER) | (1 << COLUMN_QUANTITY) | (1 << COLUMN_DATE))
+
+typedef enum FilterType
+{
+	FILTER_NAME_CONTAINS,
+	FILTER_SUPPLIER,
+	FILTER_LESS_THAN,
+	FILTER_EXPIRED,
+	FILTER_EXPIRES_WITHIN,
+	FILTER_CUSTOM
+} FilterType;
+
+typedef struct Filter
+{
+	FilterType type;
+	double number;
+	char text[MAX_FILTER_SIZE];
+	int (*filterFunction)(Material*, char*);
+} Filter;
+
+/*
+	A query is a pipeline of stages applied to the materials of a repository: every filter must match,
+	then the rows are ordered (in the order of the access path if orderBy.count is 0, see QueryPlan), cut to limit
+	rows (0 for no limit)
+	and only the columns from the columns mask are output.
+*/
+typedef struct Query
+{
+	int filterCount;
+	Filter filters[MAX_FILTERS];
+	OrderBy orderBy;
+	int limit;
+	int columns;
+	int today;
+} Query;
+
+/*
+	Receives the rows of a query, one at a time.
+	Returns 1 to receive the next row, 0 to stop the query, or -1 to stop it with an error.
+*/
+typedef int (*RowSink)(Material* material, int columns, void* context);
+
+/*
+	Initializes an empty query: no filters, repository order, no limit, all the columns, and today as the reference date.
+*/
+void initQuery(Query* query);
+
+/*
+	Add filter stages to the query.
+	Returns 1 on success, or -1 if the query already has MAX_FILTERS filters or the days of an expires within
+	filter are not between 0 and MAX_WITHIN_DAYS.
+*/
+int addNameFilter(Query* query, const char* text);
+int addSupplierFilter(Query* query, const char* supplier);
+int addQuantityFilter(Query* query, double quantity);
+int addExpiredFilter(Query* query);
+int addExpiresWithinFilter(Query* query, int days);
+int addCustomFilter(Query* query, int (*filterFunction)(Material*, char*), const char* text);
+
+/*
+	Parses a query written as space separated stages, e.g.
+	expired within=<days> supplier=HomeGoods name~"Wheat flour" quantity<10 order=supplier,-date limit=20 columns=name,quantity
+	Returns 1 on success, or -1 if a stage is not valid.
+*/
+int parseQuery(Query* query, const char* text);
+
+/*
+	Checks if two queries have the same stages and reference date.
+	Returns 1 if they do, 0 otherwise.
+*/
+int equalQueries(const Query* x, const Query* y);
+
+/*
+	Checks if a material passes every filter of the query.
+	Returns 1 if it does, 0 otherwise.
+*/
+int matchesQuery(const Query* query, Material* material);
+
+/*
+	Streams the rows of the query to the sink. The candidate rows come from the access path chosen by planQuery.
+	Without an order, the rows are passed straight from the access path, in its order;
+	with an order, only pointers to the matching rows are collected and sorted, or, if there is a limit,
+	the first rows are selected with a bounded heap.
+	Returns the number of rows passed to the sink, or -1 if an error occured.
+*/
+int runQuery(MaterialRepo* materialRepo, const Query* query, RowSink sink, void* context);
+
+/*
+	Runs the query and returns copies of the resulting rows in a new dynamic array, or NULL if an error occured.
+*/
+DynamicArray* collectQuery(MaterialRepo* materialRepo, const Query* query);
+
+/*
+	Runs the query and returns pointers to the resulting rows in a new dynamic array that does not own them,
+	or NULL if an error occured. The pointers are valid as long as the repository is not modified.
+*/
+DynamicArray* collectQueryView(MaterialRepo* materialRepo, const Query* query);
+
+//Tests
+void testQuery();
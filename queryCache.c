@@ -0,0 +1,155 @@
+#include "queryCache.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+
+void initQueryCache(QueryCache* queryCache)
+{
+	if (queryCache == NULL)
+		return;
+
+	queryCache->clock = 0;
+	queryCache->hits = 0;
+	queryCache->misses = 0;
+
+	for (int i = 0; i < QUERY_CACHE_SIZE; i++)
+	{
+		queryCache->entries[i].used = 0;
+		queryCache->entries[i].rows = NULL;
+	}
+}
+
+void clearQueryCache(QueryCache* queryCache)
+{
+	if (queryCache == NULL)
+		return;
+
+	for (int i = 0; i < QUERY_CACHE_SIZE; i++)
+	{
+		destroyDynamicArray(queryCache->entries[i].rows);
+		queryCache->entries[i].rows = NULL;
+		queryCache->entries[i].used = 0;
+	}
+}
+
+DynamicArray* lookupQueryCache(QueryCache* queryCache, const Query* query, long long version)
+{
+	if (queryCache == NULL || query == NULL)
+		return NULL;
+
+	for (int i = 0; i < QUERY_CACHE_SIZE; i++)
+	{
+		CacheEntry* entry = &queryCache->entries[i];
+
+		if (entry->used && entry->version == version && equalQueries(&entry->query, query))
+		{
+			entry->lastUse = ++queryCache->clock;
+			queryCache->hits++;
+			return entry->rows;
+		}
+	}
+
+	queryCache->misses++;
+	return NULL;
+}
+
+int storeQueryCache(QueryCache* queryCache, const Query* query, long long version, DynamicArray* rows)
+{
+	if (queryCache == NULL || query == NULL || rows == NULL)
+		return -1;
+
+	// results of older versions can never be served again, so they are replaced first
+	CacheEntry* victim = &queryCache->entries[0];
+	for (int i = 0; i < QUERY_CACHE_SIZE; i++)
+	{
+		CacheEntry* entry = &queryCache->entries[i];
+
+		if (!entry->used || entry->version != version)
+		{
+			victim = entry;
+			break;
+		}
+		if (entry->lastUse < victim->lastUse)
+			victim = entry;
+	}
+
+	destroyDynamicArray(victim->rows);
+	victim->used = 1;
+	victim->version = version;
+	victim->lastUse = ++queryCache->clock;
+	victim->query = *query;
+	victim->rows = rows;
+
+	return 1;
+}
+
+
+//Tests
+
+
+void testQueryCacheLookup()
+{
+	QueryCache queryCache;
+	Query query1, query2;
+
+	initQueryCache(&queryCache);
+	parseQuery(&query1, "expired limit=3");
+	parseQuery(&query2, "expired limit=4");
+
+	assert(lookupQueryCache(&queryCache, &query1, 1) == NULL);
+	assert(queryCache.misses == 1);
+
+	DynamicArray* rows = createDynamicArray(2, NULL);
+	assert(storeQueryCache(&queryCache, &query1, 1, rows) == 1);
+
+	assert(lookupQueryCache(&queryCache, &query1, 1) == rows);
+	assert(lookupQueryCache(&queryCache, &query2, 1) == NULL);
+	assert(lookupQueryCache(&queryCache, &query1, 2) == NULL);
+	assert(queryCache.hits == 1);
+	assert(queryCache.misses == 3);
+
+	query2 = query1;
+	query2.today++;
+	assert(lookupQueryCache(&queryCache, &query2, 1) == NULL);
+
+	clearQueryCache(&queryCache);
+	assert(lookupQueryCache(&queryCache, &query1, 1) == NULL);
+}
+
+void testQueryCacheEviction()
+{
+	QueryCache queryCache;
+	Query queries[QUERY_CACHE_SIZE + 1];
+
+	initQueryCache(&queryCache);
+
+	for (int i = 0; i <= QUERY_CACHE_SIZE; i++)
+	{
+		initQuery(&queries[i]);
+		queries[i].limit = i + 1;
+	}
+
+	for (int i = 0; i < QUERY_CACHE_SIZE; i++)
+		storeQueryCache(&queryCache, &queries[i], 1, createDynamicArray(2, NULL));
+
+	assert(lookupQueryCache(&queryCache, &queries[0], 1) != NULL);
+	storeQueryCache(&queryCache, &queries[QUERY_CACHE_SIZE], 1, createDynamicArray(2, NULL));
+
+	assert(lookupQueryCache(&queryCache, &queries[0], 1) != NULL);
+	assert(lookupQueryCache(&queryCache, &queries[1], 1) == NULL);
+	assert(lookupQueryCache(&queryCache, &queries[QUERY_CACHE_SIZE], 1) != NULL);
+
+	storeQueryCache(&queryCache, &queries[1], 2, createDynamicArray(2, NULL));
+	storeQueryCache(&queryCache, &queries[2], 2, createDynamicArray(2, NULL));
+	assert(lookupQueryCache(&queryCache, &queries[1], 2) != NULL);
+	assert(lookupQueryCache(&queryCache, &queries[2], 2) != NULL);
+
+	clearQueryCache(&queryCache);
+}
+
+void testQueryCache()
+{
+	testQueryCacheLookup();
+	testQueryCacheEviction();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "query.h"
+
+#define QUERY_CACHE_SIZE 8
+
+typedef struct CacheEntry
+{
+	int used;
+	long long version;
+	unsigned long long lastUse;
+	Query query;
+	DynamicArray* rows;
+} CacheEntry;
+
+/*
+	Remembers the results of the most recent queries. A result is keyed by the query, including its parameters
+	and reference date, and by the version of the repository it was computed on. The rows are pointers into the
+	repository, so a result is only valid while the repository keeps that version.
+*/
+typedef struct QueryCache
+{
+	unsigned long long clock;
+	int hits, misses;
+	CacheEntry entries[QUERY_CACHE_SIZE];
+} QueryCache;
+
+void initQueryCache(QueryCache* queryCache);
+
+/*
+	Drops every cached result.
+*/
+void clearQueryCache(QueryCache* queryCache);
+
+/*
+	Looks for the result of the query on the given version of the repository and counts a hit or a miss.
+	Returns the cached rows, owned by the cache, or NULL if there is no such result.
+*/
+DynamicArray* lookupQueryCache(QueryCache* queryCache, const Query* query, long long version);
+
+/*
+	Stores the rows of a query, replacing a result of an older version or the least recently used one.
+	The cache takes the ownership of the rows.
+	Returns 1 on success, or -1 if the arguments are not valid.
+*/
+int storeQueryCache(QueryCache* queryCache, const Query* query, long long version, DynamicArray* rows);
+
+//Tests
+void testQueryCache();
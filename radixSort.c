@@ -0,0 +1,201 @@
+#include "radixSort.h"
+#include "material.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+uint64_t quantityKey(double quantity)
+{
+	uint64_t bits;
+	memcpy(&bits, &quantity, sizeof(bits));
+
+	// negative numbers have all their bits flipped, positive ones only the sign bit
+	if (bits >> 63)
+		return ~bits;
+	return bits | ((uint64_t)1 << 63);
+}
+
+int radixSortPairs(KeyIndex* pairs, int size)
+{
+	if (pairs == NULL || size < 0)
+		return -1;
+
+	if (size < 2)
+		return 1;
+
+	KeyIndex* buffer = (KeyIndex*)malloc(sizeof(KeyIndex) * size);
+
+	if (buffer == NULL)
+		return -1;
+
+	// the histograms of all the bytes are built in a single pass
+	int counts[8][256] = { 0 };
+	for (int i = 0; i < size; i++)
+	{
+		uint64_t key = pairs[i].key;
+		for (int b = 0; b < 8; b++)
+			counts[b][(key >> (8 * b)) & 0xFF]++;
+	}
+
+	KeyIndex* source = pairs;
+	KeyIndex* destination = buffer;
+
+	for (int b = 0; b < 8; b++)
+	{
+		if (counts[b][(pairs[0].key >> (8 * b)) & 0xFF] == size)
+			continue;
+
+		int offsets[256];
+		int offset = 0;
+		for (int d = 0; d < 256; d++)
+		{
+			offsets[d] = offset;
+			offset += counts[b][d];
+		}
+
+		for (int i = 0; i < size; i++)
+			destination[offsets[(source[i].key >> (8 * b)) & 0xFF]++] = source[i];
+
+		KeyIndex* aux = source;
+		source = destination;
+		destination = aux;
+	}
+
+	if (source != pairs)
+		memcpy(pairs, source, sizeof(KeyIndex) * size);
+
+	free(buffer);
+	return 1;
+}
+
+int radixSortByKey(DynamicArray* dArray, uint64_t (*keyFunction)(Material*), int descending)
+{
+	if (dArray == NULL)
+		return -1;
+
+	int size = len(dArray);
+	if (size < 2)
+		return 1;
+
+	KeyIndex* pairs = (KeyIndex*)malloc(sizeof(KeyIndex) * size);
+	void** data = (void**)malloc(sizeof(void*) * size);
+
+	if (pairs == NULL || data == NULL)
+	{
+		free(pairs);
+		free(data);
+		return -1;
+	}
+
+	for (int i = 0; i < size; i++)
+	{
+		uint64_t key = keyFunction(getElement(dArray, i));
+		pairs[i].key = descending ? ~key : key;
+		pairs[i].index = (uint32_t)i;
+	}
+
+	int status = radixSortPairs(pairs, size);
+
+	if (status == 1)
+	{
+		for (int i = 0; i < size; i++)
+			data[i] = dArray->data[pairs[i].index];
+		memcpy(dArray->data, data, sizeof(void*) * size);
+	}
+
+	free(pairs);
+	free(data);
+	return status;
+}
+
+uint64_t materialQuantityKey(Material* material)
+{
+	return quantityKey(getQuantity(material));
+}
+
+uint64_t materialDateKey(Material* material)
+{
+	return (uint64_t)dateKey(getDate(material));
+}
+
+int radixSortByQuantity(DynamicArray* dArray, int descending)
+{
+	return radixSortByKey(dArray, &materialQuantityKey, descending);
+}
+
+int radixSortByDate(DynamicArray* dArray, int descending)
+{
+	return radixSortByKey(dArray, &materialDateKey, descending);
+}
+
+
+//Tests
+
+
+void testQuantityKey()
+{
+	double values[] = { -1000.5, -2, -0.25, 0, 0.25, 1, 12.34, 12.35, 1e9 };
+
+	for (int i = 0; i < 8; i++)
+		assert(quantityKey(values[i]) < quantityKey(values[i + 1]));
+}
+
+void testRadixSortPairs()
+{
+	KeyIndex pairs[1000];
+
+	assert(radixSortPairs(NULL, 1) == -1);
+
+	srand(3);
+	for (int i = 0; i < 1000; i++)
+	{
+		pairs[i].key = ((uint64_t)rand() << 32) ^ (uint64_t)(rand() % 16);
+		pairs[i].index = (uint32_t)i;
+	}
+
+	assert(radixSortPairs(pairs, 1000) == 1);
+
+	for (int i = 1; i < 1000; i++)
+	{
+		assert(pairs[i - 1].key <= pairs[i].key);
+		if (pairs[i - 1].key == pairs[i].key)
+			assert(pairs[i - 1].index < pairs[i].index);
+	}
+}
+
+void testRadixSortMaterials()
+{
+	DynamicArray* testArray = createDynamicArray(2, &destroyMaterial);
+
+	apd(testArray, createMaterial("a", "a", 3, createDate(1, 1, 2023)));
+	apd(testArray, createMaterial("b", "b", -1, createDate(5, 3, 2022)));
+	apd(testArray, createMaterial("c", "c", 2.5, createDate(1, 3, 2022)));
+	apd(testArray, createMaterial("d", "d", 10, createDate(31, 12, 2021)));
+
+	assert(radixSortByQuantity(testArray, 0) == 1);
+	assert(getQuantity(getElement(testArray, 0)) == -1);
+	assert(getQuantity(getElement(testArray, 1)) == 2.5);
+	assert(getQuantity(getElement(testArray, 2)) == 3);
+	assert(getQuantity(getElement(testArray, 3)) == 10);
+
+	assert(radixSortByQuantity(testArray, 1) == 1);
+	assert(getQuantity(getElement(testArray, 0)) == 10);
+	assert(getQuantity(getElement(testArray, 3)) == -1);
+
+	assert(radixSortByDate(testArray, 0) == 1);
+	assert(strcmp(getName(getElement(testArray, 0)), "d") == 0);
+	assert(strcmp(getName(getElement(testArray, 1)), "c") == 0);
+	assert(strcmp(getName(getElement(testArray, 2)), "b") == 0);
+	assert(strcmp(getName(getElement(testArray, 3)), "a") == 0);
+
+	destroyDynamicArray(testArray);
+}
+
+void testRadixSort()
+{
+	testQuantityKey();
+	testRadixSortPairs();
+	testRadixSortMaterials();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "dynamicArray.h"
+
+#include <stdint.h>
+
+// below this many elements the generic sort is cheaper than the radix passes
+#define RADIX_THRESHOLD 64
+
+typedef struct KeyIndex
+{
+	uint64_t key;
+	uint32_t index;
+} KeyIndex;
+
+/*
+	Maps a double to an unsigned key that has the same order as the double.
+*/
+uint64_t quantityKey(double quantity);
+
+/*
+	Sorts the pairs ascending by key with an LSD radix sort on bytes. The sort is stable and the
+	passes over bytes that are equal for every key are skipped.
+	Returns 1 on success, or -1 if the arguments are not valid or the memory could not be allocated.
+*/
+int radixSortPairs(KeyIndex* pairs, int size);
+
+/*
+	Sorts a dynamic array of materials by quantity, or by expiration date, using radixSortPairs.
+	descending - 0 for ascending order, 1 for descending order
+	Returns 1 on success, or -1 otherwise.
+*/
+int radixSortByQuantity(DynamicArray* dArray, int descending);
+int radixSortByDate(DynamicArray* dArray, int descending);
+
+//Tests
+void testRadixSort();
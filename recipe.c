@@ -0,0 +1,167 @@
+#include "recipe.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+void initRecipe(Recipe* recipe)
+{
+	if (recipe == NULL)
+		return;
+
+	recipe->size = 0;
+}
+
+int addIngredient(Recipe* recipe, const char* name, double quantity)
+{
+	if (recipe == NULL || name == NULL || name[0] == 0 || quantity <= 0)
+		return -1;
+
+	if ((int)strlen(name) > MAX_INGREDIENT_SIZE - 1)
+		return -1;
+
+	for (int i = 0; i < recipe->size; i++)
+		if (strcmp(recipe->ingredients[i].name, name) == 0)
+		{
+			recipe->ingredients[i].quantity += quantity;
+			return 1;
+		}
+
+	if (recipe->size == MAX_INGREDIENTS)
+		return -1;
+
+	strcpy(recipe->ingredients[recipe->size].name, name);
+	recipe->ingredients[recipe->size].quantity = quantity;
+	recipe->size++;
+
+	return 1;
+}
+
+int parseIngredient(Recipe* recipe, const char* text, int length)
+{
+	char pair[2 * MAX_INGREDIENT_SIZE];
+
+	// surrounding spaces are not part of the name
+	while (length > 0 && (*text == ' ' || *text == '\t'))
+	{
+		text++;
+		length--;
+	}
+	while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t' || text[length - 1] == '\r'))
+		length--;
+
+	if (length == 0 || length > (int)sizeof(pair) - 1)
+		return -1;
+
+	memcpy(pair, text, length);
+	pair[length] = 0;
+
+	// the quantity follows the last '=', so the name may contain one
+	char* separator = strrchr(pair, '=');
+	if (separator == NULL)
+		return -1;
+
+	char* end;
+	double quantity = strtod(separator + 1, &end);
+	if (end == separator + 1 || *end != 0)
+		return -1;
+
+	while (separator > pair && (separator[-1] == ' ' || separator[-1] == '\t'))
+		separator--;
+	*separator = 0;
+
+	// a name may be written between quotes
+	char* name = pair;
+	if (name[0] == '"' && separator - name >= 2 && separator[-1] == '"')
+	{
+		name++;
+		separator[-1] = 0;
+	}
+
+	return addIngredient(recipe, name, quantity);
+}
+
+int parseRecipe(Recipe* recipe, const char* text)
+{
+	if (recipe == NULL || text == NULL)
+		return -1;
+
+	initRecipe(recipe);
+
+	while (*text != 0)
+	{
+		int length = (int)strcspn(text, ",");
+
+		if (parseIngredient(recipe, text, length) == -1)
+			return -1;
+
+		text += length;
+		if (*text == ',')
+			text++;
+	}
+
+	if (recipe->size == 0)
+		return -1;
+
+	return 1;
+}
+
+
+//Tests
+
+
+void testAddIngredient()
+{
+	Recipe recipe;
+	initRecipe(&recipe);
+
+	assert(addIngredient(&recipe, "flour", 0.5) == 1);
+	assert(addIngredient(&recipe, "eggs", 2) == 1);
+	assert(addIngredient(&recipe, "flour", 0.25) == 1);
+	assert(recipe.size == 2);
+	assert(recipe.ingredients[0].quantity == 0.75);
+
+	assert(addIngredient(&recipe, "salt", 0) == -1);
+	assert(addIngredient(&recipe, "", 1) == -1);
+	assert(addIngredient(NULL, "salt", 1) == -1);
+
+	char name[] = "a";
+	for (int i = recipe.size; i < MAX_INGREDIENTS; i++)
+	{
+		name[0] = (char)('a' + i);
+		assert(addIngredient(&recipe, name, 1) == 1);
+	}
+	assert(addIngredient(&recipe, "salt", 1) == -1);
+	assert(addIngredient(&recipe, "flour", 1) == 1);
+}
+
+void testParseRecipe()
+{
+	Recipe recipe;
+
+	assert(parseRecipe(&recipe, "Wheat flour=0.5, Eggs = 2,Salt=0.01") == 1);
+	assert(recipe.size == 3);
+	assert(strcmp(recipe.ingredients[0].name, "Wheat flour") == 0 && recipe.ingredients[0].quantity == 0.5);
+	assert(strcmp(recipe.ingredients[1].name, "Eggs") == 0 && recipe.ingredients[1].quantity == 2);
+	assert(strcmp(recipe.ingredients[2].name, "Salt") == 0 && recipe.ingredients[2].quantity == 0.01);
+
+	assert(parseRecipe(&recipe, "\"Wheat flour\"=1") == 1);
+	assert(strcmp(recipe.ingredients[0].name, "Wheat flour") == 0);
+
+	assert(parseRecipe(&recipe, "a=1, a=2") == 1);
+	assert(recipe.size == 1 && recipe.ingredients[0].quantity == 3);
+
+	assert(parseRecipe(&recipe, "") == -1);
+	assert(parseRecipe(&recipe, "flour") == -1);
+	assert(parseRecipe(&recipe, "flour=x") == -1);
+	assert(parseRecipe(&recipe, "flour=1,,eggs=2") == -1);
+	assert(parseRecipe(&recipe, "=1") == -1);
+	assert(parseRecipe(&recipe, "flour=-1") == -1);
+}
+
+void testRecipe()
+{
+	testAddIngredient();
+	testParseRecipe();
+}
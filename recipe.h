@@ -0,0 +1,41 @@
+#pragma once
+
+#define MAX_INGREDIENTS 16
+#define MAX_INGREDIENT_SIZE 64
+
+typedef struct Ingredient
+{
+	char name[MAX_INGREDIENT_SIZE];
+	double quantity;
+} Ingredient;
+
+/*
+	The ingredients needed to produce one unit of a product, each with its quantity per unit.
+	An ingredient appears only once, so the quantity needed for a production run is known without adding anything up.
+*/
+typedef struct Recipe
+{
+	int size;
+	Ingredient ingredients[MAX_INGREDIENTS];
+} Recipe;
+
+/*
+	Initializes a recipe with no ingredients.
+*/
+void initRecipe(Recipe* recipe);
+
+/*
+	Adds a quantity per unit of an ingredient, on top of the quantity already in the recipe for the same name.
+	Returns 1 on success, or -1 if the arguments are not valid or the recipe already has MAX_INGREDIENTS ingredients.
+*/
+int addIngredient(Recipe* recipe, const char* name, double quantity);
+
+/*
+	Parses the ingredients of a recipe written as comma separated name=quantity pairs, e.g.
+	Wheat flour=0.5, Eggs=2, Salt=0.01
+	Returns 1 on success, or -1 if a pair is not valid or there are no ingredients.
+*/
+int parseRecipe(Recipe* recipe, const char* text);
+
+//Tests
+void testRecipe();
@@ -0,0 +1,432 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "replica.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <unistd.h>
+#include <threads.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+int initReplica(Replica* replica, MaterialServices* materialServices, const char* path)
+{
+	if (replica == NULL || materialServices == NULL || path == NULL || strlen(path) >= SERVER_PATH_SIZE)
+		return -1;
+
+	strcpy(replica->path, path);
+	replica->materialServices = materialServices;
+	replica->socket = -1;
+	initByteBuffer(&replica->input);
+	replica->scanned = 0;
+	replica->journal = 0;
+	replica->applied = 0;
+	replica->leaderSeq = 0;
+	replica->groups = 0;
+	replica->snapshots = 0;
+	replica->connects = 0;
+	replica->lag = 0;
+	replica->maxLag = 0;
+	replica->stale = 0;
+
+	materialServices->readOnly = 1;
+
+	return 1;
+}
+
+int connectReplica(Replica* replica)
+{
+	struct sockaddr_un address;
+	ByteBuffer hello;
+
+	if (replica == NULL)
+		return -1;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, replica->path);
+
+	replica->socket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (replica->socket == -1)
+		return -1;
+
+	initByteBuffer(&hello);
+	putU8(&hello, JOURNAL_MAGIC);
+	int frame = beginFrame(&hello, replica->applied, JOURNAL_HELLO);
+	putU32(&hello, replica->journal);
+	endFrame(&hello, frame);
+
+	// the hello fits in the buffer of a new socket, so it is sent whole
+	int status = hello.failed || connect(replica->socket, (struct sockaddr*)&address, sizeof(address)) == -1 ||
+		send(replica->socket, hello.data, hello.size, MSG_NOSIGNAL) != hello.size ? -1 : 1;
+
+	freeByteBuffer(&hello);
+	if (status == -1)
+	{
+		disconnectReplica(replica);
+		return -1;
+	}
+
+	replica->input.size = 0;
+	replica->scanned = 0;
+	replica->connects++;
+
+	return 1;
+}
+
+/*
+	Applies the records of a group, from its first record to its commit. A group that fails leaves the replica stale,
+	a snapshot applied whole makes it current again.
+	Returns 1 on success, or -1 if a record could not be applied.
+*/
+int applyGroup(Replica* replica, int start, int end)
+{
+	const unsigned char* data = replica->input.data;
+	int snapshot = data[start + 8] == JOURNAL_SNAPSHOT;
+	int size;
+
+	for (int position = start; position < end; position += size)
+	{
+		size = frameSize(data + position, end - position);
+		if (applyJournalRecord(replica->materialServices, data + position + 4, size - 4) == -1)
+		{
+			replica->materialServices->version++;
+			replica->stale = 1;
+			return -1;
+		}
+	}
+
+	if (snapshot)
+	{
+		replica->snapshots++;
+		replica->stale = 0;
+	}
+	replica->materialServices->version++;
+	replica->groups++;
+
+	return 1;
+}
+
+/*
+	Applies the groups received whole.
+	Returns the position of the first record of a group that is not received whole yet, or -1 if a group could not
+	be applied.
+*/
+int applyReceivedGroups(Replica* replica)
+{
+	ByteReader reader;
+	int group = 0, size;
+
+	// the records before scanned were already looked at and belong to the group that is not whole yet
+	while ((size = frameSize(replica->input.data + replica->scanned, replica->input.size - replica->scanned)) > 0)
+	{
+		int position = replica->scanned;
+
+		initByteReader(&reader, replica->input.data + position + 4, size - 4);
+		uint32_t seq = getU32(&reader);
+		uint8_t type = getU8(&reader);
+
+		replica->scanned += size;
+
+		if (type == JOURNAL_HELLO)
+		{
+			replica->journal = getU32(&reader);
+			replica->leaderSeq = seq;
+			group = replica->scanned;
+		}
+		else if (type == JOURNAL_COMMIT)
+		{
+			double committed = getDouble(&reader);
+
+			if (applyGroup(replica, group, position) == -1)
+				return -1;
+
+			replica->applied = seq;
+			if (seq > replica->leaderSeq)
+				replica->leaderSeq = seq;
+			replica->lag = journalTime() - committed;
+			if (replica->lag > replica->maxLag)
+				replica->maxLag = replica->lag;
+			group = replica->scanned;
+		}
+	}
+
+	return size == -1 ? -1 : group;
+}
+
+int pumpReplica(Replica* replica)
+{
+	uint32_t applied = replica->applied;
+
+	while (1)
+	{
+		if (reserveBuffer(&replica->input, REPLICA_READ_SIZE) == -1)
+			return -1;
+
+		ssize_t count = recv(replica->socket, replica->input.data + replica->input.size, REPLICA_READ_SIZE, 0);
+
+		if (count == 0)
+			return -1;
+		if (count == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			return -1;
+		}
+
+		replica->input.size += (int)count;
+	}
+
+	int group = applyReceivedGroups(replica);
+
+	// the repository may hold part of a group now, so it is replaced by a snapshot
+	if (group == -1)
+	{
+		replica->journal = 0;
+		replica->applied = 0;
+		return -1;
+	}
+
+	memmove(replica->input.data, replica->input.data + group, replica->input.size - group);
+	replica->input.size -= group;
+	replica->scanned -= group;
+
+	// an acknowledgement the socket cannot take now is left out, the next one will tell the leader more
+	if (replica->applied != applied)
+	{
+		ByteBuffer ack;
+		initByteBuffer(&ack);
+		endFrame(&ack, beginFrame(&ack, replica->applied, JOURNAL_ACK));
+
+		ssize_t count = ack.failed ? 0 : send(replica->socket, ack.data, ack.size, MSG_NOSIGNAL | MSG_DONTWAIT);
+		freeByteBuffer(&ack);
+		if (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+			return -1;
+	}
+
+	return 1;
+}
+
+void disconnectReplica(Replica* replica)
+{
+	if (replica == NULL || replica->socket == -1)
+		return;
+
+	close(replica->socket);
+	replica->socket = -1;
+}
+
+void freeReplica(Replica* replica)
+{
+	if (replica == NULL)
+		return;
+
+	disconnectReplica(replica);
+	freeByteBuffer(&replica->input);
+}
+
+void printReplica(Replica* replica, FILE* output)
+{
+	fprintf(output, "Replica of %s: %s, applied group %u of %u\n", replica->path,
+		replica->socket == -1 ? "disconnected" : "connected", replica->applied, replica->leaderSeq);
+	fprintf(output, "%lld groups and %lld snapshots applied, %lld connections\n", replica->groups, replica->snapshots, replica->connects);
+	fprintf(output, "Lag: %.0lf us, at most %.0lf us\n", replica->lag, replica->maxLag);
+	if (replica->stale)
+		fprintf(output, "Stale until the next snapshot\n");
+}
+
+
+//Tests
+
+
+int runServerThread(void* server)
+{
+	return runServer((Server*)server);
+}
+
+/*
+	Sends the lines to the server at the path and reads the replies, until the server closes the connection.
+*/
+void exchangeWith(const char* path, const char* lines, char* replies, int capacity)
+{
+	struct sockaddr_un address;
+	int length = 0;
+	ssize_t count;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	int client = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert(client != -1 && connect(client, (struct sockaddr*)&address, sizeof(address)) == 0);
+	assert(send(client, lines, strlen(lines), MSG_NOSIGNAL) == (ssize_t)strlen(lines));
+
+	while ((count = recv(client, replies + length, capacity - 1 - length, 0)) > 0)
+		length += (int)count;
+	replies[length] = 0;
+
+	close(client);
+}
+
+/*
+	Waits until the replica served at the path applied the given group.
+*/
+void waitForGroup(const char* path, uint32_t seq)
+{
+	char replies[512], expected[64];
+	struct timespec pause = { 0, 10000000 };
+
+	snprintf(expected, sizeof(expected), "applied group %u of", seq);
+	for (int attempt = 0; attempt < 500; attempt++)
+	{
+		exchangeWith(path, "replication\nquit\n", replies, sizeof(replies));
+		if (strstr(replies, expected) != NULL)
+			return;
+		thrd_sleep(&pause, NULL);
+	}
+	assert(0);
+}
+
+/*
+	Checks that a group that fails leaves the replica stale until a snapshot is applied.
+*/
+void testStaleReplica()
+{
+	Replica replica;
+	MaterialServices* materialServices = createMaterialServices(createMaterialRepo(2));
+	MaterialRepo* materialRepo = createMaterialRepo(2);
+
+	assert(initReplica(&replica, materialServices, "/tmp/bakery-stale.sock") == 1);
+	addMaterial(materialRepo, createMaterial("Eggs", "Farm", 3, createDate(1, 1, 2030)));
+
+	// a snapshot cut short by a record of an unknown type
+	endFrame(&replica.input, beginFrame(&replica.input, 1, JOURNAL_SNAPSHOT));
+	endFrame(&replica.input, beginFrame(&replica.input, 1, 99));
+	int frame = beginFrame(&replica.input, 1, JOURNAL_COMMIT);
+	putDouble(&replica.input, journalTime());
+	endFrame(&replica.input, frame);
+	assert(applyReceivedGroups(&replica) == -1 && replica.stale == 1 && replica.snapshots == 0);
+
+	replica.input.size = 0;
+	replica.scanned = 0;
+	writeSnapshot(&replica.input, materialRepo, 2);
+	assert(applyReceivedGroups(&replica) == replica.input.size && replica.stale == 0 && replica.snapshots == 1);
+	assert(getSize(materialServices->materialRepo) == 1);
+
+	freeReplica(&replica);
+	destroyMaterialRepo(materialRepo);
+	destroyMaterialServices(materialServices);
+}
+
+void testReplica()
+{
+	Server leader, follower;
+	Replica replica;
+	thrd_t leaderThread, followerThread;
+	char leaderPath[SERVER_PATH_SIZE], followerPath[SERVER_PATH_SIZE];
+	char replies[1024], expected[1024];
+	int result;
+
+	testStaleReplica();
+
+	snprintf(leaderPath, sizeof(leaderPath), "/tmp/bakery-leader-%d.sock", (int)getpid());
+	snprintf(followerPath, sizeof(followerPath), "/tmp/bakery-follower-%d.sock", (int)getpid());
+
+	UI* leaderUI = createUI(createMaterialServices(createMaterialRepo(10)));
+	UI* followerUI = createUI(createMaterialServices(createMaterialRepo(10)));
+
+	if (initServer(&leader, leaderUI, leaderPath) == -1)
+	{
+		destroyUI(leaderUI);
+		destroyUI(followerUI);
+		return;
+	}
+	assert(initServer(&follower, followerUI, followerPath) == 1);
+	assert(initReplica(&replica, followerUI->materialServices, leaderPath) == 1);
+
+	// the lots added before the follower connects reach it in a snapshot
+	assert(add(leaderUI->materialServices, "Eggs", "Farm", 3, 1, 1, 2030) == 1);
+	assert(add(leaderUI->materialServices, "Eggs", "Coop", 3, 1, 2, 2030) == 1);
+
+	assert(thrd_create(&leaderThread, &runServerThread, &leader) == thrd_success);
+	assert(followLeader(&follower, &replica) == 1);
+	assert(thrd_create(&followerThread, &runServerThread, &follower) == thrd_success);
+	waitForGroup(followerPath, 2);
+
+	// the groups committed later are streamed, a transaction as a single group
+	exchangeWith(leaderPath, "add Milk Dairy 2 1 1 2030\nupdate Eggs Farm 1 1 2030 Eggs Farm 5 1 1 2030\nconsume Eggs 4\n"
+		"begin\ndelete Milk Dairy 1 1 2030\nadd Salt Mine 1 1 1 2030\ncommit\nundo\nquit\n", replies, sizeof(replies));
+	waitForGroup(followerPath, 7);
+
+	exchangeWith(leaderPath, "list\nquit\n", expected, sizeof(expected));
+	exchangeWith(followerPath, "list\nquit\n", replies, sizeof(replies));
+	assert(strcmp(replies, expected) == 0 && strstr(replies, "Milk") != NULL && strstr(replies, "Salt") == NULL);
+	exchangeWith(leaderPath, "checksum\nquit\n", expected, sizeof(expected));
+	exchangeWith(followerPath, "checksum\nquit\n", replies, sizeof(replies));
+	assert(strcmp(replies, expected) == 0 && strstr(replies, "of 3 lots") != NULL);
+
+	// the replica is read-only, and does not take followers
+	exchangeWith(followerPath, "add Salt Mine 1 1 1 2030\nundo\nquit\n", replies, sizeof(replies));
+	assert(strncmp(replies, "FAILED", 6) == 0 && strstr(replies + 6, "FAILED") != NULL);
+	exchangeWith(followerPath, "\xB2", replies, sizeof(replies));
+	assert(replies[0] == 0);
+
+	exchangeWith(leaderPath, "replication\nshutdown\n", replies, sizeof(replies));
+	assert(strstr(replies, "Journal") != NULL && strstr(replies, "Follower") != NULL);
+	exchangeWith(followerPath, "shutdown\n", replies, sizeof(replies));
+
+	assert(thrd_join(leaderThread, &result) == thrd_success && result == 1);
+	assert(thrd_join(followerThread, &result) == thrd_success && result == 1);
+	assert(replica.snapshots == 1 && replica.groups == 6 && replica.connects == 1 && replica.applied == leader.journal.seq);
+
+	freeServer(&follower);
+	freeServer(&leader);
+	freeReplica(&replica);
+	destroyUI(leaderUI);
+	destroyUI(followerUI);
+}
+
+#else
+
+int initReplica(Replica* replica, MaterialServices* materialServices, const char* path)
+{
+	return -1;
+}
+
+int connectReplica(Replica* replica)
+{
+	return -1;
+}
+
+int pumpReplica(Replica* replica)
+{
+	return -1;
+}
+
+void disconnectReplica(Replica* replica)
+{
+}
+
+void freeReplica(Replica* replica)
+{
+}
+
+void printReplica(Replica* replica, FILE* output)
+{
+}
+
+void testReplica()
+{
+}
+
+#endif
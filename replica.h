@@ -0,0 +1,67 @@
+#pragma once
+
+#include "server.h"
+#include "journal.h"
+
+#define REPLICA_READ_SIZE (1 << 16)
+#define REPLICA_RETRY_MS 100
+
+/*
+	A read-only copy of the repository of a leader (see Server), kept up to date from its journal (see Journal): the
+	replica connects to the leader, says which group it applied last, and is sent the groups after it, or a snapshot
+	if the leader does not have them anymore. Every group is applied whole, once its commit is received.
+	materialServices - the services of the replica, which are made read-only
+	path - the path of the socket of the leader
+	socket - the connection to the leader, or -1 while the replica is not connected
+	input - the records received that do not form a whole group yet, scanned up to scanned
+	journal - the id of the journal the applied groups come from, or 0 if the replica has to be sent a snapshot
+	applied - the last group applied
+	leaderSeq - the last group the leader had committed when it was last heard of
+	groups, snapshots, connects - the numbers of groups and snapshots applied and of connections made
+	lag, maxLag - the time from the commit of a group by the leader to its apply, for the last group and at most,
+		in microseconds
+	stale - 1 from a group that could not be applied until a snapshot is: the repository may hold part of that group,
+		so the server of the replica refuses the requests meanwhile instead of answering them from it
+*/
+typedef struct Replica
+{
+	MaterialServices* materialServices;
+	char path[SERVER_PATH_SIZE];
+	int socket;
+	ByteBuffer input;
+	int scanned;
+	uint32_t journal, applied, leaderSeq;
+	long long groups, snapshots, connects;
+	double lag, maxLag;
+	int stale;
+} Replica;
+
+/*
+	Makes the services read-only and prepares the replica of their repository. The replica is not connected yet.
+	Returns 1 on success, or -1 if the path is too long.
+*/
+int initReplica(Replica* replica, MaterialServices* materialServices, const char* path);
+
+/*
+	Connects to the leader and asks for the groups after the last one applied.
+	Returns 1 on success, or -1 if the leader cannot be reached.
+*/
+int connectReplica(Replica* replica);
+
+/*
+	Reads what the leader sent, applies the groups received whole and tells the leader the last one applied.
+	Returns 1 on success, or -1 if the connection was lost or a group could not be applied, in which case the replica
+	has to be disconnected; after a group that could not be applied, it asks for a snapshot when it connects again.
+*/
+int pumpReplica(Replica* replica);
+
+void disconnectReplica(Replica* replica);
+void freeReplica(Replica* replica);
+
+/*
+	Prints the state of the replica and its lag behind the leader.
+*/
+void printReplica(Replica* replica, FILE* output);
+
+//Tests
+void testReplica();
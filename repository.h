@@ -2,10 +2,52 @@
 
 #include "material.h"
 #include "dynamicArray.h"
+#include "hashMap.h"
+#include "statistics.h"
+#include "trigramIndex.h"
+#include "trie.h"
+#include "calendar.h"
+#include "merkle.h"
 
+/*
+	The materials of a repository that share a key, e.g. the same supplier or the same name.
+	lots - the materials, owned by the repository, not by the group; the lots of a supplier are in no particular
+		order, the lots of a name form a binary min-heap by expiration date, so lots[0] expires first; every lot
+		records its positions (see Material), so it is removed in O(1) from a supplier and O(log n) from a name
+	total - the sum of the quantities of the lots
+	expired - the number of lots that expire before the expiredBefore day of the repository
+*/
+typedef struct MaterialGroup
+{
+	DynamicArray* lots;
+	double total;
+	int expired;
+} MaterialGroup;
+
+/*
+	suppliers, names - the materials grouped by supplier and by name, kept up to date by every operation
+	expiredBefore - the day key (see dateKey) the expired counts of the groups refer to
+	nameTrigrams - maps the trigrams of every distinct name to the name groups, for substring searches
+	nameTrie, supplierTrie - map every distinct name and supplier to its group, weighted by the group total, for prefix searches
+	calendar - the materials grouped by expiration day, for date range searches
+	changedNames, changedSuppliers - the names and suppliers whose materials were added, changed or removed since
+		the changes were last cleared, so the checks that depend on them are only repeated for those keys
+	merkle - the hashes of the lots, for comparing repositories (see getMerkleTree); nodes is NULL until the tree is
+		first needed, after which it is kept up to date by every operation
+*/
 typedef struct MaterialRepo
 {
 	DynamicArray* data;
+	HashMap* suppliers;
+	HashMap* names;
+	int expiredBefore;
+	TrigramIndex nameTrigrams;
+	Trie nameTrie, supplierTrie;
+	Calendar calendar;
+	Histogram expiryHistogram, quantityHistogram;
+	HashMap* changedNames;
+	HashMap* changedSuppliers;
+	MerkleTree merkle;
 } MaterialRepo;
 
 MaterialRepo* createMaterialRepo(int capacity);
@@ -17,10 +59,101 @@ Material* getMaterialAtPos(MaterialRepo* materialRepo, int position);
 
 int findMaterial(MaterialRepo* materialRepo, Material* material);
 int addMaterial(MaterialRepo* materialRepo, Material* material);
+
+/*
+	Adds a material that is known not to be in the repository, without looking for an equal one to merge it with.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int appendMaterial(MaterialRepo* materialRepo, Material* material);
+
+/*
+	Replaces a material with the updated one. The material is found at the position it records when it is a lot of the
+	repository itself, and among the lots of its name otherwise.
+	Returns 1 on success, or -1 if there is no such material or the memory could not be allocated.
+*/
 int updateMaterial(MaterialRepo* materialRepo, Material* material, Material* updatedMaterial);
+
+/*
+	Removes a material in O(lots of its name): the last material of the repository takes its place, so the order of
+	the materials changes.
+	Returns 1 on success, or -1 if there is no such material.
+*/
 int removeMaterial(MaterialRepo* materialRepo, Material* material);
 
 MaterialRepo* copyMaterialRepo(MaterialRepo* materialRepo);
 
+/*
+	Forgets the changed names and suppliers, once they were handled. A copy of a repository starts with no changes.
+*/
+void clearChanges(MaterialRepo* materialRepo);
+
+/*
+	Gets the group of materials of the given supplier, or NULL if the supplier has no materials.
+*/
+MaterialGroup* getSupplierGroup(MaterialRepo* materialRepo, const char* supplier);
+
+/*
+	Gets the group of materials with the given name, or NULL if there is no material with that name.
+*/
+MaterialGroup* getNameGroup(MaterialRepo* materialRepo, const char* name);
+
+/*
+	Gets the name groups of the materials whose name contains the pattern, using the trigram index.
+	The groups are appended to the groups array.
+	Returns 1 on success, or 0 if the pattern is shorter than 3 characters and the index cannot be used.
+*/
+int findNameGroups(MaterialRepo* materialRepo, const char* pattern, DynamicArray* groups);
+
+/*
+	Gets the groups of the names (bySupplier 0) or the suppliers (bySupplier 1) starting with the prefix
+	that have the largest total quantities, largest first.
+	groups - receives at most limit groups
+	Returns the number of groups, or -1 if an error occured.
+*/
+int completeGroups(MaterialRepo* materialRepo, const char* prefix, int bySupplier, int limit, MaterialGroup** groups);
+
+/*
+	Gets the names within maxDistance edits of the pattern, ignoring the case, closest first;
+	names at the same distance are ranked by their total quantity, largest first.
+	groups, distances - receive at most limit name groups and their edit distances
+	Returns the number of names, or -1 if the arguments are not valid.
+*/
+int suggestNames(MaterialRepo* materialRepo, const char* pattern, int maxDistance, int limit, MaterialGroup** groups, int* distances);
+
+/*
+	Consumes a quantity of a material from its lots, the ones expiring first being used first (FEFO):
+	the lots that are used up are removed and the last one is reduced. Each lot taken costs O(log n)
+	in the name heap and O(1) in the materials array, where the last material takes the place of a removed lot.
+	Returns 1 on success, or -1 if the name is unknown or its lots do not have the quantity, in which case nothing changes.
+*/
+int consumeMaterial(MaterialRepo* materialRepo, const char* name, double quantity);
+
+/*
+	Gets the Merkle tree of the lots, building it on the first call: the repositories that hold the same lots have the
+	same root hash, and diffMerkleTrees finds the buckets in which two repositories differ. A copy of a repository
+	has a tree if the repository has one.
+	Returns the tree, or NULL if the memory could not be allocated.
+*/
+MerkleTree* getMerkleTree(MaterialRepo* materialRepo);
+
+/*
+	Frees the Merkle tree of a repository that is not compared anymore, it is built again if it is needed.
+*/
+void dropMerkleTree(MaterialRepo* materialRepo);
+
+/*
+	Removes every lot of a bucket of the Merkle tree, in O(lots of the bucket): the last material of the repository
+	takes the place of every removed lot, so the order of the materials changes.
+	Returns the number of lots removed, or -1 if the tree could not be built.
+*/
+int removeBucket(MaterialRepo* materialRepo, int bucket);
+
+/*
+	Makes the expired counts of the groups refer to the given day. The counts are only recomputed,
+	in one pass over the materials, when the day differs from the one they already refer to.
+	Returns 1 on success, or -1 if the repository is NULL.
+*/
+int refreshExpiredCounts(MaterialRepo* materialRepo, int today);
+
 //Tests
 void testMaterialRepo();
@@ -0,0 +1,664 @@
+#include "rowWriter.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+
+int initRowWriter(RowWriter* rowWriter, FILE* file, int capacity)
+{
+	if (rowWriter == NULL || file == NULL || capacity <= 0)
+		return -1;
+
+	rowWriter->buffer = (char*)malloc(capacity);
+
+	if (rowWriter->buffer == NULL)
+		return -1;
+
+	rowWriter->file = file;
+	rowWriter->size = 0;
+	rowWriter->capacity = capacity;
+
+	return 1;
+}
+
+void freeRowWriter(RowWriter* rowWriter)
+{
+	if (rowWriter == NULL)
+		return;
+
+	free(rowWriter->buffer);
+	rowWriter->buffer = NULL;
+	rowWriter->size = 0;
+}
+
+int flushRowWriter(RowWriter* rowWriter)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL)
+		return -1;
+
+	int size = rowWriter->size;
+	rowWriter->size = 0;
+
+	if (size > 0 && (int)fwrite(rowWriter->buffer, 1, size, rowWriter->file) != size)
+		return -1;
+
+	return 1;
+}
+
+/*
+	Appends length bytes, flushing the buffer first if they do not fit. The bytes that would not fit even in an empty
+	buffer are written directly.
+*/
+void writeBytes(RowWriter* rowWriter, const char* bytes, int length)
+{
+	if (rowWriter->size + length > rowWriter->capacity)
+	{
+		flushRowWriter(rowWriter);
+
+		if (length > rowWriter->capacity)
+		{
+			fwrite(bytes, 1, length, rowWriter->file);
+			return;
+		}
+	}
+
+	memcpy(rowWriter->buffer + rowWriter->size, bytes, length);
+	rowWriter->size += length;
+}
+
+void writeSpaces(RowWriter* rowWriter, int count)
+{
+	while (count > 0)
+	{
+		if (rowWriter->size == rowWriter->capacity)
+			flushRowWriter(rowWriter);
+
+		int length = rowWriter->capacity - rowWriter->size;
+		if (length > count)
+			length = count;
+
+		memset(rowWriter->buffer + rowWriter->size, ' ', length);
+		rowWriter->size += length;
+		count -= length;
+	}
+}
+
+void writePadded(RowWriter* rowWriter, const char* text, int length, int width, int leftAlign)
+{
+	if (!leftAlign)
+		writeSpaces(rowWriter, width - length);
+
+	writeBytes(rowWriter, text, length);
+
+	if (leftAlign)
+		writeSpaces(rowWriter, width - length);
+}
+
+/*
+	Writes the decimal digits of value at the end of the text, padded with zeros to at least minimum digits.
+	Returns the number of digits, which start at text + 24 - count.
+*/
+int formatDigits(char text[24], unsigned long long value, int minimum)
+{
+	int count = 0;
+
+	do
+	{
+		text[23 - count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	while (count < minimum)
+		text[23 - count++] = '0';
+
+	return count;
+}
+
+void writeText(RowWriter* rowWriter, const char* text, int width, int leftAlign)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL)
+		return;
+
+	if (text == NULL)
+		text = "(null)";
+
+	writePadded(rowWriter, text, (int)strlen(text), width, leftAlign);
+}
+
+void writeInteger(RowWriter* rowWriter, long long value, int width, int leftAlign)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL)
+		return;
+
+	char text[24];
+	unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+	int count = formatDigits(text, magnitude, 1);
+
+	if (value < 0)
+		text[23 - count++] = '-';
+
+	writePadded(rowWriter, text + 24 - count, count, width, leftAlign);
+}
+
+/*
+	Formats the number with 4 decimals, as printf("%.4lf") does, into text.
+	The numbers below 1e9 are scaled to an integer number of ten thousandths and converted by hand. The ones whose
+	rounding is too close to call in double precision, the larger ones, infinities and NaN go through snprintf.
+	Returns the length of the text.
+*/
+int formatFixed(char text[64], double value)
+{
+	// NaN fails both comparisons
+	if (value > -1e9 && value < 1e9)
+	{
+		double scaled = fabs(value) * 10000;
+		double whole = floor(scaled);
+		double fraction = scaled - whole;
+
+		if (fabs(fraction - 0.5) > 0.01)
+		{
+			unsigned long long units = (unsigned long long)whole + (fraction > 0.5);
+			char digits[24];
+			int length = 0;
+
+			if (signbit(value))
+				text[length++] = '-';
+
+			int count = formatDigits(digits, units / 10000, 1);
+			memcpy(text + length, digits + 24 - count, count);
+			length += count;
+
+			text[length++] = '.';
+			count = formatDigits(digits, units % 10000, 4);
+			memcpy(text + length, digits + 24 - count, count);
+			length += count;
+
+			text[length] = 0;
+			return length;
+		}
+	}
+
+	return snprintf(text, 64, "%.4lf", value);
+}
+
+void writeFixed(RowWriter* rowWriter, double value, int width)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL)
+		return;
+
+	char text[64];
+	int length = formatFixed(text, value);
+
+	writePadded(rowWriter, text, length, width, 0);
+}
+
+void writeChar(RowWriter* rowWriter, char character)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL)
+		return;
+
+	if (rowWriter->size == rowWriter->capacity)
+		flushRowWriter(rowWriter);
+
+	rowWriter->buffer[rowWriter->size++] = character;
+}
+
+/*
+	Writes the date as day/month/year, the day padded to width. A missing date is written as -1/-1/-1, like getDay does.
+*/
+void writeDate(RowWriter* rowWriter, const Date* date, int width)
+{
+	writeInteger(rowWriter, getDay(date), width, 0);
+	writeChar(rowWriter, '/');
+	writeInteger(rowWriter, getMonth(date), 0, 0);
+	writeChar(rowWriter, '/');
+	writeInteger(rowWriter, getYear(date), 0, 0);
+}
+
+void writeTable(RowWriter* rowWriter, DynamicArray* materials, int columns)
+{
+	if (len(materials) == 0)
+	{
+		writeText(rowWriter, "No materials to be displayed!\n", 0, 0);
+		return;
+	}
+
+	writeText(rowWriter, "NR", 3, 1);
+	if (columns & (1 << COLUMN_NAME))
+	{
+		writeChar(rowWriter, ' ');
+		writeText(rowWriter, "NAME", 20, 0);
+	}
+	if (columns & (1 << COLUMN_SUPPLIER))
+	{
+		writeChar(rowWriter, ' ');
+		writeText(rowWriter, "SUPPLIER", 20, 0);
+	}
+	if (columns & (1 << COLUMN_QUANTITY))
+	{
+		writeChar(rowWriter, ' ');
+		writeText(rowWriter, "QUANTITY", 20, 0);
+	}
+	if (columns & (1 << COLUMN_DATE))
+	{
+		writeChar(rowWriter, ' ');
+		writeText(rowWriter, "EXPIRATION_DATE", 30, 0);
+	}
+	writeChar(rowWriter, '\n');
+
+	for (int i = 0; i < len(materials); i++)
+	{
+		Material* m = getElement(materials, i);
+
+		writeInteger(rowWriter, i + 1, 3, 1);
+		if (columns & (1 << COLUMN_NAME))
+		{
+			writeChar(rowWriter, ' ');
+			writeText(rowWriter, m->name, 20, 0);
+		}
+		if (columns & (1 << COLUMN_SUPPLIER))
+		{
+			writeChar(rowWriter, ' ');
+			writeText(rowWriter, m->supplier, 20, 0);
+		}
+		if (columns & (1 << COLUMN_QUANTITY))
+		{
+			writeChar(rowWriter, ' ');
+			writeFixed(rowWriter, m->quantity, 20);
+		}
+		if (columns & (1 << COLUMN_DATE))
+		{
+			writeChar(rowWriter, ' ');
+			writeDate(rowWriter, m->date, 20);
+		}
+		writeChar(rowWriter, '\n');
+	}
+}
+
+void writeCsvText(RowWriter* rowWriter, const char* text)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL || text == NULL)
+		return;
+
+	int length = (int)strcspn(text, ",\"\r\n");
+
+	// most fields need no quotes, and are found to be so by the same scan that measures them
+	if (text[length] == 0)
+	{
+		writeBytes(rowWriter, text, length);
+		return;
+	}
+
+	writeChar(rowWriter, '"');
+	while (1)
+	{
+		writeBytes(rowWriter, text, length);
+		text += length;
+
+		if (*text == 0)
+			break;
+		if (*text == '"')
+			writeChar(rowWriter, '"');
+		writeChar(rowWriter, *text++);
+
+		length = (int)strcspn(text, "\"");
+	}
+	writeChar(rowWriter, '"');
+}
+
+void writeJsonText(RowWriter* rowWriter, const char* text)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL || text == NULL)
+		return;
+
+	const char* hex = "0123456789abcdef";
+	const unsigned char* c = (const unsigned char*)text;
+	const unsigned char* run = c;
+
+	writeChar(rowWriter, '"');
+	for (; *c != 0; c++)
+	{
+		if (*c >= 0x20 && *c != '"' && *c != '\\')
+			continue;
+
+		writeBytes(rowWriter, (const char*)run, (int)(c - run));
+		run = c + 1;
+
+		writeChar(rowWriter, '\\');
+		switch (*c)
+		{
+		case '"':
+		case '\\':
+			writeChar(rowWriter, (char)*c);
+			break;
+		case '\n':
+			writeChar(rowWriter, 'n');
+			break;
+		case '\r':
+			writeChar(rowWriter, 'r');
+			break;
+		case '\t':
+			writeChar(rowWriter, 't');
+			break;
+		default:
+			writeText(rowWriter, "u00", 0, 0);
+			writeChar(rowWriter, hex[*c >> 4]);
+			writeChar(rowWriter, hex[*c & 15]);
+			break;
+		}
+	}
+	writeBytes(rowWriter, (const char*)run, (int)(c - run));
+	writeChar(rowWriter, '"');
+}
+
+/*
+	Writes a header, then one line per material, with the values of the columns separated by the given character.
+	The CSV layout quotes the strings that need it and leaves a quantity that is not a number empty.
+*/
+void writeSeparated(RowWriter* rowWriter, DynamicArray* materials, int columns, char separator, RowLayout layout)
+{
+	const char* names[] = { "NAME", "SUPPLIER", "QUANTITY", "EXPIRATION_DATE" };
+	int first = 1;
+
+	for (int c = COLUMN_NAME; c <= COLUMN_DATE; c++)
+		if (columns & (1 << c))
+		{
+			if (!first)
+				writeChar(rowWriter, separator);
+			writeText(rowWriter, names[c], 0, 0);
+			first = 0;
+		}
+	writeChar(rowWriter, '\n');
+
+	for (int i = 0; i < len(materials); i++)
+	{
+		Material* m = getElement(materials, i);
+		first = 1;
+
+		for (int c = COLUMN_NAME; c <= COLUMN_DATE; c++)
+		{
+			if (!(columns & (1 << c)))
+				continue;
+
+			if (!first)
+				writeChar(rowWriter, separator);
+			first = 0;
+
+			switch (c)
+			{
+			case COLUMN_NAME:
+			case COLUMN_SUPPLIER:
+			{
+				const char* text = c == COLUMN_NAME ? m->name : m->supplier;
+				if (layout == LAYOUT_CSV)
+					writeCsvText(rowWriter, text);
+				else
+					writeText(rowWriter, text, 0, 0);
+				break;
+			}
+			case COLUMN_QUANTITY:
+				if (layout != LAYOUT_CSV || isfinite(m->quantity))
+					writeFixed(rowWriter, m->quantity, 0);
+				break;
+			case COLUMN_DATE:
+				writeDate(rowWriter, m->date, 0);
+				break;
+			}
+		}
+		writeChar(rowWriter, '\n');
+	}
+}
+
+void writeJsonLines(RowWriter* rowWriter, DynamicArray* materials, int columns)
+{
+	const char* keys[] = { "\"name\":", "\"supplier\":", "\"quantity\":", "\"expirationDate\":" };
+
+	for (int i = 0; i < len(materials); i++)
+	{
+		Material* m = getElement(materials, i);
+		int first = 1;
+
+		writeChar(rowWriter, '{');
+		for (int c = COLUMN_NAME; c <= COLUMN_DATE; c++)
+		{
+			if (!(columns & (1 << c)))
+				continue;
+
+			if (!first)
+				writeChar(rowWriter, ',');
+			first = 0;
+
+			writeText(rowWriter, keys[c], 0, 0);
+			switch (c)
+			{
+			case COLUMN_NAME:
+				writeJsonText(rowWriter, m->name);
+				break;
+			case COLUMN_SUPPLIER:
+				writeJsonText(rowWriter, m->supplier);
+				break;
+			case COLUMN_QUANTITY:
+				if (isfinite(m->quantity))
+					writeFixed(rowWriter, m->quantity, 0);
+				else
+					writeText(rowWriter, "null", 0, 0);
+				break;
+			case COLUMN_DATE:
+				writeChar(rowWriter, '"');
+				writeDate(rowWriter, m->date, 0);
+				writeChar(rowWriter, '"');
+				break;
+			}
+		}
+		writeText(rowWriter, "}\n", 0, 0);
+	}
+}
+
+void writeMaterials(RowWriter* rowWriter, DynamicArray* materials, int columns, RowLayout layout)
+{
+	if (rowWriter == NULL || rowWriter->buffer == NULL || materials == NULL)
+		return;
+
+	switch (layout)
+	{
+	case LAYOUT_TSV:
+		writeSeparated(rowWriter, materials, columns, '\t', layout);
+		break;
+	case LAYOUT_CSV:
+		writeSeparated(rowWriter, materials, columns, ',', layout);
+		break;
+	case LAYOUT_JSONL:
+		writeJsonLines(rowWriter, materials, columns);
+		break;
+	default:
+		writeTable(rowWriter, materials, columns);
+		break;
+	}
+}
+
+int parseRowLayout(const char* text, RowLayout* layout)
+{
+	if (text == NULL || layout == NULL)
+		return -1;
+
+	if (strcmp(text, "table") == 0)
+		*layout = LAYOUT_TABLE;
+	else if (strcmp(text, "tsv") == 0)
+		*layout = LAYOUT_TSV;
+	else if (strcmp(text, "csv") == 0)
+		*layout = LAYOUT_CSV;
+	else if (strcmp(text, "jsonl") == 0)
+		*layout = LAYOUT_JSONL;
+	else
+		return -1;
+
+	return 1;
+}
+
+
+//Tests
+
+
+/*
+	Reads back everything written to the file.
+*/
+int readWritten(FILE* file, char* text, int capacity)
+{
+	fflush(file);
+	rewind(file);
+
+	int length = (int)fread(text, 1, capacity - 1, file);
+	text[length] = 0;
+
+	return length;
+}
+
+void testWriteValues()
+{
+	double values[] = { 0, -0.0, 1, 2.5, 0.00005, 0.00015, 0.00004999, -0.00001, 123456.78905, 999999999.99999,
+		-42.125, 1e9, -3e15, 1e300, 0.1 + 0.2, 1.0 / 3, HUGE_VAL, -HUGE_VAL };
+	int count = (int)(sizeof(values) / sizeof(values[0]));
+	char text[64], expected[64];
+
+	for (int i = 0; i < count; i++)
+	{
+		snprintf(expected, sizeof(expected), "%.4lf", values[i]);
+		formatFixed(text, values[i]);
+		assert(strcmp(text, expected) == 0);
+	}
+
+	// every quantity with up to 5 decimals around the rounding ties
+	for (int i = -200000; i <= 200000; i += 7)
+	{
+		double value = i / 100000.0 + 31.0;
+		snprintf(expected, sizeof(expected), "%.4lf", value);
+		formatFixed(text, value);
+		assert(strcmp(text, expected) == 0);
+	}
+}
+
+void testWriteTable()
+{
+	FILE* file = tmpfile();
+	RowWriter rowWriter;
+	DynamicArray* materials = createDynamicArray(2, &destroyMaterial);
+	char written[1024], expected[1024];
+
+	if (file == NULL)
+		return;
+
+	// a small buffer, so the rows are flushed while they are written
+	assert(initRowWriter(&rowWriter, file, 16) == 1);
+
+	writeMaterials(&rowWriter, materials, COLUMN_NAME, LAYOUT_TABLE);
+	flushRowWriter(&rowWriter);
+	readWritten(file, written, sizeof(written));
+	assert(strcmp(written, "No materials to be displayed!\n") == 0);
+
+	apd(materials, createMaterial("Wheat flour", "WindMill", 10.5, createDate(24, 5, 2025)));
+	apd(materials, createMaterial("a name longer than twenty characters", "b", -0.00001, createDate(1, 12, 2030)));
+
+	rewind(file);
+	writeText(&rowWriter, "the row numbers", 0, 0);
+	writeInteger(&rowWriter, -1234567, 10, 1);
+	writeInteger(&rowWriter, 42, 4, 0);
+	writeChar(&rowWriter, '\n');
+	writeMaterials(&rowWriter, materials, (1 << COLUMN_NAME) | (1 << COLUMN_SUPPLIER) | (1 << COLUMN_QUANTITY) | (1 << COLUMN_DATE), LAYOUT_TABLE);
+	flushRowWriter(&rowWriter);
+	int length = readWritten(file, written, sizeof(written));
+
+	int size = snprintf(expected, sizeof(expected), "the row numbers%-10d%4d\n", -1234567, 42);
+	size += snprintf(expected + size, sizeof(expected) - size, "%-3s %20s %20s %20s %30s\n", "NR", "NAME", "SUPPLIER", "QUANTITY", "EXPIRATION_DATE");
+	size += snprintf(expected + size, sizeof(expected) - size, "%-3d %20s %20s %*.4lf %20d/%d/%d\n", 1, "Wheat flour", "WindMill", 20, 10.5, 24, 5, 2025);
+	size += snprintf(expected + size, sizeof(expected) - size, "%-3d %20s %20s %*.4lf %20d/%d/%d\n", 2, "a name longer than twenty characters", "b", 20, -0.00001, 1, 12, 2030);
+	assert(length == size && strcmp(written, expected) == 0);
+
+	freeRowWriter(&rowWriter);
+	destroyDynamicArray(materials);
+	fclose(file);
+}
+
+void testWriteTabSeparated()
+{
+	FILE* file = tmpfile();
+	RowWriter rowWriter;
+	DynamicArray* materials = createDynamicArray(2, &destroyMaterial);
+	char written[256];
+
+	if (file == NULL)
+		return;
+
+	assert(initRowWriter(&rowWriter, file, ROW_WRITER_SIZE) == 1);
+	apd(materials, createMaterial("Wheat flour", "WindMill", 10.5, createDate(24, 5, 2025)));
+
+	writeMaterials(&rowWriter, materials, (1 << COLUMN_NAME) | (1 << COLUMN_QUANTITY) | (1 << COLUMN_DATE), LAYOUT_TSV);
+
+	// nothing is written before the flush
+	readWritten(file, written, sizeof(written));
+	assert(strcmp(written, "") == 0);
+
+	flushRowWriter(&rowWriter);
+	readWritten(file, written, sizeof(written));
+	assert(strcmp(written, "NAME\tQUANTITY\tEXPIRATION_DATE\nWheat flour\t10.5000\t24/5/2025\n") == 0);
+
+	RowLayout layout;
+	assert(parseRowLayout("tsv", &layout) == 1 && layout == LAYOUT_TSV);
+	assert(parseRowLayout("table", &layout) == 1 && layout == LAYOUT_TABLE);
+	assert(parseRowLayout("jsonl", &layout) == 1 && layout == LAYOUT_JSONL);
+	assert(parseRowLayout("xml", &layout) == -1);
+
+	freeRowWriter(&rowWriter);
+	destroyDynamicArray(materials);
+	fclose(file);
+}
+
+void testWriteEscaped()
+{
+	FILE* file = tmpfile();
+	RowWriter rowWriter;
+	DynamicArray* materials = createDynamicArray(2, &destroyMaterial);
+	char written[512];
+
+	if (file == NULL)
+		return;
+
+	assert(initRowWriter(&rowWriter, file, 8) == 1);
+
+	writeCsvText(&rowWriter, "plain");
+	writeChar(&rowWriter, ' ');
+	writeCsvText(&rowWriter, "a, \"b\"\n");
+	writeChar(&rowWriter, ' ');
+	writeJsonText(&rowWriter, "q\"\\\t\x01 end");
+	flushRowWriter(&rowWriter);
+	readWritten(file, written, sizeof(written));
+	assert(strcmp(written, "plain \"a, \"\"b\"\"\n\" \"q\\\"\\\\\\t\\u0001 end\"") == 0);
+
+	apd(materials, createMaterial("Flour, \"00\"", "Mill", 2.5, createDate(24, 5, 2025)));
+	apd(materials, createMaterial("Eggs", "Farm", NAN, createDate(1, 1, 2030)));
+
+	rewind(file);
+	writeMaterials(&rowWriter, materials, (1 << COLUMN_NAME) | (1 << COLUMN_QUANTITY) | (1 << COLUMN_DATE), LAYOUT_CSV);
+	writeMaterials(&rowWriter, materials, (1 << COLUMN_NAME) | (1 << COLUMN_QUANTITY) | (1 << COLUMN_DATE), LAYOUT_JSONL);
+	flushRowWriter(&rowWriter);
+	readWritten(file, written, sizeof(written));
+	assert(strcmp(written,
+		"NAME,QUANTITY,EXPIRATION_DATE\n"
+		"\"Flour, \"\"00\"\"\",2.5000,24/5/2025\n"
+		"Eggs,,1/1/2030\n"
+		"{\"name\":\"Flour, \\\"00\\\"\",\"quantity\":2.5000,\"expirationDate\":\"24/5/2025\"}\n"
+		"{\"name\":\"Eggs\",\"quantity\":null,\"expirationDate\":\"1/1/2030\"}\n") == 0);
+
+	freeRowWriter(&rowWriter);
+	destroyDynamicArray(materials);
+	fclose(file);
+}
+
+void testRowWriter()
+{
+	testWriteValues();
+	testWriteTable();
+	testWriteTabSeparated();
+	testWriteEscaped();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "orderBy.h"
+
+#include <stdio.h>
+
+#define ROW_WRITER_SIZE (1 << 18)
+
+typedef enum RowLayout
+{
+	LAYOUT_TABLE,
+	LAYOUT_TSV,
+	LAYOUT_CSV,
+	LAYOUT_JSONL
+} RowLayout;
+
+/*
+	Formats rows into a large reusable buffer and writes it to a file in large blocks, only when it fills up
+	or when it is flushed. The numbers are converted by hand instead of going through printf.
+	buffer - the size bytes formatted and not written yet, out of capacity
+*/
+typedef struct RowWriter
+{
+	FILE* file;
+	char* buffer;
+	int size, capacity;
+} RowWriter;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initRowWriter(RowWriter* rowWriter, FILE* file, int capacity);
+void freeRowWriter(RowWriter* rowWriter);
+
+/*
+	Writes the formatted bytes to the file.
+	Returns 1 on success, or -1 if they could not be written.
+*/
+int flushRowWriter(RowWriter* rowWriter);
+
+/*
+	Append a value, padded with spaces to at least width characters: on the left (right aligned),
+	or on the right if leftAlign is 1. A width of 0 adds no padding.
+	writeFixed writes the number with 4 decimals, exactly as printf("%.4lf") does.
+*/
+void writeText(RowWriter* rowWriter, const char* text, int width, int leftAlign);
+void writeInteger(RowWriter* rowWriter, long long value, int width, int leftAlign);
+void writeFixed(RowWriter* rowWriter, double value, int width);
+void writeChar(RowWriter* rowWriter, char character);
+
+/*
+	Append a string as a CSV field, between double quotes with the quotes doubled if it contains a comma, a quote or
+	a line break, or as a JSON string, with the quotes, backslashes and control characters escaped.
+	The string is read once: the characters that need no escaping are copied in runs.
+*/
+void writeCsvText(RowWriter* rowWriter, const char* text);
+void writeJsonText(RowWriter* rowWriter, const char* text);
+
+/*
+	Writes the materials with the given columns (see Column):
+	LAYOUT_TABLE - the table printed by the console, byte for byte: a header, then numbered rows of right aligned columns
+	LAYOUT_TSV - a header, then one line per material with the values separated by tabs, without padding or numbers
+	LAYOUT_CSV - a header, then one line per material with the values separated by commas (RFC 4180)
+	LAYOUT_JSONL - one JSON object per material, e.g. {"name":"Eggs","quantity":10.5000,"expirationDate":"24/5/2025"}
+	The dates are written as day/month/year in every layout, and a quantity that is not a number as an empty field
+	or a JSON null.
+	The rows are left in the buffer, until it fills up or it is flushed, so any number of rows is written with the
+	memory of the buffer.
+*/
+void writeMaterials(RowWriter* rowWriter, DynamicArray* materials, int columns, RowLayout layout);
+
+/*
+	Gets the layout of the given name: table, tsv, csv or jsonl.
+	Returns 1 on success, or -1 if there is no such layout.
+*/
+int parseRowLayout(const char* text, RowLayout* layout);
+
+//Tests
+void testRowWriter();
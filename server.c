@@ -0,0 +1,821 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "server.h"
+#include "replica.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <threads.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+
+int initServer(Server* server, UI* ui, const char* path)
+{
+	if (server == NULL || ui == NULL || path == NULL || strlen(path) >= SERVER_PATH_SIZE)
+		return -1;
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	server->ui = ui;
+	server->first = NULL;
+	server->connections = 0;
+	server->followers = 0;
+	server->transaction = NULL;
+	server->requests = 0;
+	server->replica = NULL;
+	server->outputText = NULL;
+	server->outputSize = 0;
+	strcpy(server->path, path);
+	atomic_init(&server->stopping, 0);
+
+	server->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	server->epoll = epoll_create1(EPOLL_CLOEXEC);
+	server->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	server->output = open_memstream(&server->outputText, &server->outputSize);
+
+	unlink(path);
+
+	struct epoll_event listenerEvent = { EPOLLIN, { .ptr = &server->listener } };
+	struct epoll_event wakeupEvent = { EPOLLIN, { .ptr = &server->wakeup } };
+
+	if (server->listener == -1 || server->epoll == -1 || server->wakeup == -1 || server->output == NULL ||
+		bind(server->listener, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(server->listener, SOMAXCONN) == -1 ||
+		epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->listener, &listenerEvent) == -1 ||
+		epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->wakeup, &wakeupEvent) == -1)
+	{
+		if (server->listener != -1)
+			close(server->listener);
+		if (server->epoll != -1)
+			close(server->epoll);
+		if (server->wakeup != -1)
+			close(server->wakeup);
+		if (server->output != NULL)
+			fclose(server->output);
+		free(server->outputText);
+		return -1;
+	}
+
+	setOutput(ui, server->output);
+
+	// the id of the journal tells a follower of an earlier run of the server that it needs a snapshot
+	uint32_t id = (uint32_t)time(NULL) ^ (uint32_t)getpid() << 16;
+	initJournal(&server->journal, id == 0 ? 1 : id);
+	attachJournal(ui->materialServices, &server->journal);
+
+	return 1;
+}
+
+void closeConnection(Server* server, Connection* connection)
+{
+	// the transaction of a client that is gone is never committed
+	if (server->transaction == connection)
+	{
+		rollbackTransaction(server->ui->materialServices);
+		server->transaction = NULL;
+	}
+
+	close(connection->socket);
+
+	if (connection->previous != NULL)
+		connection->previous->next = connection->next;
+	else
+		server->first = connection->next;
+	if (connection->next != NULL)
+		connection->next->previous = connection->previous;
+
+	freeByteBuffer(&connection->input);
+	freeByteBuffer(&connection->output);
+	if (connection->protocol == PROTOCOL_JOURNAL)
+		server->followers--;
+	free(connection);
+	server->connections--;
+}
+
+void acceptConnections(Server* server)
+{
+	while (1)
+	{
+		int client = accept4(server->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (client == -1)
+			return;
+
+		Connection* connection = (Connection*)calloc(1, sizeof(Connection));
+		struct epoll_event event = { EPOLLIN, { .ptr = connection } };
+
+		if (connection == NULL || epoll_ctl(server->epoll, EPOLL_CTL_ADD, client, &event) == -1)
+		{
+			free(connection);
+			close(client);
+			continue;
+		}
+
+		connection->socket = client;
+		connection->layout = server->ui->layout;
+		connection->events = EPOLLIN;
+		connection->shipped = -2;
+		connection->next = server->first;
+		if (server->first != NULL)
+			server->first->previous = connection;
+		server->first = connection;
+		server->connections++;
+	}
+}
+
+/*
+	Appends a reply to the output of the connection.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int appendReply(Connection* connection, const char* status, const char* text, int length)
+{
+	char header[32];
+	int headerLength = snprintf(header, sizeof(header), "%s %d\n", status, length);
+
+	putBytes(&connection->output, header, headerLength);
+	putBytes(&connection->output, text, length);
+
+	return connection->output.failed ? -1 : 1;
+}
+
+void printReplication(Server* server)
+{
+	Journal* journal = &server->journal;
+
+	if (server->replica != NULL)
+	{
+		printReplica(server->replica, server->output);
+		return;
+	}
+
+	fprintf(server->output, "Journal %08x: group %u, groups after %u kept in %d bytes\n", journal->id, journal->seq,
+		journal->dropped, journal->records.size);
+
+	for (Connection* connection = server->first; connection != NULL; connection = connection->next)
+		if (connection->protocol == PROTOCOL_JOURNAL && connection->shipped != -2)
+			fprintf(server->output, "Follower %d: applied group %u, %u groups behind, %d bytes to send\n", connection->socket,
+				connection->acked, journal->seq - connection->acked, connection->output.size - connection->outputStart);
+}
+
+/*
+	Starts running a request of the connection in its session: the UI takes the layout of the connection, and the
+	services are made read-only if another connection has a transaction open.
+	Returns the read-only flag of the services, which endSession restores.
+*/
+int beginSession(Server* server, Connection* connection)
+{
+	MaterialServices* materialServices = server->ui->materialServices;
+	int readOnly = materialServices->readOnly;
+	RowLayout layout = server->ui->layout;
+
+	server->ui->layout = connection->layout;
+	connection->layout = layout;
+	if (server->transaction != NULL && server->transaction != connection)
+		materialServices->readOnly = 1;
+
+	return readOnly;
+}
+
+/*
+	Ends the request started with beginSession, and records the connection whose transaction is open.
+*/
+void endSession(Server* server, Connection* connection, int readOnly)
+{
+	MaterialServices* materialServices = server->ui->materialServices;
+	RowLayout layout = server->ui->layout;
+
+	server->ui->layout = connection->layout;
+	connection->layout = layout;
+	materialServices->readOnly = readOnly;
+
+	if (materialServices->transaction == 0)
+		server->transaction = NULL;
+	else if (server->transaction == NULL)
+		server->transaction = connection;
+}
+
+/*
+	Tells whether a command line runs the given command.
+*/
+int isCommand(const char* line, const char* command)
+{
+	line += strspn(line, " \t");
+	size_t length = strlen(command);
+
+	return strncmp(line, command, length) == 0 && (line[length] == 0 || line[length] == ' ' || line[length] == '\t');
+}
+
+/*
+	Runs one command line of the connection and appends its reply.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int runRequest(Server* server, Connection* connection, char* line)
+{
+	const char* statuses[] = { "FAILED", "INVALID", "OK" };
+
+	server->requests++;
+
+	if (strcmp(line, "quit") == 0)
+	{
+		connection->closing = 1;
+		return appendReply(connection, "OK", "", 0);
+	}
+	if (strcmp(line, "shutdown") == 0)
+	{
+		connection->closing = 1;
+		stopServer(server);
+		return appendReply(connection, "OK", "", 0);
+	}
+
+	int status = 1;
+	if (strcmp(line, "replication") == 0)
+	{
+		connection->lines++;
+		printReplication(server);
+	}
+	else if (server->replica != NULL && server->replica->stale)
+	{
+		fprintf(server->output, "Line %d: the replica is waiting for a snapshot of its leader!\n", ++connection->lines);
+		status = -1;
+	}
+	else if (isCommand(line, "history"))
+	{
+		fprintf(server->output, "Line %d: the history is the same for every client, it cannot be changed!\n", ++connection->lines);
+		status = -1;
+	}
+	else
+	{
+		int readOnly = beginSession(server, connection);
+		status = runCommandLine(server->ui, line, ++connection->lines);
+		endSession(server, connection, readOnly);
+	}
+
+	// the output of the command is taken from the stream, which is then reused from the start
+	fflush(server->output);
+	int result = appendReply(connection, statuses[status + 1], server->outputText, (int)server->outputSize);
+	rewind(server->output);
+
+	return result;
+}
+
+/*
+	Run the whole requests received from the connection, from the given position of the input on, until its replies
+	reach SERVER_MAX_OUTPUT bytes.
+	Return the position after the last request run, the end of the input once a text line is too long, or -1 if a frame
+	is too large or the memory could not be allocated.
+*/
+int runTextRequests(Server* server, Connection* connection, int start)
+{
+	while (!connection->closing && connection->output.size - connection->outputStart < SERVER_MAX_OUTPUT)
+	{
+		char* line = (char*)connection->input.data + start;
+		char* newline = memchr(line, '\n', connection->input.size - start);
+		int length = newline == NULL ? connection->input.size - start : (int)(newline - line);
+
+		// the rest of the input is dropped with the connection
+		if (length > SERVER_MAX_LINE)
+		{
+			char text[64];
+			int textLength = snprintf(text, sizeof(text), "Line %d: the line is too long!\n", ++connection->lines);
+
+			server->requests++;
+			connection->closing = 1;
+			return appendReply(connection, "INVALID", text, textLength) == -1 ? -1 : connection->input.size;
+		}
+
+		if (newline == NULL)
+			break;
+
+		start += (int)(newline - line) + 1;
+		if (newline > line && newline[-1] == '\r')
+			newline--;
+		*newline = 0;
+
+		if (runRequest(server, connection, line) == -1)
+			return -1;
+	}
+
+	return start;
+}
+
+int runBinaryRequests(Server* server, Connection* connection, int start)
+{
+	while (connection->output.size - connection->outputStart < SERVER_MAX_OUTPUT)
+	{
+		int size = frameSize(connection->input.data + start, connection->input.size - start);
+
+		if (size == -1)
+			return -1;
+		if (size == 0)
+			break;
+
+		server->requests++;
+		if (server->replica != NULL && server->replica->stale)
+		{
+			ByteReader reader;
+			initByteReader(&reader, connection->input.data + start + 4, size - 4);
+			endFrame(&connection->output, beginFrame(&connection->output, getU32(&reader), RESPONSE_FAILED));
+			if (connection->output.failed)
+				return -1;
+		}
+		else
+		{
+			int readOnly = beginSession(server, connection);
+			int status = serveBinaryRequest(server->ui->materialServices, connection->input.data + start + 4, size - 4, &connection->output);
+			endSession(server, connection, readOnly);
+			if (status == -1)
+				return -1;
+		}
+		start += size;
+	}
+
+	return start;
+}
+
+/*
+	Answers the hello of a follower with the last group committed, and takes its acknowledgements.
+*/
+int runJournalRequests(Server* server, Connection* connection, int start)
+{
+	Journal* journal = &server->journal;
+	ByteReader reader;
+	int size;
+
+	while ((size = frameSize(connection->input.data + start, connection->input.size - start)) > 0)
+	{
+		initByteReader(&reader, connection->input.data + start + 4, size - 4);
+		uint32_t seq = getU32(&reader);
+		uint8_t type = getU8(&reader);
+
+		if (type == JOURNAL_HELLO && connection->shipped == -2)
+		{
+			uint32_t id = getU32(&reader);
+			int position = id == journal->id ? findJournalGroup(journal, seq) : -1;
+
+			// the follower is sent the groups it misses from the journal if they are still there, or a snapshot
+			connection->shipped = position == -1 ? -1 : journal->base + position;
+			connection->acked = position == -1 ? 0 : seq;
+
+			int frame = beginFrame(&connection->output, journal->seq, JOURNAL_HELLO);
+			putU32(&connection->output, journal->id);
+			endFrame(&connection->output, frame);
+		}
+		else if (type == JOURNAL_ACK && connection->shipped != -2)
+			connection->acked = seq;
+		else
+			return -1;
+
+		if (reader.failed || reader.position != reader.size)
+			return -1;
+		start += size;
+	}
+
+	return size == -1 || connection->output.failed ? -1 : start;
+}
+
+/*
+	Runs the requests received whole, the rest of them are run once the replies are written.
+	Returns 1 on success, or -1 if the connection has to be closed.
+*/
+int runRequests(Server* server, Connection* connection)
+{
+	int start = 0;
+
+	if (connection->protocol == PROTOCOL_UNKNOWN && connection->input.size > 0)
+	{
+		connection->protocol = connection->input.data[0] == PROTOCOL_MAGIC ? PROTOCOL_BINARY :
+			connection->input.data[0] == JOURNAL_MAGIC ? PROTOCOL_JOURNAL : PROTOCOL_TEXT;
+		if (connection->protocol != PROTOCOL_TEXT)
+			start = 1;
+
+		// a replica is not followed in turn, its changes are not journaled
+		if (connection->protocol == PROTOCOL_JOURNAL && server->replica != NULL)
+			return -1;
+		if (connection->protocol == PROTOCOL_JOURNAL)
+			server->followers++;
+	}
+
+	if (connection->protocol == PROTOCOL_TEXT)
+		start = runTextRequests(server, connection, start);
+	else if (connection->protocol == PROTOCOL_BINARY)
+		start = runBinaryRequests(server, connection, start);
+	else if (connection->protocol == PROTOCOL_JOURNAL)
+		start = runJournalRequests(server, connection, start);
+
+	if (start == -1)
+		return -1;
+
+	memmove(connection->input.data, connection->input.data + start, connection->input.size - start);
+	connection->input.size -= start;
+
+	return 1;
+}
+
+/*
+	Writes as much of the replies as the socket accepts.
+	Returns 1 on success, or -1 if the client is gone.
+*/
+int writeReplies(Connection* connection)
+{
+	while (connection->outputStart < connection->output.size)
+	{
+		ssize_t count = send(connection->socket, connection->output.data + connection->outputStart,
+			connection->output.size - connection->outputStart, MSG_NOSIGNAL);
+
+		if (count == -1)
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : -1;
+
+		connection->outputStart += (int)count;
+	}
+
+	connection->outputStart = 0;
+	connection->output.size = 0;
+	return 1;
+}
+
+int updateConnection(Server* server, Connection* connection);
+
+/*
+	Reads the bytes sent by the client, runs the lines completed by them and writes the replies.
+	Returns 1 on success, or -1 if the connection has to be closed.
+*/
+int serveConnection(Server* server, Connection* connection, int events)
+{
+	if (events & EPOLLOUT)
+	{
+		if (writeReplies(connection) == -1)
+			return -1;
+		if (runRequests(server, connection) == -1)
+			return -1;
+	}
+
+	if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+	{
+		if (reserveBuffer(&connection->input, SERVER_READ_SIZE) == -1)
+			return -1;
+
+		ssize_t count = recv(connection->socket, connection->input.data + connection->input.size, SERVER_READ_SIZE, 0);
+
+		if (count == 0 || (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+			return -1;
+
+		if (count > 0)
+			connection->input.size += (int)count;
+		if (runRequests(server, connection) == -1)
+			return -1;
+	}
+
+	return updateConnection(server, connection);
+}
+
+/*
+	Writes the replies, and waits for the client to accept more of them, or to send more requests.
+	Returns 1 on success, or -1 if the connection has to be closed.
+*/
+int updateConnection(Server* server, Connection* connection)
+{
+	if (writeReplies(connection) == -1)
+		return -1;
+
+	int pending = connection->output.size - connection->outputStart;
+	if (connection->closing && pending == 0)
+		return -1;
+
+	// a client that does not read its replies is not read from either, until they are written
+	int wanted = (pending > 0 ? EPOLLOUT : 0) | (pending < SERVER_MAX_OUTPUT && !connection->closing ? EPOLLIN : 0);
+	if (wanted != connection->events)
+	{
+		struct epoll_event event = { (uint32_t)wanted, { .ptr = connection } };
+		if (epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->socket, &event) == -1)
+			return -1;
+		connection->events = wanted;
+	}
+
+	return 1;
+}
+
+/*
+	Sends every follower the groups committed since it was last sent some, or a snapshot of the repository if the
+	journal does not have them anymore. A snapshot waits for the end of an active transaction, and a follower that
+	does not read what it is sent is not sent more until it does.
+*/
+void shipJournal(Server* server)
+{
+	Journal* journal = &server->journal;
+	MaterialServices* materialServices = server->ui->materialServices;
+	long long end = journal->base + committedSize(journal);
+	Connection* next;
+
+	for (Connection* connection = server->first; connection != NULL; connection = next)
+	{
+		next = connection->next;
+
+		if (connection->protocol != PROTOCOL_JOURNAL || connection->shipped == -2 || connection->shipped == end ||
+			connection->output.size - connection->outputStart >= SERVER_MAX_OUTPUT)
+			continue;
+
+		if (connection->shipped >= journal->base)
+			putBytes(&connection->output, journal->records.data + (connection->shipped - journal->base), (int)(end - connection->shipped));
+		else if (materialServices->transaction == 0)
+			writeSnapshot(&connection->output, materialServices->materialRepo, journal->seq);
+		else
+			continue;
+
+		connection->shipped = end;
+		if (connection->output.failed || updateConnection(server, connection) == -1)
+			closeConnection(server, connection);
+	}
+}
+
+/*
+	Connects the replica to its leader, if it is not connected.
+*/
+void connectLeader(Server* server)
+{
+	Replica* replica = server->replica;
+
+	if (replica->socket != -1 || connectReplica(replica) == -1)
+		return;
+
+	struct epoll_event event = { EPOLLIN, { .ptr = replica } };
+	if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, replica->socket, &event) == -1)
+		disconnectReplica(replica);
+}
+
+int followLeader(Server* server, Replica* replica)
+{
+	if (server == NULL || replica == NULL)
+		return -1;
+
+	server->replica = replica;
+	connectLeader(server);
+
+	return 1;
+}
+
+int runServer(Server* server)
+{
+	struct epoll_event events[SERVER_MAX_EVENTS];
+
+	if (server == NULL)
+		return -1;
+
+	while (!atomic_load(&server->stopping))
+	{
+		int disconnected = server->replica != NULL && server->replica->socket == -1;
+		int count = epoll_wait(server->epoll, events, SERVER_MAX_EVENTS, disconnected ? REPLICA_RETRY_MS : -1);
+
+		if (count == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			void* source = events[i].data.ptr;
+
+			if (source == &server->listener)
+				acceptConnections(server);
+			else if (source == &server->wakeup)
+			{
+				uint64_t value;
+				if (read(server->wakeup, &value, sizeof(value)) == -1)
+					continue;
+			}
+			else if (source == server->replica)
+			{
+				if (pumpReplica(server->replica) == -1)
+					disconnectReplica(server->replica);
+			}
+			else if (serveConnection(server, source, events[i].events) == -1)
+				closeConnection(server, source);
+		}
+
+		if (server->followers > 0)
+			shipJournal(server);
+		if (server->replica != NULL)
+			connectLeader(server);
+	}
+
+	return 1;
+}
+
+void stopServer(Server* server)
+{
+	if (server == NULL)
+		return;
+
+	uint64_t value = 1;
+
+	atomic_store(&server->stopping, 1);
+	if (write(server->wakeup, &value, sizeof(value)) == -1)
+		return;
+}
+
+void freeServer(Server* server)
+{
+	if (server == NULL)
+		return;
+
+	while (server->first != NULL)
+		closeConnection(server, server->first);
+	if (server->replica != NULL)
+		disconnectReplica(server->replica);
+	server->replica = NULL;
+
+	close(server->listener);
+	close(server->epoll);
+	close(server->wakeup);
+	unlink(server->path);
+
+	setOutput(server->ui, stdout);
+	fclose(server->output);
+	free(server->outputText);
+	server->output = NULL;
+	server->outputText = NULL;
+
+	attachJournal(server->ui->materialServices, NULL);
+	freeJournal(&server->journal);
+}
+
+
+//Tests
+
+
+int serveThread(void* server)
+{
+	return runServer((Server*)server);
+}
+
+int connectClient(const char* path)
+{
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	int client = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert(client != -1);
+	assert(connect(client, (struct sockaddr*)&address, sizeof(address)) == 0);
+
+	return client;
+}
+
+/*
+	Sends the lines and reads the replies, until the server closes the connection.
+	Returns the number of bytes read.
+*/
+int exchangeLines(int client, const char* lines, char* replies, int capacity)
+{
+	int length = 0;
+	ssize_t count;
+
+	assert(send(client, lines, strlen(lines), MSG_NOSIGNAL) == (ssize_t)strlen(lines));
+
+	while ((count = recv(client, replies + length, capacity - 1 - length, 0)) > 0)
+		length += (int)count;
+	replies[length] = 0;
+
+	close(client);
+	return length;
+}
+
+void testServer()
+{
+	Server server;
+	thrd_t thread;
+	char path[SERVER_PATH_SIZE];
+	char replies[1024], table[512], expected[1024];
+	int result;
+
+	snprintf(path, sizeof(path), "/tmp/bakery-test-%d.sock", (int)getpid());
+
+	MaterialRepo* materialRepo = createMaterialRepo(10);
+	UI* ui = createUI(createMaterialServices(materialRepo));
+
+	if (initServer(&server, ui, path) == -1)
+	{
+		destroyUI(ui);
+		return;
+	}
+	assert(thrd_create(&thread, &serveThread, &server) == thrd_success);
+
+	// the lines are sent at once, and answered in order
+	int client = connectClient(path);
+	exchangeLines(client, "add Eggs Farm 3 1 1 2030\r\nlist\n\nbogus\nquit\nlist\n", replies, sizeof(replies));
+
+	int length = snprintf(table, sizeof(table), "%-3s %20s %20s %20s %30s\n", "NR", "NAME", "SUPPLIER", "QUANTITY", "EXPIRATION_DATE");
+	length += snprintf(table + length, sizeof(table) - length, "%-3d %20s %20s %*.4lf %20d/%d/%d\n", 1, "Eggs", "Farm", 20, 3.0, 1, 1, 2030);
+	snprintf(expected, sizeof(expected), "OK 0\nOK %d\n%sOK 0\nINVALID 25\nLine 4: invalid command!\nOK 0\n", length, table);
+	assert(strcmp(replies, expected) == 0);
+
+	// the binary requests are sent at once, and answered in one write
+	ByteBuffer requests;
+	initByteBuffer(&requests);
+	putU8(&requests, PROTOCOL_MAGIC);
+	for (uint32_t id = 1; id <= 2; id++)
+	{
+		int frame = beginFrame(&requests, id, REQUEST_LOOKUP);
+		putStringField(&requests, "Eggs");
+		putStringField(&requests, "Farm");
+		putDateField(&requests, id, 1, 2030);
+		endFrame(&requests, frame);
+	}
+
+	client = connectClient(path);
+	assert(send(client, requests.data, requests.size, MSG_NOSIGNAL) == requests.size);
+	for (length = 0; length < 46; length += (int)result)
+		assert((result = (int)recv(client, replies + length, sizeof(replies) - length, 0)) > 0);
+	close(client);
+	freeByteBuffer(&requests);
+
+	assert(length == 46 && frameSize((unsigned char*)replies, length) == 37 && frameSize((unsigned char*)replies + 37, 9) == 9);
+	assert(replies[4] == 1 && replies[8] == RESPONSE_OK && replies[9] == 1);
+	assert(replies[37 + 4] == 2 && replies[37 + 8] == RESPONSE_FAILED);
+
+	// the layout and the transaction of a client are its own: the others cannot write into the transaction, and it
+	// is rolled back when its client leaves, while their writes stay
+	int session = connectClient(path);
+	const char* opening = "format csv\nbegin\nadd Tmp Shop 1 1 1 2030\n";
+	assert(send(session, opening, strlen(opening), MSG_NOSIGNAL) == (ssize_t)strlen(opening));
+	for (length = 0; length < 15; length += (int)result)
+		assert((result = (int)recv(session, replies + length, sizeof(replies) - length, 0)) > 0);
+	assert(strncmp(replies, "OK 0\nOK 0\nOK 0\n", 15) == 0);
+
+	client = connectClient(path);
+	exchangeLines(client, "add Milk Dairy 2 1 1 2030\ncommit\nhistory 5\nlist\nquit\n", replies, sizeof(replies));
+	assert(strncmp(replies, "FAILED 20\nLine 1: add failed!\nFAILED 23\nLine 2: commit failed!\nFAILED", 69) == 0);
+	assert(strstr(replies, "NAME") != NULL && strstr(replies, "Tmp") != NULL);
+	exchangeLines(session, "quit\n", replies, sizeof(replies));
+
+	client = connectClient(path);
+	exchangeLines(client, "add Milk Dairy 2 1 1 2030\nlist\nquit\n", replies, sizeof(replies));
+	assert(strncmp(replies, "OK 0\n", 5) == 0 && strstr(replies, "Milk") != NULL && strstr(replies, "Tmp") == NULL);
+	assert(strstr(replies, "NAME") != NULL && server.transaction == NULL);
+
+	// a line that does not end within SERVER_MAX_LINE bytes closes the connection
+	char line[SERVER_MAX_LINE + 2];
+	memset(line, 'a', SERVER_MAX_LINE + 1);
+	line[SERVER_MAX_LINE + 1] = 0;
+	client = connectClient(path);
+	exchangeLines(client, line, replies, sizeof(replies));
+	assert(strcmp(replies, "INVALID 30\nLine 1: the line is too long!\n") == 0);
+
+	client = connectClient(path);
+	exchangeLines(client, "delete Eggs Farm 2 1 2030\nshutdown\n", replies, sizeof(replies));
+	assert(strcmp(replies, "FAILED 23\nLine 1: delete failed!\nOK 0\n") == 0);
+
+	assert(thrd_join(thread, &result) == thrd_success && result == 1);
+	assert(server.requests == 22);
+
+	freeServer(&server);
+	assert(ui->output == stdout);
+	destroyUI(ui);
+}
+
+#else
+
+int initServer(Server* server, UI* ui, const char* path)
+{
+	return -1;
+}
+
+int followLeader(Server* server, struct Replica* replica)
+{
+	return -1;
+}
+
+int runServer(Server* server)
+{
+	return -1;
+}
+
+void stopServer(Server* server)
+{
+}
+
+void freeServer(Server* server)
+{
+}
+
+void testServer()
+{
+}
+
+#endif
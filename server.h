@@ -0,0 +1,129 @@
+#pragma once
+
+#include "ui.h"
+#include "protocol.h"
+#include "journal.h"
+#include "changeFeed.h"
+
+#include <stdio.h>
+
+#define SERVER_MAX_EVENTS 64
+#define SERVER_READ_SIZE (1 << 16)
+#define SERVER_MAX_OUTPUT (1 << 24)
+#define SERVER_MAX_LINE (16 * MAX_STRING_SIZE)
+#define SERVER_PATH_SIZE 108
+
+typedef enum ConnectionProtocol
+{
+	PROTOCOL_UNKNOWN,
+	PROTOCOL_TEXT,
+	PROTOCOL_BINARY,
+	PROTOCOL_JOURNAL
+} ConnectionProtocol;
+
+/*
+	A client of the server, with the bytes it sent that do not form a whole request yet and the replies that could not
+	be written to it yet, from outputStart on.
+	protocol - chosen by the first byte the client sends: PROTOCOL_MAGIC for the binary protocol (see RequestType),
+		JOURNAL_MAGIC for a follower (see Replica), any other byte for the text one
+	lines - the number of lines received, which the failed commands are reported with
+	layout - the layout the materials listed for the client are written in, see the format command
+	events - the epoll events the socket is waited for
+	closing - 1 once the client quit, the connection is closed when the replies are written
+	shipped - for a follower, the offset in the journal that the records it was sent end at, -1 if it is sent
+		a snapshot next, or -2 until it says which group it applied last
+	acked - for a follower, the last group it applied
+	previous, next - the connections are kept in a list, so they can be closed when the server is freed
+*/
+typedef struct Connection
+{
+	int socket;
+	ByteBuffer input, output;
+	int outputStart;
+	ConnectionProtocol protocol;
+	int lines;
+	RowLayout layout;
+	int events, closing;
+	long long shipped;
+	uint32_t acked;
+	struct Connection* previous;
+	struct Connection* next;
+} Connection;
+
+/*
+	Serves the batch commands (see runBatch) to the clients of a Unix domain socket, from a single thread that waits
+	for all of them with epoll. In the text protocol every line received is a command, answered in order with a
+	header line "<status> <length>\n" followed by length bytes of output, where status is OK, INVALID or FAILED.
+	The binary protocol carries the same operations in length prefixed frames (see RequestType). In both, a client
+	may send many requests without waiting for their replies, and the replies to all the requests read at once are
+	written at once.
+	Every client has a session of its own: its row layout, and the transaction it began, which is rolled back if it
+	disconnects before the commit. While a transaction is open, the other clients read its uncommitted changes but
+	their writes, commits and rollbacks fail, so they cannot join it. The history command is refused, as the history
+	limit would change for every client.
+	A text line longer than SERVER_MAX_LINE bytes is answered with INVALID and its connection is closed, so a client
+	cannot make the server buffer an endless line.
+	The commands are run one at a time, as their lines arrive, so the writes of the clients are serialized, while the
+	clients read through the query cache between them. A client reading a large result does not hold the others
+	back: its reply is written as the socket accepts it.
+	Three more commands are understood: quit closes the connection, shutdown stops the server and closes the
+	connection it came from, and replication prints the state of the journal and of the followers, or of the replica.
+	The changes of the repository are recorded in the journal of the server and sent to the followers once per wait,
+	as they are committed. A server that follows a leader (see followLeader) serves its replica instead, read-only,
+	and does not accept followers itself; while the replica is stale (see Replica), every request fails.
+	output - the stream that the output of a command is captured in, before it is copied to the client
+	followers - the number of connections of followers
+	transaction - the connection whose transaction is open, or NULL
+	replica - the replica of the leader the server follows, or NULL
+*/
+typedef struct Server
+{
+	UI* ui;
+	int listener, epoll, wakeup;
+	char path[SERVER_PATH_SIZE];
+	FILE* output;
+	char* outputText;
+	size_t outputSize;
+	Connection* first;
+	int connections, followers;
+	Connection* transaction;
+	long long requests;
+	atomic_int stopping;
+	Journal journal;
+	struct Replica* replica;
+} Server;
+
+/*
+	Creates the socket at the given path, replacing any socket left there, and starts listening on it.
+	The output of the commands of the UI is captured until the server is freed, and the changes of its repository are
+	recorded in the journal of the server.
+	Returns 1 on success, or -1 if the socket could not be created or the platform has no epoll.
+*/
+int initServer(Server* server, UI* ui, const char* path);
+
+/*
+	Makes the server serve the replica, which it keeps up to date from its leader: the leader is connected to
+	at once, and again every REPLICA_RETRY_MS milliseconds while it cannot be reached.
+	Returns 1 on success, or -1 if the platform has no epoll.
+*/
+int followLeader(Server* server, struct Replica* replica);
+
+/*
+	Accepts the clients and answers their commands until the server is stopped.
+	Returns 1 on success, or -1 if waiting for the clients failed.
+*/
+int runServer(Server* server);
+
+/*
+	Makes runServer return after the command it is running. It can be called from another thread or a signal handler.
+*/
+void stopServer(Server* server);
+
+/*
+	Closes the connections and the socket, sends the output of the UI back to the standard output and frees the
+	journal. A replica is disconnected, not freed.
+*/
+void freeServer(Server* server);
+
+//Tests
+void testServer();
@@ -1,15 +1,42 @@
 #pragma once
 
 #include "repository.h"
+#include "orderBy.h"
+#include "query.h"
+#include "planner.h"
+#include "queryCache.h"
+#include "recipe.h"
+#include "alert.h"
+#include "changeFeed.h"
 
 #define MAX_COMMAND_SIZE 32
 #define MAX_STRING_SIZE 64
+#define COMPLETE_LIMIT 5
+#define SUGGEST_DISTANCE 3
+#define HISTOGRAM_PERIODS 12
 
+/*
+	journal - records the changes of the repository, or NULL, see attachJournal
+	readOnly - 1 for the services of a follower, whose repository is only changed by the journal of its leader (see
+		applyJournalRecord), or while a client of a server runs requests during the transaction of another client
+		(see Server): every operation that would change it fails, commits and rollbacks included, without marking
+		the active transaction as failed
+	historyLimit - the number of undo steps kept, or -1 to keep all of them, see setHistoryLimit
+*/
 typedef struct MaterialServices
 {
 	int index;
+	int transaction, transactionStatus;
 	DynamicArray* repoStack;
 	MaterialRepo* materialRepo;
+	long long version;
+	QueryCache queryCache;
+	HashMap* recipes;
+	AlertMonitor alerts;
+	ChangeFeed changes;
+	struct Journal* journal;
+	int readOnly;
+	int historyLimit;
 } MaterialServices;
 
 MaterialServices* createMaterialServices(MaterialRepo* materialRepo);
@@ -17,18 +44,193 @@ void destroyMaterialServices(MaterialServices* materialServices);
 void initMaterialRepo(MaterialServices* materialServices);
 
 Material* getMaterial(MaterialServices* materialServices, int position);
+
+/*
+	Finds the lot with the given name, supplier and expiration date among the lots of the name.
+	Returns the material, owned by the repository, or NULL if there is no such lot.
+*/
+Material* findLot(MaterialServices* materialServices, const char* name, const char* supplier, int day, int month, int year);
 DynamicArray* getExpired(MaterialServices* materialServices, int (*filterFunction)(Material*, char*), char* filter);
 DynamicArray* getSortedAscending(MaterialServices* materialServices);
+DynamicArray* getSortedByDate(MaterialServices* materialServices);
+DynamicArray* getOrdered(MaterialServices* materialServices, const OrderBy* orderBy);
+DynamicArray* getQueryResult(MaterialServices* materialServices, const Query* query);
+int explain(MaterialServices* materialServices, const Query* query, QueryPlan* plan);
 DynamicArray* getShort(MaterialServices* materialServices, int (*compareFunction)(Material*, Material*), char* filterSupplier, double filterQuantity);
 
+/*
+	Top-K variants of getExpired and getShort: only the first limit materials are returned, selected with a bounded heap.
+	The expired materials are ordered by expiration date, soonest first, then by name and supplier, with or without a
+	limit. A limit of 0 returns every material, like getExpired and getShort do.
+*/
+DynamicArray* getExpiredTop(MaterialServices* materialServices, int (*filterFunction)(Material*, char*), char* filter, int limit);
+DynamicArray* getShortTop(MaterialServices* materialServices, int (*compareFunction)(Material*, Material*), char* filterSupplier, double filterQuantity, int limit);
+
+/*
+	Build the queries behind getExpiredTop and getShortTop.
+	Returns 1 on success, or -1 if the arguments are not valid. If the comparator of buildShortQuery is not
+	less or greater, the query only gets its filters and -1 is returned, as no order stage can express it.
+*/
+int buildExpiredQuery(Query* query, int (*filterFunction)(Material*, char*), char* filter, int limit);
+int buildShortQuery(Query* query, int (*compareFunction)(Material*, Material*), char* filterSupplier, double filterQuantity, int limit);
+
+/*
+	Runs the query through the query cache. The result is a new dynamic array of pointers to the materials of the
+	repository: it does not own them, so it is only valid until the next operation that modifies the repository
+	(add, update, rem, undo, redo, or a transaction).
+	Every modification bumps the version of the repository, which invalidates the cached results.
+	Returns NULL if an error occured.
+*/
+DynamicArray* getQueryView(MaterialServices* materialServices, const Query* query);
+
+/*
+	Gets the materials grouped by name (bySupplier 0) or by supplier (bySupplier 1), sorted by key. The total quantity
+	and the number of expired lots of every group are maintained by the repository, so only the groups are visited.
+	The result is a new dynamic array of HashEntry pointers (key - the name or supplier, value - its MaterialGroup)
+	that does not own them, valid until the next operation that modifies the repository.
+	Returns NULL if an error occured.
+*/
+DynamicArray* getTotals(MaterialServices* materialServices, int bySupplier);
+
+/*
+	Gets the names (bySupplier 0) or the suppliers (bySupplier 1) starting with the prefix that have the largest
+	total quantities, largest first, from the prefix tries of the repository.
+	groups - receives at most limit groups, owned by the repository and valid until the next modification
+	Returns the number of groups, or -1 if an error occured.
+*/
+int getCompletions(MaterialServices* materialServices, const char* prefix, int bySupplier, int limit, MaterialGroup** groups);
+
+/*
+	Gets the names within SUGGEST_DISTANCE edits of the given name, ignoring the case, closest first.
+	groups, distances - receive at most limit name groups, owned by the repository, and their edit distances
+	Returns the number of names, or -1 if an error occured.
+*/
+int getSuggestions(MaterialServices* materialServices, const char* name, int limit, MaterialGroup** groups, int* distances);
+
+/*
+	Builds a histogram of the materials expiring from today on, by weeks (byMonth 0) or calendar months (byMonth 1),
+	from the expiration calendar of the repository.
+	bins - receives count periods, the first one containing today
+	Returns 1 on success, or -1 if an error occured.
+*/
+int getExpiryHistogram(MaterialServices* materialServices, int byMonth, int count, CalendarBin* bins);
+
 int add(MaterialServices* materialServices, char* name, char* supplier, double quantity, int day, int month, int year);
 int update(MaterialServices* materialServices, 
 			char* name, char* supplier, int day, int month, int year, 
 			char* newName, char* newSupplier, double newQuantity, int newDay, int newMonth, int newYear);
 int rem(MaterialServices* materialServices, char* name, char* supplier, int day, int month, int year);
 
+/*
+	Starts a transaction: the add/update/rem operations performed until the commit share a single snapshot
+	of the repository, so they are recorded as one undo step.
+	Returns 1 on success, or -1 if a transaction is already active.
+*/
+int beginTransaction(MaterialServices* materialServices);
+
+/*
+	Ends the active transaction. If any operation of the transaction failed, the whole batch is rolled back.
+	Returns 1 if the batch was applied, or -1 if there is no active transaction or the batch was rolled back.
+*/
+int commitTransaction(MaterialServices* materialServices);
+
+/*
+	Discards every operation performed since the start of the active transaction.
+	Returns 1 on success, or -1 if there is no active transaction.
+*/
+int rollbackTransaction(MaterialServices* materialServices);
+
+/*
+	Consumes a quantity of the material with the given name, from the lots expiring first, as one undo step.
+	Returns 1 on success, or -1 if the name is unknown or there is not enough of it, in which case nothing changes.
+*/
+int consume(MaterialServices* materialServices, char* name, double quantity);
+
+/*
+	Stores a copy of the recipe under the given name, replacing the previous recipe with that name.
+	The recipes are not part of the repository, so they are not affected by undo and redo.
+	Returns 1 on success, or -1 if the arguments are not valid or the memory could not be allocated.
+*/
+int defineRecipe(MaterialServices* materialServices, const char* name, const Recipe* recipe);
+
+/*
+	Gets the recipe with the given name, or NULL if there is no such recipe.
+*/
+Recipe* getRecipe(MaterialServices* materialServices, const char* name);
+
+/*
+	Produces count units of a recipe: every ingredient is consumed from the lots expiring first, all of them
+	as one undo step. The stock of every ingredient is checked before anything changes.
+	shortfalls - receives the ingredients that are not available in the needed quantity, with the missing quantities;
+		it must have room for MAX_INGREDIENTS ingredients
+	shortfallCount - receives the number of shortfalls
+	Returns 1 on success, or -1 if the recipe is unknown or some ingredient is short, in which case nothing changes.
+*/
+int produce(MaterialServices* materialServices, const char* recipeName, int count, Ingredient* shortfalls, int* shortfallCount);
+
+/*
+	Registers a standing alert rule, see AlertRule. The rules are checked after every modification of the repository,
+	only for the names and suppliers it changed, and after undo and redo; during a transaction they are checked
+	once, when it is committed. The alerts are queued until they are taken with takeAlert.
+	Returns 1 on success, or -1 if the rule is not valid or there are already MAX_ALERT_RULES rules.
+*/
+int addAlert(MaterialServices* materialServices, const AlertRule* rule);
+
+/*
+	Takes the oldest queued alert.
+	Returns 1 on success, or 0 if there are no alerts.
+*/
+int takeAlert(MaterialServices* materialServices, Alert* alert);
+
+/*
+	Attaches a consumer to the change feed of the services: every successful add, update, rem, consume, produce and
+	applyDiff, every undo and redo, and the start and end of every transaction is published to it, see ChangeFeed.
+	The consumer may read the feed from another thread.
+	Returns the id of the consumer, or -1 if MAX_FEED_CONSUMERS consumers are already attached.
+*/
+int subscribe(MaterialServices* materialServices);
+
+/*
+	Records every change of the repository in the journal from now on (see Journal), or stops recording them if the
+	journal is NULL. Every operation is committed to it as a group, a transaction as a single one when it is committed.
+	The journal is not owned by the services.
+*/
+void attachJournal(MaterialServices* materialServices, struct Journal* journal);
+
+/*
+	Gets the hash of the lots of the repository, the root of its Merkle tree (see getMerkleTree), and their number:
+	two inventories holding the same lots have the same hash, whatever their order.
+	Returns 1 on success, or -1 if the memory for the tree could not be allocated.
+*/
+int getInventoryHash(MaterialServices* materialServices, uint64_t* hash, int* lots);
+
+/*
+	Finds the buckets of lots in which two inventories differ, see diffMerkleTrees. The lots of these buckets, written
+	by exportDiff from one inventory, make the other one hold the same lots when they are applied with applyDiff.
+	buckets - receives the buckets in increasing order; it must have room for MERKLE_LEAVES buckets
+	Returns the number of buckets, or -1 if the memory for a tree could not be allocated.
+*/
+int diffInventories(MaterialServices* x, MaterialServices* y, int* buckets);
+
+/*
+	Replaces the lots of every bucket of the diff with the lots the diff gives it (see exportDiff), as one undo step.
+	The whole diff is checked before anything changes.
+	Returns 1 on success, or -1 if the diff is not valid or the memory could not be allocated, in which case nothing
+	changes.
+*/
+int applyDiff(MaterialServices* materialServices, const unsigned char* diff, int size);
+
 int undo(MaterialServices* materialServices);
 int redo(MaterialServices* materialServices);
 
+/*
+	Keeps at most limit undo steps, dropping the oldest ones, or all of them for a limit of -1 (the default).
+	With a limit of 0 the operations outside transactions change the repository in place, without copying it first,
+	so they cannot be undone, and a produce or applyDiff that runs out of memory halfway keeps its partial changes;
+	a transaction still copies it once, to roll back to.
+	Returns 1 on success, or -1 if the limit is not valid.
+*/
+int setHistoryLimit(MaterialServices* materialServices, int limit);
+
 //Tests
 void testMaterialServices();
@@ -0,0 +1,190 @@
+#include "statistics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#define QUANTITY_MIN_BUCKET -64
+#define QUANTITY_MAX_BUCKET 64
+
+
+void initHistogram(Histogram* histogram)
+{
+	histogram->base = 0;
+	histogram->size = 0;
+	histogram->total = 0;
+	histogram->counts = NULL;
+}
+
+void freeHistogram(Histogram* histogram)
+{
+	free(histogram->counts);
+	initHistogram(histogram);
+}
+
+int growHistogram(Histogram* histogram, int bucket)
+{
+	int low = histogram->base, high = histogram->base + histogram->size;
+
+	if (histogram->size == 0)
+	{
+		low = bucket;
+		high = bucket + 1;
+	}
+	if (bucket < low)
+		low = bucket - histogram->size / 2;
+	if (bucket >= high)
+		high = bucket + 1 + histogram->size / 2;
+
+	int* counts = (int*)calloc(high - low, sizeof(int));
+
+	if (counts == NULL)
+		return -1;
+
+	if (histogram->size > 0)
+		memcpy(counts + (histogram->base - low), histogram->counts, sizeof(int) * histogram->size);
+
+	free(histogram->counts);
+	histogram->counts = counts;
+	histogram->base = low;
+	histogram->size = high - low;
+
+	return 1;
+}
+
+int addToHistogram(Histogram* histogram, int bucket, int delta)
+{
+	if (histogram->size == 0 || bucket < histogram->base || bucket >= histogram->base + histogram->size)
+		if (growHistogram(histogram, bucket) == -1)
+			return -1;
+
+	histogram->counts[bucket - histogram->base] += delta;
+	histogram->total += delta;
+
+	return 1;
+}
+
+int histogramCount(const Histogram* histogram, int bucket)
+{
+	if (bucket < histogram->base || bucket >= histogram->base + histogram->size)
+		return 0;
+
+	return histogram->counts[bucket - histogram->base];
+}
+
+int histogramCountBelow(const Histogram* histogram, int bucket)
+{
+	int count = 0;
+
+	for (int i = 0; i < histogram->size && histogram->base + i < bucket; i++)
+		count += histogram->counts[i];
+
+	return count;
+}
+
+int expiryBucket(const Date* date)
+{
+	return getYear(date) * 12 + getMonth(date) - 1;
+}
+
+int quantityBucket(double quantity)
+{
+	if (!(quantity > 0))
+		return QUANTITY_MIN_BUCKET;
+
+	int exponent;
+	frexp(quantity, &exponent);
+
+	if (exponent < QUANTITY_MIN_BUCKET + 1)
+		return QUANTITY_MIN_BUCKET + 1;
+	if (exponent > QUANTITY_MAX_BUCKET)
+		return QUANTITY_MAX_BUCKET;
+
+	return exponent;
+}
+
+double estimateExpired(const Histogram* expiryHistogram, int today)
+{
+	int year = today >> 9, month = (today >> 5) & 15, day = today & 31;
+	int bucket = year * 12 + month - 1;
+
+	// the dates of the current month are assumed to be spread evenly over 31 days
+	return histogramCountBelow(expiryHistogram, bucket) + histogramCount(expiryHistogram, bucket) * (day - 1) / 31.0;
+}
+
+double estimateLessThan(const Histogram* quantityHistogram, double quantity)
+{
+	int bucket = quantityBucket(quantity);
+	double estimate = histogramCountBelow(quantityHistogram, bucket);
+
+	if (bucket == QUANTITY_MIN_BUCKET)
+		return estimate;
+
+	// the bucket of exponent e holds the quantities from [2^(e-1), 2^e)
+	double low = ldexp(1, bucket - 1);
+	double fraction = (quantity - low) / low;
+	if (fraction > 1)
+		fraction = 1;
+
+	return estimate + histogramCount(quantityHistogram, bucket) * fraction;
+}
+
+
+//Tests
+
+
+void testHistogram()
+{
+	Histogram histogram;
+	initHistogram(&histogram);
+
+	assert(histogramCount(&histogram, 5) == 0);
+	assert(addToHistogram(&histogram, 5, 2) == 1);
+	assert(addToHistogram(&histogram, -3, 1) == 1);
+	assert(addToHistogram(&histogram, 40, 4) == 1);
+	assert(addToHistogram(&histogram, 5, -1) == 1);
+
+	assert(histogram.total == 6);
+	assert(histogramCount(&histogram, 5) == 1);
+	assert(histogramCount(&histogram, -3) == 1);
+	assert(histogramCount(&histogram, 40) == 4);
+	assert(histogramCountBelow(&histogram, 5) == 1);
+	assert(histogramCountBelow(&histogram, 6) == 2);
+	assert(histogramCountBelow(&histogram, 100) == 6);
+
+	freeHistogram(&histogram);
+}
+
+void testEstimates()
+{
+	Histogram expiry, quantity;
+	initHistogram(&expiry);
+	initHistogram(&quantity);
+
+	Date* dates[] = { createDate(1, 1, 2020), createDate(15, 6, 2021), createDate(20, 6, 2021), createDate(1, 1, 2030) };
+	double quantities[] = { 0, 1.5, 3, 100 };
+
+	for (int i = 0; i < 4; i++)
+	{
+		addToHistogram(&expiry, expiryBucket(dates[i]), 1);
+		addToHistogram(&quantity, quantityBucket(quantities[i]), 1);
+	}
+
+	Date today = { 1, 7, 2021 };
+	assert(estimateExpired(&expiry, dateKey(&today)) == 3);
+	assert(estimateLessThan(&quantity, 1000) == 4);
+	assert(estimateLessThan(&quantity, 0) == 0);
+	assert(estimateLessThan(&quantity, 1.5) > 1 && estimateLessThan(&quantity, 1.5) < 2);
+
+	for (int i = 0; i < 4; i++)
+		destroyDate(dates[i]);
+	freeHistogram(&expiry);
+	freeHistogram(&quantity);
+}
+
+void testStatistics()
+{
+	testHistogram();
+	testEstimates();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "date.h"
+
+/*
+	A histogram over integer buckets that grows in both directions as new buckets are used.
+*/
+typedef struct Histogram
+{
+	int base, size, total;
+	int* counts;
+} Histogram;
+
+void initHistogram(Histogram* histogram);
+void freeHistogram(Histogram* histogram);
+
+/*
+	Adds delta to the count of the bucket.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int addToHistogram(Histogram* histogram, int bucket, int delta);
+
+int histogramCount(const Histogram* histogram, int bucket);
+
+/*
+	Returns the sum of the counts of all the buckets lower than the given one.
+*/
+int histogramCountBelow(const Histogram* histogram, int bucket);
+
+/*
+	Buckets used by the repository statistics: expiration dates are grouped by month,
+	quantities by their power of two (every quantity that is not positive goes to the lowest bucket).
+*/
+int expiryBucket(const Date* date);
+int quantityBucket(double quantity);
+
+/*
+	Estimate the number of materials expired on the given reference date (a dateKey), and the number of
+	materials with a quantity less than the given one, assuming uniform values inside the buckets.
+*/
+double estimateExpired(const Histogram* expiryHistogram, int today);
+double estimateLessThan(const Histogram* quantityHistogram, double quantity);
+
+//Tests
+void testStatistics();
@@ -0,0 +1,215 @@
+#include "topK.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+
+int initTopK(TopK* topK, int k, const OrderBy* orderBy)
+{
+	if (topK == NULL || orderBy == NULL || k < 1)
+		return -1;
+
+	topK->entries = (TopKEntry*)calloc(k, sizeof(TopKEntry));
+
+	if (topK->entries == NULL)
+		return -1;
+
+	topK->k = k;
+	topK->size = 0;
+	topK->offered = 0;
+	topK->orderBy = orderBy;
+	topK->spare.buffer = NULL;
+	topK->spare.capacity = 0;
+
+	return 1;
+}
+
+void freeTopK(TopK* topK)
+{
+	if (topK == NULL || topK->entries == NULL)
+		return;
+
+	for (int i = 0; i < topK->k; i++)
+		free(topK->entries[i].buffer);
+
+	free(topK->spare.buffer);
+	free(topK->entries);
+	topK->entries = NULL;
+	topK->size = 0;
+}
+
+int encodeEntry(TopK* topK, TopKEntry* entry, Material* material)
+{
+	int length = encodeSortKey(topK->orderBy, material, NULL);
+
+	if (length > entry->capacity)
+	{
+		unsigned char* buffer = (unsigned char*)realloc(entry->buffer, length);
+		if (buffer == NULL)
+			return -1;
+		entry->buffer = buffer;
+		entry->capacity = length;
+	}
+
+	encodeSortKey(topK->orderBy, material, entry->buffer);
+	entry->ref.prefix = getKeyPrefix(entry->buffer, length);
+	entry->ref.key = entry->buffer;
+	entry->ref.length = (uint32_t)length;
+	entry->ref.index = topK->offered;
+	entry->material = material;
+
+	return 1;
+}
+
+void swapEntries(TopKEntry* x, TopKEntry* y)
+{
+	TopKEntry aux = *x;
+	*x = *y;
+	*y = aux;
+}
+
+void siftUpTopK(TopK* topK, int position)
+{
+	while (position > 0)
+	{
+		int parent = (position - 1) / 2;
+		if (compareSortKeys(&topK->entries[parent].ref, &topK->entries[position].ref) >= 0)
+			break;
+		swapEntries(&topK->entries[parent], &topK->entries[position]);
+		position = parent;
+	}
+}
+
+void siftDownTopK(TopK* topK, int position, int size)
+{
+	while (2 * position + 1 < size)
+	{
+		int child = 2 * position + 1;
+		if (child + 1 < size && compareSortKeys(&topK->entries[child].ref, &topK->entries[child + 1].ref) < 0)
+			child++;
+		if (compareSortKeys(&topK->entries[position].ref, &topK->entries[child].ref) >= 0)
+			break;
+		swapEntries(&topK->entries[position], &topK->entries[child]);
+		position = child;
+	}
+}
+
+int offerTopK(TopK* topK, Material* material)
+{
+	if (topK == NULL || material == NULL)
+		return -1;
+
+	if (topK->size < topK->k)
+	{
+		if (encodeEntry(topK, &topK->entries[topK->size], material) == -1)
+			return -1;
+		topK->size++;
+		siftUpTopK(topK, topK->size - 1);
+		topK->offered++;
+		return 1;
+	}
+
+	// the candidate is encoded in the spare entry and replaces the root only if it goes before it,
+	// the buffer of the evicted root becomes the new spare
+	int status = encodeEntry(topK, &topK->spare, material);
+
+	if (status == 1 && compareSortKeys(&topK->spare.ref, &topK->entries[0].ref) < 0)
+	{
+		swapEntries(&topK->spare, &topK->entries[0]);
+		siftDownTopK(topK, 0, topK->size);
+	}
+
+	topK->offered++;
+	return status;
+}
+
+int drainTopK(TopK* topK, DynamicArray* dArray)
+{
+	if (topK == NULL || dArray == NULL)
+		return -1;
+
+	int size = topK->size;
+
+	// heap sort in place: the largest entry goes to the end every step
+	for (int i = size - 1; i > 0; i--)
+	{
+		swapEntries(&topK->entries[0], &topK->entries[i]);
+		siftDownTopK(topK, 0, i);
+	}
+
+	if (reserve(dArray, len(dArray) + size) == -1)
+		return -1;
+
+	for (int i = 0; i < size; i++)
+		apd(dArray, topK->entries[i].material);
+
+	topK->size = 0;
+	return 1;
+}
+
+
+//Tests
+
+
+void testTopKQuantity()
+{
+	DynamicArray* materials = createDynamicArray(2, &destroyMaterial);
+	DynamicArray* result = createDynamicArray(2, NULL);
+	OrderBy orderBy;
+	TopK topK;
+
+	srand(11);
+	for (int i = 0; i < 500; i++)
+		apd(materials, createMaterial("name", "supplier", rand() % 1000, createDate(1, 1, 2022)));
+
+	parseOrderBy(&orderBy, "quantity");
+	assert(initTopK(&topK, 0, &orderBy) == -1);
+	assert(initTopK(&topK, 20, &orderBy) == 1);
+
+	for (int i = 0; i < len(materials); i++)
+		assert(offerTopK(&topK, getElement(materials, i)) == 1);
+	assert(drainTopK(&topK, result) == 1);
+	assert(len(result) == 20);
+
+	sortOrderBy(materials, &orderBy);
+	for (int i = 0; i < 20; i++)
+		assert(getQuantity(getElement(result, i)) == getQuantity(getElement(materials, i)));
+
+	freeTopK(&topK);
+	destroyDynamicArray(result);
+	destroyDynamicArray(materials);
+}
+
+void testTopKStable()
+{
+	DynamicArray* materials = createDynamicArray(2, &destroyMaterial);
+	DynamicArray* result = createDynamicArray(2, NULL);
+	OrderBy orderBy;
+	TopK topK;
+
+	apd(materials, createMaterial("a", "supplier", 1, createDate(1, 1, 2022)));
+	apd(materials, createMaterial("b", "supplier", 1, createDate(1, 1, 2021)));
+	apd(materials, createMaterial("c", "supplier", 1, createDate(1, 1, 2022)));
+	apd(materials, createMaterial("d", "supplier", 1, createDate(1, 1, 2022)));
+
+	parseOrderBy(&orderBy, "date");
+	initTopK(&topK, 3, &orderBy);
+	for (int i = 0; i < len(materials); i++)
+		offerTopK(&topK, getElement(materials, i));
+	drainTopK(&topK, result);
+
+	assert(len(result) == 3);
+	assert(strcmp(getName(getElement(result, 0)), "b") == 0);
+	assert(strcmp(getName(getElement(result, 1)), "a") == 0);
+	assert(strcmp(getName(getElement(result, 2)), "c") == 0);
+
+	freeTopK(&topK);
+	destroyDynamicArray(result);
+	destroyDynamicArray(materials);
+}
+
+void testTopK()
+{
+	testTopKQuantity();
+	testTopKStable();
+}
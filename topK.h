@@ -0,0 +1,46 @@
+#pragma once
+
+#include "orderBy.h"
+
+typedef struct TopKEntry
+{
+	SortKeyRef ref;
+	unsigned char* buffer;
+	int capacity;
+	Material* material;
+} TopKEntry;
+
+/*
+	Keeps the k first materials in the order given by orderBy out of all the materials offered to it,
+	in a max-heap of k entries, so selecting them costs O(n log k) time and O(k) memory.
+*/
+typedef struct TopK
+{
+	int k, size;
+	uint32_t offered;
+	const OrderBy* orderBy;
+	TopKEntry* entries;
+	TopKEntry spare;
+} TopK;
+
+/*
+	Initializes the selection of the first k materials.
+	Returns 1 on success, or -1 if the arguments are not valid or the memory could not be allocated.
+*/
+int initTopK(TopK* topK, int k, const OrderBy* orderBy);
+void freeTopK(TopK* topK);
+
+/*
+	Offers a material to the selection. Materials with equal keys are kept in the order they were offered.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int offerTopK(TopK* topK, Material* material);
+
+/*
+	Moves the selected materials, in order, at the end of the dynamic array and empties the selection.
+	Returns 1 on success, or -1 otherwise.
+*/
+int drainTopK(TopK* topK, DynamicArray* dArray);
+
+//Tests
+void testTopK();
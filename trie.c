@@ -0,0 +1,319 @@
+#include "trie.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+
+typedef struct TrieCandidate
+{
+	double best;
+	int node;
+	int terminal;
+} TrieCandidate;
+
+int newTrieNode(Trie* trie, char character, int parent)
+{
+	if (trie->size == trie->capacity)
+	{
+		int capacity = trie->capacity * 2;
+		TrieNode* nodes = (TrieNode*)realloc(trie->nodes, sizeof(TrieNode) * capacity);
+
+		if (nodes == NULL)
+			return -1;
+
+		trie->nodes = nodes;
+		trie->capacity = capacity;
+	}
+
+	TrieNode* node = &trie->nodes[trie->size];
+	node->character = character;
+	node->parent = parent;
+	node->child = -1;
+	node->sibling = -1;
+	node->items = 0;
+	node->weight = 0;
+	node->best = -HUGE_VAL;
+	node->item = NULL;
+
+	return trie->size++;
+}
+
+int initTrie(Trie* trie)
+{
+	if (trie == NULL)
+		return -1;
+
+	trie->size = 0;
+	trie->capacity = 16;
+	trie->nodes = (TrieNode*)malloc(sizeof(TrieNode) * trie->capacity);
+
+	if (trie->nodes == NULL)
+		return -1;
+
+	newTrieNode(trie, 0, -1);
+	return 1;
+}
+
+void freeTrie(Trie* trie)
+{
+	if (trie == NULL)
+		return;
+
+	free(trie->nodes);
+	trie->nodes = NULL;
+	trie->size = 0;
+	trie->capacity = 0;
+}
+
+/*
+	Finds the child of a node with the given character. If create is 1, a missing child is inserted
+	at its sorted position among the siblings.
+	Returns the position of the child, or -1 if it does not exist or could not be created.
+*/
+int findTrieChild(Trie* trie, int node, char character, int create)
+{
+	int previous = -1;
+	int child = trie->nodes[node].child;
+
+	while (child != -1 && (unsigned char)trie->nodes[child].character < (unsigned char)character)
+	{
+		previous = child;
+		child = trie->nodes[child].sibling;
+	}
+
+	if (child != -1 && trie->nodes[child].character == character)
+		return child;
+
+	if (!create)
+		return -1;
+
+	int newChild = newTrieNode(trie, character, node);
+
+	if (newChild == -1)
+		return -1;
+
+	trie->nodes[newChild].sibling = child;
+	if (previous == -1)
+		trie->nodes[node].child = newChild;
+	else
+		trie->nodes[previous].sibling = newChild;
+
+	return newChild;
+}
+
+int findTrieNode(Trie* trie, const char* key)
+{
+	int node = 0;
+
+	for (; *key != 0 && node != -1; key++)
+		node = findTrieChild(trie, node, *key, 0);
+
+	return node;
+}
+
+/*
+	Recomputes the best weight and the number of items of a node from its own item and its children.
+*/
+void refreshTrieNode(Trie* trie, int node)
+{
+	TrieNode* n = &trie->nodes[node];
+
+	n->items = n->item != NULL;
+	n->best = n->item != NULL ? n->weight : -HUGE_VAL;
+
+	for (int child = n->child; child != -1; child = trie->nodes[child].sibling)
+	{
+		n->items += trie->nodes[child].items;
+		if (trie->nodes[child].best > n->best)
+			n->best = trie->nodes[child].best;
+	}
+}
+
+int setTrieKey(Trie* trie, const char* key, void* item, double weight)
+{
+	if (trie == NULL || key == NULL)
+		return -1;
+
+	int node;
+
+	if (item == NULL)
+	{
+		node = findTrieNode(trie, key);
+		if (node == -1)
+			return 1;
+	}
+	else
+	{
+		node = 0;
+		for (; *key != 0; key++)
+		{
+			node = findTrieChild(trie, node, *key, 1);
+			if (node == -1)
+				return -1;
+		}
+	}
+
+	trie->nodes[node].item = item;
+	trie->nodes[node].weight = weight;
+
+	for (; node != -1; node = trie->nodes[node].parent)
+		refreshTrieNode(trie, node);
+
+	return 1;
+}
+
+void pushCandidate(TrieCandidate* heap, int* size, TrieCandidate candidate)
+{
+	int i = (*size)++;
+
+	while (i > 0 && heap[(i - 1) / 2].best < candidate.best)
+	{
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap[i] = candidate;
+}
+
+TrieCandidate popCandidate(TrieCandidate* heap, int* size)
+{
+	TrieCandidate top = heap[0];
+	TrieCandidate last = heap[--(*size)];
+	int i = 0;
+
+	while (2 * i + 1 < *size)
+	{
+		int child = 2 * i + 1;
+		if (child + 1 < *size && heap[child + 1].best > heap[child].best)
+			child++;
+		if (heap[child].best <= last.best)
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = last;
+
+	return top;
+}
+
+int completeTrie(Trie* trie, const char* prefix, int limit, TrieMatch* matches)
+{
+	if (trie == NULL || prefix == NULL || matches == NULL || limit < 0)
+		return -1;
+
+	int start = findTrieNode(trie, prefix);
+
+	if (start == -1 || limit == 0 || trie->nodes[start].items == 0)
+		return 0;
+
+	// a popped node pushes at most its item and its children, so the heap never holds more than that per match
+	int capacity = 16;
+	TrieCandidate* heap = (TrieCandidate*)malloc(sizeof(TrieCandidate) * capacity);
+
+	if (heap == NULL)
+		return -1;
+
+	int size = 0, count = 0;
+	TrieCandidate candidate = { trie->nodes[start].best, start, 0 };
+	pushCandidate(heap, &size, candidate);
+
+	while (size > 0 && count < limit)
+	{
+		candidate = popCandidate(heap, &size);
+		TrieNode* node = &trie->nodes[candidate.node];
+
+		if (candidate.terminal)
+		{
+			matches[count].item = node->item;
+			matches[count].weight = node->weight;
+			count++;
+			continue;
+		}
+
+		// every child, plus the item of the node
+		int needed = size + 1;
+		for (int child = node->child; child != -1; child = trie->nodes[child].sibling)
+			needed++;
+
+		if (needed > capacity)
+		{
+			while (capacity < needed)
+				capacity *= 2;
+
+			TrieCandidate* newHeap = (TrieCandidate*)realloc(heap, sizeof(TrieCandidate) * capacity);
+			if (newHeap == NULL)
+			{
+				free(heap);
+				return -1;
+			}
+			heap = newHeap;
+			node = &trie->nodes[candidate.node];
+		}
+
+		if (node->item != NULL)
+		{
+			TrieCandidate item = { node->weight, candidate.node, 1 };
+			pushCandidate(heap, &size, item);
+		}
+
+		for (int child = node->child; child != -1; child = trie->nodes[child].sibling)
+			if (trie->nodes[child].items > 0)
+			{
+				TrieCandidate subtree = { trie->nodes[child].best, child, 0 };
+				pushCandidate(heap, &size, subtree);
+			}
+	}
+
+	free(heap);
+	return count;
+}
+
+
+//Tests
+
+
+void testTrieComplete()
+{
+	Trie trie;
+	TrieMatch matches[4];
+	char* keys[] = { "Wheat flour", "Whole milk", "White sugar", "Salt", "Wh" };
+	double weights[] = { 10, 30, 20, 5, 1 };
+
+	assert(initTrie(&trie) == 1);
+
+	for (int i = 0; i < 5; i++)
+		assert(setTrieKey(&trie, keys[i], keys[i], weights[i]) == 1);
+
+	assert(completeTrie(&trie, "Wh", 4, matches) == 4);
+	assert(matches[0].item == keys[1]);
+	assert(matches[1].item == keys[2]);
+	assert(matches[2].item == keys[0]);
+	assert(matches[3].item == keys[4]);
+
+	assert(completeTrie(&trie, "Wh", 2, matches) == 2);
+	assert(matches[1].weight == 20);
+
+	assert(completeTrie(&trie, "S", 4, matches) == 1);
+	assert(completeTrie(&trie, "X", 4, matches) == 0);
+	assert(completeTrie(&trie, "", 4, matches) == 4);
+	assert(matches[3].item == keys[3]);
+
+	// the weight of an existing key changes and the key is moved in the ranking
+	assert(setTrieKey(&trie, "Wheat flour", keys[0], 100) == 1);
+	assert(completeTrie(&trie, "Whe", 4, matches) == 1);
+	assert(completeTrie(&trie, "W", 1, matches) == 1 && matches[0].item == keys[0]);
+
+	assert(setTrieKey(&trie, "Wheat flour", NULL, 0) == 1);
+	assert(setTrieKey(&trie, "Missing", NULL, 0) == 1);
+	assert(completeTrie(&trie, "Whe", 4, matches) == 0);
+	assert(completeTrie(&trie, "W", 4, matches) == 3);
+	assert(trie.nodes[0].items == 4);
+
+	freeTrie(&trie);
+}
+
+void testTrie()
+{
+	testTrieComplete();
+}
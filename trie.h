@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+	A node of a trie, linked to its first child and its next sibling; the children are kept sorted by character.
+	item - the item of the key ending at this node, or NULL if no key ends here
+	weight - the weight of the item
+	best - the largest weight of an item in the subtree of the node
+	items - the number of items in the subtree of the node
+*/
+typedef struct TrieNode
+{
+	char character;
+	int parent, child, sibling;
+	int items;
+	double weight, best;
+	void* item;
+} TrieNode;
+
+/*
+	A trie mapping string keys to weighted items, stored compactly as an array of nodes (node 0 is the root).
+	Every node knows the best weight of its subtree, so the heaviest keys with a given prefix are found
+	best-first, without visiting the rest of the subtree.
+	The nodes of removed keys stay in the array and are reused if the keys are added again.
+*/
+typedef struct Trie
+{
+	int size, capacity;
+	TrieNode* nodes;
+} Trie;
+
+/*
+	A key found by completeTrie.
+*/
+typedef struct TrieMatch
+{
+	void* item;
+	double weight;
+} TrieMatch;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initTrie(Trie* trie);
+void freeTrie(Trie* trie);
+
+/*
+	Sets the item and the weight of a key, or removes the key if the item is NULL.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int setTrieKey(Trie* trie, const char* key, void* item, double weight);
+
+/*
+	Finds the keys starting with the prefix that have the largest weights, heaviest first.
+	matches - receives at most limit matches
+	Returns the number of matches, or -1 if the arguments are not valid or the memory could not be allocated.
+*/
+int completeTrie(Trie* trie, const char* prefix, int limit, TrieMatch* matches);
+
+//Tests
+void testTrie();
@@ -0,0 +1,173 @@
+#include "trigramIndex.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+// returned for the patterns that contain a trigram no text has
+static DynamicArray emptyPosting = { 0, 0, NULL, NULL };
+
+int initTrigramIndex(TrigramIndex* trigramIndex)
+{
+	if (trigramIndex == NULL)
+		return -1;
+
+	trigramIndex->postings = createHashMap(64, &destroyDynamicArray);
+
+	if (trigramIndex->postings == NULL)
+		return -1;
+
+	return 1;
+}
+
+void freeTrigramIndex(TrigramIndex* trigramIndex)
+{
+	if (trigramIndex == NULL)
+		return;
+
+	destroyHashMap(trigramIndex->postings);
+	trigramIndex->postings = NULL;
+}
+
+void getTrigram(const char* text, char* trigram)
+{
+	memcpy(trigram, text, TRIGRAM_SIZE);
+	trigram[TRIGRAM_SIZE] = 0;
+}
+
+int addTrigrams(TrigramIndex* trigramIndex, const char* text, void* item)
+{
+	if (trigramIndex == NULL || text == NULL || item == NULL)
+		return -1;
+
+	int length = (int)strlen(text);
+	char trigram[TRIGRAM_SIZE + 1];
+
+	for (int i = 0; i + TRIGRAM_SIZE <= length; i++)
+	{
+		getTrigram(text + i, trigram);
+
+		DynamicArray* posting = getValue(trigramIndex->postings, trigram);
+
+		if (posting == NULL)
+		{
+			posting = createDynamicArray(2, NULL);
+			if (posting == NULL || putValue(trigramIndex->postings, trigram, posting) == -1)
+			{
+				destroyDynamicArray(posting);
+				removeTrigrams(trigramIndex, text, item);
+				return -1;
+			}
+		}
+
+		// a trigram repeated in the text was already added for this item, as the last element of its posting
+		if (len(posting) > 0 && getElement(posting, len(posting) - 1) == item)
+			continue;
+
+		if (apd(posting, item) == -1)
+		{
+			removeTrigrams(trigramIndex, text, item);
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+void removeTrigrams(TrigramIndex* trigramIndex, const char* text, void* item)
+{
+	if (trigramIndex == NULL || text == NULL)
+		return;
+
+	int length = (int)strlen(text);
+	char trigram[TRIGRAM_SIZE + 1];
+
+	for (int i = 0; i + TRIGRAM_SIZE <= length; i++)
+	{
+		getTrigram(text + i, trigram);
+
+		DynamicArray* posting = getValue(trigramIndex->postings, trigram);
+
+		if (posting == NULL)
+			continue;
+
+		for (int j = len(posting) - 1; j >= 0; j--)
+			if (getElement(posting, j) == item)
+			{
+				del(posting, j);
+				break;
+			}
+
+		if (len(posting) == 0)
+			removeValue(trigramIndex->postings, trigram);
+	}
+}
+
+DynamicArray* getTrigramCandidates(TrigramIndex* trigramIndex, const char* pattern)
+{
+	if (trigramIndex == NULL || pattern == NULL)
+		return NULL;
+
+	int length = (int)strlen(pattern);
+	if (length < TRIGRAM_SIZE)
+		return NULL;
+
+	DynamicArray* best = NULL;
+	char trigram[TRIGRAM_SIZE + 1];
+
+	for (int i = 0; i + TRIGRAM_SIZE <= length; i++)
+	{
+		getTrigram(pattern + i, trigram);
+
+		DynamicArray* posting = getValue(trigramIndex->postings, trigram);
+
+		if (posting == NULL)
+			return &emptyPosting;
+
+		if (best == NULL || len(posting) < len(best))
+			best = posting;
+	}
+
+	return best;
+}
+
+
+//Tests
+
+
+void testTrigramCandidates()
+{
+	TrigramIndex trigramIndex;
+	char* texts[] = { "Wheat flour", "Cake flour", "Sugar", "aaaa" };
+
+	assert(initTrigramIndex(&trigramIndex) == 1);
+
+	for (int i = 0; i < 4; i++)
+		assert(addTrigrams(&trigramIndex, texts[i], texts[i]) == 1);
+	assert(addTrigrams(&trigramIndex, "ab", "ab") == 1);
+
+	DynamicArray* candidates = getTrigramCandidates(&trigramIndex, "flour");
+	assert(len(candidates) == 2);
+
+	candidates = getTrigramCandidates(&trigramIndex, "Cake f");
+	assert(len(candidates) == 1 && getElement(candidates, 0) == texts[1]);
+
+	assert(len(getTrigramCandidates(&trigramIndex, "aaa")) == 1);
+	assert(len(getTrigramCandidates(&trigramIndex, "Salt")) == 0);
+	assert(getTrigramCandidates(&trigramIndex, "ab") == NULL);
+
+	removeTrigrams(&trigramIndex, texts[1], texts[1]);
+	assert(len(getTrigramCandidates(&trigramIndex, "flour")) == 1);
+	assert(len(getTrigramCandidates(&trigramIndex, "Cake")) == 0);
+
+	removeTrigrams(&trigramIndex, texts[3], texts[3]);
+	assert(getValue(trigramIndex.postings, "aaa") == NULL);
+
+	freeTrigramIndex(&trigramIndex);
+}
+
+void testTrigramIndex()
+{
+	testTrigramCandidates();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "dynamicArray.h"
+#include "hashMap.h"
+
+#define TRIGRAM_SIZE 3
+
+/*
+	An inverted index from the trigrams (substrings of 3 characters) of some texts to the items the texts belong to.
+	Every text containing a pattern of at least 3 characters also contains each trigram of the pattern, so the items
+	of any one of those trigrams are a superset of the items whose text contains the pattern.
+	postings - maps a trigram to a dynamic array of items, without duplicates; the index does not own the items
+*/
+typedef struct TrigramIndex
+{
+	HashMap* postings;
+} TrigramIndex;
+
+/*
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int initTrigramIndex(TrigramIndex* trigramIndex);
+void freeTrigramIndex(TrigramIndex* trigramIndex);
+
+/*
+	Adds the item under every trigram of the text. Texts shorter than 3 characters are not indexed.
+	Returns 1 on success, or -1 if the memory could not be allocated.
+*/
+int addTrigrams(TrigramIndex* trigramIndex, const char* text, void* item);
+
+/*
+	Removes the item from every trigram of the text it was added with.
+*/
+void removeTrigrams(TrigramIndex* trigramIndex, const char* text, void* item);
+
+/*
+	Gets the candidate items for a substring search: the shortest posting among the trigrams of the pattern.
+	The candidates still have to be verified, e.g. with strstr.
+	Returns the posting, owned by the index, an empty array if some trigram of the pattern is not indexed
+	(no text contains the pattern), or NULL if the pattern is shorter than 3 characters and the index cannot help.
+*/
+DynamicArray* getTrigramCandidates(TrigramIndex* trigramIndex, const char* pattern);
+
+//Tests
+void testTrigramIndex();
@@ -0,0 +1,87 @@
+#include "typedVector.h"
+
+#include <assert.h>
+
+
+//Tests
+
+
+void testIndexVector()
+{
+	IndexVector vector;
+
+	assert(IndexVectorInit(&vector, 0) == 1);
+	assert(IndexVectorAt(&vector, 0) == NULL);
+
+	for (uint32_t i = 0; i < 100; i++)
+		assert(IndexVectorPush(&vector, (i * 37) % 100) == 1);
+
+	assert(vector.size == 100);
+	assert(*IndexVectorAt(&vector, 1) == 37);
+
+	IndexSort(vector.data, vector.size);
+
+	for (int i = 0; i < vector.size; i++)
+		assert(vector.data[i] == (uint32_t)i);
+
+	assert(IndexLowerBound(vector.data, vector.size, 42) == 42);
+	assert(IndexLowerBound(vector.data, vector.size, 1000) == 100);
+
+	IndexVectorFree(&vector);
+}
+
+void testIndexSortDuplicates()
+{
+	IndexVector vector;
+	IndexVectorInit(&vector, 16);
+
+	srand(7);
+	for (int i = 0; i < 5000; i++)
+		IndexVectorPush(&vector, (uint32_t)(rand() % 50));
+
+	IndexSort(vector.data, vector.size);
+
+	for (int i = 1; i < vector.size; i++)
+		assert(vector.data[i - 1] <= vector.data[i]);
+
+	IndexVectorFree(&vector);
+}
+
+void testMaterialVector()
+{
+	Date* testDate = createDate(1, 2, 3);
+	Material* testMaterial = createMaterial("testName", "testSupplier", 0, testDate);
+
+	MaterialVector vector;
+	MaterialVectorInit(&vector, 2);
+
+	double quantities[] = { 5, 1, 4, 2, 3 };
+	for (int i = 0; i < 5; i++)
+	{
+		Material record = *testMaterial;
+		record.quantity = quantities[i];
+		MaterialVectorPush(&vector, record);
+	}
+
+	MaterialLessSort(vector.data, vector.size);
+	for (int i = 0; i < 5; i++)
+		assert(vector.data[i].quantity == i + 1);
+
+	Material key = *testMaterial;
+	key.quantity = 3;
+	assert(MaterialLessLowerBound(vector.data, vector.size, key) == 2);
+
+	MaterialGreaterSort(vector.data, vector.size);
+	for (int i = 0; i < 5; i++)
+		assert(vector.data[i].quantity == 5 - i);
+
+	MaterialVectorFree(&vector);
+	destroyMaterial(testMaterial);
+}
+
+void testTypedVector()
+{
+	testIndexVector();
+	testIndexSortDuplicates();
+	testMaterialVector();
+}
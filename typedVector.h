@@ -0,0 +1,221 @@
+#pragma once
+
+#include "material.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+	Generators for typed containers. Unlike DynamicArray, which stores void pointers and compares them
+	through a function pointer, the generated code stores the values contiguously and the comparator
+	is expanded in place, so the compiler can inline it.
+*/
+
+/*
+	DEFINE_VECTOR(Name, Type) generates the type Name, a growable array of Type values, and the functions:
+	Name##Init(vector, capacity), Name##Free(vector), Name##Reserve(vector, capacity),
+	Name##Push(vector, value), Name##At(vector, position), Name##Clear(vector).
+	The functions returning int return 1 on success and -1 on failure, like the DynamicArray ones.
+*/
+#define DEFINE_VECTOR(Name, Type) \
+typedef struct Name \
+{ \
+	int size, capacity; \
+	Type* data; \
+} Name; \
+\
+static inline int Name##Reserve(Name* vector, int capacity) \
+{ \
+	if (vector == NULL) \
+		return -1; \
+	if (capacity <= vector->capacity) \
+		return 1; \
+	Type* data = (Type*)realloc(vector->data, sizeof(Type) * capacity); \
+	if (data == NULL) \
+		return -1; \
+	vector->data = data; \
+	vector->capacity = capacity; \
+	return 1; \
+} \
+\
+static inline int Name##Init(Name* vector, int capacity) \
+{ \
+	if (vector == NULL) \
+		return -1; \
+	vector->size = 0; \
+	vector->capacity = 0; \
+	vector->data = NULL; \
+	if (capacity < 1) \
+		capacity = 1; \
+	return Name##Reserve(vector, capacity); \
+} \
+\
+static inline void Name##Free(Name* vector) \
+{ \
+	if (vector == NULL) \
+		return; \
+	free(vector->data); \
+	vector->data = NULL; \
+	vector->size = 0; \
+	vector->capacity = 0; \
+} \
+\
+static inline int Name##Push(Name* vector, Type value) \
+{ \
+	if (vector->size == vector->capacity && Name##Reserve(vector, vector->capacity * 2 + 1) == -1) \
+		return -1; \
+	vector->data[vector->size++] = value; \
+	return 1; \
+} \
+\
+static inline Type* Name##At(Name* vector, int position) \
+{ \
+	if (vector == NULL || position < 0 || position >= vector->size) \
+		return NULL; \
+	return &vector->data[position]; \
+} \
+\
+static inline void Name##Clear(Name* vector) \
+{ \
+	vector->size = 0; \
+}
+
+/*
+	DEFINE_SORT(Name, Type, LESS) generates Name##Sort(data, size), an introsort over an array of Type.
+	LESS(x, y) receives two const Type* and must evaluate to nonzero if *x goes before *y.
+*/
+#define DEFINE_SORT(Name, Type, LESS) \
+static inline void Name##InsertionSort(Type* data, int size) \
+{ \
+	for (int i = 1; i < size; i++) \
+	{ \
+		Type value = data[i]; \
+		int j = i - 1; \
+		while (j >= 0 && LESS((&value), (&data[j]))) \
+		{ \
+			data[j + 1] = data[j]; \
+			j--; \
+		} \
+		data[j + 1] = value; \
+	} \
+} \
+\
+static inline void Name##SiftDown(Type* data, int root, int size) \
+{ \
+	Type value = data[root]; \
+	while (2 * root + 1 < size) \
+	{ \
+		int child = 2 * root + 1; \
+		if (child + 1 < size && LESS((&data[child]), (&data[child + 1]))) \
+			child++; \
+		if (!LESS((&value), (&data[child]))) \
+			break; \
+		data[root] = data[child]; \
+		root = child; \
+	} \
+	data[root] = value; \
+} \
+\
+static inline void Name##HeapSort(Type* data, int size) \
+{ \
+	for (int i = size / 2 - 1; i >= 0; i--) \
+		Name##SiftDown(data, i, size); \
+	for (int i = size - 1; i > 0; i--) \
+	{ \
+		Type aux = data[0]; \
+		data[0] = data[i]; \
+		data[i] = aux; \
+		Name##SiftDown(data, 0, i); \
+	} \
+} \
+\
+static inline void Name##IntroSort(Type* data, int size, int depth) \
+{ \
+	while (size > 16) \
+	{ \
+		if (depth-- == 0) \
+		{ \
+			Name##HeapSort(data, size); \
+			return; \
+		} \
+		int middle = size / 2; \
+		Type aux; \
+		if (LESS((&data[middle]), (&data[0]))) { aux = data[middle]; data[middle] = data[0]; data[0] = aux; } \
+		if (LESS((&data[size - 1]), (&data[0]))) { aux = data[size - 1]; data[size - 1] = data[0]; data[0] = aux; } \
+		if (LESS((&data[size - 1]), (&data[middle]))) { aux = data[size - 1]; data[size - 1] = data[middle]; data[middle] = aux; } \
+		Type pivot = data[middle]; \
+		int i = 0, j = size - 1; \
+		while (1) \
+		{ \
+			while (LESS((&data[i]), (&pivot))) \
+				i++; \
+			while (LESS((&pivot), (&data[j]))) \
+				j--; \
+			if (i >= j) \
+				break; \
+			aux = data[i]; data[i] = data[j]; data[j] = aux; \
+			i++; \
+			j--; \
+		} \
+		int split = j + 1; \
+		if (split < size - split) \
+		{ \
+			Name##IntroSort(data, split, depth); \
+			data += split; \
+			size -= split; \
+		} \
+		else \
+		{ \
+			Name##IntroSort(data + split, size - split, depth); \
+			size = split; \
+		} \
+	} \
+	Name##InsertionSort(data, size); \
+} \
+\
+static inline void Name##Sort(Type* data, int size) \
+{ \
+	int depth = 0; \
+	for (int n = size; n > 1; n >>= 1) \
+		depth += 2; \
+	Name##IntroSort(data, size, depth); \
+}
+
+/*
+	DEFINE_SEARCH(Name, Type, LESS) generates Name##LowerBound(data, size, value), which returns the first
+	position of a sorted array whose element does not go before value (size if there is none).
+*/
+#define DEFINE_SEARCH(Name, Type, LESS) \
+static inline int Name##LowerBound(const Type* data, int size, Type value) \
+{ \
+	int left = 0, right = size; \
+	while (left < right) \
+	{ \
+		int middle = left + (right - left) / 2; \
+		if (LESS((&data[middle]), (&value))) \
+			left = middle + 1; \
+		else \
+			right = middle; \
+	} \
+	return left; \
+}
+
+
+//Instantiations
+
+#define INDEX_LESS(x, y) (*(x) < *(y))
+#define MATERIAL_QUANTITY_LESS(x, y) ((x)->quantity < (y)->quantity)
+#define MATERIAL_QUANTITY_GREATER(x, y) ((x)->quantity > (y)->quantity)
+
+DEFINE_VECTOR(IndexVector, uint32_t)
+DEFINE_SORT(Index, uint32_t, INDEX_LESS)
+DEFINE_SEARCH(Index, uint32_t, INDEX_LESS)
+
+// the records are shallow copies, the strings and the date stay owned by the repository
+DEFINE_VECTOR(MaterialVector, Material)
+DEFINE_SORT(MaterialLess, Material, MATERIAL_QUANTITY_LESS)
+DEFINE_SORT(MaterialGreater, Material, MATERIAL_QUANTITY_GREATER)
+DEFINE_SEARCH(MaterialLess, Material, MATERIAL_QUANTITY_LESS)
+
+//Tests
+void testTypedVector();
@@ -2,10 +2,12 @@
 #include "services.h"
 #include "ui.h"
 #include "validation.h"
+#include "batch.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 UI* createUI(MaterialServices* materialServices)
 {
@@ -14,7 +16,15 @@ UI* createUI(MaterialServices* materialServices)
 	if (ui == NULL)
 		return NULL;
 
+	if (initRowWriter(&ui->rowWriter, stdout, ROW_WRITER_SIZE) == -1)
+	{
+		free(ui);
+		return NULL;
+	}
+
 	ui->materialServices = materialServices;
+	ui->output = stdout;
+	ui->layout = LAYOUT_TABLE;
 
 	return ui;
 }
@@ -25,6 +35,7 @@ void destroyUI(UI* ui)
 		return;
 
 	destroyMaterialServices(ui->materialServices);
+	freeRowWriter(&ui->rowWriter);
 	free(ui);
 }
 
@@ -34,12 +45,32 @@ void printMenu()
 	printf("add\tAdd a material.\n");
 	printf("delete\tDelete a material.\n");
 	printf("update\tUpdate a material.\n");
+	printf("consume\tUse a quantity of a material, from the lots expiring first.\n");
+	printf("recipe <name>\tDefine the ingredients needed for one unit of a product.\n");
+	printf("recipes\tList the recipes.\n");
+	printf("produce <recipe> <count>\tUse the ingredients of a recipe for a number of units.\n");
 	printf("list\tList all available materials.\n\n");
 	printf("expired\tGet all expired materials.\n");
-	printf("short\tGet materials that are short on quantity.\n\n");
-	printf("sort\tPrint materials sorted by name.\n\n");
+	printf("short\tGet materials that are short on quantity.\n");
+	printf("expiring <days>\tGet the materials expiring in the next days.\n");
+	printf("format <table|tsv|csv|jsonl>\tList the materials as a table, tab or comma separated values, or JSON lines.\n");
+	printf("histogram <week|month>\tShow how many materials expire in the next weeks or months.\n");
+	printf("totals\tShow the total quantity and expired lots per name and per supplier.\n");
+	printf("complete <prefix>\tShow the names and suppliers starting with a prefix, largest quantity first.\n");
+	printf("suggest <name>\tShow the names close to a possibly misspelled one.\n\n");
+	printf("sort\tPrint materials sorted by name.\n");
+	printf("bydate\tPrint materials sorted by expiration date.\n");
+	printf("order\tPrint materials sorted by several columns.\n");
+	printf("query\tPrint the materials matching a combination of filters.\n");
+	printf("explain\tShow how a query is executed.\n");
+	printf("cache\tShow the query cache statistics.\n\n");
+	printf("alert\tWatch for low stock or expiring lots.\n");
+	printf("alerts\tShow the new alerts.\n\n");
 	printf("undo\tUndo an operation.\n");
-	printf("redo\tRedo an operation.\n");
+	printf("redo\tRedo an operation.\n\n");
+	printf("begin\tStart a batch of operations recorded as a single undo step.\n");
+	printf("commit\tApply the current batch of operations.\n");
+	printf("rollback\tDiscard the current batch of operations.\n\n");
 	printf("help\tShow this menu.\n");
 	printf("exit\tExit the application.\n");
 	printf("\nEnter a command:\n");
@@ -52,6 +83,15 @@ void printExpiredMenu()
 	printf("2\tGet expired materials having a quantity less than a given one.\n");
 }
 
+void printAlertMenu()
+{
+	printf("Choose one of the option:\n");
+	printf("1\tAlert when the total quantity of a name falls below a threshold.\n");
+	printf("2\tAlert when the total quantity of a supplier falls below a threshold.\n");
+	printf("3\tAlert when a lot of a name expires in the next days.\n");
+	printf("4\tAlert when any lot expires in the next days.\n");
+}
+
 void printShortMenu()
 {
 	printf("Choose one of the option:\n");
@@ -59,33 +99,62 @@ void printShortMenu()
 	printf("2\tSorted in descending order by the quantity.\n");
 }
 
-void printMaterials(DynamicArray* dArray)
+/*
+	Writes the materials through the row writer of the UI, which is flushed at the end, so the rows come out before
+	anything else that is printed.
+*/
+void printMaterialsColumns(UI* ui, DynamicArray* dArray, int columns)
 {
-	if (len(dArray) == 0)
-	{
-		printf("No materials to be displayed!\n");
-		return;
-	}
+	writeMaterials(&ui->rowWriter, dArray, columns, ui->layout);
+	flushRowWriter(&ui->rowWriter);
+}
 
-	printf("%-3s %20s %20s %20s %30s\n", "NR", "NAME", "SUPPLIER", "QUANTITY", "EXPIRATION_DATE");
-	for (int i = 0; i < len(dArray); i++)
-	{
-		Material* m = getElement(dArray, i);
-		const Date* d = getDate(m);
-		printf("%-3d %20s %20s %*.4lf %20d/%d/%d\n", i + 1, getName(m), getSupplier(m), 20, getQuantity(m), getDay(d), getMonth(d), getYear(d));
-	}
+void printMaterials(UI* ui, DynamicArray* dArray)
+{
+	printMaterialsColumns(ui, dArray, COLUMNS_ALL);
 }
 
 int getCommand(char* command)
 {
 	printf(">>>");
-	int status = scanf("%63s", command);
+	int status = scanf("%31s", command);
 	int c;  while ((c = getchar()) != '\n' && c != EOF) {}
 	if (status == 0)
 		return -1;
 	return 1;
 }
 
+/*
+	Reads a command line: the command, and the rest of the line, without the leading spaces, as its argument.
+	Returns 1 on success, or 0 at the end of the input.
+*/
+int getCommandLine(char* command, char* argument)
+{
+	char line[2 * MAX_STRING_SIZE] = { 0 };
+
+	printf(">>>");
+	int status = scanf("%127[^\n]", line);
+	int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+
+	if (status == EOF)
+		return 0;
+
+	int start = (int)strspn(line, " \t");
+	int length = (int)strcspn(line + start, " \t\r");
+	if (length > MAX_COMMAND_SIZE - 1)
+		length = MAX_COMMAND_SIZE - 1;
+
+	memcpy(command, line + start, length);
+	command[length] = 0;
+
+	const char* rest = line + start + strcspn(line + start, " \t\r");
+	rest += strspn(rest, " \t");
+	snprintf(argument, MAX_STRING_SIZE, "%s", rest);
+	argument[strcspn(argument, "\r")] = 0;
+
+	return 1;
+}
+
 int getNameInput(char *name)
 {
 	int x = 0;
@@ -213,6 +282,53 @@ int getDateInput(int* day, int* month, int* year)
 	return 1;
 }
 
+int getLimitInput(int* limit)
+{
+	int x = 0;
+	while (x == 0)
+	{
+		char l[MAX_STRING_SIZE] = { 0 };
+
+		printf("Enter the maximum number of materials (0 for all of them): ");
+		x = scanf("%63s", l);
+		int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+
+		char* end;
+		long value = strtol(l, &end, 10);
+		*limit = value > INT_MAX ? -1 : (int)value;
+		if (x == 0 || *end != 0 || *limit < 0)
+		{
+			x = 0;
+			printf("Enter a valid number!\n");
+		}
+	}
+	return 1;
+}
+
+int getDaysInput(int* days)
+{
+	int x = 0;
+	while (x == 0)
+	{
+		char d[MAX_STRING_SIZE] = { 0 };
+
+		printf("Enter the number of days: ");
+		x = scanf("%63s", d);
+		int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+
+		// strtol saturates on overflow, so a number too large for a long is rejected with the ones above the limit
+		char* end;
+		long value = strtol(d, &end, 10);
+		*days = value < 1 || value > MAX_WITHIN_DAYS ? 0 : (int)value;
+		if (x == 0 || end == d || *end != 0 || *days < 1)
+		{
+			x = 0;
+			printf("Enter a valid number!\n");
+		}
+	}
+	return 1;
+}
+
 int getString(char* s)
 {
 	int status = 0;
@@ -230,6 +346,53 @@ int getString(char* s)
 	return 1;
 }
 
+int getOrderInput(OrderBy* orderBy)
+{
+	int status = 0;
+
+	while (status != 1)
+	{
+		char s[MAX_STRING_SIZE] = { 0 };
+
+		printf("Enter the columns (name, supplier, quantity, date; '-' in front for descending order): ");
+
+		int x = scanf("%63[^\n]s", s);
+		int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+
+		if (x == 1)
+			status = parseOrderBy(orderBy, s);
+		if (status != 1)
+			printf("Enter valid columns!\n");
+	}
+	return 1;
+}
+
+
+/*
+	Prints the names close to the given one. If quiet is 1, nothing is printed when there are no close names.
+*/
+int printSuggestions(UI* ui, const char* name, int quiet)
+{
+	MaterialGroup* groups[COMPLETE_LIMIT];
+	int distances[COMPLETE_LIMIT];
+
+	int count = getSuggestions(ui->materialServices, name, COMPLETE_LIMIT, groups, distances);
+
+	if (count == -1)
+		return -1;
+	if (count == 0)
+	{
+		if (!quiet)
+			printf("No similar names!\n");
+		return 1;
+	}
+
+	printf("Did you mean:\n");
+	for (int i = 0; i < count; i++)
+		printf("%-3d %20s %20.4lf\n", i + 1, getName(getElement(groups[i]->lots, 0)), groups[i]->total);
+
+	return 1;
+}
 
 int addHandler(UI* ui)
 {
@@ -256,7 +419,12 @@ int deleteHandler(UI* ui)
 	getSupplierInput(supplier);
 	getDateInput(&day, &month, &year);
 	
-	return rem(ui->materialServices, name, supplier, day, month, year);
+	int status = rem(ui->materialServices, name, supplier, day, month, year);
+
+	if (status == -1 && getNameGroup(ui->materialServices->materialRepo, name) == NULL)
+		printSuggestions(ui, name, 1);
+
+	return status;
 }
 
 int updateHandler(UI* ui)
@@ -281,8 +449,142 @@ int updateHandler(UI* ui)
 	getQuantityInput(&newQuantity);
 	getDateInput(&newDay, &newMonth, &newYear);
 
-	return update(ui->materialServices, name, supplier, day, month, year, 
+	int status = update(ui->materialServices, name, supplier, day, month, year, 
 										newName, newSupplier, newQuantity, newDay, newMonth, newYear);
+
+	if (status == -1 && getNameGroup(ui->materialServices->materialRepo, name) == NULL)
+		printSuggestions(ui, name, 1);
+
+	return status;
+}
+
+int consumeHandler(UI* ui)
+{
+	char name[MAX_STRING_SIZE] = { 0 };
+	double quantity = 0;
+
+	getNameInput(name);
+	getQuantityInput(&quantity);
+
+	int status = consume(ui->materialServices, name, quantity);
+
+	if (status == -1)
+	{
+		MaterialGroup* group = getNameGroup(ui->materialServices->materialRepo, name);
+		if (group == NULL)
+			printSuggestions(ui, name, 1);
+		else
+			printf("Only %.4lf available!\n", group->total);
+	}
+
+	return status;
+}
+
+int recipeHandler(UI* ui, char* name)
+{
+	char line[4 * MAX_STRING_SIZE] = { 0 };
+	Recipe recipe;
+
+	if (name[0] == 0)
+		getNameInput(name);
+
+	printf("Enter the ingredients for one unit (name=quantity, separated by commas): ");
+	int x = scanf("%255[^\n]", line);
+	int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+
+	if (x != 1 || parseRecipe(&recipe, line) == -1)
+	{
+		printf("Invalid ingredients!\n");
+		return -1;
+	}
+
+	return defineRecipe(ui->materialServices, name, &recipe);
+}
+
+void recipesHandler(UI* ui)
+{
+	HashMap* recipes = ui->materialServices->recipes;
+
+	if (mapSize(recipes) == 0)
+	{
+		printf("No recipes defined!\n");
+		return;
+	}
+
+	for (int slot = 0; slot < recipes->capacity; slot++)
+	{
+		HashEntry* entry = getEntryAt(recipes, slot);
+		if (entry == NULL)
+			continue;
+
+		Recipe* recipe = entry->value;
+		printf("%s:\n", entry->key);
+		for (int i = 0; i < recipe->size; i++)
+			printf("    %20s %20.4lf\n", recipe->ingredients[i].name, recipe->ingredients[i].quantity);
+	}
+}
+
+int produceHandler(UI* ui, char* argument)
+{
+	Ingredient shortfalls[MAX_INGREDIENTS];
+	int shortfallCount = 0;
+	long count = 0;
+
+	// the count is the last word, the recipe name may contain spaces
+	char* separator = strrchr(argument, ' ');
+	if (separator != NULL)
+	{
+		char* end;
+		count = strtol(separator + 1, &end, 10);
+		if (end == separator + 1 || *end != 0)
+			count = 0;
+		else
+			*separator = 0;
+	}
+
+	if (argument[0] == 0)
+		getNameInput(argument);
+
+	while (count < 1)
+	{
+		char text[MAX_STRING_SIZE] = { 0 };
+		char* end;
+
+		printf("Enter the number of units: ");
+		int x = scanf("%63[^\n]", text);
+		int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+		if (x == EOF)
+			return -1;
+		count = strtol(text, &end, 10);
+		if (end == text || *end != 0)
+			count = 0;
+	}
+
+	int status = produce(ui->materialServices, argument, (int)count, shortfalls, &shortfallCount);
+
+	if (status == -1 && getRecipe(ui->materialServices, argument) == NULL)
+		printf("Unknown recipe!\n");
+
+	for (int i = 0; i < shortfallCount; i++)
+		printf("Missing %.4lf of %s!\n", shortfalls[i].quantity, shortfalls[i].name);
+
+	return status;
+}
+
+/*
+	Prints the result of a query, served from the query cache when the repository did not change since it was last run.
+*/
+int printQuery(UI* ui, const Query* query)
+{
+	DynamicArray* view = getQueryView(ui->materialServices, query);
+
+	if (view == NULL)
+		return -1;
+
+	printMaterialsColumns(ui, view, query->columns);
+
+	destroyDynamicArray(view);
+	return 1;
 }
 
 int getExpiredHandler(UI* ui)
@@ -324,34 +626,107 @@ int getExpiredHandler(UI* ui)
 			printf("Invalid option!\n");
 	}
 
-	DynamicArray* expired;
+	int limit = 0;
+	getLimitInput(&limit);
+
+	Query query;
 	if (strcmp(s, "none") == 0)
-		expired = getExpired(ui->materialServices, filterFunction, "");
+		buildExpiredQuery(&query, filterFunction, "", limit);
 	else
-		expired = getExpired(ui->materialServices, filterFunction, s);
+		buildExpiredQuery(&query, filterFunction, s, limit);
 
-	if (expired == NULL)
-		return -1;
+	return printQuery(ui, &query);
+}
+
+int sortHandler(UI* ui)
+{
+	Query query;
 
-	printMaterials(expired);
+	initQuery(&query);
+	parseOrderBy(&query.orderBy, "name");
+
+	return printQuery(ui, &query);
+}
+
+int sortByDateHandler(UI* ui)
+{
+	Query query;
 
-	destroyDynamicArray(expired);
+	initQuery(&query);
+	parseOrderBy(&query.orderBy, "date");
+
+	return printQuery(ui, &query);
+}
+
+int orderHandler(UI* ui)
+{
+	Query query;
+
+	initQuery(&query);
+	getOrderInput(&query.orderBy);
+
+	return printQuery(ui, &query);
+}
+
+int getQueryInput(Query* query)
+{
+	int status = 0;
+
+	printf("Stages: expired, name~<text>, supplier=<supplier>, quantity<<number>, order=<columns>, limit=<number>, columns=<columns>\n");
+	while (status != 1)
+	{
+		char s[2 * MAX_STRING_SIZE] = { 0 };
+
+		printf("Enter the query (or 'none', all materials): ");
+
+		int x = scanf("%127[^\n]s", s);
+		int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+
+		if (x == 1)
+			status = parseQuery(query, s);
+		if (status != 1)
+			printf("Enter a valid query!\n");
+	}
 	return 1;
 }
 
-int sortHandler(UI* ui)
+int queryHandler(UI* ui)
 {
-	DynamicArray* sorted = getSortedAscending(ui->materialServices);
+	Query query;
 
-	if (sorted == NULL)
-		return -1;
+	getQueryInput(&query);
 
-	printMaterials(sorted);
+	return printQuery(ui, &query);
+}
 
-	destroyDynamicArray(sorted);
+int printExplain(UI* ui, const Query* query)
+{
+	QueryPlan plan;
+
+	int status = explain(ui->materialServices, query, &plan);
+
+	if (status == -1)
+		return -1;
+
+	fprintf(ui->output, "Access path: %s", getAccessPathName(plan.path));
+	if (plan.filter != -1)
+		fprintf(ui->output, " (%s)", query->filters[plan.filter].text);
+	fprintf(ui->output, "\n");
+	fprintf(ui->output, "Estimated cost: %.0lf rows examined\n", plan.cost);
+	fprintf(ui->output, "Estimated rows: %.1lf\n", plan.estimatedRows);
+	fprintf(ui->output, "Actual rows: %d\n", plan.actualRows);
 	return 1;
 }
 
+int explainHandler(UI* ui)
+{
+	Query query;
+
+	getQueryInput(&query);
+
+	return printExplain(ui, &query);
+}
+
 int getShortHandler(UI* ui)
 {
 	char filterSupplier[MAX_STRING_SIZE] = { 0 };
@@ -383,23 +758,236 @@ int getShortHandler(UI* ui)
 			printf("Invalid option!\n");
 	}
 
-	DynamicArray* shortMaterial = getShort(ui->materialServices, compareFunction, filterSupplier, filterQuantity);
+	int limit = 0;
+	getLimitInput(&limit);
+
+	Query query;
+	buildShortQuery(&query, compareFunction, filterSupplier, filterQuantity, limit);
+
+	return printQuery(ui, &query);
+}
+
+int printTotals(UI* ui, int bySupplier)
+{
+	DynamicArray* totals = getTotals(ui->materialServices, bySupplier);
+
+	if (totals == NULL)
+		return -1;
+
+	fprintf(ui->output, "%-20s %20s %10s %10s\n", bySupplier ? "SUPPLIER" : "NAME", "TOTAL", "LOTS", "EXPIRED");
+	for (int i = 0; i < len(totals); i++)
+	{
+		HashEntry* entry = getElement(totals, i);
+		MaterialGroup* group = entry->value;
+
+		fprintf(ui->output, "%-20s %20.4lf %10d %10d\n", entry->key, group->total, len(group->lots), group->expired);
+	}
+
+	destroyDynamicArray(totals);
+	return 1;
+}
+
+int totalsHandler(UI* ui)
+{
+	if (printTotals(ui, 0) == -1)
+		return -1;
+
+	fprintf(ui->output, "\n");
+	return printTotals(ui, 1);
+}
+
+int printCompletions(UI* ui, const char* prefix, int bySupplier)
+{
+	MaterialGroup* groups[COMPLETE_LIMIT];
+
+	int count = getCompletions(ui->materialServices, prefix, bySupplier, COMPLETE_LIMIT, groups);
+
+	if (count == -1)
+		return -1;
+
+	printf("%s:\n", bySupplier ? "Suppliers" : "Names");
+	for (int i = 0; i < count; i++)
+	{
+		Material* material = getElement(groups[i]->lots, 0);
+		printf("%-3d %20s %20.4lf\n", i + 1, bySupplier ? getSupplier(material) : getName(material), groups[i]->total);
+	}
+	if (count == 0)
+		printf("No matches!\n");
+
+	return 1;
+}
+
+int completeHandler(UI* ui, char* prefix)
+{
+	if (prefix[0] == 0)
+	{
+		printf("Enter prefix: ");
+		int x = scanf("%63[^\n]", prefix);
+		int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+		if (x != 1)
+			prefix[0] = 0;
+	}
+
+	if (printCompletions(ui, prefix, 0) == -1)
+		return -1;
+
+	return printCompletions(ui, prefix, 1);
+}
+
+int expiringHandler(UI* ui, char* argument)
+{
+	char* end;
+	long days = strtol(argument, &end, 10);
+
+	while (end == argument || *end != 0 || days < 1 || days > MAX_WITHIN_DAYS)
+	{
+		printf("Enter the number of days: ");
+		int x = scanf("%63[^\n]", argument);
+		int c;  while ((c = getchar()) != '\n' && c != EOF) {}
+		if (x == EOF)
+			return -1;
+		if (x != 1)
+			argument[0] = 0;
+		days = strtol(argument, &end, 10);
+	}
+
+	Query query;
+	initQuery(&query);
+	addExpiresWithinFilter(&query, (int)days);
+	parseOrderBy(&query.orderBy, "date");
+
+	return printQuery(ui, &query);
+}
+
+int formatHandler(UI* ui, char* argument)
+{
+	if (parseRowLayout(argument, &ui->layout) == -1)
+	{
+		printf("Choose table, tsv, csv or jsonl!\n");
+		return -1;
+	}
+
+	return 1;
+}
+
+int histogramHandler(UI* ui, char* argument)
+{
+	CalendarBin bins[HISTOGRAM_PERIODS];
+	int byMonth = strcmp(argument, "month") == 0;
 
-	if (shortMaterial == NULL)
+	if (!byMonth && strcmp(argument, "week") != 0 && argument[0] != 0)
+	{
+		printf("Choose week or month!\n");
+		return 1;
+	}
+
+	if (getExpiryHistogram(ui->materialServices, byMonth, HISTOGRAM_PERIODS, bins) == -1)
 		return -1;
 
-	printMaterials(shortMaterial);
+	printf("%-12s %10s %20s\n", byMonth ? "MONTH" : "WEEK", "LOTS", "QUANTITY");
+	for (int i = 0; i < HISTOGRAM_PERIODS; i++)
+	{
+		char period[16];
+		snprintf(period, sizeof(period), "%s+%d", byMonth ? "month" : "week", i);
+		printf("%-12s %10d %20.4lf\n", period, bins[i].lots, bins[i].quantity);
+	}
 
-	destroyDynamicArray(shortMaterial);
 	return 1;
 }
 
+int suggestHandler(UI* ui, char* name)
+{
+	if (name[0] == 0)
+		getNameInput(name);
+
+	return printSuggestions(ui, name, 0);
+}
+
+int alertHandler(UI* ui)
+{
+	AlertRule rule = { ALERT_LOW_STOCK, 0, "", 0, 0, 0 };
+	int option = 0;
+
+	printAlertMenu();
+	while (option == 0)
+	{
+		char command[MAX_COMMAND_SIZE] = { 0 };
+
+		int status = getCommand(command);
+		if (status == -1)
+			return -1;
+		if (strlen(command) == 1 && command[0] >= '1' && command[0] <= '4')
+			option = command[0] - '0';
+		else
+			printf("Invalid option!\n");
+	}
+
+	rule.type = option <= 2 ? ALERT_LOW_STOCK : ALERT_EXPIRING;
+	rule.bySupplier = option == 2;
+
+	if (option == 2)
+		getSupplierInput(rule.key);
+	else if (option != 4)
+		getNameInput(rule.key);
+
+	if (rule.type == ALERT_LOW_STOCK)
+		getQuantityInput(&rule.threshold);
+	else
+		getDaysInput(&rule.days);
+
+	return addAlert(ui->materialServices, &rule);
+}
+
+void alertsHandler(UI* ui)
+{
+	Alert alert;
+	int count = 0;
+
+	while (takeAlert(ui->materialServices, &alert) == 1)
+	{
+		const char* key = alert.key[0] == 0 ? "any material" : alert.key;
+		const char* kind = alert.bySupplier ? "supplier" : "name";
+
+		if (alert.type == ALERT_LOW_STOCK && alert.raised)
+			fprintf(ui->output, "Low stock of %s %s: only %.4lf left!\n", kind, key, alert.value);
+		else if (alert.type == ALERT_LOW_STOCK)
+			fprintf(ui->output, "Stock of %s %s restored: %.4lf available.\n", kind, key, alert.value);
+		else if (alert.raised)
+			fprintf(ui->output, "%d lots of %s expire soon!\n", (int)alert.value, key);
+		else
+			fprintf(ui->output, "No more lots of %s expire soon.\n", key);
+		count++;
+	}
+
+	if (ui->materialServices->alerts.ring.dropped > 0)
+		fprintf(ui->output, "%lld older alerts were dropped.\n", ui->materialServices->alerts.ring.dropped);
+	ui->materialServices->alerts.ring.dropped = 0;
+
+	if (count == 0)
+		fprintf(ui->output, "No new alerts!\n");
+}
+
+void cacheHandler(UI* ui)
+{
+	QueryCache* queryCache = &ui->materialServices->queryCache;
+
+	printf("Repository version: %lld\n", ui->materialServices->version);
+	printf("Cache hits: %d\n", queryCache->hits);
+	printf("Cache misses: %d\n", queryCache->misses);
+}
+
 void commandHandler(UI* ui)
 {
 	while (1)
 	{
 		char command[MAX_COMMAND_SIZE];
-		int status = getCommand(command);
+		char argument[MAX_STRING_SIZE];
+		int status = getCommandLine(command, argument);
+
+		if (status == 0)
+			break;
+		if (command[0] == 0)
+			continue;
 
 		command[strcspn(command, "\r\n")] = 0; //remove any unwanted invisible characters
 		if (status == 1)
@@ -433,9 +1021,35 @@ void commandHandler(UI* ui)
 				else
 					printf("An error occured while trying to update the material, try again!\n");
 			}
+			else if (strcmp(command, "consume") == 0)
+			{
+				status = consumeHandler(ui);
+				if (status == 1)
+					printf("Consumed successfully!\n");
+				else
+					printf("An error occured while trying to consume the material, try again!\n");
+			}
+			else if (strcmp(command, "recipe") == 0)
+			{
+				status = recipeHandler(ui, argument);
+				if (status == 1)
+					printf("Recipe saved!\n");
+				else
+					printf("An error occured while trying to save the recipe, try again!\n");
+			}
+			else if (strcmp(command, "recipes") == 0)
+				recipesHandler(ui);
+			else if (strcmp(command, "produce") == 0)
+			{
+				status = produceHandler(ui, argument);
+				if (status == 1)
+					printf("Produced successfully!\n");
+				else
+					printf("Nothing was used, try again!\n");
+			}
 			else if (strcmp(command, "list") == 0)
 			{
-				printMaterials(ui->materialServices->materialRepo->data);
+				printMaterials(ui, ui->materialServices->materialRepo->data);
 			}
 			else if (strcmp(command, "expired") == 0)
 			{
@@ -449,6 +1063,78 @@ void commandHandler(UI* ui)
 				if (status == -1)
 					printf("Something went wrong!\n");
 			}
+			else if (strcmp(command, "bydate") == 0)
+			{
+				status = sortByDateHandler(ui);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "order") == 0)
+			{
+				status = orderHandler(ui);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "query") == 0)
+			{
+				status = queryHandler(ui);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "explain") == 0)
+			{
+				status = explainHandler(ui);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "totals") == 0)
+			{
+				status = totalsHandler(ui);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "complete") == 0)
+			{
+				status = completeHandler(ui, argument);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "expiring") == 0)
+			{
+				status = expiringHandler(ui, argument);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "format") == 0)
+			{
+				status = formatHandler(ui, argument);
+				if (status == 1)
+					printf("Format changed successfully!\n");
+			}
+			else if (strcmp(command, "histogram") == 0)
+			{
+				status = histogramHandler(ui, argument);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "suggest") == 0)
+			{
+				status = suggestHandler(ui, argument);
+				if (status == -1)
+					printf("Something went wrong!\n");
+			}
+			else if (strcmp(command, "cache") == 0)
+				cacheHandler(ui);
+			else if (strcmp(command, "alert") == 0)
+			{
+				status = alertHandler(ui);
+				if (status == 1)
+					printf("Alert added!\n");
+				else
+					printf("An error occured while trying to add the alert, try again!\n");
+			}
+			else if (strcmp(command, "alerts") == 0)
+				alertsHandler(ui);
 			else if (strcmp(command, "short") == 0)
 			{
 				status = getShortHandler(ui);
@@ -471,10 +1157,331 @@ void commandHandler(UI* ui)
 				else
 					printf("No operations to redo!\n");
 			}
+			else if (strcmp(command, "begin") == 0)
+			{
+				status = beginTransaction(ui->materialServices);
+				if (status == 1)
+					printf("Batch started!\n");
+				else
+					printf("A batch is already in progress!\n");
+			}
+			else if (strcmp(command, "commit") == 0)
+			{
+				if (ui->materialServices->transaction == 0)
+					printf("No batch is in progress!\n");
+				else if (commitTransaction(ui->materialServices) == 1)
+					printf("Batch applied successfully!\n");
+				else
+					printf("The batch could not be applied, all of its operations were discarded!\n");
+			}
+			else if (strcmp(command, "rollback") == 0)
+			{
+				status = rollbackTransaction(ui->materialServices);
+				if (status == 1)
+					printf("Batch discarded!\n");
+				else
+					printf("No batch in progress!\n");
+			}
 			else
 				printf("Invalid command!\n");
 		}
+
+		if (ui->materialServices->alerts.ring.size > 0)
+			printf("New alerts: %d, enter alerts to see them.\n", ui->materialServices->alerts.ring.size);
+	}
+}
+
+/*
+	Checks that the tokens of a batch command fit in the strings of a material and that the date is valid.
+	Returns 1 if they do, -1 otherwise.
+*/
+int checkBatchMaterial(char** strings, int count, int day, int month, int year)
+{
+	for (int i = 0; i < count; i++)
+		if ((int)strlen(strings[i]) > MAX_STRING_SIZE - 1)
+			return -1;
+
+	if (!validateDate(day, month, year))
+		return -1;
+
+	return 1;
+}
+
+/*
+	Parses the tokens from the given position as day, month and year.
+	Returns 1 on success, or -1 if a token is not a number.
+*/
+int parseBatchDate(char** tokens, int* day, int* month, int* year)
+{
+	if (parseInteger(tokens[0], day) == -1 || parseInteger(tokens[1], month) == -1 || parseInteger(tokens[2], year) == -1)
+		return -1;
+
+	return 1;
+}
+
+/*
+	Runs a single batch command.
+	command - the first word of the line
+	rest - the rest of the line, for the commands that take it whole (query, explain, order, recipe)
+	tokens - the arguments of the command, count of them
+	Returns 1 on success, -1 if the command failed, or 0 if the command is unknown or has the wrong arguments.
+*/
+int runBatchCommand(UI* ui, const char* command, char* rest, char** tokens, int count)
+{
+	MaterialServices* materialServices = ui->materialServices;
+	int day, month, year;
+	double quantity;
+
+	if (strcmp(command, "add") == 0)
+	{
+		if (count != 6 || parseDouble(tokens[2], &quantity) == -1 || parseBatchDate(tokens + 3, &day, &month, &year) == -1)
+			return 0;
+		if (checkBatchMaterial(tokens, 2, day, month, year) == -1)
+			return -1;
+
+		return add(materialServices, tokens[0], tokens[1], quantity, day, month, year);
+	}
+	if (strcmp(command, "delete") == 0)
+	{
+		if (count != 5 || parseBatchDate(tokens + 2, &day, &month, &year) == -1)
+			return 0;
+		if (checkBatchMaterial(tokens, 2, day, month, year) == -1)
+			return -1;
+
+		return rem(materialServices, tokens[0], tokens[1], day, month, year);
+	}
+	if (strcmp(command, "update") == 0)
+	{
+		int newDay, newMonth, newYear;
+
+		if (count != 11 || parseBatchDate(tokens + 2, &day, &month, &year) == -1 ||
+			parseDouble(tokens[7], &quantity) == -1 || parseBatchDate(tokens + 8, &newDay, &newMonth, &newYear) == -1)
+			return 0;
+		if (checkBatchMaterial(tokens, 2, day, month, year) == -1 || checkBatchMaterial(tokens + 5, 2, newDay, newMonth, newYear) == -1)
+			return -1;
+
+		return update(materialServices, tokens[0], tokens[1], day, month, year, tokens[5], tokens[6], quantity, newDay, newMonth, newYear);
+	}
+	if (strcmp(command, "lookup") == 0)
+	{
+		if (count != 5 || parseBatchDate(tokens + 2, &day, &month, &year) == -1)
+			return 0;
+
+		Material* lot = findLot(materialServices, tokens[0], tokens[1], day, month, year);
+		if (lot == NULL)
+			return -1;
+
+		DynamicArray* view = createDynamicArray(1, NULL);
+		apd(view, lot);
+		printMaterials(ui, view);
+		destroyDynamicArray(view);
+
+		return 1;
+	}
+	if (strcmp(command, "consume") == 0)
+	{
+		if (count != 2 || parseDouble(tokens[1], &quantity) == -1)
+			return 0;
+
+		return consume(materialServices, tokens[0], quantity);
+	}
+	if (strcmp(command, "recipe") == 0)
+	{
+		Recipe recipe;
+		char* name = rest;
+		char* ingredients;
+
+		if (rest == NULL)
+			return 0;
+
+		// the name is the first word, or the text between quotes, the ingredients are the rest of the line
+		if (*rest == '"')
+		{
+			name = rest + 1;
+			ingredients = strchr(name, '"');
+			if (ingredients == NULL)
+				return 0;
+		}
+		else
+			ingredients = rest + strcspn(rest, " \t");
+
+		if (*ingredients == 0)
+			return 0;
+		*ingredients++ = 0;
+		if (parseRecipe(&recipe, ingredients) == -1)
+			return 0;
+
+		return defineRecipe(materialServices, name, &recipe);
 	}
+	if (strcmp(command, "produce") == 0)
+	{
+		Ingredient shortfalls[MAX_INGREDIENTS];
+		int shortfallCount, units;
+
+		if (count != 2 || parseInteger(tokens[1], &units) == -1)
+			return 0;
+
+		int status = produce(materialServices, tokens[0], units, shortfalls, &shortfallCount);
+		for (int i = 0; i < shortfallCount; i++)
+			fprintf(ui->output, "Missing %.4lf of %s!\n", shortfalls[i].quantity, shortfalls[i].name);
+
+		return status;
+	}
+	if (strcmp(command, "list") == 0)
+	{
+		printMaterials(ui, materialServices->materialRepo->data);
+		return 1;
+	}
+	if (strcmp(command, "sort") == 0)
+		return sortHandler(ui);
+	if (strcmp(command, "short") == 0)
+	{
+		Query query;
+		int descending = count == 3 && strcmp(tokens[2], "desc") == 0;
+
+		if ((count != 2 && count != 3) || parseDouble(tokens[1], &quantity) == -1 ||
+			(count == 3 && !descending && strcmp(tokens[2], "asc") != 0))
+			return 0;
+
+		buildShortQuery(&query, descending ? &greater : &less, tokens[0], quantity, 0);
+		return printQuery(ui, &query);
+	}
+	if (strcmp(command, "bydate") == 0)
+		return sortByDateHandler(ui);
+	if (strcmp(command, "order") == 0 || strcmp(command, "query") == 0 || strcmp(command, "explain") == 0 ||
+		strcmp(command, "expired") == 0)
+	{
+		Query query;
+		initQuery(&query);
+
+		if (rest == NULL)
+			return 0;
+
+		if (strcmp(command, "order") == 0 && parseOrderBy(&query.orderBy, rest) == -1)
+			return 0;
+		if (strcmp(command, "expired") == 0 && parseQuery(&query, "expired order=date") == -1)
+			return -1;
+		if ((strcmp(command, "query") == 0 || strcmp(command, "explain") == 0) && parseQuery(&query, rest) == -1)
+			return 0;
+
+		if (strcmp(command, "explain") == 0)
+			return printExplain(ui, &query);
+		return printQuery(ui, &query);
+	}
+	if (strcmp(command, "expiring") == 0)
+	{
+		int days;
+		if (count != 1 || parseInteger(tokens[0], &days) == -1 || days < 1 || days > MAX_WITHIN_DAYS)
+			return 0;
+
+		return expiringHandler(ui, tokens[0]);
+	}
+	if (strcmp(command, "totals") == 0)
+		return totalsHandler(ui);
+	if (strcmp(command, "checksum") == 0)
+	{
+		uint64_t hash;
+		int lots;
+
+		if (getInventoryHash(materialServices, &hash, &lots) == -1)
+			return -1;
+
+		fprintf(ui->output, "Checksum %016llx of %d lots\n", (unsigned long long)hash, lots);
+		return 1;
+	}
+	if (strcmp(command, "format") == 0)
+	{
+		if (count != 1)
+			return 0;
+
+		return parseRowLayout(tokens[0], &ui->layout) == 1 ? 1 : 0;
+	}
+	if (strcmp(command, "alerts") == 0)
+	{
+		alertsHandler(ui);
+		return 1;
+	}
+	if (strcmp(command, "undo") == 0)
+		return undo(materialServices);
+	if (strcmp(command, "redo") == 0)
+		return redo(materialServices);
+	if (strcmp(command, "begin") == 0)
+		return beginTransaction(materialServices);
+	if (strcmp(command, "commit") == 0)
+		return commitTransaction(materialServices);
+	if (strcmp(command, "rollback") == 0)
+		return rollbackTransaction(materialServices);
+	if (strcmp(command, "history") == 0)
+	{
+		int limit;
+
+		if (count != 1 || parseInteger(tokens[0], &limit) == -1 || setHistoryLimit(materialServices, limit) == -1)
+			return 0;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+int runCommandLine(UI* ui, char* line, int number)
+{
+	char* tokens[MAX_BATCH_TOKENS];
+	char* command = line + strspn(line, " \t");
+
+	if (*command == 0 || *command == '#')
+		return 1;
+
+	char* rest = command + strcspn(command, " \t");
+	if (*rest != 0)
+	{
+		*rest++ = 0;
+		rest += strspn(rest, " \t");
+	}
+
+	// the commands that take the whole rest of the line get it before it is split into tokens, or NULL if it is
+	// too long for them, so it is rejected rather than cut short
+	char text[4 * MAX_STRING_SIZE];
+	int fits = snprintf(text, sizeof(text), "%s", rest) < (int)sizeof(text);
+
+	int count = tokenizeLine(rest, tokens, MAX_BATCH_TOKENS);
+	int status = count == -1 ? 0 : runBatchCommand(ui, command, fits ? text : NULL, tokens, count);
+
+	if (status == 0)
+		fprintf(ui->output, "Line %d: invalid command!\n", number);
+	else if (status == -1)
+		fprintf(ui->output, "Line %d: %s failed!\n", number, command);
+
+	return status;
+}
+
+int runBatch(UI* ui, FILE* input)
+{
+	LineReader lineReader;
+	int failed = 0;
+
+	if (ui == NULL || initLineReader(&lineReader, input) == -1)
+		return -1;
+
+	char* line;
+	for (int number = 1; (line = readLine(&lineReader)) != NULL; number++)
+		if (runCommandLine(ui, line, number) != 1)
+			failed++;
+
+	freeLineReader(&lineReader);
+	fflush(ui->output);
+
+	return failed;
+}
+
+void setOutput(UI* ui, FILE* output)
+{
+	if (ui == NULL || output == NULL)
+		return;
+
+	flushRowWriter(&ui->rowWriter);
+	ui->output = output;
+	ui->rowWriter.file = output;
 }
 
 void start(UI* ui)
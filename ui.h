@@ -1,12 +1,58 @@
 #pragma once
 
 #include "services.h"
+#include "rowWriter.h"
 
+#include <stdio.h>
+
+/*
+	output - receives the output of the commands run from a batch, the standard output by default
+	rowWriter - formats the listed materials, in the given layout, before they are written to the output
+*/
 typedef struct UI
 {
 	MaterialServices* materialServices;
+	FILE* output;
+	RowWriter rowWriter;
+	RowLayout layout;
 } UI;
 
 UI* createUI(MaterialServices* materialServices);
 void destroyUI(UI* ui);
 void start(UI* ui);
+
+/*
+	Runs the commands read from the input, one per line, with all of their arguments on the line and without any
+	prompt or menu. Words containing spaces are written between double quotes; empty lines and lines starting with #
+	are skipped. The commands are:
+		add <name> <supplier> <quantity> <day> <month> <year>
+		delete <name> <supplier> <day> <month> <year>
+		lookup <name> <supplier> <day> <month> <year>
+		update <name> <supplier> <day> <month> <year> <new name> <new supplier> <new quantity> <new day> <new month> <new year>
+		consume <name> <quantity>
+		recipe <name> <ingredient>=<quantity>, ...
+		produce <recipe> <count>
+		list, sort, bydate, expired, totals, alerts, checksum, undo, redo, begin, commit, rollback
+		short <supplier> <quantity> [asc|desc]
+		format <table|tsv|csv|jsonl>
+		order <columns>
+		query <stages>, explain <stages>
+		expiring <days>
+		history <limit>, see setHistoryLimit
+	The recipe, order, query and explain commands are rejected if the rest of their line is longer than
+	4 * MAX_STRING_SIZE - 1 characters. Every failed or invalid command is reported with its line number.
+	Returns the number of commands that failed, or -1 if an error occured.
+*/
+int runBatch(UI* ui, FILE* input);
+
+/*
+	Runs a single line of a batch, see runBatch. The line is modified.
+	number - the line number that a failed or invalid command is reported with
+	Returns 1 on success or for an empty line or comment, 0 if the command is not valid, or -1 if it failed.
+*/
+int runCommandLine(UI* ui, char* line, int number);
+
+/*
+	Sends the output of the commands run from a batch, including the listed materials, to the given file.
+*/
+void setOutput(UI* ui, FILE* output);